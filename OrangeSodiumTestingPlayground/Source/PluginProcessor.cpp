@@ -26,7 +26,6 @@ OrangeSodiumTestingPlaygroundAudioProcessor::OrangeSodiumTestingPlaygroundAudioP
 {
     synth = nullptr;
     synthLoaded = false;
-    synthsNeedSwapped = false;
     //initSynth();
 }
 
@@ -34,6 +33,9 @@ OrangeSodiumTestingPlaygroundAudioProcessor::~OrangeSodiumTestingPlaygroundAudio
 {
     // Clean up singleton program if created
     //OrangeSodium::Program::destroyInstance();
+    delete pendingSynth;
+    delete retiredSynth;
+    delete synth;
 }
 
 //==============================================================================
@@ -106,6 +108,12 @@ void OrangeSodiumTestingPlaygroundAudioProcessor::prepareToPlay (double sampleRa
         synthLoaded = true;
     }
     synth->prepare(2, samplesPerBlock, sampleRate);
+    {
+        const juce::SpinLock::ScopedLockType lock(reloadLock);
+        if (pendingSynth) {
+            pendingSynth->prepare(2, samplesPerBlock, sampleRate);
+        }
+    }
     lastSampleRate = sampleRate;
     lastSamplesPerBlock = samplesPerBlock;
     //synth->setSampleRate(sampleRate);
@@ -162,21 +170,19 @@ void OrangeSodiumTestingPlaygroundAudioProcessor::processBlock (juce::AudioBuffe
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
-    if (synthsNeedSwapped) {
-
-        // Delete old synth so Lua can handle closing
-        delete synth;
-        synth = nullptr;
-
-        swap_synth = OrangeSodium::createSynthesizerFromString(newProgram.toStdString());
-        logStream.str(""); // Reset log stream
-        swap_synth->setLogStream(&logStream);
-        swap_synth->buildSynthFromProgram();
-        synth = swap_synth;
-        if (synth) {
-            synth->prepare(2, lastSamplesPerBlock, static_cast<float>(lastSampleRate));
+    {
+        // Swap in a reloaded program at the block boundary. If the message thread is busy building one, try next block.
+        const juce::SpinLock::ScopedTryLockType lock(reloadLock);
+        if (lock.isLocked() && pendingSynth && !retiredSynth) {
+            if (synth) {
+                pendingSynth->completeHotReload();
+            }
+            retiredSynth = synth;
+            synth = pendingSynth;
+            pendingSynth = nullptr;
+            retiredLog = std::move(synthLog);
+            synthLog = std::move(pendingLog);
         }
-        synthsNeedSwapped = false;
     }
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
@@ -334,11 +340,50 @@ void OrangeSodiumTestingPlaygroundAudioProcessor::initSynth()
 
 
 void OrangeSodiumTestingPlaygroundAudioProcessor::updateProgram(juce::String& program) {
+    // Runs on the message thread. The lock is only held to hand pointers over, so the audio thread never waits
+    // for a build.
+    OrangeSodium::Synthesizer* retired = nullptr;
+    OrangeSodium::Synthesizer* unused = nullptr;
+    OrangeSodium::Synthesizer* running = nullptr;
+    std::unique_ptr<std::ostringstream> retiredStream;
+    std::unique_ptr<std::ostringstream> unusedStream;
+    {
+        const juce::SpinLock::ScopedLockType lock(reloadLock);
+        retired = retiredSynth;
+        retiredStream = std::move(retiredLog);
+        retiredSynth = nullptr;
+        // A reload that was never swapped in. With no pending synth the audio thread cannot swap, so the running
+        // synth stays put until the new one is handed over.
+        unused = pendingSynth;
+        unusedStream = std::move(pendingLog);
+        pendingSynth = nullptr;
+        running = synth;
+    }
+    delete retired;
+    delete unused;
+
+    // The new build logs into its own stream; the running synth may still be writing to its one on the audio thread
+    auto reloadedLog = std::make_unique<std::ostringstream>();
+    OrangeSodium::Synthesizer* reloaded = OrangeSodium::createSynthesizerFromString(program.toStdString());
+    reloaded->setLogStream(reloadedLog.get());
+    reloaded->buildSynthFromProgram();
+    if (!reloaded->isProgramValid()) {
+        // Keep playing the last program that built
+        buildLog = reloadedLog->str();
+        delete reloaded;
+        return;
+    }
+    reloaded->prepare(2, lastSamplesPerBlock, static_cast<float>(lastSampleRate));
+    if (running) {
+        reloaded->prepareHotReload(*running);
+    }
+    buildLog = reloadedLog->str();
 
-    synthsNeedSwapped = true;
-    newProgram = program;
+    const juce::SpinLock::ScopedLockType lock(reloadLock);
+    pendingSynth = reloaded;
+    pendingLog = std::move(reloadedLog);
 }
 
 void OrangeSodiumTestingPlaygroundAudioProcessor::getLogText(juce::String& text) {
-    text = logStream.str();
+    text = buildLog;
 }
\ No newline at end of file
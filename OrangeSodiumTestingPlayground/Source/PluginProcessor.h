@@ -65,16 +65,23 @@ public:
 private:
     // Synth integration
     OrangeSodium::Synthesizer* synth;
-    OrangeSodium::Synthesizer* swap_synth;
-    bool synthsNeedSwapped;
+    // Hot reload: updateProgram builds and prepares pendingSynth on the message thread without holding reloadLock,
+    // then hands it over under the lock. processBlock swaps it in between blocks and hands the old synth back
+    // through retiredSynth to be deleted off the audio thread. The audio thread only ever try-locks reloadLock.
+    // Every reloaded synth logs into its own stream, which moves along with it.
+    OrangeSodium::Synthesizer* pendingSynth = nullptr;
+    OrangeSodium::Synthesizer* retiredSynth = nullptr;
+    std::unique_ptr<std::ostringstream> synthLog;
+    std::unique_ptr<std::ostringstream> pendingLog;
+    std::unique_ptr<std::ostringstream> retiredLog;
+    juce::SpinLock reloadLock;
     juce::File findDefaultScript() const;
     void initSynth();
     bool synthLoaded;
     std::string loadedScript;
     double lastSampleRate;
     int lastSamplesPerBlock;
-    std::ostringstream logStream;
-    juce::String newProgram;
+    std::string buildLog; // Log of the last build; message thread only
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OrangeSodiumTestingPlaygroundAudioProcessor)
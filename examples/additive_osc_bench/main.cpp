@@ -0,0 +1,105 @@
+// Benchmark and accuracy check for the additive oscillator: a sawtooth of N harmonics played by one
+// AdditiveOscillator against the same spectrum built from N SineOscillators, one per partial
+#include "oscillators/additive_osc.h"
+#include "oscillators/sine_osc.h"
+#include "resource_manager.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 512;
+static constexpr size_t kBlocks = 2000;
+static constexpr float kSampleRate = 48000.f;
+static constexpr float kNote = 45.f; // 110 Hz, so 128 harmonics stay below Nyquist
+
+struct Result {
+    double t_stack;
+    double t_additive;
+    float error; // Max difference of the additive oscillator from a double precision sum of sines
+};
+
+static Result run(size_t n_partials) {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.max_n_frames = kFrames;
+    context.resource_manager = new ResourceManager();
+    const ResourceID table_id = context.resource_manager->createHarmonicPartialTable(n_partials, 1.f, false);
+    const float gain = 0.1f;
+
+    AdditiveOscillator additive(&context, 0, table_id, kChannels, gain);
+    additive.setSampleRate(kSampleRate);
+    additive.setOverwriteOutput(true);
+
+    // The SineOscillator stack: partial k is offset by 12 * log2(k) semitones, with amplitude gain / k
+    std::vector<SineOscillator*> stack;
+    for (size_t k = 1; k <= n_partials; ++k) {
+        SineOscillator* osc = new SineOscillator(&context, static_cast<ObjectID>(k), kChannels, gain / static_cast<float>(k));
+        osc->setSampleRate(kSampleRate);
+        osc->setFrequencyOffset(12.f * std::log2(static_cast<float>(k)));
+        osc->setOverwriteOutput(k == 1);
+        stack.push_back(osc);
+    }
+
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, 2);
+    mod_inputs.setChannelConstant(0, kNote);
+    mod_inputs.setChannelSilent(1);
+    SignalBuffer stack_outputs(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    SignalBuffer additive_outputs(SignalBuffer::EType::kAudio, kFrames, kChannels);
+
+    // Accuracy over the first blocks against a double precision sum
+    const double hz = 440.0 * std::pow(2.0, (kNote - 69.0) / 12.0);
+    float error = 0.f;
+    for (size_t b = 0; b < 100; ++b) {
+        additive.beginBlock();
+        additive.processBlock(nullptr, &mod_inputs, &additive_outputs, kFrames);
+        for (size_t i = 0; i < kFrames; ++i) {
+            const double t = static_cast<double>(b * kFrames + i + 1) / kSampleRate;
+            double reference = 0.0;
+            for (size_t k = 1; k <= n_partials; ++k) {
+                reference += gain / static_cast<double>(k) * std::sin(6.28318530717958647692 * hz * static_cast<double>(k) * t);
+            }
+            error = std::max(error, std::abs(additive_outputs.getElement(0, i) - static_cast<float>(reference)));
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        for (SineOscillator* osc : stack) {
+            osc->beginBlock();
+            osc->processBlock(nullptr, &mod_inputs, &stack_outputs, kFrames);
+        }
+    }
+    auto mid = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        additive.beginBlock();
+        additive.processBlock(nullptr, &mod_inputs, &additive_outputs, kFrames);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    for (SineOscillator* osc : stack) {
+        delete osc;
+    }
+    delete context.resource_manager;
+    return { std::chrono::duration<double>(mid - start).count(), std::chrono::duration<double>(end - mid).count(), error };
+}
+
+int main() {
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks" << std::endl;
+    for (size_t n_partials : { 16, 64, 128 }) {
+        const Result result = run(n_partials);
+        std::cout << n_partials << " partials" << std::endl;
+        std::cout << "  SineOscillator stack: " << result.t_stack * 1e3 << " ms" << std::endl;
+        std::cout << "  AdditiveOscillator:   " << result.t_additive * 1e3 << " ms" << std::endl;
+        std::cout << "  Cost: " << 100.0 * result.t_additive / result.t_stack << "% of the stack" << std::endl;
+        std::cout << std::scientific << "  Max error against double precision: " << result.error << std::fixed << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Benchmark for overwrite-first buffer writes: clearing every buffer and accumulating into it, against
+// letting the first writer of each buffer overwrite it
+#include "signal_buffer.h"
+#include "dsp/vector_ops.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 1024; // 512 frames at 2x oversampling
+static constexpr size_t kBlocks = 20000;
+static constexpr size_t kBuffers = 8;   // Audio buffers in the graph
+static constexpr size_t kWriters = 12;  // Writer i writes buffer i % kBuffers, so the first kBuffers writers are first writers
+
+struct Graph {
+    std::vector<SignalBuffer*> buffers;
+    std::vector<SignalBuffer*> sources; // What each writer produces
+    Graph() {
+        for (size_t b = 0; b < kBuffers; ++b) {
+            buffers.push_back(new SignalBuffer(SignalBuffer::EType::kAudio, kFrames, kChannels));
+        }
+        for (size_t w = 0; w < kWriters; ++w) {
+            SignalBuffer* source = new SignalBuffer(SignalBuffer::EType::kAudio, kFrames, kChannels);
+            for (size_t c = 0; c < kChannels; ++c) {
+                float* data = source->getChannel(c);
+                for (size_t i = 0; i < kFrames; ++i) {
+                    data[i] = 0.1f * std::sin(0.01f * static_cast<float>((w + 1) * i + c));
+                }
+            }
+            sources.push_back(source);
+        }
+    }
+    ~Graph() {
+        for (auto* buffer : buffers) delete buffer;
+        for (auto* source : sources) delete source;
+    }
+};
+
+// Previous behaviour: every buffer is zeroed at the start of the block and every writer accumulates
+static void runZeroThenAccumulate(Graph& graph) {
+    for (auto* buffer : graph.buffers) {
+        for (size_t c = 0; c < kChannels; ++c) {
+            std::memset(buffer->getChannel(c), 0, kFrames * sizeof(float));
+        }
+    }
+    for (size_t w = 0; w < kWriters; ++w) {
+        SignalBuffer* dest = graph.buffers[w % kBuffers];
+        for (size_t c = 0; c < kChannels; ++c) {
+            vectorAdd(dest->getChannel(c), graph.sources[w]->getChannel(c), kFrames);
+        }
+    }
+}
+
+// Overwrite-first: buffers are only marked silent, the first writer overwrites and later writers accumulate
+static void runOverwriteFirst(Graph& graph) {
+    for (auto* buffer : graph.buffers) {
+        buffer->zeroOut();
+    }
+    for (size_t w = 0; w < kWriters; ++w) {
+        SignalBuffer* dest = graph.buffers[w % kBuffers];
+        for (size_t c = 0; c < kChannels; ++c) {
+            if (dest->isChannelSilent(c)) {
+                vectorCopy(dest->getChannelForOverwrite(c, 0, kFrames), graph.sources[w]->getChannel(c), kFrames);
+            } else {
+                vectorAdd(dest->getChannel(c), graph.sources[w]->getChannel(c), kFrames);
+            }
+        }
+    }
+}
+
+typedef void (*GraphRunner)(Graph& graph);
+
+static double timeRunner(Graph& graph, GraphRunner runner) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        runner(graph);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    Graph before;
+    Graph after;
+
+    // Warm up
+    timeRunner(before, runZeroThenAccumulate);
+    timeRunner(after, runOverwriteFirst);
+
+    const double t_before = timeRunner(before, runZeroThenAccumulate);
+    const double t_after = timeRunner(after, runOverwriteFirst);
+
+    float max_diff = 0.f;
+    for (size_t b = 0; b < kBuffers; ++b) {
+        for (size_t c = 0; c < kChannels; ++c) {
+            for (size_t i = 0; i < kFrames; ++i) {
+                max_diff = std::max(max_diff, std::abs(before.buffers[b]->getChannel(c)[i] - after.buffers[b]->getChannel(c)[i]));
+            }
+        }
+    }
+
+    // Bytes moved per block. Accumulating reads the destination and the source and writes the destination;
+    // overwriting reads the source and writes the destination. Clearing writes every buffer once.
+    const double channel_bytes = static_cast<double>(kChannels * kFrames * sizeof(float));
+    const double bytes_before = kBuffers * channel_bytes + kWriters * 3.0 * channel_bytes;
+    const double bytes_after = kBuffers * 2.0 * channel_bytes + (kWriters - kBuffers) * 3.0 * channel_bytes;
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << kBuffers << " buffers, " << kWriters << " writers, " << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks" << std::endl;
+    std::cout << "Zero then accumulate: " << t_before * 1e3 << " ms, " << bytes_before / 1024.0 << " KiB/block, "
+              << bytes_before * kBlocks / t_before / (1024.0 * 1024.0 * 1024.0) << " GiB/s" << std::endl;
+    std::cout << "Overwrite first:      " << t_after * 1e3 << " ms, " << bytes_after / 1024.0 << " KiB/block, "
+              << bytes_after * kBlocks / t_after / (1024.0 * 1024.0 * 1024.0) << " GiB/s" << std::endl;
+    std::cout << "Traffic saved: " << (1.0 - bytes_after / bytes_before) * 100.0 << "%, speedup: " << t_before / t_after << "x" << std::endl;
+    std::cout << "Max difference between outputs: " << max_diff << std::endl;
+    return 0;
+}
@@ -0,0 +1,128 @@
+// Benchmark for the partitioned convolver: uniform and non-uniform layouts, with and without the threaded tail,
+// against direct time-domain convolution
+#include "dsp/convolution.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 256;
+static constexpr size_t kBlocks = 2000;
+static constexpr size_t kDirectBlocks = 20; // Direct convolution of a long response is far too slow for kBlocks
+static constexpr size_t kIRLength = 96000;   // 2 s at 48 kHz
+static constexpr float kSampleRate = 48000.f;
+
+template <typename Process>
+static double timeBlocks(size_t n_blocks, Process process) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < n_blocks; ++b) {
+        process(b);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    // Decaying noise, like a reverb response
+    std::vector<float> ir(kIRLength);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < kIRLength; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        ir[i] = (static_cast<float>(seed >> 8) / 8388608.f - 1.f) * std::exp(-6.f * static_cast<float>(i) / kIRLength);
+    }
+    const size_t n_input = kDirectBlocks * kFrames;
+    std::vector<float> input(kChannels * kBlocks * kFrames);
+    for (float& x : input) {
+        seed = seed * 1664525u + 1013904223u;
+        x = 0.5f * (static_cast<float>(seed >> 8) / 8388608.f - 1.f);
+    }
+
+    // Direct convolution, as the old time-domain Convolver did it (one dot product per output sample)
+    std::vector<float> history(kChannels * (kIRLength + n_input), 0.f);
+    std::vector<float> direct_output(kChannels * n_input);
+    const double t_direct = timeBlocks(kDirectBlocks, [&](size_t b) {
+        for (size_t c = 0; c < kChannels; ++c) {
+            float* channel_history = history.data() + c * (kIRLength + n_input);
+            for (size_t i = 0; i < kFrames; ++i) {
+                const size_t n = b * kFrames + i;
+                channel_history[kIRLength + n] = input[c * kBlocks * kFrames + n];
+                const float* x = channel_history + kIRLength + n;
+                float sum = 0.f;
+                for (size_t j = 0; j < kIRLength; ++j) {
+                    sum += ir[j] * x[-static_cast<ptrdiff_t>(j)];
+                }
+                direct_output[c * n_input + n] = sum;
+            }
+        }
+    });
+
+    std::vector<float> output(kChannels * kBlocks * kFrames);
+    auto processBlock = [&](Convolver& convolver, size_t b) {
+        const float* inputs[kChannels];
+        float* outputs[kChannels];
+        for (size_t c = 0; c < kChannels; ++c) {
+            inputs[c] = input.data() + c * kBlocks * kFrames + b * kFrames;
+            outputs[c] = output.data() + c * kBlocks * kFrames + b * kFrames;
+        }
+        convolver.process(inputs, outputs, kFrames);
+    };
+    auto runConvolver = [&](Convolver& convolver) {
+        return timeBlocks(kBlocks, [&](size_t b) { processBlock(convolver, b); });
+    };
+    // The worker gets one block of wall time per job, so the threaded convolver is fed in real time, as a host
+    // would; only the time spent in process counts
+    auto runConvolverRealTime = [&](Convolver& convolver) {
+        const auto period = std::chrono::duration<double>(kFrames / kSampleRate);
+        const auto start = std::chrono::steady_clock::now();
+        double busy = 0.0;
+        for (size_t b = 0; b < kBlocks; ++b) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(period * static_cast<double>(b)));
+            busy += timeBlocks(1, [&](size_t) { processBlock(convolver, b); });
+        }
+        return busy;
+    };
+    auto maxDifference = [&]() {
+        float max_diff = 0.f;
+        for (size_t c = 0; c < kChannels; ++c) {
+            for (size_t n = 0; n < n_input; ++n) {
+                max_diff = std::max(max_diff, std::abs(output[c * kBlocks * kFrames + n] - direct_output[c * n_input + n]));
+            }
+        }
+        return max_diff;
+    };
+
+    auto build_start = std::chrono::high_resolution_clock::now();
+    auto kernel = std::make_shared<ConvolutionKernel>(ir.data(), kIRLength);
+    const double t_build = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - build_start).count();
+    auto uniform_kernel = std::make_shared<ConvolutionKernel>(ir.data(), kIRLength, 256, true);
+
+    Convolver uniform(uniform_kernel, kChannels);
+    const double t_uniform = runConvolver(uniform);
+    const float diff_uniform = maxDifference();
+    Convolver non_uniform(kernel, kChannels);
+    const double t_non_uniform = runConvolver(non_uniform);
+    const float diff_non_uniform = maxDifference();
+    Convolver threaded(kernel, kChannels, true, kFrames);
+    const double t_threaded = runConvolverRealTime(threaded);
+    const float diff_threaded = maxDifference();
+
+    const double total_frames = static_cast<double>(kBlocks * kFrames);
+    const double realtime = total_frames / kSampleRate;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << kIRLength << "-tap response, " << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks" << std::endl;
+    std::cout << "  Stages (non-uniform): " << kernel->getNumStages() << ", built in " << t_build * 1e3 << " ms" << std::endl;
+    std::cout << "  Direct:                " << t_direct * 1e9 / (kDirectBlocks * kFrames) << " ns/frame (" << 100.0 * t_direct / (n_input / kSampleRate) << "% of real time)" << std::endl;
+    std::cout << "  Uniform (256):         " << t_uniform * 1e9 / total_frames << " ns/frame (" << 100.0 * t_uniform / realtime << "%)" << std::endl;
+    std::cout << "  Non-uniform:           " << t_non_uniform * 1e9 / total_frames << " ns/frame (" << 100.0 * t_non_uniform / realtime << "%)" << std::endl;
+    std::cout << "  Non-uniform, threaded: " << t_threaded * 1e9 / total_frames << " ns/frame on the audio thread (" << 100.0 * t_threaded / realtime << "%), "
+              << threaded.getNumOverruns() << " overruns" << std::endl;
+    std::cout << "  Max difference from direct: " << std::setprecision(8) << diff_uniform << " / " << diff_non_uniform << " / " << diff_threaded << std::endl;
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Benchmark for the convolution reverb: kernel sharing between instances, and the average and worst block cost of
+// a stereo reverb with and without the threaded tail
+#include "effect_chain.h"
+#include "effects/effect_convolution_reverb.h"
+#include "resource_manager.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 256;
+static constexpr size_t kBlocks = 750; // 4 s of audio, run in real time
+static constexpr size_t kInstances = 8;
+static constexpr float kSampleRate = 48000.f;
+static constexpr float kIRSeconds = 3.f;
+
+struct BlockTimes {
+    double total = 0.0;
+    double worst = 0.0;
+};
+
+// Blocks are started at the pace of a live stream, so the background thread gets the time it would have there
+static BlockTimes timeChain(EffectChain& chain) {
+    BlockTimes times;
+    const auto first_block = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<double> block_period(kFrames / kSampleRate);
+    for (size_t b = 0; b < kBlocks; ++b) {
+        std::this_thread::sleep_until(first_block + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(block_period * static_cast<double>(b)));
+        auto start = std::chrono::high_resolution_clock::now();
+        chain.beginBlock();
+        chain.processBlock(kFrames);
+        const double t = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        times.total += t;
+        times.worst = std::max(times.worst, t);
+    }
+    return times;
+}
+
+int main() {
+    ResourceManager resource_manager;
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.oversampling = 1;
+    context.max_n_frames = kFrames;
+    context.resource_manager = &resource_manager;
+    context.waveform_fft_manager = nullptr;
+
+    // Stereo decaying noise, like a hall response
+    const size_t ir_length = static_cast<size_t>(kIRSeconds * kSampleRate);
+    std::vector<float> ir(kChannels * ir_length);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < ir.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        const size_t frame = i % ir_length;
+        ir[i] = 0.1f * (static_cast<float>(seed >> 8) / 8388608.f - 1.f) * std::exp(-7.f * static_cast<float>(frame) / ir_length);
+    }
+    const float* ir_channels[kChannels] = { ir.data(), ir.data() + ir_length };
+    const ResourceID ir_id = resource_manager.createSample(ir_channels, kChannels, ir_length, kSampleRate);
+
+    SignalBuffer input(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    SignalBuffer output(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    for (size_t c = 0; c < kChannels; ++c) {
+        float* data = input.getChannel(c);
+        for (size_t i = 0; i < kFrames; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            data[i] = 0.5f * (static_cast<float>(seed >> 8) / 8388608.f - 1.f);
+        }
+    }
+
+    // The first instance builds the kernels, the others share them
+    std::vector<EffectChain*> chains;
+    std::vector<double> setup_times;
+    for (size_t k = 0; k < kInstances; ++k) {
+        auto start = std::chrono::high_resolution_clock::now();
+        EffectChain* chain = new EffectChain(&context, kChannels, static_cast<EffectChainIndex>(k));
+        chain->addEffectConvolutionReverbJSON("{\"ir\": " + std::to_string(ir_id) + ", \"dry\": 1.0, \"wet\": 0.5, \"threaded\": " + ((k == 1) ? "true" : "false") + "}");
+        chain->setIO(&input, &output);
+        chain->connectEffects();
+        chain->setSampleRate(kSampleRate);
+        setup_times.push_back(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+        chains.push_back(chain);
+    }
+
+    const BlockTimes foreground = timeChain(*chains[0]);
+    const BlockTimes threaded = timeChain(*chains[1]);
+
+    const double total_frames = static_cast<double>(kBlocks * kFrames);
+    const double block_seconds = kFrames / kSampleRate;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << kIRSeconds << " s stereo IR, " << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks" << std::endl;
+    std::cout << "  Setup, first instance:  " << setup_times[0] * 1e3 << " ms (builds the kernels)" << std::endl;
+    double shared_setup = 0.0;
+    for (size_t k = 1; k < kInstances; ++k) {
+        shared_setup += setup_times[k];
+    }
+    std::cout << "  Setup, other instances: " << shared_setup * 1e3 / (kInstances - 1) << " ms each (shared kernels)" << std::endl;
+    std::cout << "  Foreground: " << foreground.total * 1e9 / total_frames << " ns/frame, worst block "
+              << 100.0 * foreground.worst / block_seconds << "% of its real time" << std::endl;
+    std::cout << "  Threaded:   " << threaded.total * 1e9 / total_frames << " ns/frame, worst block "
+              << 100.0 * threaded.worst / block_seconds << "% of its real time" << std::endl;
+
+    for (EffectChain* chain : chains) {
+        delete chain;
+    }
+    return 0;
+}
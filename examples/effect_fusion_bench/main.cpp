@@ -0,0 +1,113 @@
+// Benchmark for fused effect runs: the same chains processed with and without fusion
+#include "effect_chain.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 1024;
+static constexpr size_t kBlocks = 2000;
+static constexpr double kSampleRate = 96000.0;
+
+// Runs the chain for kBlocks blocks and returns the time in seconds. The last block is left in the chain output.
+static double runChain(EffectChain& chain) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        chain.beginBlock();
+        chain.zeroOutModulationBuffers();
+        chain.processBlock(kFrames);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Adds the effects of one benchmark scenario to a chain
+typedef void (*ScenarioBuilder)(EffectChain& chain);
+
+static void buildSaturatorClipper(EffectChain& chain) {
+    chain.addEffectDistortionJSON("{\"type\": \"soft\", \"drive\": 2.0, \"mix\": 1.0, \"output_gain\": 0.5}");
+    chain.addEffectDistortionJSON("{\"type\": \"hard\", \"drive\": 1.5, \"mix\": 1.0, \"output_gain\": 0.9}");
+}
+
+static void buildClipperStack(EffectChain& chain) {
+    chain.addEffectDistortionJSON("{\"type\": \"hard\", \"drive\": 2.0, \"mix\": 0.8, \"output_gain\": 0.7}");
+    chain.addEffectDistortionJSON("{\"type\": \"hard\", \"drive\": 1.5, \"mix\": 1.0, \"output_gain\": 0.9}");
+    chain.addEffectDistortionJSON("{\"type\": \"hard\", \"drive\": 1.2, \"mix\": 0.5, \"output_gain\": 1.0}");
+}
+
+static void buildFilterSaturator(EffectChain& chain) {
+    chain.addEffectFilterJSON("{\"filter_object_type\": \"ZDF\", \"frequency\": 2000.0, \"resonance\": 0.3}");
+    chain.addEffectDistortionJSON("{\"type\": \"soft\", \"drive\": 2.0, \"mix\": 1.0, \"output_gain\": 0.5}");
+}
+
+static void runScenario(Context& context, SignalBuffer& input, const char* name, ScenarioBuilder builder) {
+    SignalBuffer output_unfused(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    SignalBuffer output_fused(SignalBuffer::EType::kAudio, kFrames, kChannels);
+
+    EffectChain unfused(&context, kChannels, 0);
+    builder(unfused);
+    unfused.setIO(&input, &output_unfused);
+    unfused.connectEffects();
+    unfused.setSampleRate(static_cast<float>(kSampleRate));
+    unfused.setFusionEnabled(false);
+
+    EffectChain fused(&context, kChannels, 1);
+    builder(fused);
+    fused.setIO(&input, &output_fused);
+    fused.connectEffects();
+    fused.setSampleRate(static_cast<float>(kSampleRate));
+    fused.setFusionEnabled(true);
+
+    const double t_unfused = runChain(unfused);
+    const double t_fused = runChain(fused);
+
+    // Both paths run the same per-sample code, so the results should match exactly
+    float max_diff = 0.f;
+    for (size_t c = 0; c < kChannels; ++c) {
+        for (size_t i = 0; i < kFrames; ++i) {
+            max_diff = std::max(max_diff, std::abs(output_unfused.getChannel(c)[i] - output_fused.getChannel(c)[i]));
+        }
+    }
+
+    // Unfused, every stage boundary inside the run is one full-block write and one full-block read
+    const size_t n_stages = unfused.getNumEffects();
+    const double bytes_per_block = static_cast<double>((n_stages - 1) * 2 * kChannels * kFrames * sizeof(float));
+    const double total_samples = static_cast<double>(kBlocks * kFrames * kChannels);
+
+    std::cout << name << " (" << n_stages << " stages)" << std::endl;
+    std::cout << "  Unfused: " << t_unfused * 1e3 << " ms (" << t_unfused * 1e9 / total_samples << " ns/sample)" << std::endl;
+    std::cout << "  Fused:   " << t_fused * 1e3 << " ms (" << t_fused * 1e9 / total_samples << " ns/sample)" << std::endl;
+    std::cout << "  Speedup: " << t_unfused / t_fused << "x" << std::endl;
+    std::cout << "  Intermediate traffic avoided: " << bytes_per_block / 1024.0 << " KiB/block, "
+              << bytes_per_block * kBlocks / t_unfused / (1024.0 * 1024.0 * 1024.0) << " GiB/s at the unfused rate" << std::endl;
+    std::cout << "  Max difference between outputs: " << max_diff << std::endl;
+}
+
+int main() {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.oversampling = 1;
+    context.max_n_frames = kFrames;
+    context.resource_manager = nullptr;
+    context.waveform_fft_manager = nullptr;
+
+    SignalBuffer input(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    for (size_t c = 0; c < kChannels; ++c) {
+        float* data = input.getChannel(c);
+        for (size_t i = 0; i < kFrames; ++i) {
+            data[i] = 0.8f * std::sin(2.f * 3.14159265f * 220.f * static_cast<float>(i) / static_cast<float>(kSampleRate));
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks" << std::endl;
+    runScenario(context, input, "Soft distortion -> hard clipper", buildSaturatorClipper);
+    runScenario(context, input, "Hard clipper x3", buildClipperStack);
+    runScenario(context, input, "ZDF low-pass -> soft distortion", buildFilterSaturator);
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Benchmark for the parametric EQ: a 10-band stereo EQ in an effect chain against one scalar biquad per band and channel
+#include "effect_chain.h"
+#include "effects/effect_eq.h"
+#include "dsp/biquad.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 512;
+static constexpr size_t kBlocks = 4000;
+static constexpr size_t kBands = 10;
+static constexpr float kSampleRate = 48000.f;
+
+static const char* kBandTypes[kBands] = { "highpass", "lowshelf", "peak", "peak", "peak", "peak", "peak", "peak", "highshelf", "lowpass" };
+static const float kBandFrequencies[kBands] = { 30.f, 120.f, 250.f, 500.f, 1000.f, 2000.f, 3500.f, 6000.f, 9000.f, 18000.f };
+static const float kBandGains[kBands] = { 0.f, 3.f, -2.f, 1.5f, -4.f, 2.f, -1.f, 3.f, -3.f, 0.f };
+
+static std::string bandsJSON(bool flat) {
+    std::string json = "{\"bands\": [";
+    for (size_t b = 0; b < kBands; ++b) {
+        // Flat: every band a 0 dB peak
+        json += std::string((b > 0) ? ", " : "") + "{\"type\": \"" + ((flat) ? "peak" : kBandTypes[b]) + "\", \"frequency\": "
+                + std::to_string(kBandFrequencies[b]) + ", \"q\": 0.9, \"gain\": " + std::to_string((flat) ? 0.f : kBandGains[b]) + "}";
+    }
+    return json + "]}";
+}
+
+template <typename Process>
+static double timeBlocks(Process process) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        process();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.oversampling = 1;
+    context.max_n_frames = kFrames;
+    context.resource_manager = nullptr;
+    context.waveform_fft_manager = nullptr;
+
+    SignalBuffer input(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    SignalBuffer output(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    SignalBuffer reference_output(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    uint32_t seed = 1;
+    for (size_t c = 0; c < kChannels; ++c) {
+        float* data = input.getChannel(c);
+        for (size_t i = 0; i < kFrames; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            data[i] = 0.5f * (static_cast<float>(seed >> 8) / 8388608.f - 1.f);
+        }
+    }
+
+    // Scalar reference: one BiquadFilter per band and channel
+    BiquadFilter reference[kChannels][kBands];
+    for (size_t c = 0; c < kChannels; ++c) {
+        for (size_t b = 0; b < kBands; ++b) {
+            BiquadFilter::EFilterType type;
+            BiquadFilter::getFilterTypeFromString(kBandTypes[b], type);
+            reference[c][b].setSampleRate(kSampleRate);
+            reference[c][b].setFilterType(type);
+            reference[c][b].setCutoffFrequency(kBandFrequencies[b]);
+            reference[c][b].setQFactor(0.9f);
+            reference[c][b].setGain(kBandGains[b]);
+        }
+    }
+    auto runReference = [&]() {
+        for (size_t c = 0; c < kChannels; ++c) {
+            const float* in = input.getChannel(c);
+            float* out = reference_output.getChannel(c);
+            for (size_t i = 0; i < kFrames; ++i) {
+                float x = in[i];
+                for (size_t b = 0; b < kBands; ++b) {
+                    x = reference[c][b].tick(x);
+                }
+                out[i] = x;
+            }
+        }
+    };
+
+    EffectChain chain(&context, kChannels, 0);
+    chain.addEffectEQJSON(bandsJSON(false));
+    chain.setIO(&input, &output);
+    chain.connectEffects();
+    chain.setSampleRate(kSampleRate);
+    auto runChain = [&](EffectChain& c) {
+        c.beginBlock();
+        c.processBlock(kFrames);
+    };
+
+    // Same input every block, so the last outputs compare directly
+    const double t_reference = timeBlocks(runReference);
+    const double t_chain = timeBlocks([&]() { runChain(chain); });
+
+    float max_diff = 0.f;
+    for (size_t c = 0; c < kChannels; ++c) {
+        for (size_t i = 0; i < kFrames; ++i) {
+            max_diff = std::max(max_diff, std::abs(output.getChannel(c)[i] - reference_output.getChannel(c)[i]));
+        }
+    }
+
+    EffectChain flat_chain(&context, kChannels, 1);
+    flat_chain.addEffectEQJSON(bandsJSON(true));
+    flat_chain.setIO(&input, &output);
+    flat_chain.connectEffects();
+    flat_chain.setSampleRate(kSampleRate);
+    const double t_flat = timeBlocks([&]() { runChain(flat_chain); });
+
+    // Moving one band every block keeps a section ramping
+    EQEffect* eq = static_cast<EQEffect*>(chain.getEffectByIndex(0));
+    size_t block = 0;
+    const double t_ramping = timeBlocks([&]() {
+        EQEffect::Band band = eq->getBand(4);
+        band.gain_db = (block++ % 2 == 0) ? -6.f : 6.f;
+        eq->setBand(4, band);
+        runChain(chain);
+    });
+
+    const double total_frames = static_cast<double>(kBlocks * kFrames);
+    const double realtime = total_frames / kSampleRate;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << kBands << "-band EQ, " << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks" << std::endl;
+    std::cout << "  Scalar biquads:      " << t_reference * 1e9 / total_frames << " ns/frame (" << std::setprecision(3) << 100.0 * t_reference / realtime << "% of real time at 48 kHz)" << std::setprecision(2) << std::endl;
+    std::cout << "  EQ effect:           " << t_chain * 1e9 / total_frames << " ns/frame (" << std::setprecision(3) << 100.0 * t_chain / realtime << "%), " << std::setprecision(2) << t_reference / t_chain << "x" << std::endl;
+    std::cout << "  EQ effect, ramping:  " << t_ramping * 1e9 / total_frames << " ns/frame" << std::endl;
+    std::cout << "  EQ effect, all 0 dB: " << t_flat * 1e9 / total_frames << " ns/frame" << std::endl;
+    std::cout << "  Max difference from scalar biquads: " << std::setprecision(8) << max_diff << std::endl;
+    return 0;
+}
@@ -0,0 +1,156 @@
+// Benchmark for the FDN reverb at 96 kHz: 8 and 16 lines with either matrix, against a scalar network with modulo
+// delay lines, plus a check of the decay time on the impulse response
+#include "effect_chain.h"
+#include "effects/effect_fdn_reverb.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 256;
+static constexpr size_t kBlocks = 4000;
+static constexpr float kSampleRate = 96000.f;
+static constexpr float kDecay = 2.f;
+
+template <typename Process>
+static double timeBlocks(Process process) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        process();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Scalar 8-line Householder network: one sample at a time, modulo on every delay access
+struct ScalarFDN {
+    static constexpr size_t kLines = 8;
+    std::vector<float> buffers[kLines];
+    size_t lengths[kLines];
+    size_t positions[kLines] = {};
+    float gains[kLines];
+    float states[kLines] = {};
+
+    ScalarFDN() {
+        for (size_t l = 0; l < kLines; ++l) {
+            lengths[l] = static_cast<size_t>(0.029f * std::pow(3.f, static_cast<float>(l) / kLines) * kSampleRate);
+            buffers[l].assign(lengths[l], 0.f);
+            gains[l] = std::pow(10.f, -3.f * lengths[l] / (kSampleRate * kDecay));
+        }
+    }
+
+    void process(const float* const* in, float* const* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            float x[kLines];
+            float sum = 0.f;
+            for (size_t l = 0; l < kLines; ++l) {
+                x[l] = buffers[l][positions[l] % lengths[l]];
+                states[l] = gains[l] * (0.7f * x[l] + 0.3f * states[l]);
+                sum += states[l];
+            }
+            out[0][i] = x[0] - x[2] + x[4] - x[6];
+            out[1][i] = x[1] - x[3] + x[5] - x[7];
+            for (size_t l = 0; l < kLines; ++l) {
+                buffers[l][positions[l] % lengths[l]] = states[l] - 0.25f * sum + in[l % 2][i];
+                positions[l] = (positions[l] + 1) % lengths[l];
+            }
+        }
+    }
+};
+
+int main() {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.oversampling = 1;
+    context.max_n_frames = kFrames;
+    context.control_rate_division = 32;
+    context.resource_manager = nullptr;
+    context.waveform_fft_manager = nullptr;
+
+    SignalBuffer input(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    SignalBuffer output(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    uint32_t seed = 1;
+    for (size_t c = 0; c < kChannels; ++c) {
+        float* data = input.getChannel(c);
+        for (size_t i = 0; i < kFrames; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            data[i] = 0.5f * (static_cast<float>(seed >> 8) / 8388608.f - 1.f);
+        }
+    }
+
+    const double total_frames = static_cast<double>(kBlocks * kFrames);
+    const double realtime = total_frames / kSampleRate;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "FDN reverb, " << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks at 96 kHz" << std::endl;
+
+    ScalarFDN scalar;
+    const float* scalar_in[kChannels] = { input.getChannel(0), input.getChannel(1) };
+    float* scalar_out[kChannels] = { output.getChannel(0), output.getChannel(1) };
+    const double t_scalar = timeBlocks([&]() { scalar.process(scalar_in, scalar_out, kFrames); });
+    std::cout << "  Scalar, 8 lines, modulo:  " << t_scalar * 1e9 / total_frames << " ns/frame (" << 100.0 * t_scalar / realtime << "% of a core)" << std::endl;
+
+    for (size_t n_lines : { 8, 16 }) {
+        for (const char* matrix : { "householder", "hadamard" }) {
+            EffectChain chain(&context, kChannels, 0);
+            chain.addEffectFDNReverbJSON(std::string("{\"lines\": ") + std::to_string(n_lines) + ", \"matrix\": \"" + matrix + "\", \"decay\": 2.0, \"mix\": 0.5}");
+            chain.setIO(&input, &output);
+            chain.connectEffects();
+            chain.setSampleRate(kSampleRate);
+            FDNReverbEffect* reverb = static_cast<FDNReverbEffect*>(chain.getEffectByIndex(0));
+
+            const double t = timeBlocks([&]() {
+                chain.beginBlock();
+                chain.processBlock(kFrames);
+            });
+
+            // Moving the size every block keeps every line gliding
+            size_t block = 0;
+            const double t_moving = timeBlocks([&]() {
+                reverb->setSize((block++ % 2 == 0) ? 0.9f : 1.1f);
+                chain.beginBlock();
+                chain.processBlock(kFrames);
+            });
+            reverb->setSize(1.f);
+
+            // Decay check: energy of the impulse response 0.1 s in, against kDecay later
+            EffectChain impulse_chain(&context, kChannels, 1);
+            impulse_chain.addEffectFDNReverbJSON(std::string("{\"lines\": ") + std::to_string(n_lines) + ", \"matrix\": \"" + matrix + "\", \"decay\": 2.0, \"damping\": 0.0, \"mix\": 1.0}");
+            SignalBuffer impulse(SignalBuffer::EType::kAudio, kFrames, kChannels);
+            impulse_chain.setIO(&impulse, &impulse);
+            impulse_chain.connectEffects();
+            impulse_chain.setSampleRate(kSampleRate);
+            const size_t window_blocks = static_cast<size_t>(0.1f * kSampleRate / kFrames);
+            const size_t decay_blocks = static_cast<size_t>(kDecay * kSampleRate / kFrames);
+            double early = 0.0, late = 0.0;
+            for (size_t b = 0; b < 2 * window_blocks + decay_blocks; ++b) {
+                for (size_t c = 0; c < kChannels; ++c) {
+                    std::fill(impulse.getChannel(c), impulse.getChannel(c) + kFrames, 0.f);
+                    impulse.getChannel(c)[0] = (b == 0) ? 1.f : 0.f;
+                }
+                impulse_chain.beginBlock();
+                impulse_chain.processBlock(kFrames);
+                double energy = 0.0;
+                for (size_t i = 0; i < kFrames; ++i) {
+                    energy += impulse.getChannel(0)[i] * impulse.getChannel(0)[i];
+                }
+                if (b >= window_blocks && b < 2 * window_blocks) {
+                    early += energy;
+                } else if (b >= window_blocks + decay_blocks) {
+                    late += energy;
+                }
+            }
+
+            std::cout << "  " << std::setw(2) << n_lines << " lines, " << std::setw(11) << matrix << ": " << t * 1e9 / total_frames << " ns/frame ("
+                      << 100.0 * t / realtime << "% of a core), " << t_moving * 1e9 / total_frames << " ns/frame with the size moving, decay over "
+                      << kDecay << " s: " << 10.0 * std::log10(late / early) << " dB" << std::endl;
+        }
+    }
+    return 0;
+}
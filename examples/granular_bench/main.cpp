@@ -0,0 +1,135 @@
+// Benchmark and accuracy check for the granular oscillator: one grain against an exact windowed and resampled
+// sine, then the cost of a block against the number of grains playing at once.
+#include "oscillators/granular_osc.h"
+#include "resource_manager.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 512;
+static constexpr size_t kBlocks = 2000;
+static constexpr float kSampleRate = 48000.f;
+static constexpr float kSourceRate = 44100.f;
+static constexpr float kRootNote = 60.f;
+static constexpr float kNote = 67.f;
+static constexpr double kSourceHz = 440.0;
+
+struct Setup {
+    Context context;
+    ResourceID sample_id;
+
+    Setup() {
+        context.sample_rate = kSampleRate;
+        context.max_n_frames = kFrames;
+        context.resource_manager = new ResourceManager();
+        const double two_pi = 6.28318530717958647692;
+        std::vector<float> source(static_cast<size_t>(kSourceRate) * 10);
+        for (size_t i = 0; i < source.size(); ++i) {
+            source[i] = static_cast<float>(std::sin(two_pi * kSourceHz * static_cast<double>(i) / kSourceRate));
+        }
+        const float* channels[1] = { source.data() };
+        sample_id = context.resource_manager->createSample(channels, 1, source.size(), kSourceRate);
+        context.resource_manager->getSample(sample_id)->setRootNote(kRootNote);
+    }
+    ~Setup() { delete context.resource_manager; }
+};
+
+// One Hann grain started on the first frame, against the exact grain
+static double grainError() {
+    Setup setup;
+    GranularOscillator osc(&setup.context, 0, setup.sample_id, 1, 1.f);
+    osc.setSampleRate(kSampleRate);
+    osc.setOverwriteOutput(true);
+    const float grain_ms = 100.f;
+    osc.setGrainSize(grain_ms);
+    osc.setDensity(1.f);
+    osc.setPosition(0.25f);
+    osc.onRetrigger();
+
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, GranularOscillator::kNumModChannels);
+    mod_inputs.setChannelConstant(0, kNote);
+    for (size_t c = 1; c < GranularOscillator::kNumModChannels; ++c) {
+        mod_inputs.setChannelSilent(c);
+    }
+    SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, 1);
+
+    const double two_pi = 6.28318530717958647692;
+    const double grain_frames = grain_ms * 0.001 * kSampleRate;
+    const double increment = std::pow(2.0, (kNote - kRootNote) / 12.0) * kSourceRate / kSampleRate;
+    const double start = 0.25 * static_cast<double>(kSourceRate) * 10.0;
+    double error = 0.0;
+    double signal = 0.0;
+    for (size_t b = 0; b * kFrames < grain_frames; ++b) {
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+        for (size_t i = 0; i < kFrames; ++i) {
+            const double t = static_cast<double>(b * kFrames + i);
+            const double window = (t < grain_frames) ? 0.5 - 0.5 * std::cos(two_pi * t / grain_frames) : 0.0;
+            const double reference = window * std::sin(two_pi * kSourceHz * (start + t * increment) / kSourceRate);
+            const double difference = outputs.getElement(0, i) - reference;
+            error += difference * difference;
+            signal += reference * reference;
+        }
+    }
+    return 10.0 * std::log10(error / signal);
+}
+
+// Seconds to render kBlocks blocks with about n_grains grains playing
+static double run(size_t n_grains, size_t& active) {
+    Setup setup;
+    GranularOscillator osc(&setup.context, 0, setup.sample_id, kChannels, 1.f);
+    osc.setSampleRate(kSampleRate);
+    osc.setOverwriteOutput(true);
+    const float grain_ms = 200.f;
+    osc.setGrainSize(grain_ms);
+    osc.setDensity(static_cast<float>(n_grains) * 1000.f / grain_ms);
+    osc.setMaxGrains(n_grains);
+    osc.setPosition(0.5f);
+    osc.setSpray(2.f);
+    osc.setStereoSpread(1.f);
+    osc.onRetrigger();
+
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, GranularOscillator::kNumModChannels);
+    mod_inputs.setChannelConstant(0, kNote);
+    for (size_t c = 1; c < GranularOscillator::kNumModChannels; ++c) {
+        mod_inputs.setChannelSilent(c);
+    }
+    SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, kChannels);
+
+    // Let the grain pool fill up
+    for (size_t b = 0; b < 40; ++b) {
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+    }
+    active = osc.getActiveGrains();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "One grain of a " << kSourceHz << " Hz sine, a fifth up: error " << grainError() << " dB" << std::endl;
+
+    const double audio_seconds = static_cast<double>(kBlocks * kFrames) / kSampleRate;
+    for (size_t n_grains : { 16, 64, 128, 256 }) {
+        size_t active = 0;
+        const double seconds = run(n_grains, active);
+        const double grain_frames = static_cast<double>(active) * static_cast<double>(kBlocks * kFrames);
+        std::cout << std::setw(4) << n_grains << " grain cap: " << std::setw(3) << active << " playing, "
+                  << std::setprecision(2) << seconds * 1e9 / grain_frames << " ns per grain frame, " << std::setprecision(1)
+                  << audio_seconds / seconds << "x real time" << std::endl;
+    }
+    return 0;
+}
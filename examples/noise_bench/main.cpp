@@ -0,0 +1,142 @@
+// Benchmark and checks for the noise oscillator: speed of each colour against a rand() loop, the spectral slope
+// of pink noise, and that the output does not depend on the block size.
+#include "oscillators/noise_osc.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kFrames = 512;
+static constexpr size_t kBlocks = 20000;
+static constexpr float kSampleRate = 48000.f;
+
+static Context makeContext() {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.max_n_frames = kFrames;
+    return context;
+}
+
+// Render n_total frames of one channel in blocks of block_frames
+static std::vector<float> render(NoiseOscillator::EColor color, size_t n_total, size_t block_frames) {
+    Context context = makeContext();
+    NoiseOscillator osc(&context, 7, color, 1, 1.f, 3);
+    osc.setSampleRate(kSampleRate);
+    osc.setOverwriteOutput(true);
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, 2);
+    mod_inputs.setChannelConstant(0, 81.f);
+    mod_inputs.setChannelSilent(1);
+    SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, 1);
+
+    std::vector<float> result;
+    while (result.size() < n_total) {
+        const size_t n = std::min(block_frames, n_total - result.size());
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, n);
+        for (size_t i = 0; i < n; ++i) {
+            result.push_back(outputs.getElement(0, i));
+        }
+    }
+    return result;
+}
+
+// Average power around frequency hz, from Goertzel filters over 4096-frame segments
+static double bandPower(const std::vector<float>& x, double hz) {
+    const size_t segment = 4096;
+    const double coefficient = 2.0 * std::cos(2.0 * 3.14159265358979 * hz / kSampleRate);
+    double power = 0.0;
+    size_t n_segments = 0;
+    for (size_t start = 0; start + segment <= x.size(); start += segment, ++n_segments) {
+        double s1 = 0.0, s2 = 0.0;
+        for (size_t i = 0; i < segment; ++i) {
+            // Hann window keeps the estimate local
+            const double w = 0.5 - 0.5 * std::cos(2.0 * 3.14159265358979 * static_cast<double>(i) / segment);
+            const double s0 = x[start + i] * w + coefficient * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+        power += s1 * s1 + s2 * s2 - coefficient * s1 * s2;
+    }
+    return power / static_cast<double>(n_segments);
+}
+
+static double timeColor(NoiseOscillator::EColor color) {
+    Context context = makeContext();
+    NoiseOscillator osc(&context, 7, color, 2, 1.f, 0);
+    osc.setSampleRate(kSampleRate);
+    osc.setOverwriteOutput(true);
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, 2);
+    mod_inputs.setChannelConstant(0, 69.f);
+    mod_inputs.setChannelSilent(1);
+    SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, 2);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    const double n_samples = static_cast<double>(kBlocks * kFrames * 2);
+    std::vector<float> scratch(kFrames * 2);
+    float sink = 0.f;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        for (size_t i = 0; i < kFrames * 2; ++i) {
+            scratch[i] = static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.f - 1.f;
+        }
+        sink += scratch[b % scratch.size()];
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const double rand_seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "rand() loop:  " << rand_seconds * 1e9 / n_samples << " ns per sample (" << sink * 0.f << ")" << std::endl;
+    const struct {
+        NoiseOscillator::EColor color;
+        const char* name;
+    } colors[] = {
+        { NoiseOscillator::EColor::kWhite, "white" },
+        { NoiseOscillator::EColor::kPink, "pink " },
+        { NoiseOscillator::EColor::kBand, "band " },
+    };
+    for (const auto& c : colors) {
+        std::cout << c.name << " noise:  " << timeColor(c.color) * 1e9 / n_samples << " ns per sample" << std::endl;
+    }
+
+    // The same stream whatever the block size
+    bool same = true;
+    for (const auto& c : colors) {
+        const std::vector<float> a = render(c.color, 48000, 512);
+        const std::vector<float> b = render(c.color, 48000, 37);
+        same = same && (a == b);
+    }
+    std::cout << "Blocks of 512 and of 37 frames give " << (same ? "identical" : "DIFFERENT") << " output" << std::endl;
+
+    const std::vector<float> pink = render(NoiseOscillator::EColor::kPink, 48000 * 20, 512);
+    std::cout << "Pink noise, power relative to 100 Hz (-3 dB per octave expected):" << std::endl;
+    const double reference = bandPower(pink, 100.0);
+    for (double hz : { 200.0, 400.0, 800.0, 1600.0, 3200.0, 6400.0, 12800.0 }) {
+        std::cout << "  " << std::setw(7) << std::setprecision(0) << hz << " Hz: " << std::setprecision(1)
+                  << 10.0 * std::log10(bandPower(pink, hz) / reference) << " dB" << std::endl;
+    }
+
+    const std::vector<float> band = render(NoiseOscillator::EColor::kBand, 48000 * 5, 512);
+    const std::vector<float> white = render(NoiseOscillator::EColor::kWhite, 48000 * 5, 512);
+    double band_power = 0.0, white_power = 0.0;
+    for (size_t i = 0; i < band.size(); ++i) {
+        band_power += static_cast<double>(band[i]) * band[i];
+        white_power += static_cast<double>(white[i]) * white[i];
+    }
+    std::cout << "Band noise at 880 Hz, one octave: " << std::setprecision(1) << 10.0 * std::log10(band_power / white_power)
+              << " dB relative to white" << std::endl;
+    return 0;
+}
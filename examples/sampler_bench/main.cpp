@@ -0,0 +1,116 @@
+// Benchmark and accuracy check for the sampler oscillator: a 44.1 kHz sine sample played at 48 kHz, a fifth above
+// its root, with each resampling quality. The error is measured against the exact resampled sine.
+#include "oscillators/sampler_osc.h"
+#include "resource_manager.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 512;
+static constexpr size_t kBlocks = 2000;
+static constexpr float kSampleRate = 48000.f;
+static constexpr float kSourceRate = 44100.f;
+static constexpr float kRootNote = 60.f;
+static constexpr float kNote = 67.f;
+
+struct Result {
+    double seconds;
+    double error_db; // RMS error relative to the RMS of the signal
+};
+
+static Result run(SamplerOscillator::EQuality quality, double source_hz) {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.max_n_frames = kFrames;
+    context.resource_manager = new ResourceManager();
+
+    // Ten seconds of sine, looped over a whole number of cycles so playback never stops
+    const double two_pi = 6.28318530717958647692;
+    const size_t n_sample_frames = static_cast<size_t>(kSourceRate) * 10;
+    std::vector<float> source(n_sample_frames);
+    for (size_t i = 0; i < n_sample_frames; ++i) {
+        source[i] = static_cast<float>(std::sin(two_pi * source_hz * static_cast<double>(i) / kSourceRate));
+    }
+    const float* channels[1] = { source.data() };
+    const ResourceID sample_id = context.resource_manager->createSample(channels, 1, n_sample_frames, kSourceRate);
+    SampleResource* sample = context.resource_manager->getSample(sample_id);
+    sample->setRootNote(kRootNote);
+    const size_t loop_cycles = static_cast<size_t>(static_cast<double>(n_sample_frames - 1000) * source_hz / kSourceRate);
+    const size_t loop_end = 1000 + static_cast<size_t>(std::round(static_cast<double>(loop_cycles) * kSourceRate / source_hz));
+    sample->setLoop(1000, loop_end);
+
+    SamplerOscillator osc(&context, 0, sample_id, kChannels, 1.f);
+    osc.setSampleRate(kSampleRate);
+    osc.setOverwriteOutput(true);
+    osc.setQuality(quality);
+    osc.onRetrigger();
+
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, 2);
+    mod_inputs.setChannelConstant(0, kNote);
+    mod_inputs.setChannelSilent(1);
+    SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, kChannels);
+
+    // The oscillator's own increment, so only the interpolation differs from the reference
+    const double increment = static_cast<double>(std::pow(2.f, (kNote - kRootNote) / 12.f) * (kSourceRate / kSampleRate));
+    double error = 0.0;
+    double signal = 0.0;
+    for (size_t b = 0; b < 20; ++b) {
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+        for (size_t i = 0; i < kFrames; ++i) {
+            const size_t frame = b * kFrames + i;
+            if (frame < 64) {
+                continue; // The sample starts from silence
+            }
+            const double reference = std::sin(two_pi * source_hz * static_cast<double>(frame) * increment / kSourceRate);
+            const double difference = outputs.getElement(0, i) - reference;
+            error += difference * difference;
+            signal += reference * reference;
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    delete context.resource_manager;
+    return { std::chrono::duration<double>(end - start).count(), 10.0 * std::log10(error / signal) };
+}
+
+int main() {
+    const double audio_seconds = static_cast<double>(kBlocks * kFrames) / kSampleRate;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Mono sample at " << kSourceRate << " Hz played a fifth up at " << kSampleRate << " Hz, " << kChannels
+              << " output channels" << std::endl;
+    const struct {
+        SamplerOscillator::EQuality quality;
+        const char* name;
+    } qualities[] = {
+        { SamplerOscillator::EQuality::kCubic, "cubic" },
+        { SamplerOscillator::EQuality::kHermite, "hermite" },
+        { SamplerOscillator::EQuality::kSinc, "sinc" },
+    };
+    for (const auto& q : qualities) {
+        std::cout << q.name << std::endl;
+        for (double source_hz : { 1000.0, 5000.0, 12000.0 }) {
+            const Result result = run(q.quality, source_hz);
+            std::cout << "  " << std::setw(5) << std::setprecision(0) << source_hz << " Hz source: error " << std::setprecision(1)
+                      << result.error_db << " dB";
+            if (source_hz == 1000.0) {
+                std::cout << ", " << std::setprecision(0) << audio_seconds / result.seconds << " voices in real time";
+            }
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Benchmark and accuracy check for the SIMD sine oscillator: the per-sample std::pow/std::fmod/std::sin loop it
+// replaced, against SineOscillator, for a held note (flat pitch) and a glide (audio-rate pitch)
+#include "oscillators/sine_osc.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 1024; // 512 frames at 2x oversampling
+static constexpr size_t kBlocks = 20000;
+static constexpr float kSampleRate = 96000.f;
+static constexpr float kAmplitude = 0.5f;
+
+// Previous kernel: every channel computes its own phase with std::pow, std::fmod and std::sin per sample
+struct ScalarSine {
+    float phase[kChannels] = {};
+    void process(const float* pitch, float* const* outputs, size_t n_frames) {
+        constexpr float kTwoPi = 6.28318530717958647692f;
+        for (size_t c = 0; c < kChannels; ++c) {
+            for (size_t i = 0; i < n_frames; ++i) {
+                const float hz = 440.0f * std::pow(2.0f, (pitch[i] - 69.f) / 12.0f);
+                phase[c] += kTwoPi * hz / kSampleRate;
+                phase[c] = std::fmod(phase[c], kTwoPi);
+                outputs[c][i] = kAmplitude * std::sin(phase[c]);
+            }
+        }
+    }
+};
+
+// Exact reference: double precision phase and sine
+struct ReferenceSine {
+    double phase = 0.0;
+    void process(const float* pitch, float* output, size_t n_frames) {
+        for (size_t i = 0; i < n_frames; ++i) {
+            phase += 440.0 * std::pow(2.0, (static_cast<double>(pitch[i]) - 69.0) / 12.0) / kSampleRate;
+            phase -= std::floor(phase);
+            output[i] = static_cast<float>(kAmplitude * std::sin(6.28318530717958647692 * phase));
+        }
+    }
+};
+
+struct Result {
+    double t_scalar;
+    double t_simd;
+    float scalar_error; // Max difference from the double precision reference
+    float simd_error;
+};
+
+static Result run(bool glide) {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.max_n_frames = kFrames;
+    SineOscillator osc(&context, 0, kChannels, kAmplitude);
+    osc.setSampleRate(kSampleRate);
+    osc.setOverwriteOutput(true);
+
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, 2);
+    SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, kChannels);
+
+    std::vector<float> pitch(kFrames);
+    std::vector<float> scalar_out(kChannels * kFrames);
+    std::vector<float> reference_out(kFrames);
+    float* scalar_ptrs[kChannels] = { scalar_out.data(), scalar_out.data() + kFrames };
+    ScalarSine scalar;
+    ReferenceSine reference;
+
+    // Held note: a constant pitch channel. Glide: a new audio-rate pitch curve every block.
+    auto setPitch = [&](size_t block) {
+        for (size_t i = 0; i < kFrames; ++i) {
+            pitch[i] = (glide) ? 48.f + 24.f * static_cast<float>((block * kFrames + i) % 48000) / 48000.f : 57.f;
+        }
+        if (glide) {
+            mod_inputs.setChannelHint(0, SignalBuffer::ChannelHint());
+            std::copy(pitch.begin(), pitch.end(), mod_inputs.getChannel(0));
+        } else {
+            mod_inputs.setChannelConstant(0, 57.f);
+        }
+        mod_inputs.setChannelSilent(1);
+    };
+
+    // Accuracy over the first blocks. Both kernels accumulate the phase in single precision, so part of the
+    // difference is phase drift that grows with time; the rest is the sine itself.
+    float scalar_error = 0.f;
+    float simd_error = 0.f;
+    for (size_t b = 0; b < 200; ++b) {
+        setPitch(b);
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+        scalar.process(pitch.data(), scalar_ptrs, kFrames);
+        reference.process(pitch.data(), reference_out.data(), kFrames);
+        for (size_t c = 0; c < kChannels; ++c) {
+            for (size_t i = 0; i < kFrames; ++i) {
+                simd_error = std::max(simd_error, std::abs(outputs.getElement(c, i) - reference_out[i]));
+                scalar_error = std::max(scalar_error, std::abs(scalar_ptrs[c][i] - reference_out[i]));
+            }
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        setPitch(b);
+        scalar.process(pitch.data(), scalar_ptrs, kFrames);
+    }
+    auto mid = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        setPitch(b);
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return { std::chrono::duration<double>(mid - start).count(), std::chrono::duration<double>(end - mid).count(), scalar_error, simd_error };
+}
+
+int main() {
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks" << std::endl;
+    for (bool glide : { false, true }) {
+        const Result result = run(glide);
+        const double samples = static_cast<double>(kChannels * kFrames * kBlocks);
+        std::cout << ((glide) ? "Glide (audio-rate pitch)" : "Held note (flat pitch)") << std::endl;
+        std::cout << "  std::pow/fmod/sin: " << result.t_scalar * 1e3 << " ms, " << samples / result.t_scalar * 1e-6 << " Msamples/s" << std::endl;
+        std::cout << "  SIMD kernel:       " << result.t_simd * 1e3 << " ms, " << samples / result.t_simd * 1e-6 << " Msamples/s" << std::endl;
+        std::cout << "  Speedup: " << result.t_scalar / result.t_simd << "x" << std::endl;
+        std::cout << std::scientific << "  Max error against double precision: std::sin " << result.scalar_error
+                  << ", SIMD " << result.simd_error << std::fixed << std::endl;
+    }
+    return 0;
+}
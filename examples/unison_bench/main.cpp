@@ -0,0 +1,82 @@
+// Benchmark for unison: the WaveformOscillator with 1, 8 and 16 unison voices against the per-sample scalar loop
+// it used before unison (one voice, one fmod and one table read per sample and channel)
+#include "oscillators/waveform_osc.h"
+#include "constants.h"
+#include "resource_manager.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 512;
+static constexpr size_t kBlocks = 4000;
+static constexpr float kSampleRate = 48000.f;
+static constexpr float kNote = 45.f;
+
+/// @brief The pre-unison inner loop: every channel advances its own phase and reads the table per sample
+static double runScalar(const float* table, SignalBuffer* outputs) {
+    const float increment = 440.f * std::pow(2.f, (kNote - 69.f) / 12.f) / kSampleRate;
+    float phase[kChannels] = {};
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        for (size_t c = 0; c < kChannels; ++c) {
+            float* out_buffer = outputs->getChannel(c);
+            for (size_t i = 0; i < kFrames; ++i) {
+                phase[c] = std::fmod(phase[c] + increment, 1.f);
+                const float index = phase[c] * static_cast<float>(WAVEFORM_STANDARD_LENGTH);
+                const size_t index_int = static_cast<size_t>(index);
+                const float frac = index - static_cast<float>(index_int);
+                const size_t index_next = (index_int + 1) % WAVEFORM_STANDARD_LENGTH;
+                out_buffer[i] = 0.5f * ((1.0f - frac) * table[index_int] + frac * table[index_next]);
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static double runUnison(Context* context, ResourceID waveform_id, size_t n_voices, SignalBuffer* mod_inputs, SignalBuffer* outputs) {
+    WaveformOscillator osc(context, 0, waveform_id, kChannels, 0.5f);
+    osc.setSampleRate(kSampleRate);
+    osc.setOverwriteOutput(true);
+    osc.setUnison(n_voices, 0.3f, 1.f);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        osc.beginBlock();
+        osc.processBlock(nullptr, mod_inputs, outputs, kFrames);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.max_n_frames = kFrames;
+    context.resource_manager = new ResourceManager();
+    const ResourceID waveform_id = context.resource_manager->createSawtoothWaveform();
+    const float* table = context.resource_manager->getWaveformBuffer(waveform_id);
+
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, 2);
+    mod_inputs.setChannelConstant(0, kNote);
+    mod_inputs.setChannelSilent(1);
+    SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, kChannels);
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks" << std::endl;
+    const double t_scalar = runScalar(table, &outputs);
+    std::cout << "Scalar loop, 1 voice:        " << t_scalar * 1e3 << " ms" << std::endl;
+    for (size_t n_voices : { 1, 8, 16 }) {
+        const double t = runUnison(&context, waveform_id, n_voices, &mod_inputs, &outputs);
+        std::cout << "WaveformOscillator, " << std::setw(2) << n_voices << " voices: " << t * 1e3 << " ms ("
+                  << 100.0 * t / t_scalar << "% of the scalar loop)" << std::endl;
+    }
+
+    delete context.resource_manager;
+    return 0;
+}
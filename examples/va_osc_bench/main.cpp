@@ -0,0 +1,125 @@
+// Aliasing and speed of the PolyBLEP/PolyBLAMP oscillator without oversampling. The note is chosen so that a
+// 65536-sample window holds a whole number of cycles: harmonics land on multiples of the fundamental's bin, and
+// anything in between is aliasing.
+#include "oscillators/va_osc.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <algorithm>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kWindow = 65536;
+static constexpr size_t kCycles = 3413; // Cycles per window; coprime with the window, so aliases fall between harmonics
+static constexpr size_t kFrames = 512;
+static constexpr size_t kBlocks = 20000;
+static constexpr float kSampleRate = 48000.f;
+
+static void fft(std::vector<std::complex<double>>& x) {
+    const size_t n = x.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(x[i], x[j]);
+        }
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const std::complex<double> w(std::cos(-2.0 * M_PI / len), std::sin(-2.0 * M_PI / len));
+        for (size_t i = 0; i < n; i += len) {
+            std::complex<double> wk(1.0);
+            for (size_t k = 0; k < len / 2; ++k) {
+                const std::complex<double> u = x[i + k];
+                const std::complex<double> v = x[i + k + len / 2] * wk;
+                x[i + k] = u + v;
+                x[i + k + len / 2] = u - v;
+                wk *= w;
+            }
+        }
+    }
+}
+
+/// @brief Power between the harmonics relative to the power on them, in dB
+static double aliasingDb(const std::vector<float>& signal) {
+    std::vector<std::complex<double>> spectrum(signal.begin(), signal.end());
+    fft(spectrum);
+    double harmonic = 0.0;
+    double alias = 0.0;
+    for (size_t bin = 1; bin < kWindow / 2; ++bin) {
+        const double power = std::norm(spectrum[bin]);
+        if (bin % kCycles == 0) {
+            harmonic += power;
+        } else {
+            alias += power;
+        }
+    }
+    return 10.0 * std::log10(alias / harmonic);
+}
+
+/// @brief The waveform without any band-limiting, for comparison
+static std::vector<float> naiveWindow(VAOscillator::EShape shape, double increment) {
+    std::vector<float> out(kWindow);
+    for (size_t i = 0; i < kWindow; ++i) {
+        const double t = std::fmod(static_cast<double>(i) * increment, 1.0);
+        switch (shape) {
+            case VAOscillator::EShape::kSaw: out[i] = static_cast<float>(2.0 * t - 1.0); break;
+            case VAOscillator::EShape::kPulse: out[i] = (t < 0.5) ? 1.f : -1.f; break;
+            case VAOscillator::EShape::kTriangle: out[i] = static_cast<float>(1.0 - 4.0 * std::abs(t - 0.5)); break;
+        }
+    }
+    return out;
+}
+
+int main() {
+    const double increment = static_cast<double>(kCycles) / kWindow;
+    const float note = static_cast<float>(69.0 + 12.0 * std::log2(increment * kSampleRate / 440.0));
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Fundamental " << increment * kSampleRate << " Hz at " << kSampleRate << " Hz, no oversampling" << std::endl;
+
+    const char* names[] = { "saw", "pulse", "triangle" };
+    for (int s = 0; s < 3; ++s) {
+        const VAOscillator::EShape shape = static_cast<VAOscillator::EShape>(s);
+        Context context;
+        context.sample_rate = kSampleRate;
+        context.max_n_frames = kFrames;
+        VAOscillator osc(&context, 0, shape, 1, 1.f);
+        osc.setSampleRate(kSampleRate);
+        osc.setOverwriteOutput(true);
+        SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, 4);
+        SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, 1);
+        mod_inputs.setChannelConstant(0, note);
+        for (size_t ch = 1; ch < 4; ++ch) {
+            mod_inputs.setChannelSilent(ch);
+        }
+
+        // One window after a settling window
+        std::vector<float> signal(kWindow);
+        for (size_t pass = 0; pass < 2; ++pass) {
+            for (size_t start = 0; start < kWindow; start += kFrames) {
+                osc.beginBlock();
+                osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+                std::copy(outputs.getChannel(0), outputs.getChannel(0) + kFrames, signal.begin() + start);
+            }
+        }
+
+        auto begin = std::chrono::high_resolution_clock::now();
+        for (size_t b = 0; b < kBlocks; ++b) {
+            osc.beginBlock();
+            osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        const double seconds = std::chrono::duration<double>(end - begin).count();
+
+        std::cout << names[s] << std::endl;
+        std::cout << "  Aliasing: naive " << aliasingDb(naiveWindow(shape, increment)) << " dB, PolyBLEP " << aliasingDb(signal) << " dB" << std::endl;
+        std::cout << "  Speed: " << static_cast<double>(kFrames * kBlocks) / seconds * 1e-6 << " Msamples/s" << std::endl;
+    }
+    return 0;
+}
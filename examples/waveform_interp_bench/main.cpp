@@ -0,0 +1,137 @@
+// Benchmark for the WaveformOscillator interpolation tiers: the error of each tier reading tables of sines of
+// rising harmonic number, and the cost of rendering a 16-voice unison with each tier
+#include "oscillators/waveform_osc.h"
+#include "dsp/interpolation.h"
+#include "constants.h"
+#include "resource_manager.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 512;
+static constexpr size_t kBlocks = 4000;
+static constexpr float kSampleRate = 48000.f;
+static constexpr float kNote = 45.f;
+static constexpr size_t kReads = 1 << 16;
+
+using EInterpolation = WaveformOscillator::EInterpolation;
+
+static const char* getName(EInterpolation mode) {
+    switch (mode) {
+    case EInterpolation::kLinear:
+        return "linear     ";
+    case EInterpolation::kCubic:
+        return "cubic      ";
+    case EInterpolation::kCatmullRom:
+        return "catmull_rom";
+    default:
+        return "hermite6   ";
+    }
+}
+
+/// @brief RMS error, in dB below the sine, of kReads reads at random positions of a table holding one sine of
+/// the given harmonic number
+static double measureError(EInterpolation mode, size_t harmonic) {
+    const double pi = 3.14159265358979323846;
+    constexpr size_t kGuard = 8;
+    std::vector<float> storage(kGuard + WAVEFORM_STANDARD_LENGTH + kGuard);
+    float* table = storage.data() + kGuard;
+    for (int i = -static_cast<int>(kGuard); i < static_cast<int>(WAVEFORM_STANDARD_LENGTH + kGuard); ++i) {
+        table[i] = static_cast<float>(std::sin(2.0 * pi * harmonic * i / WAVEFORM_STANDARD_LENGTH));
+    }
+
+    alignas(OS_SIMD_ALIGNMENT) float positions[OS_SIMD_WIDTH];
+    alignas(OS_SIMD_ALIGNMENT) float results[OS_SIMD_WIDTH];
+    alignas(OS_SIMD_ALIGNMENT) int indices[OS_SIMD_WIDTH];
+    uint32_t state = 12345u;
+    double error = 0.0;
+    for (size_t r = 0; r < kReads; r += OS_SIMD_WIDTH) {
+        for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+            state = state * 1664525u + 1013904223u;
+            positions[l] = static_cast<float>(state >> 8) / 16777216.f * WAVEFORM_STANDARD_LENGTH;
+        }
+        const os_simd_t position = OS_SIMD_LOAD_ALIGNED(positions);
+        const os_simd_t frac = OS_SIMD_SUB(position, simdFloorToIndices(position, indices));
+        os_simd_t x[8];
+        os_simd_t sample;
+        if (mode == EInterpolation::kLinear) {
+            simdGather2(table, indices, x[0], x[1]);
+            sample = simdInterpolateLinear(x[0], x[1], frac);
+        } else if (mode == EInterpolation::kHermite6) {
+            simdGather4(table - 2, indices, x);
+            simdGather4(table + 2, indices, x + 4);
+            sample = simdInterpolateHermite6(x, frac);
+        } else {
+            simdGather4(table - 1, indices, x);
+            sample = (mode == EInterpolation::kCubic) ? simdInterpolateLagrange4(x[0], x[1], x[2], x[3], frac)
+                                                      : simdInterpolateCatmullRom(x[0], x[1], x[2], x[3], frac);
+        }
+        OS_SIMD_STORE_ALIGNED(results, sample);
+        for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+            const double exact = std::sin(2.0 * pi * harmonic * positions[l] / WAVEFORM_STANDARD_LENGTH);
+            error += (results[l] - exact) * (results[l] - exact);
+        }
+    }
+    // A sine's RMS is 1 / sqrt(2)
+    return 10.0 * std::log10(2.0 * error / kReads);
+}
+
+static double runOscillator(Context* context, ResourceID waveform_id, EInterpolation mode, SignalBuffer* mod_inputs, SignalBuffer* outputs) {
+    WaveformOscillator osc(context, 0, waveform_id, kChannels, 0.5f);
+    osc.setSampleRate(kSampleRate);
+    osc.setOverwriteOutput(true);
+    osc.setUnison(16, 0.3f, 1.f);
+    osc.setInterpolation(mode);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        osc.beginBlock();
+        osc.processBlock(nullptr, mod_inputs, outputs, kFrames);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.max_n_frames = kFrames;
+    context.resource_manager = new ResourceManager();
+    const ResourceID waveform_id = context.resource_manager->createSawtoothWaveform();
+
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, 2);
+    mod_inputs.setChannelConstant(0, kNote);
+    mod_inputs.setChannelSilent(1);
+    SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, kChannels);
+
+    const EInterpolation modes[] = { EInterpolation::kLinear, EInterpolation::kCubic, EInterpolation::kCatmullRom, EInterpolation::kHermite6 };
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "RMS error (dB) of a sine with 64, 16 and 8 table points per cycle" << std::endl;
+    for (EInterpolation mode : modes) {
+        std::cout << getName(mode);
+        for (size_t harmonic : { 32, 128, 256 }) {
+            std::cout << "  " << std::setw(7) << measureError(mode, harmonic);
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << std::setprecision(3);
+    std::cout << "16 unison voices, " << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks" << std::endl;
+    double t_linear = 0.0;
+    for (EInterpolation mode : modes) {
+        const double t = runOscillator(&context, waveform_id, mode, &mod_inputs, &outputs);
+        if (mode == EInterpolation::kLinear) {
+            t_linear = t;
+        }
+        std::cout << getName(mode) << ": " << t * 1e3 << " ms (" << 100.0 * t / t_linear << "% of linear)" << std::endl;
+    }
+
+    delete context.resource_manager;
+    return 0;
+}
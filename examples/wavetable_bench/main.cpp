@@ -0,0 +1,130 @@
+// Benchmark for wavetables: the time to build the mip levels of a 256-frame wavetable, the error of the first
+// frame (a sine) against an exact sine, and the cost of the wavetable oscillator with a fixed and a moving position
+#include "oscillators/wavetable_osc.h"
+#include "constants.h"
+#include "resource_manager.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kFrames = 512;
+static constexpr size_t kBlocks = 4000;
+static constexpr float kSampleRate = 48000.f;
+static constexpr size_t kWavetableFrames = 256;
+static constexpr size_t kHarmonics = 256;
+
+/// @brief Frame f fades the harmonics of a sawtooth in over the wavetable: frame 0 is a sine, the last a sawtooth
+static std::vector<float> makeFrames() {
+    const double two_pi = 6.28318530717958647692;
+    std::vector<float> frames(kWavetableFrames * WAVEFORM_STANDARD_LENGTH, 0.f);
+    for (size_t f = 0; f < kWavetableFrames; ++f) {
+        const double fade = static_cast<double>(f) / (kWavetableFrames - 1);
+        for (size_t k = 1; k <= kHarmonics; ++k) {
+            const double gain = ((k == 1) ? 1.0 : fade) / static_cast<double>(k);
+            for (size_t i = 0; i < WAVEFORM_STANDARD_LENGTH; ++i) {
+                frames[f * WAVEFORM_STANDARD_LENGTH + i] += static_cast<float>(gain * std::sin(two_pi * k * i / WAVEFORM_STANDARD_LENGTH));
+            }
+        }
+    }
+    return frames;
+}
+
+static float noteToHz(float note) {
+    return 440.f * std::pow(2.f, (note - 69.f) / 12.f);
+}
+
+/// @brief RMS error, in dB below the sine, of the first frame played at note. Only two blocks are compared, as the
+/// oscillator's float phase drifts from the exact one over time.
+static double sineError(Context* context, ResourceID wavetable_id, float note) {
+    WavetableOscillator osc(context, 0, wavetable_id, 1, 1.f);
+    osc.setSampleRate(kSampleRate);
+    osc.setOverwriteOutput(true);
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, WavetableOscillator::kNumModChannels);
+    mod_inputs.setChannelConstant(0, note);
+    mod_inputs.setChannelSilent(1);
+    mod_inputs.setChannelSilent(2);
+    SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, 1);
+
+    const double two_pi = 6.28318530717958647692;
+    const double increment = static_cast<double>(noteToHz(note)) / kSampleRate;
+    double error = 0.0;
+    size_t n = 0;
+    for (size_t b = 0; b < 2; ++b) {
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+        const float* out = outputs.getChannel(0);
+        for (size_t i = 0; i < kFrames; ++i, ++n) {
+            const double exact = std::sin(two_pi * increment * static_cast<double>(n));
+            error += (out[i] - exact) * (out[i] - exact);
+        }
+    }
+    return 10.0 * std::log10(2.0 * error / static_cast<double>(n));
+}
+
+static double runOscillator(Context* context, ResourceID wavetable_id, float note, bool moving_position) {
+    WavetableOscillator osc(context, 0, wavetable_id, 1, 0.5f);
+    osc.setSampleRate(kSampleRate);
+    osc.setOverwriteOutput(true);
+    osc.setPosition(0.5f);
+    SignalBuffer mod_inputs(SignalBuffer::EType::kMod, kFrames, WavetableOscillator::kNumModChannels);
+    mod_inputs.setChannelConstant(0, note);
+    mod_inputs.setChannelSilent(1);
+    SignalBuffer outputs(SignalBuffer::EType::kAudio, kFrames, 1);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        if (moving_position) {
+            mod_inputs.setChannelRamp(2, -0.5f, 1.f / kFrames, 0, kFrames, true);
+        } else {
+            mod_inputs.setChannelSilent(2);
+        }
+        osc.beginBlock();
+        osc.processBlock(nullptr, &mod_inputs, &outputs, kFrames);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.max_n_frames = kFrames;
+    context.resource_manager = new ResourceManager();
+    const std::vector<float> frames = makeFrames();
+
+    std::cout << std::fixed << std::setprecision(2);
+    auto start = std::chrono::high_resolution_clock::now();
+    const ResourceID wavetable_id = context.resource_manager->createWavetable(frames.data(), kWavetableFrames);
+    auto created = std::chrono::high_resolution_clock::now();
+    context.resource_manager->getWavetable(wavetable_id)->waitForMips();
+    auto built = std::chrono::high_resolution_clock::now();
+    std::cout << kWavetableFrames << " frames: level 0 ready in " << std::chrono::duration<double>(created - start).count() * 1e3
+              << " ms, " << WavetableData::kNumMips << " mip levels in " << std::chrono::duration<double>(built - start).count() * 1e3
+              << " ms (background)" << std::endl;
+
+    std::cout << "First frame against an exact sine:";
+    for (float note : { 36.f, 69.f, 96.f }) {
+        std::cout << "  note " << note << ": " << sineError(&context, wavetable_id, note) << " dB";
+    }
+    std::cout << std::endl;
+
+    std::cout << "Render cost, " << kFrames << " frames, " << kBlocks << " blocks" << std::endl;
+    const double n_samples = static_cast<double>(kFrames) * kBlocks;
+    for (EAudioQuality quality : { kHighQuality, kLowQuality }) {
+        context.audio_quality = quality;
+        for (float note : { 36.f, 69.f, 96.f }) {
+            const double t_fixed = runOscillator(&context, wavetable_id, note, false);
+            const double t_moving = runOscillator(&context, wavetable_id, note, true);
+            std::cout << ((quality == kHighQuality) ? "lagrange" : "linear  ") << ", note " << note << ": fixed position "
+                      << t_fixed / n_samples * 1e9 << " ns/sample, moving position " << t_moving / n_samples * 1e9 << " ns/sample" << std::endl;
+        }
+    }
+
+    delete context.resource_manager;
+    return 0;
+}
@@ -0,0 +1,192 @@
+// Benchmark for the ZDF ladder filter: a modulated stereo filter against the per-sample coefficient loop it replaced
+#include "filters/ZDF_filter.h"
+#include "signal_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+using namespace OrangeSodium;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFrames = 512;
+static constexpr size_t kBlocks = 4000;
+static constexpr size_t kDivision = 16;
+static constexpr float kSampleRate = 48000.f;
+static constexpr float kPi = 3.14159265358979f;
+
+// The previous processBlock: every frame of every channel evaluates the cutoff (log10, pow, tan), smooths g with a
+// one-pole and divides by 1 + g in each stage
+struct ReferenceLadder {
+    float ic1eq[kChannels] = {};
+    float ic2eq[kChannels] = {};
+    float ic3eq[kChannels] = {};
+    float ic4eq[kChannels] = {};
+    float g_smooth[kChannels] = {};
+    float g_smooth_coeff = 500.f / kSampleRate;
+    float param_cutoff = 1000.f;
+    float param_resonance = 0.5f;
+    float max_frequency = 22050.f;
+
+    float knobValueToFrequency(float value) {
+        value = std::clamp(value, 0.0f, 1.0f);
+        const float log_min = std::log10(8.f);
+        const float log_max = std::log10(max_frequency);
+        return std::pow(10.f, log_min + value * (log_max - log_min));
+    }
+
+    float frequencyToKnobValue(float frequency) {
+        frequency = std::clamp(frequency, 8.f, max_frequency);
+        const float log_min = std::log10(8.f);
+        const float log_max = std::log10(max_frequency);
+        return (std::log10(frequency) - log_min) / (log_max - log_min);
+    }
+
+    void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_frames) {
+        const float* cutoff_buffer = mod_inputs->getChannel(0);
+        const float* resonance_buffer = mod_inputs->getChannel(1);
+        for (size_t c = 0; c < kChannels; ++c) {
+            const float* in_buffer = audio_inputs->getChannel(c);
+            float* out_buffer = outputs->getChannel(c);
+            for (size_t i = 0; i < n_frames; ++i) {
+                const float cutoff_knob = std::clamp(cutoff_buffer[i / kDivision] + frequencyToKnobValue(param_cutoff), 0.0f, 1.0f);
+                float g = std::tan(kPi * std::clamp(knobValueToFrequency(cutoff_knob) / kSampleRate, 0.0f, 0.499f));
+                if (i == 0) {
+                    g_smooth[c] = g;
+                }
+                g = g_smooth[c] + g_smooth_coeff * (g - g_smooth[c]);
+                g_smooth[c] = g;
+
+                const float resonance = std::clamp(resonance_buffer[i / kDivision] + param_resonance, 0.0f, 1.0f);
+                const float k = resonance * 4.f * (1.f - 1.5f * g + 0.5f * g * g);
+                const float input_signal = in_buffer[i] - k * ic4eq[c];
+                const float v0 = (input_signal * g + ic1eq[c]) / (1.0f + g);
+                ic1eq[c] = 2.f * v0 - ic1eq[c];
+                const float v1 = (v0 * g + ic2eq[c]) / (1.0f + g);
+                ic2eq[c] = 2.f * v1 - ic2eq[c];
+                const float v2 = (v1 * g + ic3eq[c]) / (1.0f + g);
+                ic3eq[c] = 2.f * v2 - ic3eq[c];
+                const float v3 = (v2 * g + ic4eq[c]) / (1.0f + g);
+                ic4eq[c] = 2.f * v3 - ic4eq[c];
+                out_buffer[i] = v3;
+            }
+        }
+    }
+};
+
+// Fills the cutoff channel with one sweep of a sine LFO per block, so every control point moves the cutoff
+static void fillCutoffSweep(SignalBuffer& mod) {
+    float* cutoff = mod.getChannel(0);
+    const size_t n_points = kFrames / kDivision;
+    for (size_t i = 0; i < n_points; ++i) {
+        cutoff[i] = 0.3f * std::sin(2.f * kPi * static_cast<float>(i) / static_cast<float>(n_points));
+    }
+    std::fill(mod.getChannel(1), mod.getChannel(1) + n_points, 0.f);
+}
+
+template <typename Process>
+static double timeBlocks(Process process) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t b = 0; b < kBlocks; ++b) {
+        process();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static ZDFFilter* makeFilter(Context& context, Filter::EFilterType type) {
+    ZDFFilter* filter = new ZDFFilter(&context, 1, kChannels);
+    filter->setSampleRate(kSampleRate);
+    filter->setCutoff(1000.f);
+    filter->setResonance(0.5f);
+    filter->setFilterType(type);
+    return filter;
+}
+
+int main() {
+    Context context;
+    context.sample_rate = kSampleRate;
+    context.oversampling = 1;
+    context.max_n_frames = kFrames;
+    context.resource_manager = nullptr;
+    context.waveform_fft_manager = nullptr;
+
+    SignalBuffer input(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    SignalBuffer output(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    SignalBuffer scalar_output(SignalBuffer::EType::kAudio, kFrames, kChannels);
+    for (size_t c = 0; c < kChannels; ++c) {
+        float* data = input.getChannel(c);
+        for (size_t i = 0; i < kFrames; ++i) {
+            // Saw-like test tone, slightly detuned between the channels
+            const float phase = static_cast<float>(i) * (110.f + 3.f * static_cast<float>(c)) / kSampleRate;
+            data[i] = 0.8f * (2.f * (phase - std::floor(phase)) - 1.f);
+        }
+    }
+
+    SignalBuffer mod(SignalBuffer::EType::kMod, kFrames, MAX_FILTER_MOD_PARAMETERS);
+    mod.setChannelDivision(0, kDivision);
+    mod.setChannelDivision(1, kDivision);
+    fillCutoffSweep(mod);
+
+    const double total_frames = static_cast<double>(kBlocks * kFrames);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << kChannels << " channels, " << kFrames << " frames, " << kBlocks << " blocks, cutoff modulated every " << kDivision << " frames" << std::endl;
+
+    ReferenceLadder reference;
+    const double t_reference = timeBlocks([&]() { reference.processBlock(&input, &mod, &output, kFrames); });
+    std::cout << "  Per-sample coefficients: " << t_reference * 1e9 / total_frames << " ns/frame" << std::endl;
+
+    const char* names[] = { "low-pass", "high-pass", "band-pass" };
+    const Filter::EFilterType types[] = { Filter::EFilterType::kLowPass, Filter::EFilterType::kHighPass, Filter::EFilterType::kBandPass };
+    for (size_t t = 0; t < 3; ++t) {
+        ZDFFilter* filter = makeFilter(context, types[t]);
+        const double t_filter = timeBlocks([&]() {
+            filter->beginBlock();
+            filter->processBlock(&input, &mod, &output, kFrames);
+        });
+        std::cout << "  Control-rate, SIMD " << names[t] << ": " << t_filter * 1e9 / total_frames << " ns/frame ("
+                  << t_reference / t_filter << "x)" << std::endl;
+        delete filter;
+    }
+
+    // Constant cutoff: after the first block g has settled and the coefficients are a fill
+    {
+        SignalBuffer flat_mod(SignalBuffer::EType::kMod, kFrames, MAX_FILTER_MOD_PARAMETERS);
+        flat_mod.setChannelDivision(0, kDivision);
+        flat_mod.setChannelDivision(1, kDivision);
+        flat_mod.setConstantValue(0, 0.f);
+        flat_mod.setConstantValue(1, 0.f);
+        ZDFFilter* filter = makeFilter(context, Filter::EFilterType::kLowPass);
+        const double t_filter = timeBlocks([&]() {
+            filter->beginBlock();
+            filter->processBlock(&input, &flat_mod, &output, kFrames);
+        });
+        std::cout << "  Constant cutoff low-pass: " << t_filter * 1e9 / total_frames << " ns/frame" << std::endl;
+        delete filter;
+    }
+
+    // The SIMD lanes run the same arithmetic as the scalar tick used by fused effect runs
+    for (size_t t = 0; t < 3; ++t) {
+        ZDFFilter* lanes = makeFilter(context, types[t]);
+        ZDFFilter* scalar = makeFilter(context, types[t]);
+        float max_diff = 0.f;
+        for (size_t b = 0; b < 8; ++b) {
+            lanes->beginBlock();
+            lanes->processBlock(&input, &mod, &output, kFrames);
+            scalar->prepareCoefficients(&mod, kFrames, 0);
+            for (size_t c = 0; c < kChannels; ++c) {
+                const float* in = input.getChannel(c);
+                const float* out = output.getChannel(c);
+                for (size_t i = 0; i < kFrames; ++i) {
+                    const float y = scalar->tick(in[i], c, scalar->getGainCoefficients()[i], scalar->getResonanceCoefficients()[i]);
+                    max_diff = std::max(max_diff, std::abs(y - out[i]));
+                }
+            }
+        }
+        std::cout << "  Max difference from tick (" << names[t] << "): " << std::setprecision(8) << max_diff << std::setprecision(2) << std::endl;
+        delete lanes;
+        delete scalar;
+    }
+    return 0;
+}
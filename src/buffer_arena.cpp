@@ -0,0 +1,66 @@
+#include "buffer_arena.h"
+#include "constants.h"
+#include <algorithm>
+#include <new>
+
+namespace OrangeSodium {
+
+static constexpr size_t kArenaAlignmentFloats = OS_CACHE_LINE_SIZE / sizeof(float);
+
+BufferArena::~BufferArena() {
+    // Registered buffers are owned elsewhere and may already be gone, so they are not touched here
+    releaseBlock();
+}
+
+void BufferArena::addBuffer(SignalBuffer* buffer) {
+    if (!buffer) {
+        return;
+    }
+    if (std::find(buffers.begin(), buffers.end(), buffer) != buffers.end()) {
+        return;
+    }
+    buffers.push_back(buffer);
+}
+
+void BufferArena::clear() {
+    buffers.clear();
+}
+
+void BufferArena::layout() {
+    size_t total_floats = 0;
+    for (auto* buffer : buffers) {
+        total_floats += buffer->getStorageSize(kArenaAlignmentFloats);
+    }
+
+    // Allocate the new block before releasing the old one; bindChannelStorage detaches each channel from the old block
+    float* new_block = nullptr;
+    if (total_floats > 0) {
+        new_block = static_cast<float*>(::operator new(total_floats * sizeof(float), std::align_val_t(OS_CACHE_LINE_SIZE)));
+    }
+
+    size_t offset = 0;
+    for (auto* buffer : buffers) {
+        for (size_t c = 0; c < buffer->getNumChannels(); ++c) {
+            const size_t length = buffer->getChannelLength(c);
+            if (length == 0) {
+                continue;
+            }
+            buffer->bindChannelStorage(c, new_block + offset);
+            offset += (length + kArenaAlignmentFloats - 1) / kArenaAlignmentFloats * kArenaAlignmentFloats;
+        }
+    }
+
+    releaseBlock();
+    block = new_block;
+    block_floats = total_floats;
+}
+
+void BufferArena::releaseBlock() {
+    if (block) {
+        ::operator delete(block, std::align_val_t(OS_CACHE_LINE_SIZE));
+        block = nullptr;
+    }
+    block_floats = 0;
+}
+
+}
@@ -0,0 +1,48 @@
+// Contiguous, cache-line-aligned storage for SignalBuffer channel data
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "signal_buffer.h"
+
+/*
+A BufferArena packs the sample data of every registered SignalBuffer into one block of memory.
+Buffers keep their own metadata (ids, lengths, divisions) and become non-owning views into the block,
+so the data touched every sample (hot) is contiguous while the bookkeeping (cold) stays out of the way.
+Channels are laid out in registration order, which callers keep equal to execution order so a block
+is processed as one linear stream. Every channel starts on a cache line boundary, which also makes it
+safe to use aligned SIMD loads and stores on it.
+*/
+
+namespace OrangeSodium {
+
+class BufferArena {
+public:
+    BufferArena() = default;
+    /// Frees the block. Buffers bound to the arena must not be used after it is destroyed.
+    ~BufferArena();
+
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+
+    /// @brief Register a buffer to be packed. Registering the same buffer twice has no effect.
+    void addBuffer(SignalBuffer* buffer);
+
+    /// @brief Forget all registered buffers. Buffers still bound to the arena must be re-laid out or destroyed first.
+    void clear();
+
+    /// @brief Pack all registered buffers into a single aligned block. Channel contents are zeroed.
+    /// Must be called again whenever a registered buffer is resized.
+    void layout();
+
+    size_t getSizeInBytes() const { return block_floats * sizeof(float); }
+    size_t getNumBuffers() const { return buffers.size(); }
+
+private:
+    std::vector<SignalBuffer*> buffers;
+    float* block = nullptr;
+    size_t block_floats = 0;
+
+    void releaseBlock();
+};
+
+}
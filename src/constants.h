@@ -4,4 +4,5 @@
 
 #define OS_VERSION "0.0.1"
 #define OS_NAME "OrangeSodium"
-#define WAVEFORM_STANDARD_LENGTH 2048
\ No newline at end of file
+#define WAVEFORM_STANDARD_LENGTH 2048
+#define OS_CACHE_LINE_SIZE 64
\ No newline at end of file
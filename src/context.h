@@ -4,6 +4,7 @@
 #include <iostream>
 #include "resource_manager.h"
 #include "dsp/fft.h"
+#include "object_registry.h"
 
 enum EAudioQuality {
     kLowQuality = 0,
@@ -30,9 +31,11 @@ struct Context{
     unsigned int next_object_id = 0; // Incrementing ID for all objects (oscillators, filters, effects, etc)
     EffectChainIndex next_effect_chain_id = 0;
     size_t max_n_frames; // Number of frames per audio block
+    size_t control_rate_division = 16; // Channel division of control-rate signals (envelopes, filter modulation). Read when those objects are added.
 
     ResourceManager* resource_manager;
     FFTManager* waveform_fft_manager;
+    ObjectRegistry object_registry; // ObjectID -> object, for every object created through getNextObjectID
 
     unsigned int getNextObjectID() { return next_object_id++; }
     EffectChainIndex getNextEffectChainIndex() { return next_effect_chain_id++; }
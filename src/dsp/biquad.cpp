@@ -1,5 +1,6 @@
 #include "biquad.h"
 #include <cmath>
+#include <algorithm>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -12,9 +13,7 @@ BiquadFilter::BiquadFilter()
       filter_type(EFilterType::kLowPass),
       cutoff_frequency(1000.0f),
       q_factor(0.707f),
-      gain_db(0.0f),
-      a0(1.0f), a1(0.0f), a2(0.0f),
-      b0(1.0f), b1(0.0f), b2(0.0f) {
+      gain_db(0.0f) {
     calculateCoefficients();
 }
 
@@ -47,19 +46,54 @@ void BiquadFilter::setGain(float gain) {
     calculateCoefficients();
 }
 
+bool BiquadFilter::getFilterTypeFromString(const std::string& type_str, EFilterType& out) {
+    if (type_str == "lowpass") {
+        out = EFilterType::kLowPass;
+    } else if (type_str == "highpass") {
+        out = EFilterType::kHighPass;
+    } else if (type_str == "bandpass") {
+        out = EFilterType::kBandPass;
+    } else if (type_str == "notch") {
+        out = EFilterType::kNotch;
+    } else if (type_str == "peak") {
+        out = EFilterType::kPeak;
+    } else if (type_str == "lowshelf") {
+        out = EFilterType::kLowShelf;
+    } else if (type_str == "highshelf") {
+        out = EFilterType::kHighShelf;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 void BiquadFilter::calculateCoefficients() {
+    coefficients = design(filter_type, cutoff_frequency, q_factor, gain_db, sample_rate);
+}
+
+BiquadCoefficients BiquadFilter::design(EFilterType type, float frequency, float q, float gain_db, float sample_rate) {
+    BiquadCoefficients out;
+
+    // A boost or cut of 0 dB is no filter at all; return it exactly so banks can skip the section
+    const bool has_gain = type == EFilterType::kPeak || type == EFilterType::kLowShelf || type == EFilterType::kHighShelf;
+    if (has_gain && gain_db == 0.f) {
+        return out;
+    }
+
     // Precompute common values
-    const float w0 = 2.0f * static_cast<float>(M_PI) * cutoff_frequency / sample_rate;
+    const float w0 = 2.0f * static_cast<float>(M_PI) * std::clamp(frequency / sample_rate, 1e-5f, 0.499f);
     const float cos_w0 = std::cos(w0);
     const float sin_w0 = std::sin(w0);
-    const float alpha = sin_w0 / (2.0f * q_factor);
+    const float alpha = sin_w0 / (2.0f * std::max(q, 1e-3f));
 
     // For peak and shelving filters
     const float A = std::pow(10.0f, gain_db / 40.0f); // sqrt of linear gain
 
+    float a0, a1, a2, b0, b1, b2;
+
     // Calculate coefficients based on filter type
     // Using the Audio EQ Cookbook formulas
-    switch (filter_type) {
+    switch (type) {
         case EFilterType::kLowPass:
             b0 = (1.0f - cos_w0) / 2.0f;
             b1 = 1.0f - cos_w0;
@@ -108,8 +142,8 @@ void BiquadFilter::calculateCoefficients() {
 
         case EFilterType::kLowShelf:
             {
-                const float sqrt_A = std::sqrt(A);
-                const float beta = std::sqrt(A) / q_factor;
+                // beta * sin_w0 is the cookbook's 2 sqrt(A) alpha, with the shelf slope given as Q
+                const float beta = std::sqrt(A) / q;
 
                 b0 = A * ((A + 1.0f) - (A - 1.0f) * cos_w0 + beta * sin_w0);
                 b1 = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cos_w0);
@@ -122,8 +156,7 @@ void BiquadFilter::calculateCoefficients() {
 
         case EFilterType::kHighShelf:
             {
-                const float sqrt_A = std::sqrt(A);
-                const float beta = std::sqrt(A) / q_factor;
+                const float beta = std::sqrt(A) / q;
 
                 b0 = A * ((A + 1.0f) + (A - 1.0f) * cos_w0 + beta * sin_w0);
                 b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cos_w0);
@@ -136,35 +169,26 @@ void BiquadFilter::calculateCoefficients() {
 
         default:
             // Default to pass-through
-            b0 = 1.0f;
-            b1 = 0.0f;
-            b2 = 0.0f;
-            a0 = 1.0f;
-            a1 = 0.0f;
-            a2 = 0.0f;
-            break;
+            return out;
     }
 
     // Normalize coefficients by a0
     const float a0_inv = 1.0f / a0;
-    b0 *= a0_inv;
-    b1 *= a0_inv;
-    b2 *= a0_inv;
-    a1 *= a0_inv;
-    a2 *= a0_inv;
-    a0 = 1.0f;
+    out.b0 = b0 * a0_inv;
+    out.b1 = b1 * a0_inv;
+    out.b2 = b2 * a0_inv;
+    out.a1 = a1 * a0_inv;
+    out.a2 = a2 * a0_inv;
+    return out;
 }
 
-
 float BiquadFilter::tick(float input_sample) {
-    static float z1 = 0.0f; // Delay buffer 1
-    static float z2 = 0.0f; // Delay buffer 2
-
-    // Direct Form I implementation
-    float output_sample = b0 * input_sample + z1;
-    z1 = b1 * input_sample - a1 * output_sample + z2;
-    z2 = b2 * input_sample - a2 * output_sample;
-
+    // Transposed direct form II; the state belongs to this filter
+    const BiquadCoefficients& c = coefficients;
+    const float output_sample = c.b0 * input_sample + z1;
+    z1 = c.b1 * input_sample - c.a1 * output_sample + z2;
+    z2 = c.b2 * input_sample - c.a2 * output_sample;
     return output_sample;
+}
 
-} // namespace OrangeSodium
\ No newline at end of file
+} // namespace OrangeSodium
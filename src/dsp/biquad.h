@@ -1,10 +1,25 @@
 #pragma once
 
 #include "../signal_buffer.h"
+#include <string>
 
 namespace OrangeSodium{
 
+// Normalized biquad coefficients (a0 = 1)
+struct BiquadCoefficients {
+    float b0 = 1.f;
+    float b1 = 0.f;
+    float b2 = 0.f;
+    float a1 = 0.f;
+    float a2 = 0.f;
+
+    /// @brief True for the pass-through section (b0 = 1, everything else 0)
+    bool isIdentity() const { return b0 == 1.f && b1 == 0.f && b2 == 0.f && a1 == 0.f && a2 == 0.f; }
+};
+
 // Biquad filter class
+// Single filter on one signal, in transposed direct form II. Blocks of several signals or cascades of sections
+// go through BiquadBank, which uses the same coefficient design.
 
 class BiquadFilter {
 public:
@@ -30,6 +45,17 @@ public:
     void calculateCoefficients();
     float tick(float input_sample);
 
+    /// @brief Clear the filter state
+    void reset() { z1 = 0.f; z2 = 0.f; }
+
+    const BiquadCoefficients& getCoefficients() const { return coefficients; }
+
+    /// @brief Audio EQ Cookbook design. Peak and shelving filters with 0 dB gain give the exact pass-through section.
+    static BiquadCoefficients design(EFilterType type, float frequency, float q, float gain_db, float sample_rate);
+
+    /// @brief Parse a filter type name ("lowpass", "highpass", "bandpass", "notch", "peak", "lowshelf", "highshelf");
+    /// returns false if unknown
+    static bool getFilterTypeFromString(const std::string& type_str, EFilterType& out);
 
 private:
     float sample_rate;
@@ -38,8 +64,11 @@ private:
     float q_factor;
     float gain_db;
 
-    // Biquad coefficients
-    float a0, a1, a2, b0, b1, b2;
+    BiquadCoefficients coefficients;
+
+    // Transposed direct form II state
+    float z1 = 0.f;
+    float z2 = 0.f;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,306 @@
+#include "biquad_bank.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace OrangeSodium {
+
+BiquadBank::BiquadBank(size_t n_signals, size_t n_sections, size_t max_n_frames)
+    : n_signals(n_signals), n_sections(n_sections), max_n_frames(std::max(max_n_frames, static_cast<size_t>(1))) {
+    n_groups = (n_signals + kLanes - 1) / kLanes;
+    sections = new Section[n_groups * n_sections];
+    for (size_t i = 0; i < n_groups * n_sections; ++i) {
+        Section& s = sections[i];
+        for (size_t l = 0; l < kLanes; ++l) {
+            s.b0[l] = 1.f;
+            s.b1[l] = s.b2[l] = s.a1[l] = s.a2[l] = 0.f;
+            s.target[0][l] = 1.f;
+            for (size_t k = 1; k < 5; ++k) {
+                s.target[k][l] = 0.f;
+            }
+            for (size_t k = 0; k < 5; ++k) {
+                s.step[k][l] = 0.f;
+            }
+            s.z1[l] = s.z2[l] = 0.f;
+        }
+        s.ramp_remaining = 0;
+        s.identity = true;
+    }
+    lanes = new float[this->max_n_frames * kLanes];
+    silence = new float[this->max_n_frames]();
+    discarded = new float[this->max_n_frames];
+}
+
+BiquadBank::~BiquadBank() {
+    delete[] sections;
+    delete[] lanes;
+    delete[] silence;
+    delete[] discarded;
+}
+
+void BiquadBank::setCoefficients(size_t section, size_t signal, const BiquadCoefficients& coefficients, size_t ramp_frames) {
+    if (section >= n_sections || signal >= n_signals) {
+        return;
+    }
+    Section& s = getSection(signal / kLanes, section);
+    const size_t l = signal % kLanes;
+    s.target[0][l] = coefficients.b0;
+    s.target[1][l] = coefficients.b1;
+    s.target[2][l] = coefficients.b2;
+    s.target[3][l] = coefficients.a1;
+    s.target[4][l] = coefficients.a2;
+    startRamp(s, ramp_frames);
+}
+
+void BiquadBank::setCoefficients(size_t section, const BiquadCoefficients& coefficients, size_t ramp_frames) {
+    for (size_t signal = 0; signal < n_signals; ++signal) {
+        setCoefficients(section, signal, coefficients, ramp_frames);
+    }
+}
+
+void BiquadBank::startRamp(Section& s, size_t ramp_frames) {
+    // Every lane restarts from where it is, so lanes set one after the other arrive together
+    if (ramp_frames == 0) {
+        finishRamp(s);
+        return;
+    }
+    float* current[5] = { s.b0, s.b1, s.b2, s.a1, s.a2 };
+    const float inv_frames = 1.f / static_cast<float>(ramp_frames);
+    for (size_t k = 0; k < 5; ++k) {
+        for (size_t l = 0; l < kLanes; ++l) {
+            s.step[k][l] = (s.target[k][l] - current[k][l]) * inv_frames;
+        }
+    }
+    s.ramp_remaining = ramp_frames;
+    s.identity = false;
+}
+
+void BiquadBank::finishRamp(Section& s) {
+    float* current[5] = { s.b0, s.b1, s.b2, s.a1, s.a2 };
+    bool identity = true;
+    for (size_t k = 0; k < 5; ++k) {
+        for (size_t l = 0; l < kLanes; ++l) {
+            current[k][l] = s.target[k][l];
+            s.step[k][l] = 0.f;
+            identity = identity && s.target[k][l] == ((k == 0) ? 1.f : 0.f);
+        }
+    }
+    s.ramp_remaining = 0;
+    if (identity && !s.identity) {
+        // A pass-through section forgets its state within two frames anyway
+        std::fill(s.z1, s.z1 + kLanes, 0.f);
+        std::fill(s.z2, s.z2 + kLanes, 0.f);
+    }
+    s.identity = identity;
+}
+
+void BiquadBank::runRamping(Section& s, float* block, size_t n_frames) {
+    __m128 b0 = _mm_load_ps(s.b0), b1 = _mm_load_ps(s.b1), b2 = _mm_load_ps(s.b2);
+    __m128 a1 = _mm_load_ps(s.a1), a2 = _mm_load_ps(s.a2);
+    const __m128 db0 = _mm_load_ps(s.step[0]), db1 = _mm_load_ps(s.step[1]), db2 = _mm_load_ps(s.step[2]);
+    const __m128 da1 = _mm_load_ps(s.step[3]), da2 = _mm_load_ps(s.step[4]);
+    __m128 z1 = _mm_load_ps(s.z1), z2 = _mm_load_ps(s.z2);
+    for (size_t i = 0; i < n_frames; ++i) {
+        b0 = _mm_add_ps(b0, db0);
+        b1 = _mm_add_ps(b1, db1);
+        b2 = _mm_add_ps(b2, db2);
+        a1 = _mm_add_ps(a1, da1);
+        a2 = _mm_add_ps(a2, da2);
+        const __m128 x = _mm_loadu_ps(block + i * kLanes);
+        const __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        _mm_storeu_ps(block + i * kLanes, y);
+    }
+    _mm_store_ps(s.b0, b0);
+    _mm_store_ps(s.b1, b1);
+    _mm_store_ps(s.b2, b2);
+    _mm_store_ps(s.a1, a1);
+    _mm_store_ps(s.a2, a2);
+    _mm_store_ps(s.z1, z1);
+    _mm_store_ps(s.z2, z2);
+    s.ramp_remaining -= n_frames;
+    if (s.ramp_remaining == 0) {
+        finishRamp(s);
+    }
+}
+
+template <size_t kCount>
+void BiquadBank::runSettled(Section* const* cascade, float* block, size_t n_frames) {
+    // Each section only waits for the previous one's output of the same frame, so the recursions of the kCount
+    // sections overlap instead of running back to back
+    __m128 b0[kCount], b1[kCount], b2[kCount], a1[kCount], a2[kCount], z1[kCount], z2[kCount];
+    for (size_t k = 0; k < kCount; ++k) {
+        b0[k] = _mm_load_ps(cascade[k]->b0);
+        b1[k] = _mm_load_ps(cascade[k]->b1);
+        b2[k] = _mm_load_ps(cascade[k]->b2);
+        a1[k] = _mm_load_ps(cascade[k]->a1);
+        a2[k] = _mm_load_ps(cascade[k]->a2);
+        z1[k] = _mm_load_ps(cascade[k]->z1);
+        z2[k] = _mm_load_ps(cascade[k]->z2);
+    }
+    for (size_t i = 0; i < n_frames; ++i) {
+        __m128 x = _mm_loadu_ps(block + i * kLanes);
+        for (size_t k = 0; k < kCount; ++k) {
+            const __m128 y = _mm_add_ps(_mm_mul_ps(b0[k], x), z1[k]);
+            z1[k] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1[k], x), _mm_mul_ps(a1[k], y)), z2[k]);
+            z2[k] = _mm_sub_ps(_mm_mul_ps(b2[k], x), _mm_mul_ps(a2[k], y));
+            x = y;
+        }
+        _mm_storeu_ps(block + i * kLanes, x);
+    }
+    for (size_t k = 0; k < kCount; ++k) {
+        _mm_store_ps(cascade[k]->z1, z1[k]);
+        _mm_store_ps(cascade[k]->z2, z2[k]);
+    }
+}
+
+void BiquadBank::runSettled(Section* const* cascade, size_t count, float* block, size_t n_frames) {
+    while (count >= 4) {
+        runSettled<4>(cascade, block, n_frames);
+        cascade += 4;
+        count -= 4;
+    }
+    switch (count) {
+        case 3:
+            runSettled<3>(cascade, block, n_frames);
+            break;
+        case 2:
+            runSettled<2>(cascade, block, n_frames);
+            break;
+        case 1:
+            runSettled<1>(cascade, block, n_frames);
+            break;
+        default:
+            break;
+    }
+}
+
+void BiquadBank::process(const float* const* inputs, float* const* outputs, size_t n_frames) {
+    n_frames = std::min(n_frames, max_n_frames);
+    for (size_t g = 0; g < n_groups; ++g) {
+        const float* in[kLanes];
+        float* out[kLanes];
+        for (size_t l = 0; l < kLanes; ++l) {
+            const size_t signal = g * kLanes + l;
+            in[l] = (signal < n_signals && inputs[signal]) ? inputs[signal] : silence;
+            out[l] = (signal < n_signals && outputs[signal]) ? outputs[signal] : discarded;
+        }
+
+        bool bypassed = true;
+        for (size_t k = 0; k < n_sections && bypassed; ++k) {
+            bypassed = getSection(g, k).identity;
+        }
+        if (bypassed) {
+            for (size_t l = 0; l < kLanes; ++l) {
+                if (out[l] != discarded && out[l] != in[l]) {
+                    std::memcpy(out[l], in[l], n_frames * sizeof(float));
+                }
+            }
+            continue;
+        }
+
+        // Planar signals to frame-major lanes, four frames at a time
+        size_t i = 0;
+        for (; i + 4 <= n_frames; i += 4) {
+            __m128 x0 = _mm_loadu_ps(in[0] + i);
+            __m128 x1 = _mm_loadu_ps(in[1] + i);
+            __m128 x2 = _mm_loadu_ps(in[2] + i);
+            __m128 x3 = _mm_loadu_ps(in[3] + i);
+            _MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+            _mm_storeu_ps(lanes + i * kLanes, x0);
+            _mm_storeu_ps(lanes + (i + 1) * kLanes, x1);
+            _mm_storeu_ps(lanes + (i + 2) * kLanes, x2);
+            _mm_storeu_ps(lanes + (i + 3) * kLanes, x3);
+        }
+        for (; i < n_frames; ++i) {
+            _mm_storeu_ps(lanes + i * kLanes, _mm_setr_ps(in[0][i], in[1][i], in[2][i], in[3][i]));
+        }
+
+        // Settled sections are gathered and run together; a ramping section runs on its own between them
+        Section* settled[kMaxSettled];
+        size_t n_settled = 0;
+        for (size_t k = 0; k < n_sections; ++k) {
+            Section& s = getSection(g, k);
+            if (s.identity) {
+                continue;
+            }
+            if (s.ramp_remaining > 0 || n_settled == kMaxSettled) {
+                runSettled(settled, n_settled, lanes, n_frames);
+                n_settled = 0;
+            }
+            if (s.ramp_remaining > 0) {
+                const size_t n_ramp = std::min(n_frames, s.ramp_remaining);
+                runRamping(s, lanes, n_ramp);
+                // The ramp may end inside the block; the rest runs settled
+                if (n_ramp < n_frames && !s.identity) {
+                    Section* rest = &s;
+                    runSettled(&rest, 1, lanes + n_ramp * kLanes, n_frames - n_ramp);
+                }
+            } else {
+                settled[n_settled++] = &s;
+            }
+        }
+        runSettled(settled, n_settled, lanes, n_frames);
+
+        // And back to planar
+        i = 0;
+        for (; i + 4 <= n_frames; i += 4) {
+            __m128 y0 = _mm_loadu_ps(lanes + i * kLanes);
+            __m128 y1 = _mm_loadu_ps(lanes + (i + 1) * kLanes);
+            __m128 y2 = _mm_loadu_ps(lanes + (i + 2) * kLanes);
+            __m128 y3 = _mm_loadu_ps(lanes + (i + 3) * kLanes);
+            _MM_TRANSPOSE4_PS(y0, y1, y2, y3);
+            _mm_storeu_ps(out[0] + i, y0);
+            _mm_storeu_ps(out[1] + i, y1);
+            _mm_storeu_ps(out[2] + i, y2);
+            _mm_storeu_ps(out[3] + i, y3);
+        }
+        alignas(16) float frame[kLanes];
+        for (; i < n_frames; ++i) {
+            _mm_store_ps(frame, _mm_loadu_ps(lanes + i * kLanes));
+            for (size_t l = 0; l < kLanes; ++l) {
+                out[l][i] = frame[l];
+            }
+        }
+    }
+}
+
+bool BiquadBank::isSilent(float threshold) const {
+    for (size_t i = 0; i < n_groups * n_sections; ++i) {
+        for (size_t l = 0; l < kLanes; ++l) {
+            if (std::abs(sections[i].z1[l]) > threshold || std::abs(sections[i].z2[l]) > threshold) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void BiquadBank::reset() {
+    for (size_t i = 0; i < n_groups * n_sections; ++i) {
+        std::fill(sections[i].z1, sections[i].z1 + kLanes, 0.f);
+        std::fill(sections[i].z2, sections[i].z2 + kLanes, 0.f);
+    }
+}
+
+void BiquadBank::copyStateFrom(const BiquadBank& other) {
+    if (other.n_signals != n_signals || other.n_sections != n_sections) {
+        return;
+    }
+    for (size_t i = 0; i < n_groups * n_sections; ++i) {
+        std::memcpy(sections[i].z1, other.sections[i].z1, sizeof(sections[i].z1));
+        std::memcpy(sections[i].z2, other.sections[i].z2, sizeof(sections[i].z2));
+    }
+}
+
+bool BiquadBank::isBypassed() const {
+    for (size_t i = 0; i < n_groups * n_sections; ++i) {
+        if (!sections[i].identity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace OrangeSodium
@@ -0,0 +1,87 @@
+#pragma once
+#include "biquad.h"
+#include "../simd.h"
+#include <cstddef>
+
+/*
+A bank of biquad cascades: n_signals independent signals, each through the same number of sections in series.
+Every (signal, section) pair has its own coefficients and state. Signals run four at a time in SSE lanes, so
+a stereo pair (or four parallel bands of one signal) costs one pass per section.
+
+Layout is SoA per group of four signals: a section of a group holds b0[4], b1[4], ..., z1[4], z2[4], so each
+coefficient is one aligned vector. A block is transposed into frame-major lanes once, every section runs over it
+with its coefficients and state in registers (transposed direct form II), then it is transposed back. Sections
+that do not ramp run up to four per pass over the block, so their recursions overlap.
+
+Coefficient changes ramp linearly over a number of frames. The ramp moves between two stable sets; short ramps
+stay stable in practice. Sections whose coefficients are the identity (e.g. a 0 dB peak) are skipped.
+*/
+
+namespace OrangeSodium {
+
+class BiquadBank {
+public:
+    static constexpr size_t kLanes = 4; // Signals per SSE pass
+
+    BiquadBank(size_t n_signals, size_t n_sections, size_t max_n_frames);
+    ~BiquadBank();
+
+    /// @brief Set the coefficients of one section of one signal, reached after ramp_frames frames (0 snaps)
+    void setCoefficients(size_t section, size_t signal, const BiquadCoefficients& coefficients, size_t ramp_frames);
+
+    /// @brief Set the coefficients of one section of every signal
+    void setCoefficients(size_t section, const BiquadCoefficients& coefficients, size_t ramp_frames);
+
+    /// @brief Run n_frames (at most getMaxFrames()) frames of every signal through its cascade. outputs may alias inputs. A missing input
+    /// reads silence; a missing output drops the signal (its state is still advanced).
+    void process(const float* const* inputs, float* const* outputs, size_t n_frames);
+
+    /// @brief True if every state has decayed below threshold
+    bool isSilent(float threshold) const;
+
+    /// @brief Clear every state
+    void reset();
+
+    /// @brief Take over the state (not the coefficients) of a bank with the same layout
+    void copyStateFrom(const BiquadBank& other);
+
+    /// @brief True if every section is skipped, i.e. the bank passes its input through
+    bool isBypassed() const;
+
+    size_t getNumSignals() const { return n_signals; }
+    size_t getNumSections() const { return n_sections; }
+    size_t getMaxFrames() const { return max_n_frames; }
+
+private:
+    struct alignas(16) Section {
+        float b0[kLanes], b1[kLanes], b2[kLanes], a1[kLanes], a2[kLanes];   // Current coefficients
+        float step[5][kLanes];                                              // Per-frame increments while ramping
+        float target[5][kLanes];                                            // Coefficients at the end of the ramp
+        float z1[kLanes], z2[kLanes];
+        size_t ramp_remaining;
+        bool identity;                                                      // Skipped: settled at pass-through
+    };
+
+    size_t n_signals;
+    size_t n_sections;
+    size_t n_groups;
+    size_t max_n_frames;
+    Section* sections;  // [group * n_sections + section]
+    float* lanes;       // Frame-major block of one group: [frame * kLanes + lane]
+    float* silence;     // Input of missing signals
+    float* discarded;   // Output of missing signals
+
+    Section& getSection(size_t group, size_t section) { return sections[group * n_sections + section]; }
+    void startRamp(Section& s, size_t ramp_frames);
+    void finishRamp(Section& s);
+
+    static constexpr size_t kMaxSettled = 16; // Settled sections gathered before they are run
+
+    void runRamping(Section& s, float* block, size_t n_frames);
+    /// @brief Run count settled sections in series over the block, up to four per pass
+    void runSettled(Section* const* cascade, size_t count, float* block, size_t n_frames);
+    template <size_t kCount>
+    void runSettled(Section* const* cascade, float* block, size_t n_frames);
+};
+
+} // namespace OrangeSodium
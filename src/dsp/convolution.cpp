@@ -1,103 +1,409 @@
 #include "convolution.h"
-#include <cstring>  // for std::memmove
+#include "vector_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace OrangeSodium {
 
-Convolver::Convolver(float* ir_buffer, size_t ir_length)
+static size_t log2Size(size_t n) {
+    size_t order = 0;
+    while ((static_cast<size_t>(1) << order) < n) {
+        ++order;
+    }
+    return order;
+}
+
+ConvolutionKernel::ConvolutionKernel(const float* ir, size_t ir_length, size_t head_size, bool uniform)
     : ir_length(ir_length) {
-    impulse_response = new float[ir_length];
-    for (size_t i = 0; i < ir_length; ++i) {
-        impulse_response[i] = ir_buffer[i];
+    this->head_size = static_cast<size_t>(1) << log2Size(std::min(std::max(head_size, static_cast<size_t>(16)), static_cast<size_t>(1024)));
+    head = new float[this->head_size]();
+    std::memcpy(head, ir, std::min(ir_length, this->head_size) * sizeof(float));
+
+    size_t block = this->head_size;
+    if (uniform) {
+        addStage(ir, block, block, 2 * block);
+        addStage(ir, block, 2 * block, ir_length);
+        return;
     }
-    history_buffer = new float[ir_length];
-    for (size_t i = 0; i < ir_length; ++i) {
-        history_buffer[i] = 0.0f;
+    size_t begin = block;
+    while (begin < ir_length) {
+        // Stage k + 1 starts at twice its block size, which leaves it a block of slack
+        const size_t next_block = std::min(block * kGrowth, kMaxBlock);
+        const size_t end = (next_block > block) ? std::min(2 * next_block, ir_length) : ir_length;
+        addStage(ir, block, begin, end);
+        begin = end;
+        block = next_block;
     }
 }
 
+ConvolutionKernel::~ConvolutionKernel() {
+    delete[] head;
+    for (Stage& stage : stages) {
+        delete[] stage.spectra;
+    }
+}
+
+void ConvolutionKernel::addStage(const float* ir, size_t block, size_t begin, size_t end) {
+    end = std::min(end, ir_length);
+    if (begin >= end) {
+        return;
+    }
+    Stage stage;
+    stage.block = block;
+    stage.offset_blocks = begin / block;
+    stage.n_partitions = (end - begin + block - 1) / block;
+    const size_t spectrum_size = 2 * block + 2;
+    stage.spectra = new float[stage.n_partitions * spectrum_size];
+
+    FFTManager fft(static_cast<unsigned int>(log2Size(2 * block)));
+    float* padded = new float[2 * block];
+    for (size_t p = 0; p < stage.n_partitions; ++p) {
+        const size_t first = begin + p * block;
+        const size_t n_taps = std::min(block, end - first);
+        std::fill(padded, padded + 2 * block, 0.f);
+        std::memcpy(padded, ir + first, n_taps * sizeof(float));
+        fft.forwardReal(padded, stage.spectra + p * spectrum_size);
+    }
+    delete[] padded;
+    stages.push_back(stage);
+}
+
+Convolver::Convolver(std::shared_ptr<const ConvolutionKernel> kernel, size_t n_channels, bool threaded_tail, size_t max_process_frames)
+    : kernel(std::move(kernel)), n_channels(n_channels), threaded_tail(threaded_tail), max_process_frames(max_process_frames) {
+    allocate();
+}
+
+Convolver::Convolver(const float* ir_buffer, size_t ir_length)
+    : kernel(std::make_shared<ConvolutionKernel>(ir_buffer, ir_length)), n_channels(1), threaded_tail(false), max_process_frames(kChunk) {
+    allocate();
+}
+
 Convolver::~Convolver() {
-    if (impulse_response) {
-        delete[] impulse_response;
-        impulse_response = nullptr;
+    release();
+}
+
+void Convolver::setImpulseResponse(const float* ir_buffer, size_t ir_length) {
+    release();
+    kernel = std::make_shared<ConvolutionKernel>(ir_buffer, ir_length);
+    allocate();
+}
+
+void Convolver::allocate() {
+    const size_t head = kernel->getHeadSize();
+    history = new float[n_channels * (head - 1 + kChunk)]();
+    chunk_inputs.assign(n_channels, nullptr);
+    chunk_outputs.assign(n_channels, nullptr);
+
+    bool any_threaded = false;
+    size_t largest_block = 0;
+    for (size_t s = 0; s < kernel->getNumStages(); ++s) {
+        const ConvolutionKernel::Stage& stage = kernel->getStage(s);
+        const size_t block = stage.block;
+        StageState* state = new StageState();
+        state->stage = &stage;
+        state->fft = new FFTManager(static_cast<unsigned int>(log2Size(2 * block)));
+        state->threaded = threaded_tail && stage.offset_blocks >= 2 && block >= max_process_frames;
+        // The block computed at a boundary is played from it on (one boundary later when threaded), so the
+        // partitions start offset_blocks - 1 (- 1) slots back
+        state->fdl_shift = stage.offset_blocks - 1 - ((state->threaded) ? 1 : 0);
+        state->fdl_slots = stage.n_partitions + state->fdl_shift;
+        state->fdl_position = 0;
+        state->fill = 0;
+        state->dropped = 0;
+        state->job_dropped = 0;
+        state->input = new float[n_channels * 2 * block]();
+        state->job_input = (state->threaded) ? new float[n_channels * 2 * block]() : nullptr;
+        state->fdl = new float[n_channels * state->fdl_slots * (2 * block + 2)]();
+        state->output = new float[n_channels * block]();
+        state->next_output = (state->threaded) ? new float[n_channels * block]() : nullptr;
+        state->accumulator = new float[2 * block + 2];
+        state->time = new float[2 * block];
+        stages.push_back(state);
+        any_threaded = any_threaded || state->threaded;
+        largest_block = std::max(largest_block, block);
     }
-    if (history_buffer) {
-        delete[] history_buffer;
-        history_buffer = nullptr;
+
+    // Input silent for this long has played out of every stage
+    silence_horizon = kernel->getLength() + 2 * largest_block;
+    silent_frames = silence_horizon;
+
+    if (any_threaded) {
+        worker = ConvolutionWorker::acquire();
+        worker->add(this);
     }
 }
 
-void Convolver::setImpulseResponse(float* ir_buffer, size_t ir_length) {
-    if (impulse_response) {
-        delete[] impulse_response;
+void Convolver::release() {
+    if (worker) {
+        worker->remove(this);
+        worker.reset();
     }
-    impulse_response = new float[ir_length];
-    this->ir_length = ir_length;
-    for (size_t i = 0; i < ir_length; ++i) {
-        impulse_response[i] = ir_buffer[i];
+    for (StageState* state : stages) {
+        delete state->fft;
+        delete[] state->input;
+        delete[] state->job_input;
+        delete[] state->fdl;
+        delete[] state->output;
+        delete[] state->next_output;
+        delete[] state->accumulator;
+        delete[] state->time;
+        delete state;
     }
-    // Reset history buffer
-    if (history_buffer) {
-        delete[] history_buffer;
+    stages.clear();
+    delete[] history;
+    history = nullptr;
+}
+
+void Convolver::reset() {
+    const size_t head = kernel->getHeadSize();
+    std::fill(history, history + n_channels * (head - 1 + kChunk), 0.f);
+    // Jobs still waiting are dropped along with the rest of the state
+    std::unique_lock<std::mutex> paused;
+    if (worker) {
+        paused = worker->pause();
     }
-    history_buffer = new float[ir_length];
-    for (size_t i = 0; i < ir_length; ++i) {
-        history_buffer[i] = 0.0f;
+    for (StageState* state : stages) {
+        state->pending.store(false, std::memory_order_relaxed);
+        const size_t block = state->stage->block;
+        std::fill(state->input, state->input + n_channels * 2 * block, 0.f);
+        std::fill(state->fdl, state->fdl + n_channels * state->fdl_slots * (2 * block + 2), 0.f);
+        std::fill(state->output, state->output + n_channels * block, 0.f);
+        if (state->threaded) {
+            std::fill(state->next_output, state->next_output + n_channels * block, 0.f);
+        }
+        state->fill = 0;
+        state->dropped = 0;
+        state->job_dropped = 0;
     }
+    silent_frames = silence_horizon;
 }
 
 float Convolver::tick(float input) {
-    // Shift history buffer to make room for new input
-    // Using memmove for efficient overlapping memory copy
-    if (ir_length > 1) {
-        std::memmove(&history_buffer[1], &history_buffer[0], (ir_length - 1) * sizeof(float));
+    float output = 0.f;
+    chunk_inputs.assign(n_channels, nullptr);
+    chunk_outputs.assign(n_channels, nullptr);
+    chunk_inputs[0] = &input;
+    chunk_outputs[0] = &output;
+    processChunk(chunk_inputs.data(), chunk_outputs.data(), 1);
+    return output;
+}
+
+void Convolver::process(const float* const* inputs, float* const* outputs, size_t n_frames) {
+    for (size_t start = 0; start < n_frames; start += kChunk) {
+        for (size_t c = 0; c < n_channels; ++c) {
+            chunk_inputs[c] = (inputs[c]) ? inputs[c] + start : nullptr;
+            chunk_outputs[c] = (outputs[c]) ? outputs[c] + start : nullptr;
+        }
+        processChunk(chunk_inputs.data(), chunk_outputs.data(), std::min(kChunk, n_frames - start));
     }
-    history_buffer[0] = input;
+}
 
-    // Compute convolution sum using SIMD
-    os_simd_t acc = OS_SIMD_SET1(0.0f);
+void Convolver::processChunk(const float* const* inputs, float* const* outputs, size_t n_frames) {
+    const size_t head = kernel->getHeadSize();
+    const size_t stride = head - 1 + kChunk;
 
-    size_t i = 0;
-    const size_t simd_end = (ir_length / OS_SIMD_WIDTH) * OS_SIMD_WIDTH;
+    // Take the input first, so outputs may alias it
+    bool silent = true;
+    for (size_t c = 0; c < n_channels; ++c) {
+        float* current = history + c * stride + head - 1;
+        if (inputs[c]) {
+            std::memcpy(current, inputs[c], n_frames * sizeof(float));
+            for (size_t i = 0; i < n_frames && silent; ++i) {
+                silent = std::abs(current[i]) <= kSilence;
+            }
+        } else {
+            std::fill(current, current + n_frames, 0.f);
+        }
+    }
+    silent_frames = (silent) ? std::min(silent_frames + n_frames, silence_horizon) : 0;
 
-    // Process OS_SIMD_WIDTH samples at a time using FMA
-    for (; i < simd_end; i += OS_SIMD_WIDTH) {
-        os_simd_t h = OS_SIMD_LOAD(&history_buffer[i]);
-        os_simd_t ir = OS_SIMD_LOAD(&impulse_response[i]);
-        acc = OS_SIMD_FMADD(h, ir, acc);  // acc += h * ir
+    for (size_t c = 0; c < n_channels; ++c) {
+        if (outputs[c]) {
+            runHead(c, outputs[c], n_frames);
+        }
     }
 
-    // Horizontal sum of SIMD accumulator
-    float sum = 0.0f;
-#ifdef OS_AVX
-    // For AVX: sum all 8 lanes
-    // Extract high and low 128-bit lanes
-    __m128 low = _mm256_castps256_ps128(acc);
-    __m128 high = _mm256_extractf128_ps(acc, 1);
-    __m128 sum128 = _mm_add_ps(low, high);
+    for (StageState* state : stages) {
+        const size_t block = state->stage->block;
+        size_t position = 0;
+        while (position < n_frames) {
+            const size_t n = std::min(n_frames - position, block - state->fill);
+            for (size_t c = 0; c < n_channels; ++c) {
+                std::memcpy(state->input + c * 2 * block + block + state->fill, history + c * stride + head - 1 + position, n * sizeof(float));
+                if (outputs[c]) {
+                    vectorAdd(outputs[c] + position, state->output + c * block + state->fill, n);
+                }
+            }
+            state->fill += n;
+            position += n;
+            if (state->fill == block) {
+                finishBlock(*state);
+                state->fill = 0;
+            }
+        }
+    }
+
+    // Keep the last head - 1 inputs in front of the next chunk
+    for (size_t c = 0; c < n_channels; ++c) {
+        float* channel_history = history + c * stride;
+        std::memmove(channel_history, channel_history + n_frames, (head - 1) * sizeof(float));
+    }
+}
+
+void Convolver::runHead(size_t channel, float* out, size_t n_frames) {
+    // Direct convolution with the head taps, vectorized along the output: out[i] += h[j] * x[i - j] for every tap j
+    const size_t head = kernel->getHeadSize();
+    const float* taps = kernel->getHead();
+    const float* x = history + channel * (head - 1 + kChunk) + head - 1;
+    std::fill(out, out + n_frames, 0.f);
+    const size_t n_vector = n_frames / OS_SIMD_WIDTH * OS_SIMD_WIDTH;
+    for (size_t j = 0; j < head; ++j) {
+        const float tap = taps[j];
+        if (tap == 0.f) {
+            continue;
+        }
+        const os_simd_t h = OS_SIMD_SET1(tap);
+        const float* source = x - j;
+        size_t i = 0;
+        for (; i < n_vector; i += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE(out + i, OS_SIMD_ADD(OS_SIMD_LOAD(out + i), OS_SIMD_MUL(h, OS_SIMD_LOAD(source + i))));
+        }
+        for (; i < n_frames; ++i) {
+            out[i] += tap * source[i];
+        }
+    }
+}
+
+void Convolver::finishBlock(StageState& state) {
+    const size_t block = state.stage->block;
+    if (!state.threaded) {
+        convolveBlock(state, state.input, state.output);
+    } else if (state.pending.load(std::memory_order_acquire)) {
+        // Overrun: the worker is still on the last block. This block plays silence and is not handed over.
+        std::fill(state.output, state.output + n_channels * block, 0.f);
+        ++state.dropped;
+        overruns.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // Pick up the block the worker computed at the last boundary and hand it this one. After an overrun the
+        // result is a block late, and the block due now was never computed, so the stage stays silent once more.
+        std::swap(state.output, state.next_output);
+        if (state.dropped > 0) {
+            std::fill(state.output, state.output + n_channels * block, 0.f);
+        }
+        std::memcpy(state.job_input, state.input, n_channels * 2 * block * sizeof(float));
+        state.job_dropped = state.dropped;
+        state.dropped = 0;
+        state.pending.store(true, std::memory_order_release);
+        worker->wake();
+    }
+
+    // The current block becomes the first half of the next window
+    for (size_t c = 0; c < n_channels; ++c) {
+        float* window = state.input + c * 2 * block;
+        std::memcpy(window, window + block, block * sizeof(float));
+    }
+}
+
+void Convolver::convolveBlock(StageState& state, const float* windows, float* out) {
+    const ConvolutionKernel::Stage& stage = *state.stage;
+    const size_t block = stage.block;
+    const size_t spectrum_size = 2 * block + 2;
+    const int n_bins = static_cast<int>(block + 1);
+    // Blocks dropped by overruns take their slots as silence, so the partitions stay lined up with the input
+    for (size_t d = 0; d < std::min(state.job_dropped, state.fdl_slots); ++d) {
+        state.fdl_position = (state.fdl_position + 1) % state.fdl_slots;
+        for (size_t c = 0; c < n_channels; ++c) {
+            std::fill_n(state.fdl + (c * state.fdl_slots + state.fdl_position) * spectrum_size, spectrum_size, 0.f);
+        }
+    }
+    state.job_dropped = 0;
+    state.fdl_position = (state.fdl_position + 1) % state.fdl_slots;
 
-    // Horizontal add within 128-bit lane
-    sum128 = _mm_hadd_ps(sum128, sum128);
-    sum128 = _mm_hadd_ps(sum128, sum128);
+    for (size_t c = 0; c < n_channels; ++c) {
+        float* fdl = state.fdl + c * state.fdl_slots * spectrum_size;
+        state.fft->forwardReal(windows + c * 2 * block, fdl + state.fdl_position * spectrum_size);
 
-    // Extract scalar result
-    sum = _mm_cvtss_f32(sum128);
-#else
-    // For SSE or other: store and manually sum
-    float temp[OS_SIMD_WIDTH];
-    OS_SIMD_STORE(temp, acc);
-    for (int j = 0; j < OS_SIMD_WIDTH; ++j) {
-        sum += temp[j];
+        // Partition p multiplies the spectrum p + fdl_shift blocks old
+        ippsZero_32f(state.accumulator, static_cast<int>(spectrum_size));
+        for (size_t p = 0; p < stage.n_partitions; ++p) {
+            const size_t slot = (state.fdl_position + state.fdl_slots - p - state.fdl_shift) % state.fdl_slots;
+            ippsAddProduct_32fc(reinterpret_cast<const Ipp32fc*>(fdl + slot * spectrum_size),
+                                reinterpret_cast<const Ipp32fc*>(stage.spectra + p * spectrum_size),
+                                reinterpret_cast<Ipp32fc*>(state.accumulator), n_bins);
+        }
+        state.fft->inverseReal(state.accumulator, state.time);
+
+        // Overlap-save: the second half is the linear convolution of the current block
+        std::memcpy(out + c * block, state.time + block, block * sizeof(float));
+    }
+}
+
+Convolver::StageState* Convolver::getNextJob() const {
+    // Stages are ordered by block size
+    for (StageState* state : stages) {
+        if (state->threaded && state->pending.load(std::memory_order_acquire)) {
+            return state;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<ConvolutionWorker> ConvolutionWorker::acquire() {
+    static std::mutex instance_mutex;
+    static std::weak_ptr<ConvolutionWorker> instance;
+    std::lock_guard<std::mutex> lock(instance_mutex);
+    std::shared_ptr<ConvolutionWorker> worker = instance.lock();
+    if (!worker) {
+        worker.reset(new ConvolutionWorker());
+        instance = worker;
     }
-#endif
+    return worker;
+}
+
+ConvolutionWorker::ConvolutionWorker() {
+    thread = std::thread(&ConvolutionWorker::loop, this);
+}
 
-    // Handle remaining elements (tail)
-    for (; i < ir_length; ++i) {
-        sum += history_buffer[i] * impulse_response[i];
+ConvolutionWorker::~ConvolutionWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
     }
+    wake_condition.notify_one();
+    thread.join();
+}
 
-    return sum;
+void ConvolutionWorker::add(Convolver* convolver) {
+    std::lock_guard<std::mutex> lock(mutex);
+    convolvers.push_back(convolver);
 }
 
+void ConvolutionWorker::remove(Convolver* convolver) {
+    std::lock_guard<std::mutex> lock(mutex);
+    convolvers.erase(std::remove(convolvers.begin(), convolvers.end(), convolver), convolvers.end());
+}
 
+void ConvolutionWorker::loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stop) {
+        // One job at a time, smallest block first across every convolver: its result is due soonest
+        Convolver* next = nullptr;
+        Convolver::StageState* job = nullptr;
+        for (Convolver* convolver : convolvers) {
+            Convolver::StageState* state = convolver->getNextJob();
+            if (state && (!job || state->stage->block < job->stage->block)) {
+                next = convolver;
+                job = state;
+            }
+        }
+        if (!job) {
+            wake_condition.wait_for(lock, kPoll);
+            continue;
+        }
+        next->convolveBlock(*job, job->job_input, job->next_output);
+        job->pending.store(false, std::memory_order_release);
+    }
+}
 
-} // namespace OrangeSodium
\ No newline at end of file
+} // namespace OrangeSodium
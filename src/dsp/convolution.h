@@ -1,21 +1,192 @@
 #pragma once
 #include "../simd.h"
+#include "fft.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Partitioned convolution
+
+The impulse response is split into a head and a number of stages:
+- Head: the first head_size taps, convolved directly in the time domain, so the output has no latency.
+- Stages: uniformly partitioned overlap-save convolution with a frequency-domain delay line. A stage with block
+  size B covers the taps [offset, offset + n_partitions * B). Its output for a block is ready when the block of
+  input is complete, i.e. B frames late, so every stage starts at least B taps into the response and the delay is
+  absorbed by skipping FDL slots.
+
+Non-uniform layout: the block size grows 8x per stage (up to kMaxBlock), and stage k > 0 starts at 2 B_k. Stage 0
+runs at the head size and covers the taps up to the start of stage 1. Uniform layout: every stage uses the head
+size; the first covers one block and the second the rest.
+
+Stages that start at least 2 B taps in have a whole block of slack, so a Convolver can hand them to a background
+thread: at each boundary the block is passed to the worker and the result is picked up one boundary later. Only
+stages with B at least the largest process call are handed over; a call could cross two boundaries of a shorter
+block at once, leaving the worker no time at all. Every threaded Convolver of the process shares one worker thread
+(ConvolutionWorker), which runs the waiting jobs one at a time, smallest block first. The audio side never waits
+for the worker. If a result is not ready at its boundary (an overrun), the stage plays
+silence for that block and the next one, the block it could not hand over is left out of the delay line, and
+getNumOverruns counts it.
+
+ConvolutionKernel holds the head taps and the partition spectra. It is read-only once built and can be shared by
+any number of Convolvers (e.g. every channel or every instance of a reverb with the same IR). A Convolver holds the
+per-channel state (input windows, delay lines, output blocks).
+*/
 
-// Efficient convolution using SIMD
 namespace OrangeSodium{
 
+class ConvolutionKernel {
+public:
+    static constexpr size_t kMaxBlock = 8192; // Largest partition (FFT of 16384)
+    static constexpr size_t kGrowth = 8;      // Block size ratio of neighbouring stages
+
+    struct Stage {
+        size_t block;          // Partition size B; the FFT is 2B
+        size_t offset_blocks;  // First tap of the stage, in blocks
+        size_t n_partitions;
+        float* spectra;        // [partition * (2B + 2)], CCS spectra of the zero-padded partitions
+    };
+
+    /// @brief Partition an impulse response. Builds FFTs, so call it outside the audio thread.
+    /// @param head_size Taps convolved directly, rounded up to a power of two (16 to 1024)
+    /// @param uniform Use head_size for every partition instead of growing blocks
+    ConvolutionKernel(const float* ir, size_t ir_length, size_t head_size = 64, bool uniform = false);
+    ~ConvolutionKernel();
+
+    size_t getLength() const { return ir_length; }
+    size_t getHeadSize() const { return head_size; }
+    const float* getHead() const { return head; }
+    size_t getNumStages() const { return stages.size(); }
+    const Stage& getStage(size_t index) const { return stages[index]; }
+
+private:
+    size_t ir_length;
+    size_t head_size;
+    float* head;           // head_size taps, zero padded past ir_length
+    std::vector<Stage> stages;
+
+    void addStage(const float* ir, size_t block, size_t begin, size_t end);
+};
+
+class Convolver;
+
+/// @brief Background thread shared by every threaded Convolver of the process, so the number of threads does not grow
+/// with voices, routes or plugin instances. It lives while any threaded Convolver holds it.
+class ConvolutionWorker {
+public:
+    static std::shared_ptr<ConvolutionWorker> acquire();
+    ~ConvolutionWorker();
+
+    /// @brief Register or unregister a convolver. remove returns once no job of the convolver is running.
+    void add(Convolver* convolver);
+    void remove(Convolver* convolver);
+
+    /// @brief Signal a new job. Does not take the mutex, so the audio thread can call it; a wake-up that slips in
+    /// before the worker waits is caught by kPoll.
+    void wake() { wake_condition.notify_one(); }
+
+    /// @brief Hold the worker off while the calling thread works on a convolver's state; no job runs meanwhile
+    std::unique_lock<std::mutex> pause() { return std::unique_lock<std::mutex>(mutex); }
+
+private:
+    static constexpr std::chrono::milliseconds kPoll{1};
+
+    std::thread thread;
+    std::mutex mutex;      // Held by the worker while it runs jobs
+    std::condition_variable wake_condition;
+    bool stop = false;
+    std::vector<Convolver*> convolvers;
+
+    ConvolutionWorker();
+    void loop();
+};
+
 class Convolver {
 public:
-    Convolver(float* ir_buffer, size_t ir_length);
+    /// @brief Convolve n_channels signals with a shared kernel
+    /// @param threaded_tail Run the stages with a block of slack on a background thread
+    /// @param max_process_frames Most frames passed to one process call; shorter stages stay on the calling thread
+    Convolver(std::shared_ptr<const ConvolutionKernel> kernel, size_t n_channels, bool threaded_tail = false, size_t max_process_frames = kChunk);
+
+    /// @brief Single-channel convolver with its own kernel
+    Convolver(const float* ir_buffer, size_t ir_length);
     ~Convolver();
 
-    void setImpulseResponse(float* ir_buffer, size_t ir_length);
-    inline float tick(float input);
+    /// @brief Replace the impulse response (builds a new kernel and clears the state; not for the audio thread)
+    void setImpulseResponse(const float* ir_buffer, size_t ir_length);
+
+    /// @brief Convolve n_frames frames of every channel. outputs are overwritten with the wet signal and may alias inputs.
+    void process(const float* const* inputs, float* const* outputs, size_t n_frames);
+
+    /// @brief One sample of channel 0. Same result as process, without its per-block efficiency.
+    float tick(float input);
+
+    /// @brief Clear every channel's state. Waits for a running background job, so call it outside the audio thread.
+    void reset();
+
+    /// @brief True once the input has been below kSilence for longer than the response (and its block delays) lasts
+    bool isSilent() const { return silent_frames >= silence_horizon; }
+
+    size_t getNumChannels() const { return n_channels; }
+    const ConvolutionKernel* getKernel() const { return kernel.get(); }
+    bool isTailThreaded() const { return threaded_tail; }
+    /// @brief Blocks whose threaded result was not ready in time (see the overview)
+    size_t getNumOverruns() const { return overruns.load(std::memory_order_relaxed); }
 
 private:
-    float* impulse_response;
-    float* history_buffer;
-    size_t ir_length;
+    static constexpr size_t kChunk = 256; // Frames handled per pass of process
+    static constexpr float kSilence = 1e-7f;
+
+    struct StageState {
+        const ConvolutionKernel::Stage* stage;
+        FFTManager* fft;
+        bool threaded;
+        size_t fdl_slots;      // Spectra kept per channel
+        size_t fdl_shift;      // Slots skipped before the first partition
+        size_t fdl_position;   // Slot of the newest spectrum
+        size_t fill;           // Frames of the current block received so far
+        size_t dropped;        // Threaded stages: blocks not handed over since the last job (overruns)
+        size_t job_dropped;    // Threaded stages: dropped blocks the worker leaves as silent slots before the job
+        float* input;          // [channel * 2B]: previous block, then the current one
+        float* job_input;      // [channel * 2B]: threaded stages: the window handed to the worker
+        float* fdl;            // [(channel * fdl_slots + slot) * (2B + 2)]
+        float* output;         // [channel * B]: block being played
+        float* next_output;    // [channel * B]: threaded stages: block the worker writes
+        float* accumulator;    // 2B + 2
+        float* time;           // 2B
+        std::atomic<bool> pending{false}; // A job has been handed to the worker and not finished
+    };
+
+    std::shared_ptr<const ConvolutionKernel> kernel;
+    size_t n_channels;
+    bool threaded_tail;
+    size_t max_process_frames;
+    std::vector<StageState*> stages;
+    float* history;        // [channel * (head - 1 + kChunk)]: the last head - 1 inputs, then the current chunk
+    size_t silent_frames = 0;
+    size_t silence_horizon = 0;
+    std::vector<const float*> chunk_inputs;
+    std::vector<float*> chunk_outputs;
+
+    std::shared_ptr<ConvolutionWorker> worker; // Only set if a stage is threaded
+    std::atomic<size_t> overruns{0};
+
+    void allocate();
+    void release();
+    void processChunk(const float* const* inputs, float* const* outputs, size_t n_frames);
+    void runHead(size_t channel, float* out, size_t n_frames);
+    void finishBlock(StageState& state);
+    /// @brief FFT a window into the delay line and sum the partitions into out (B frames per channel)
+    void convolveBlock(StageState& state, const float* windows, float* out);
+
+    friend class ConvolutionWorker;
+    /// @brief The waiting threaded stage with the smallest block, or nullptr
+    StageState* getNextJob() const;
 };
 
-}
\ No newline at end of file
+}
@@ -11,13 +11,13 @@
 namespace OrangeSodium {
 
 DelayLine::DelayLine(size_t max_delay_samples)
-    : max_delay(max_delay_samples),
+    : buffer(nullptr),
+      max_delay(max_delay_samples),
       write_index(0),
       delay_samples(max_delay_samples),
       mod_phase(0.0f),
       mod_amount(0.0f) {
-    buffer = new float[max_delay];
-    std::memset(buffer, 0, max_delay * sizeof(float));
+    allocate();
 }
 
 DelayLine::~DelayLine() {
@@ -27,6 +27,32 @@ DelayLine::~DelayLine() {
     }
 }
 
+void DelayLine::allocate() {
+    // Room for max_delay samples behind the newest one, plus the point after it for interpolation
+    size_t length = 1;
+    while (length < max_delay + 2) {
+        length <<= 1;
+    }
+    mask = length - 1;
+    buffer = new float[length + 1]; // Plus a copy of the first point, so pairs of points can be read without wrapping
+    std::memset(buffer, 0, (length + 1) * sizeof(float));
+}
+
+void DelayLine::reset() {
+    write_index = 0;
+    std::memset(buffer, 0, (mask + 2) * sizeof(float));
+    mod_phase = 0.0f;
+}
+
+void DelayLine::copyStateFrom(const DelayLine& other) {
+    if (other.mask != mask) {
+        return;
+    }
+    std::memcpy(buffer, other.buffer, (mask + 2) * sizeof(float));
+    write_index = other.write_index;
+    mod_phase = other.mod_phase;
+}
+
 void DelayLine::setDelayTime(size_t delay_samples) {
     // Clamp to valid range
     this->delay_samples = std::min(delay_samples, max_delay);
@@ -38,8 +64,7 @@ void DelayLine::setMaxDelayTime(size_t max_delay_samples) {
         delete[] buffer;
     }
     max_delay = max_delay_samples;
-    buffer = new float[max_delay];
-    std::memset(buffer, 0, max_delay * sizeof(float));
+    allocate();
 
     // Reset state
     write_index = 0;
@@ -50,6 +75,7 @@ void DelayLine::setMaxDelayTime(size_t max_delay_samples) {
 float DelayLine::tick(float input_sample) {
     // Write input to circular buffer
     buffer[write_index] = input_sample;
+    buffer[mask + 1] = buffer[0];
 
     // Calculate modulated delay time
     // LFO frequency: ~1 Hz at 44.1kHz (adjustable by scaling mod_phase increment)
@@ -66,12 +92,13 @@ float DelayLine::tick(float input_sample) {
     // Clamp modulated delay to valid range
     const float clamped_delay = std::max(1.0f, std::min(modulated_delay, static_cast<float>(max_delay - 1)));
 
-    // Calculate read position (fractional) and read from circular buffer with interpolation
-    float read_pos = static_cast<float>(write_index) - clamped_delay;
-    const float output_sample = readCircularBufferLinear(buffer, max_delay, read_pos);
+    // Read position behind the write position; adding the buffer length keeps it positive and the mask wraps it
+    const float whole = std::ceil(clamped_delay);
+    const size_t index0 = write_index + mask + 1 - static_cast<size_t>(whole);
+    const float output_sample = interpolateLinear(buffer[index0 & mask], buffer[(index0 + 1) & mask], whole - clamped_delay);
 
     // Advance write index (circular buffer)
-    write_index = (write_index + 1) % max_delay;
+    write_index = (write_index + 1) & mask;
 
     // Advance modulation phase
     mod_phase += lfo_increment;
@@ -84,4 +111,66 @@ float DelayLine::tick(float input_sample) {
     return output_sample;
 }
 
+void DelayLine::write(const float* input, size_t n, size_t stride) {
+    if (stride == 1) {
+        // At most two copies: up to the end of the buffer, then from its start
+        const size_t first = std::min(n, mask + 1 - write_index);
+        std::memcpy(buffer + write_index, input, first * sizeof(float));
+        std::memcpy(buffer, input + first, (n - first) * sizeof(float));
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            buffer[(write_index + i) & mask] = input[i * stride];
+        }
+    }
+    buffer[mask + 1] = buffer[0];
+    write_index = (write_index + n) & mask;
+}
+
+void DelayLine::read(float* out, size_t n, size_t delay, size_t stride) const {
+    const size_t start = (write_index + mask + 1 - delay) & mask;
+    if (stride == 1) {
+        const size_t first = std::min(n, mask + 1 - start);
+        std::memcpy(out, buffer + start, first * sizeof(float));
+        std::memcpy(out + first, buffer, (n - first) * sizeof(float));
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            out[i * stride] = buffer[(start + i) & mask];
+        }
+    }
+}
+
+void DelayLine::readRamped(float* out, size_t n, float delay_start, float delay_end, size_t stride) const {
+    // Frame i reads offset_i = frac + i * (1 - step) past index0. The offsets stay small, so they keep their
+    // fractional precision in any buffer length, and index0 starts far enough back for them to stay positive
+    // when the delay grows faster than time passes. OS_SIMD_WIDTH frames are worked out at a time; each lane
+    // loads its pair of points at once, which the guard point makes safe at the end of the buffer.
+    const float step = (delay_end - delay_start) / static_cast<float>(n);
+    const float increment = 1.f - step;
+    const size_t bias = (increment < 0.f) ? static_cast<size_t>(std::ceil(-increment * static_cast<float>(n))) + 1 : 0;
+    const float whole = std::ceil(delay_start);
+    const size_t index0 = write_index + mask + 1 - static_cast<size_t>(whole) - bias;
+    const float frac = whole - delay_start + static_cast<float>(bias);
+
+    alignas(OS_SIMD_ALIGNMENT) float lanes[OS_SIMD_WIDTH];
+    alignas(OS_SIMD_ALIGNMENT) int indices[OS_SIMD_WIDTH];
+    for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+        lanes[l] = frac + increment * static_cast<float>(l);
+    }
+    const os_simd_t first_offsets = OS_SIMD_LOAD_ALIGNED(lanes);
+    for (size_t i = 0; i < n; i += OS_SIMD_WIDTH) {
+        const os_simd_t offset = OS_SIMD_ADD(first_offsets, OS_SIMD_SET1(increment * static_cast<float>(i)));
+        const os_simd_t offset_whole = simdFloorToIndices(offset, indices);
+        for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+            indices[l] = static_cast<int>((index0 + static_cast<size_t>(indices[l])) & mask);
+        }
+        os_simd_t x0, x1;
+        simdGather2(buffer, indices, x0, x1);
+        OS_SIMD_STORE_ALIGNED(lanes, simdInterpolateLinear(x0, x1, OS_SIMD_SUB(offset, offset_whole)));
+        const size_t n_lanes = std::min(static_cast<size_t>(OS_SIMD_WIDTH), n - i);
+        for (size_t l = 0; l < n_lanes; ++l) {
+            out[(i + l) * stride] = lanes[l];
+        }
+    }
+}
+
 } // namespace OrangeSodium
@@ -1,4 +1,14 @@
 #pragma once
+#include <cstddef>
+
+/*
+Circular delay line. The buffer is a power of two long, so positions wrap with a mask instead of a modulo.
+
+Besides the per-sample tick, blocks can be written and read in one call: write appends n samples, and read /
+readRamped fetch the n samples that line up with the next n writes. A block read needs every sample it touches to
+be written already, so its delay must be at least n (n + 1 for fractional delays). Both take a stride, so they can
+fill or drain one column of an interleaved (frame-major) buffer.
+*/
 
 namespace OrangeSodium{
 
@@ -16,6 +26,16 @@ public:
     /// @return The delayed output sample
     float tick(float input_sample);
 
+    /// @brief Append n samples, taken every stride floats from input
+    void write(const float* input, size_t n, size_t stride = 1);
+
+    /// @brief out[i * stride] = the sample written delay writes before the (i + 1)th of the next n writes; delay >= n
+    void read(float* out, size_t n, size_t delay, size_t stride = 1) const;
+
+    /// @brief Like read, with a fractional delay moving linearly from delay_start (first frame) towards delay_end
+    /// (one frame past the last), read with linear interpolation; both delays >= n + 1
+    void readRamped(float* out, size_t n, float delay_start, float delay_end, size_t stride = 1) const;
+
     /// @brief Set the modulation amount for modulated delay
     void setModulationAmount(float mod_amount) {
         this->mod_amount = mod_amount;
@@ -27,16 +47,14 @@ public:
         return mod_amount;
     }
 
-    void reset() {
-        write_index = 0;
-        for (size_t i = 0; i < max_delay; ++i) {
-            buffer[i] = 0.0f;
-        }
-        mod_phase = 0.0f;
-    }
+    void reset();
+
+    /// @brief Take over the contents and position of a line of the same length
+    void copyStateFrom(const DelayLine& other);
 
     /// @brief Set the max delay time in samples
     void setMaxDelayTime(size_t max_delay_samples);
+    size_t getMaxDelayTime() const { return max_delay; }
 
     /// @brief Set the sample rate
     void setSampleRate(float rate) {
@@ -45,14 +63,17 @@ public:
 
 private:
     float* buffer;
+    size_t mask;           // Buffer length - 1; the length is a power of two above max_delay, plus one guard point
+                           // after the end that mirrors the first
     size_t max_delay;
     size_t write_index;
     size_t delay_samples;
-    float sample_rate;
+    float sample_rate = 48000.0f;
 
     float mod_phase; // Used for modulated delay using sine LFO
     float mod_amount; // Amount of modulation to apply
 
+    void allocate();
 };
 
-}
\ No newline at end of file
+}
@@ -54,6 +54,25 @@ bool FFTManager::initialize(int order){
         return false; // allocation failure
     }
 
+    // ---- real FFT of the same order ----
+    int sizeRealSpec = 0, sizeRealInit = 0, sizeRealBuf = 0;
+    st = ippsFFTGetSize_R_32f(order, IPP_FFT_DIV_INV_BY_N, hint_, &sizeRealSpec, &sizeRealInit, &sizeRealBuf);
+    if (st != ippStsNoErr) return false;
+
+    std::unique_ptr<Ipp8u, IppFree> realSpecMem( sizeRealSpec ? ippsMalloc_8u(sizeRealSpec) : nullptr );
+    std::unique_ptr<Ipp8u, IppFree> realInitMem( sizeRealInit ? ippsMalloc_8u(sizeRealInit) : nullptr );
+    std::unique_ptr<Ipp8u, IppFree> realBuf    ( sizeRealBuf  ? ippsMalloc_8u(sizeRealBuf)  : nullptr );
+    if ((sizeRealSpec && !realSpecMem) || (sizeRealInit && !realInitMem) || (sizeRealBuf && !realBuf))
+        return false; // allocation failure
+
+    IppsFFTSpec_R_32f* realSpecTmp = nullptr;
+    st = ippsFFTInit_R_32f(&realSpecTmp, order, IPP_FFT_DIV_INV_BY_N, hint_, realSpecMem.get(), realInitMem.get());
+    if (st != ippStsNoErr) return false;
+
+    real_spec_     = realSpecTmp;
+    real_spec_mem_ = std::move(realSpecMem);
+    real_buf_      = std::move(realBuf);
+
     // initMem is temporary and frees automatically here
     return true;
 }
@@ -117,6 +136,14 @@ void FFTManager::brickwallWaveform(const float* input, float* output, size_t bin
     }
 }
 
+void FFTManager::forwardReal(const float* input, float* spectrum) {
+    ippsFFTFwd_RToCCS_32f(input, spectrum, real_spec_, real_buf_.get());
+}
+
+void FFTManager::inverseReal(const float* spectrum, float* output) {
+    ippsFFTInv_CCSToR_32f(spectrum, output, real_spec_, real_buf_.get());
+}
+
 FFTManager::~FFTManager() {
     // unique_ptrs automatically free memory
 }
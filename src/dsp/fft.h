@@ -24,6 +24,15 @@ public:
 
     void brickwallWaveform(const float* input, float* output, size_t bin_cutoff);
 
+    /// @brief Real forward FFT of getSize() samples. The spectrum is in IPP's CCS format: getSize() / 2 + 1 complex
+    /// bins (getSize() + 2 floats), so it can be read as Ipp32fc.
+    void forwardReal(const float* input, float* spectrum);
+
+    /// @brief Real inverse FFT of a CCS spectrum, scaled by 1 / getSize()
+    void inverseReal(const float* spectrum, float* output);
+
+    int getSize() const { return fft_size_; }
+
 private:
     IppHintAlgorithm hint_{ippAlgHintAccurate};
     // IPP objects
@@ -36,6 +45,11 @@ private:
     std::unique_ptr<Ipp32fc, IppFreeCplx> complex_buf1_; // reusable buffer
     std::unique_ptr<Ipp32fc, IppFreeCplx> complex_buf2_; // reusable buffer
 
+    // Real FFT of the same size, for convolution
+    IppsFFTSpec_R_32f* real_spec_ = nullptr;        // points INTO real_spec_mem_
+    std::unique_ptr<Ipp8u, IppFree> real_spec_mem_; // owns spec storage
+    std::unique_ptr<Ipp8u, IppFree> real_buf_;      // scratch for real calls
+
     bool initialize(int order);
 };
 
@@ -1,4 +1,6 @@
 #pragma once
+#include "../simd.h"
+#include <cstddef>
 
 namespace OrangeSodium {
 
@@ -28,6 +30,23 @@ inline float interpolateCubic(float xm1, float x0, float x1, float x2, float fra
     return ((c3 * frac + c2) * frac + c1) * frac + c0;
 }
 
+/// @brief 4-point, 3rd-order Lagrange interpolation. Passes through all four points, where the Hermite form
+/// (interpolateCubic, which is the same polynomial as interpolateCatmullRom) only matches the slopes at x0 and x1.
+/// @param xm1 Sample at position -1
+/// @param x0 Sample at position 0
+/// @param x1 Sample at position 1
+/// @param x2 Sample at position 2
+/// @param frac Fractional position [0, 1] between x0 and x1
+/// @return Interpolated value
+inline float interpolateLagrange4(float xm1, float x0, float x1, float x2, float frac) {
+    const float c0 = x0;
+    const float c1 = x1 - (1.0f / 3.0f) * xm1 - 0.5f * x0 - (1.0f / 6.0f) * x2;
+    const float c2 = 0.5f * (xm1 + x1) - x0;
+    const float c3 = (1.0f / 6.0f) * (x2 - xm1) + 0.5f * (x0 - x1);
+
+    return ((c3 * frac + c2) * frac + c1) * frac + c0;
+}
+
 /// @brief Catmull-Rom spline interpolation (4-point)
 /// @param xm1 Sample at position -1
 /// @param x0 Sample at position 0
@@ -47,32 +66,157 @@ inline float interpolateCatmullRom(float xm1, float x0, float x1, float x2, floa
     return a0 * frac3 + a1 * frac2 + a2 * frac + a3;
 }
 
-/// @brief 6-point, 5th-order Hermite interpolation (optimal)
+/// @brief 6-point, 5th-order Hermite interpolation
 /// @param buffer Pointer to buffer containing at least 6 samples starting at offset-2
 /// @param frac Fractional position [0, 1] between sample[2] and sample[3]
 /// @return Interpolated value
 inline float interpolateHermite6(const float* buffer, float frac) {
-    // Using optimal 6-point, 5th-order Hermite interpolation
+    // 6-point, 5th-order Hermite (x-form)
     // buffer[0] = x[-2], buffer[1] = x[-1], buffer[2] = x[0],
     // buffer[3] = x[1], buffer[4] = x[2], buffer[5] = x[3]
+    const float xm2 = buffer[0];
+    const float xm1 = buffer[1];
+    const float x0 = buffer[2];
+    const float x1 = buffer[3];
+    const float x2 = buffer[4];
+    const float x3 = buffer[5];
 
-    const float even1 = buffer[3] + buffer[2];
-    const float odd1 = buffer[3] - buffer[2];
-    const float even2 = buffer[4] + buffer[1];
-    const float odd2 = buffer[4] - buffer[1];
-    const float even3 = buffer[5] + buffer[0];
-    const float odd3 = buffer[5] - buffer[0];
-
-    const float c0 = buffer[2];
-    const float c1 = 0.04166666666666666667f * odd3 - 0.29166666666666666667f * odd2 + 1.25f * odd1;
-    const float c2 = 0.04166666666666666667f * even3 - 0.41666666666666666667f * even2 + 1.375f * even1 - 1.0f * buffer[2];
-    const float c3 = 0.20833333333333333333f * odd2 - 0.625f * odd1 - 0.04166666666666666667f * odd3;
-    const float c4 = 0.125f * even3 - 0.625f * even2 + 1.5f * even1 - buffer[2];
-    const float c5 = 0.04166666666666666667f * odd3 - 0.20833333333333333333f * odd2 + 0.375f * odd1;
+    const float c0 = x0;
+    const float c1 = (1.0f / 12.0f) * (xm2 - x2) + (2.0f / 3.0f) * (x1 - xm1);
+    const float c2 = (13.0f / 12.0f) * xm1 - (25.0f / 12.0f) * x0 + 1.5f * x1 - (11.0f / 24.0f) * x2 + (1.0f / 12.0f) * x3 - 0.125f * xm2;
+    const float c3 = (5.0f / 12.0f) * x0 - (7.0f / 12.0f) * x1 + (7.0f / 24.0f) * x2 - (1.0f / 24.0f) * (xm2 + xm1 + x3);
+    const float c4 = 0.125f * xm2 - (7.0f / 12.0f) * xm1 + (13.0f / 12.0f) * x0 - x1 + (11.0f / 24.0f) * x2 - (1.0f / 12.0f) * x3;
+    const float c5 = (1.0f / 24.0f) * (x3 - xm2) + (5.0f / 24.0f) * (xm1 - x2) + (5.0f / 12.0f) * (x1 - x0);
 
     return ((((c5 * frac + c4) * frac + c3) * frac + c2) * frac + c1) * frac + c0;
 }
 
+// Vector versions: OS_SIMD_WIDTH independent reads at once, one per lane. The points are gathered from a table
+// that has guard points around it (see simdGather4), so no read needs wrapping.
+
+/// @brief Round down and convert to int, storing the integer parts in indices; returns the rounded values
+/// @param indices OS_SIMD_ALIGNMENT aligned, OS_SIMD_WIDTH ints
+inline os_simd_t simdFloorToIndices(os_simd_t x, int* indices) {
+#ifdef OS_AVX
+    const os_simd_t whole = _mm256_floor_ps(x);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indices), _mm256_cvttps_epi32(whole));
+#else
+    const os_simd_t whole = _mm_floor_ps(x);
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(whole));
+#endif
+    return whole;
+}
+
+/// @brief x0[l] = table[indices[l]], x1[l] = table[indices[l] + 1]. There is no gather in AVX, so each lane reads
+/// its pair of neighbouring points with one 64-bit load, then the pairs are split.
+inline void simdGather2(const float* table, const int* indices, os_simd_t& x0, os_simd_t& x1) {
+#ifdef OS_AVX
+    __m128 pairs[4];
+    for (size_t l = 0; l < 4; ++l) {
+        const __m64* p0 = reinterpret_cast<const __m64*>(table + indices[2 * l]);
+        const __m64* p1 = reinterpret_cast<const __m64*>(table + indices[2 * l + 1]);
+        pairs[l] = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), p0), p1);
+    }
+    x0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_shuffle_ps(pairs[0], pairs[1], _MM_SHUFFLE(2, 0, 2, 0))),
+                              _mm_shuffle_ps(pairs[2], pairs[3], _MM_SHUFFLE(2, 0, 2, 0)), 1);
+    x1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_shuffle_ps(pairs[0], pairs[1], _MM_SHUFFLE(3, 1, 3, 1))),
+                              _mm_shuffle_ps(pairs[2], pairs[3], _MM_SHUFFLE(3, 1, 3, 1)), 1);
+#else
+    __m128 pairs[2];
+    for (size_t l = 0; l < 2; ++l) {
+        const __m64* p0 = reinterpret_cast<const __m64*>(table + indices[2 * l]);
+        const __m64* p1 = reinterpret_cast<const __m64*>(table + indices[2 * l + 1]);
+        pairs[l] = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), p0), p1);
+    }
+    x0 = _mm_shuffle_ps(pairs[0], pairs[1], _MM_SHUFFLE(2, 0, 2, 0));
+    x1 = _mm_shuffle_ps(pairs[0], pairs[1], _MM_SHUFFLE(3, 1, 3, 1));
+#endif
+}
+
+/// @brief x[j][l] = table[indices[l] + j] for j in [0, 4). Each lane reads its four neighbouring points with one
+/// unaligned 128-bit load, and the 4x4 blocks are transposed into one vector per point.
+inline void simdGather4(const float* table, const int* indices, os_simd_t* x) {
+    __m128 r0 = _mm_loadu_ps(table + indices[0]);
+    __m128 r1 = _mm_loadu_ps(table + indices[1]);
+    __m128 r2 = _mm_loadu_ps(table + indices[2]);
+    __m128 r3 = _mm_loadu_ps(table + indices[3]);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+#ifdef OS_AVX
+    __m128 s0 = _mm_loadu_ps(table + indices[4]);
+    __m128 s1 = _mm_loadu_ps(table + indices[5]);
+    __m128 s2 = _mm_loadu_ps(table + indices[6]);
+    __m128 s3 = _mm_loadu_ps(table + indices[7]);
+    _MM_TRANSPOSE4_PS(s0, s1, s2, s3);
+    x[0] = _mm256_insertf128_ps(_mm256_castps128_ps256(r0), s0, 1);
+    x[1] = _mm256_insertf128_ps(_mm256_castps128_ps256(r1), s1, 1);
+    x[2] = _mm256_insertf128_ps(_mm256_castps128_ps256(r2), s2, 1);
+    x[3] = _mm256_insertf128_ps(_mm256_castps128_ps256(r3), s3, 1);
+#else
+    x[0] = r0;
+    x[1] = r1;
+    x[2] = r2;
+    x[3] = r3;
+#endif
+}
+
+/// @brief Vector interpolateLinear
+inline os_simd_t simdInterpolateLinear(os_simd_t x0, os_simd_t x1, os_simd_t frac) {
+    return OS_SIMD_ADD(x0, OS_SIMD_MUL(frac, OS_SIMD_SUB(x1, x0)));
+}
+
+/// @brief Vector interpolateLagrange4
+inline os_simd_t simdInterpolateLagrange4(os_simd_t xm1, os_simd_t x0, os_simd_t x1, os_simd_t x2, os_simd_t frac) {
+    const os_simd_t half = OS_SIMD_SET1(0.5f);
+    const os_simd_t sixth = OS_SIMD_SET1(1.0f / 6.0f);
+    const os_simd_t c1 = OS_SIMD_SUB(OS_SIMD_SUB(x1, OS_SIMD_MUL(OS_SIMD_SET1(1.0f / 3.0f), xm1)),
+                                     OS_SIMD_ADD(OS_SIMD_MUL(half, x0), OS_SIMD_MUL(sixth, x2)));
+    const os_simd_t c2 = OS_SIMD_SUB(OS_SIMD_MUL(half, OS_SIMD_ADD(xm1, x1)), x0);
+    const os_simd_t c3 = OS_SIMD_ADD(OS_SIMD_MUL(sixth, OS_SIMD_SUB(x2, xm1)), OS_SIMD_MUL(half, OS_SIMD_SUB(x0, x1)));
+
+    return OS_SIMD_ADD(OS_SIMD_MUL(OS_SIMD_ADD(OS_SIMD_MUL(OS_SIMD_ADD(OS_SIMD_MUL(c3, frac), c2), frac), c1), frac), x0);
+}
+
+/// @brief Vector interpolateCatmullRom
+inline os_simd_t simdInterpolateCatmullRom(os_simd_t xm1, os_simd_t x0, os_simd_t x1, os_simd_t x2, os_simd_t frac) {
+    const os_simd_t half = OS_SIMD_SET1(0.5f);
+    const os_simd_t c1 = OS_SIMD_MUL(half, OS_SIMD_SUB(x1, xm1));
+    const os_simd_t c2 = OS_SIMD_SUB(OS_SIMD_ADD(xm1, OS_SIMD_ADD(x1, x1)), OS_SIMD_MUL(half, OS_SIMD_ADD(OS_SIMD_MUL(OS_SIMD_SET1(5.0f), x0), x2)));
+    const os_simd_t c3 = OS_SIMD_ADD(OS_SIMD_MUL(half, OS_SIMD_SUB(x2, xm1)), OS_SIMD_MUL(OS_SIMD_SET1(1.5f), OS_SIMD_SUB(x0, x1)));
+
+    return OS_SIMD_ADD(OS_SIMD_MUL(OS_SIMD_ADD(OS_SIMD_MUL(OS_SIMD_ADD(OS_SIMD_MUL(c3, frac), c2), frac), c1), frac), x0);
+}
+
+/// @brief Vector interpolateHermite6
+/// @param x The six points x[-2] to x[3], one vector each
+inline os_simd_t simdInterpolateHermite6(const os_simd_t* x, os_simd_t frac) {
+    const os_simd_t xm2 = x[0];
+    const os_simd_t xm1 = x[1];
+    const os_simd_t x0 = x[2];
+    const os_simd_t x1 = x[3];
+    const os_simd_t x2 = x[4];
+    const os_simd_t x3 = x[5];
+    auto k = [](float value) { return OS_SIMD_SET1(value); };
+
+    const os_simd_t c1 = OS_SIMD_ADD(OS_SIMD_MUL(k(1.0f / 12.0f), OS_SIMD_SUB(xm2, x2)), OS_SIMD_MUL(k(2.0f / 3.0f), OS_SIMD_SUB(x1, xm1)));
+    const os_simd_t c2 = OS_SIMD_ADD(OS_SIMD_ADD(OS_SIMD_SUB(OS_SIMD_MUL(k(13.0f / 12.0f), xm1), OS_SIMD_MUL(k(25.0f / 12.0f), x0)),
+                                                 OS_SIMD_SUB(OS_SIMD_MUL(k(1.5f), x1), OS_SIMD_MUL(k(11.0f / 24.0f), x2))),
+                                     OS_SIMD_SUB(OS_SIMD_MUL(k(1.0f / 12.0f), x3), OS_SIMD_MUL(k(0.125f), xm2)));
+    const os_simd_t c3 = OS_SIMD_SUB(OS_SIMD_ADD(OS_SIMD_SUB(OS_SIMD_MUL(k(5.0f / 12.0f), x0), OS_SIMD_MUL(k(7.0f / 12.0f), x1)),
+                                                 OS_SIMD_MUL(k(7.0f / 24.0f), x2)),
+                                     OS_SIMD_MUL(k(1.0f / 24.0f), OS_SIMD_ADD(OS_SIMD_ADD(xm2, xm1), x3)));
+    const os_simd_t c4 = OS_SIMD_SUB(OS_SIMD_ADD(OS_SIMD_SUB(OS_SIMD_MUL(k(0.125f), xm2), OS_SIMD_MUL(k(7.0f / 12.0f), xm1)),
+                                                 OS_SIMD_SUB(OS_SIMD_MUL(k(13.0f / 12.0f), x0), x1)),
+                                     OS_SIMD_SUB(OS_SIMD_MUL(k(1.0f / 12.0f), x3), OS_SIMD_MUL(k(11.0f / 24.0f), x2)));
+    const os_simd_t c5 = OS_SIMD_ADD(OS_SIMD_ADD(OS_SIMD_MUL(k(1.0f / 24.0f), OS_SIMD_SUB(x3, xm2)), OS_SIMD_MUL(k(5.0f / 24.0f), OS_SIMD_SUB(xm1, x2))),
+                                     OS_SIMD_MUL(k(5.0f / 12.0f), OS_SIMD_SUB(x1, x0)));
+
+    os_simd_t result = OS_SIMD_ADD(OS_SIMD_MUL(c5, frac), c4);
+    result = OS_SIMD_ADD(OS_SIMD_MUL(result, frac), c3);
+    result = OS_SIMD_ADD(OS_SIMD_MUL(result, frac), c2);
+    result = OS_SIMD_ADD(OS_SIMD_MUL(result, frac), c1);
+    return OS_SIMD_ADD(OS_SIMD_MUL(result, frac), x0);
+}
+
 /// @brief Read from circular buffer with linear interpolation
 /// @param buffer Circular buffer
 /// @param buffer_size Size of the circular buffer
@@ -0,0 +1,116 @@
+// Counter-based random numbers for noise and random modulation
+#pragma once
+#include "../simd.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+Value n of a random stream is a hash of (key, n), so there is no shared generator state: a stream is only its
+key and a counter. Every object owns its streams, keyed by its voice and its ObjectID, which makes the output
+the same whatever thread renders the voice and in whatever order voices run.
+
+The hash is the "lowbias32" integer finalizer (two multiply-xorshift rounds), applied to the key plus the
+counter times a large odd constant. It is not cryptographic, but its output passes the usual statistical
+tests and has no audible structure. OS_SIMD_WIDTH consecutive counters are hashed at once with 128-bit integer
+instructions (AVX has no 256-bit integer multiply), and the top 23 bits become the mantissa of a float.
+*/
+
+namespace OrangeSodium {
+
+class CounterRandom {
+public:
+    CounterRandom() = default;
+    explicit CounterRandom(uint32_t key) : key(key) {}
+
+    /// @brief Key of the stream number stream of an object, from its voice and its ObjectID
+    static uint32_t makeKey(size_t voice_index, uint32_t object_id, uint32_t stream = 0) {
+        uint32_t key = hash(static_cast<uint32_t>(voice_index) * 0x9E3779B9u + 0x7F4A7C15u);
+        key = hash(key ^ (object_id * 0x85EBCA6Bu));
+        return hash(key ^ (stream * 0xC2B2AE35u));
+    }
+
+    static inline uint32_t hash(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15;
+        x *= 0x846CA68Bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    /// @brief Value number position of the stream, as raw bits
+    uint32_t bitsAt(uint32_t position) const { return hash(key + position * kCounterStep); }
+
+    /// @brief Next value, uniform in [-1, 1)
+    float nextBipolar() {
+        return bitsToBipolar(bitsAt(counter++));
+    }
+
+    /// @brief Next value, uniform in [0, 1)
+    float nextUnipolar() {
+        return 0.5f * nextBipolar() + 0.5f;
+    }
+
+    /// @brief Fill out with the next n values, uniform in [-1, 1)
+    void fillBipolar(float* out, size_t n) {
+        size_t i = 0;
+        for (; i + OS_SIMD_WIDTH <= n; i += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE(out + i, nextBipolarVector());
+        }
+        for (; i < n; ++i) {
+            out[i] = nextBipolar();
+        }
+    }
+
+    /// @brief The next OS_SIMD_WIDTH values, uniform in [-1, 1)
+    inline os_simd_t nextBipolarVector() {
+        const __m128i step = _mm_set1_epi32(static_cast<int>(kCounterStep));
+        const __m128i base = _mm_set1_epi32(static_cast<int>(key + counter * kCounterStep));
+        const __m128i lane_steps = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), step);
+#ifdef OS_AVX
+        const __m128i low = hashVector(_mm_add_epi32(base, lane_steps));
+        const __m128i high = hashVector(_mm_add_epi32(_mm_add_epi32(base, _mm_mullo_epi32(_mm_set1_epi32(4), step)), lane_steps));
+        const os_simd_t bits = _mm256_insertf128_ps(_mm256_castps128_ps256(bitsToFloatVector(low)), bitsToFloatVector(high), 1);
+#else
+        const os_simd_t bits = bitsToFloatVector(hashVector(_mm_add_epi32(base, lane_steps)));
+#endif
+        counter += OS_SIMD_WIDTH;
+        // [1, 2) to [-1, 1)
+        return OS_SIMD_SUB(OS_SIMD_ADD(bits, bits), OS_SIMD_SET1(3.f));
+    }
+
+    uint32_t getKey() const { return key; }
+    uint32_t getCounter() const { return counter; }
+    void setCounter(uint32_t position) { counter = position; }
+
+private:
+    static constexpr uint32_t kCounterStep = 0x9E3779B9u; // Odd, so every counter maps to a different input
+
+    uint32_t key = 0;
+    uint32_t counter = 0;
+
+    /// @brief Same mapping as the vector path, so a value does not depend on which path computed it
+    static inline float bitsToBipolar(uint32_t bits) {
+        const uint32_t mantissa = (bits >> 9) | 0x3F800000u;
+        float value;
+        std::memcpy(&value, &mantissa, sizeof(value));
+        return value + value - 3.f;
+    }
+
+    static inline __m128i hashVector(__m128i x) {
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+        x = _mm_mullo_epi32(x, _mm_set1_epi32(0x7FEB352D));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+        x = _mm_mullo_epi32(x, _mm_set1_epi32(static_cast<int>(0x846CA68Bu)));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+        return x;
+    }
+
+    /// @brief Top 23 bits as the mantissa of a float in [1, 2)
+    static inline __m128 bitsToFloatVector(__m128i bits) {
+        return _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(bits, 9), _mm_set1_epi32(0x3F800000)));
+    }
+};
+
+}
@@ -0,0 +1,68 @@
+#include "sinc_interpolator.h"
+#include <cmath>
+#include <new>
+
+namespace OrangeSodium {
+
+static constexpr double kKaiserBeta = 8.6; // Stopband around -85 dB
+
+/// @brief Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+const SincInterpolator& SincInterpolator::get() {
+    static const SincInterpolator instance;
+    return instance;
+}
+
+size_t SincInterpolator::getCutoffForRatio(float ratio) {
+    if (ratio <= 1.f) {
+        return 0;
+    }
+    const size_t cutoff = static_cast<size_t>(std::ceil(4.f * std::log2(ratio)));
+    return (cutoff < kCutoffs) ? cutoff : kCutoffs - 1;
+}
+
+SincInterpolator::SincInterpolator() {
+    const size_t n_rows = kCutoffs * (kPhases + 1);
+    tables = static_cast<float*>(::operator new(n_rows * kTaps * sizeof(float), std::align_val_t(OS_SIMD_ALIGNMENT)));
+
+    const double pi = 3.14159265358979323846;
+    const double half_width = static_cast<double>(kTaps) / 2.0;
+    const double i0_beta = besselI0(kKaiserBeta);
+    for (size_t k = 0; k < kCutoffs; ++k) {
+        const double cutoff = kPassband * std::pow(2.0, -static_cast<double>(k) / 4.0);
+        for (size_t p = 0; p <= kPhases; ++p) {
+            const double frac = static_cast<double>(p) / static_cast<double>(kPhases);
+            float* row = tables + (k * (kPhases + 1) + p) * kTaps;
+            double sum = 0.0;
+            double coefficients[kTaps];
+            for (size_t j = 0; j < kTaps; ++j) {
+                // Distance of tap j from the read position
+                const double x = static_cast<double>(j) - static_cast<double>(kTapsBefore) - frac;
+                const double sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+                const double r = x / half_width;
+                const double window = (std::abs(r) < 1.0) ? besselI0(kKaiserBeta * std::sqrt(1.0 - r * r)) / i0_beta : 0.0;
+                coefficients[j] = sinc * window;
+                sum += coefficients[j];
+            }
+            // Unity gain at DC for every fractional position
+            for (size_t j = 0; j < kTaps; ++j) {
+                row[j] = static_cast<float>(coefficients[j] / sum);
+            }
+        }
+    }
+}
+
+SincInterpolator::~SincInterpolator() {
+    ::operator delete(tables, std::align_val_t(OS_SIMD_ALIGNMENT));
+}
+
+}
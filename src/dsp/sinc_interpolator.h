@@ -0,0 +1,64 @@
+#pragma once
+#include "../simd.h"
+#include <cstddef>
+
+/*
+Polyphase windowed-sinc interpolation. A table holds the kTaps (32) coefficients of a Kaiser-windowed sinc for kPhases
+fractional positions; coefficients between two rows are interpolated linearly, and the dot product with the 32
+samples around the read position runs in SIMD.
+
+There are kCutoffs tables, a quarter octave apart. Reading faster than the source rate (ratio > 1) would alias,
+so the cutoff is lowered to 1 / ratio, up to an octave up; getCutoffForRatio picks the table.
+*/
+
+namespace OrangeSodium {
+
+class SincInterpolator {
+public:
+    static constexpr size_t kTaps = 32;           // Reads x[-15] to x[16] around the read position
+    static constexpr size_t kTapsBefore = kTaps / 2 - 1;
+    static constexpr size_t kPhases = 256;        // Rows per table
+    static constexpr size_t kCutoffs = 5;         // Cutoff tiers: 1, 2^-1/4, ... 2^-1 of the passband
+    static constexpr float kPassband = 0.92f;     // Cutoff of the first tier, relative to Nyquist
+
+    /// @brief The shared tables, built on first use (call it once outside the audio thread)
+    static const SincInterpolator& get();
+
+    /// @brief Table to use when reading ratio source frames per output frame
+    static size_t getCutoffForRatio(float ratio);
+
+    /// @brief Value at x[0] + frac, frac in [0, 1). x[-15] to x[16] must be readable.
+    inline float interpolate(const float* x, float frac, size_t cutoff) const {
+        const float row_position = frac * static_cast<float>(kPhases);
+        const size_t row = static_cast<size_t>(row_position);
+        const os_simd_t t = OS_SIMD_SET1(row_position - static_cast<float>(row));
+        const float* a = tables + (cutoff * (kPhases + 1) + row) * kTaps;
+        const float* b = a + kTaps;
+        const float* first = x - kTapsBefore;
+
+        os_simd_t sum = OS_SIMD_SET1(0.f);
+        for (size_t v = 0; v < kTaps; v += OS_SIMD_WIDTH) {
+            const os_simd_t ca = OS_SIMD_LOAD_ALIGNED(a + v);
+            const os_simd_t c = OS_SIMD_ADD(ca, OS_SIMD_MUL(t, OS_SIMD_SUB(OS_SIMD_LOAD_ALIGNED(b + v), ca)));
+            sum = OS_SIMD_ADD(sum, OS_SIMD_MUL(c, OS_SIMD_LOAD(first + v)));
+        }
+        alignas(OS_SIMD_ALIGNMENT) float lanes[OS_SIMD_WIDTH];
+        OS_SIMD_STORE_ALIGNED(lanes, sum);
+        float result = 0.f;
+        for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+            result += lanes[l];
+        }
+        return result;
+    }
+
+    SincInterpolator(const SincInterpolator&) = delete;
+    SincInterpolator& operator=(const SincInterpolator&) = delete;
+
+private:
+    SincInterpolator();
+    ~SincInterpolator();
+
+    float* tables; // kCutoffs tables of kPhases + 1 rows of kTaps coefficients
+};
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "../simd.h"
+#include <cstddef>
+#include <cstdint>
+
+// Block operations on float vectors using SIMD
+// Buffers laid out by a BufferArena start on a cache line, so when both pointers share the same
+// alignment the aligned load/store path is taken.
+
+namespace OrangeSodium {
+
+/// @brief Returns true if the pointer can be used with OS_SIMD_LOAD_ALIGNED/OS_SIMD_STORE_ALIGNED
+inline bool isSimdAligned(const float* ptr) {
+    return (reinterpret_cast<std::uintptr_t>(ptr) % OS_SIMD_ALIGNMENT) == 0;
+}
+
+/// @brief dst[i] += src[i]
+inline void vectorAdd(float* dst, const float* src, size_t n) {
+    size_t i = 0;
+    const size_t simd_end = n - (n % OS_SIMD_WIDTH);
+    if (isSimdAligned(dst) && isSimdAligned(src)) {
+        for (; i < simd_end; i += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE_ALIGNED(dst + i, OS_SIMD_ADD(OS_SIMD_LOAD_ALIGNED(dst + i), OS_SIMD_LOAD_ALIGNED(src + i)));
+        }
+    } else {
+        for (; i < simd_end; i += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE(dst + i, OS_SIMD_ADD(OS_SIMD_LOAD(dst + i), OS_SIMD_LOAD(src + i)));
+        }
+    }
+    for (; i < n; ++i) {
+        dst[i] += src[i];
+    }
+}
+
+/// @brief dst[i] = src[i]
+inline void vectorCopy(float* dst, const float* src, size_t n) {
+    size_t i = 0;
+    const size_t simd_end = n - (n % OS_SIMD_WIDTH);
+    if (isSimdAligned(dst) && isSimdAligned(src)) {
+        for (; i < simd_end; i += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE_ALIGNED(dst + i, OS_SIMD_LOAD_ALIGNED(src + i));
+        }
+    } else {
+        for (; i < simd_end; i += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE(dst + i, OS_SIMD_LOAD(src + i));
+        }
+    }
+    for (; i < n; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+/// @brief out[i] = sum of the lanes of sums[i]. Whole vectors of frames are reduced together, which needs a
+/// quarter of the shuffles of reducing frame by frame.
+inline void vectorHorizontalSums(const os_simd_t* sums, float* out, size_t n) {
+    size_t i = 0;
+#ifdef OS_AVX
+    for (; i + 8 <= n; i += 8) {
+        const __m256 s01 = _mm256_hadd_ps(sums[i], sums[i + 1]);
+        const __m256 s23 = _mm256_hadd_ps(sums[i + 2], sums[i + 3]);
+        const __m256 s45 = _mm256_hadd_ps(sums[i + 4], sums[i + 5]);
+        const __m256 s67 = _mm256_hadd_ps(sums[i + 6], sums[i + 7]);
+        const __m256 s0123 = _mm256_hadd_ps(s01, s23); // Low half: frames 0-3 of lanes 0-3; high half: lanes 4-7
+        const __m256 s4567 = _mm256_hadd_ps(s45, s67);
+        const __m256 low = _mm256_permute2f128_ps(s0123, s4567, 0x20);
+        const __m256 high = _mm256_permute2f128_ps(s0123, s4567, 0x31);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(low, high));
+    }
+#else
+    for (; i + 4 <= n; i += 4) {
+        const __m128 s01 = _mm_hadd_ps(sums[i], sums[i + 1]);
+        const __m128 s23 = _mm_hadd_ps(sums[i + 2], sums[i + 3]);
+        _mm_storeu_ps(out + i, _mm_hadd_ps(s01, s23));
+    }
+#endif
+    alignas(OS_SIMD_ALIGNMENT) float lanes[OS_SIMD_WIDTH];
+    for (; i < n; ++i) {
+        OS_SIMD_STORE_ALIGNED(lanes, sums[i]);
+        float sum = 0.f;
+        for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+            sum += lanes[l];
+        }
+        out[i] = sum;
+    }
+}
+
+}
@@ -12,10 +12,14 @@ public:
     enum class EEffectType {
         kDistortion = 0,
         kFilter,
+        kFreqDiffuse,
+        kEQ,
+        kConvolutionReverb,
+        kFDNReverb,
     };
 
     Effect(Context* context, ObjectID id, size_t n_channels);
-    ~Effect() = default;
+    virtual ~Effect() = default;
 
     /// @brief Run the effect
     /// @param audio_inputs Audio input to be processed
@@ -23,10 +27,32 @@ public:
     /// @param outputs Audio output of effect
     virtual void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) = 0;
 
+    /// @brief Returns true if the effect can run with the same buffer as input and output.
+    /// This holds for effects that read each input sample before writing the output sample at the same index.
+    virtual bool canProcessInPlace() const { return false; }
+
+    /// @brief Returns true if silent input would give silent output right now, so the effect can be skipped.
+    /// Effects with internal state (filters, delays) must only return true once that state has died out.
+    virtual bool producesSilenceFromSilence() const { return false; }
+
+    /// @brief Clear the remains of a tail that producesSilenceFromSilence reported as dead. Called by the chain when
+    /// it skips the effect, so the leftovers do not come back when the input does.
+    virtual void flushTail() {}
+
+    /// @brief Advance past frames that were not processed because the input was silent
+    virtual void skipFrames(size_t n_audio_frames) { frame_offset += n_audio_frames; }
+
     /// @brief Called when the sample rate changes
     /// @param new_sample_rate The new sample rate
     virtual void onSampleRateChange(float new_sample_rate) = 0;
 
+    /// @brief Name of the effect type, as used by the Lua API. Hot reloads only match objects of the same type.
+    virtual const char* getTypeName() const = 0;
+
+    /// @brief Take over the running state (filter integrators, delay lines, etc) of the same effect in the previous
+    /// build of the program. Parameters set by the script are kept. other always has the same type name as this effect.
+    virtual void copyStateFrom(const Effect& /*other*/) {}
+
     /// @brief Set the sample rate and notify the effect
     /// @param rate The new sample rate
     void setSampleRate(float rate) { sample_rate = rate; onSampleRateChange(rate); }
@@ -82,9 +108,9 @@ protected:
     // Names of modulation sources connected to this oscillator. This is used for linking modulation sources by name in Lua.
     std::vector<std::string> modulation_source_names;
 
-    SignalBuffer* input_buffer;
-    SignalBuffer* output_buffer;
-    SignalBuffer* mod_buffer;
+    SignalBuffer* input_buffer = nullptr;
+    SignalBuffer* output_buffer = nullptr;
+    SignalBuffer* mod_buffer = nullptr;
 
     EEffectType effect_type;
     ObjectID id; // Unique ID for this effect instance
@@ -2,6 +2,11 @@
 #include "effects/effect_filter.h"
 #include "effects/effect_distortion.h"
 #include "effects/effect_freqdiffuse.h"
+#include "effects/effect_eq.h"
+#include "effects/effect_convolution_reverb.h"
+#include "effects/effect_fdn_reverb.h"
+#include "dsp/vector_ops.h"
+#include <cstring>
 #include "json/include/nlohmann/json.hpp"
 
 using json = nlohmann::json;
@@ -12,27 +17,31 @@ EffectChain::EffectChain(Context* context, size_t n_channels, EffectChainIndex i
     : m_context(context), n_channels(n_channels), index(index) {
 }
 
-ObjectID EffectChain::addEffectFilter(const std::string& filter_object_type, float frequency, float resonance) {
+ObjectID EffectChain::addEffect(Effect* effect, ObjectID id) {
+    m_context->object_registry.add(id, EObjectType::kEffect, effect, this, effects.size());
+    effects.push_back(effect);
+    effect_ids.push_back(id);
+    return id;
+}
+
+ObjectID EffectChain::addEffectFilter(const std::string& filter_object_type, float frequency, float resonance, const std::string& mode) {
     ObjectID id = m_context->getNextObjectID();
     Filter::EFilterObjects filter_type = Filter::getFilterObjectTypeFromString(filter_object_type);
     FilterEffect* effect = new FilterEffect(m_context, id, n_channels, filter_type);
     effect->getFilter()->setCutoff(frequency);
     effect->getFilter()->setResonance(resonance);
+    effect->getFilter()->setFilterType(Filter::getFilterTypeFromString(mode));
 
-    // We only need to create the output bufer and modulation buffer; the input buffer will be automatically connected
+    // We only need to create the modulation buffer; audio buffers are assigned by connectEffects
     SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, MAX_FILTER_MOD_PARAMETERS);
-    SignalBuffer* output_buffer = new SignalBuffer(SignalBuffer::EType::kAudio, m_context->max_n_frames, n_channels);
 
-    // Set modulation buffer divisions
-    mod_buffer->setChannelDivision(0, Filter::getDefaultDivisions()); // Cutoff channel at audio rate
-    mod_buffer->setChannelDivision(1, Filter::getDefaultDivisions()); // Resonance channel at audio rate
+    // Set modulation buffer divisions. The filter only evaluates its cutoff once per control point and ramps in between.
+    mod_buffer->setChannelDivision(0, m_context->control_rate_division); // Cutoff channel at control rate
+    mod_buffer->setChannelDivision(1, m_context->control_rate_division); // Resonance channel at control rate
     mod_buffer->setConstantValue(0, 0.f); // Default no modulation
     mod_buffer->setConstantValue(1, 0.f); // Default no modulation
     effect->setModulationBuffer(mod_buffer);
-    effect->setOutputBuffer(output_buffer);
-    effects.push_back(effect);
-    effect_ids.push_back(id);
-    return id;
+    return addEffect(effect, id);
 }
 
 ObjectID EffectChain::addEffectFilterJSON(const std::string& json_data) {
@@ -47,8 +56,9 @@ ObjectID EffectChain::addEffectFilterJSON(const std::string& json_data) {
     std::string filter_object_type = j.value("filter_object_type", "ZDF");
     float frequency = j.value("frequency", 1000.0f);
     float resonance = j.value("resonance", 0.5f);
+    std::string mode = j.value("mode", "lowpass");
 
-    return addEffectFilter(filter_object_type, frequency, resonance);
+    return addEffectFilter(filter_object_type, frequency, resonance, mode);
 }
 
 ObjectID EffectChain::addEffectDistortionJSON(const std::string& json_data) {
@@ -72,16 +82,11 @@ ObjectID EffectChain::addEffectDistortionJSON(const std::string& json_data) {
     effect->setMix(mix);
     effect->setOutputGain(output_gain);
 
-    // We only need to create the output bufer and modulation buffer; the input buffer will be automatically connected
+    // We only need to create the modulation buffer; audio buffers are assigned by connectEffects
     SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, DistortionEffect::getMaxModulationChannels());
 
-    SignalBuffer* output_buffer = new SignalBuffer(SignalBuffer::EType::kAudio, m_context->max_n_frames, n_channels);
-
     effect->setModulationBuffer(mod_buffer);
-    effect->setOutputBuffer(output_buffer);
-    effects.push_back(effect);
-    effect_ids.push_back(id);
-    return id;
+    return addEffect(effect, id);
 }
 
 ObjectID EffectChain::addEffectFreqDiffuseJSON(const std::string& json_data) {
@@ -99,15 +104,156 @@ ObjectID EffectChain::addEffectFreqDiffuseJSON(const std::string& json_data) {
     FreqDiffuseEffect* effect = new FreqDiffuseEffect(m_context, id, n_channels, 24*4);
     //effect->setDiffusionAmount(diffusion_amount);
 
-    // We only need to create the output bufer; the input buffer will be automatically connected
-    SignalBuffer* output_buffer = new SignalBuffer(SignalBuffer::EType::kAudio, m_context->max_n_frames, n_channels);
+    // We only need to create the modulation buffer; audio buffers are assigned by connectEffects
     SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, FreqDiffuseEffect::getMaxModulationChannels());
 
     effect->setModulationBuffer(mod_buffer);
-    effect->setOutputBuffer(output_buffer);
-    effects.push_back(effect);
-    effect_ids.push_back(id);
-    return id;
+    return addEffect(effect, id);
+}
+
+// Reads the keys of one EQ band (type, frequency, q, gain) over the values already in band
+static bool readEQBand(const json& j, EQEffect::Band& band, std::ostream& log) {
+    if (j.contains("type")) {
+        const std::string type_str = j.value("type", "peak");
+        if (!BiquadFilter::getFilterTypeFromString(type_str, band.type)) {
+            log << "Unknown EQ band type: " << type_str << std::endl;
+            return false;
+        }
+    }
+    band.frequency = j.value("frequency", band.frequency);
+    band.q = j.value("q", band.q);
+    band.gain_db = j.value("gain", band.gain_db);
+    return true;
+}
+
+ObjectID EffectChain::addEffectEQJSON(const std::string& json_data) {
+    json j;
+    try {
+        j = json::parse(json_data);
+    } catch (json::parse_error& e) {
+        *(m_context->log_stream) << "Error parsing JSON data for EQEffect: " << e.what() << std::endl;
+        return -1; // Indicate error
+    }
+
+    // Either a list of bands, or a number of flat bands to set later
+    const bool has_bands = j.contains("bands") && j["bands"].is_array();
+    const size_t n_bands = (has_bands) ? j["bands"].size() : j.value("n_bands", static_cast<size_t>(1));
+    if (n_bands == 0 || n_bands > EQEffect::kMaxBands) {
+        *(m_context->log_stream) << "EQEffect needs 1 to " << EQEffect::kMaxBands << " bands" << std::endl;
+        return -1;
+    }
+
+    ObjectID id = m_context->getNextObjectID();
+    EQEffect* effect = new EQEffect(m_context, id, n_channels, n_bands);
+    if (has_bands) {
+        for (size_t b = 0; b < n_bands; ++b) {
+            EQEffect::Band band;
+            if (!readEQBand(j["bands"][b], band, *(m_context->log_stream))) {
+                delete effect;
+                return -1;
+            }
+            effect->setBand(b, band);
+        }
+    }
+
+    // The EQ has no modulation inputs, so no modulation buffer
+    return addEffect(effect, id);
+}
+
+bool EffectChain::setEQBandJSON(ObjectID effect_id, size_t band_index, const std::string& json_data) {
+    EQEffect* effect = dynamic_cast<EQEffect*>(getEffectByObjectID(effect_id));
+    if (!effect || band_index >= effect->getNumBands()) {
+        return false;
+    }
+    json j;
+    try {
+        j = json::parse(json_data);
+    } catch (json::parse_error& e) {
+        *(m_context->log_stream) << "Error parsing JSON data for EQ band: " << e.what() << std::endl;
+        return false;
+    }
+    EQEffect::Band band = effect->getBand(band_index);
+    if (!readEQBand(j, band, *(m_context->log_stream))) {
+        return false;
+    }
+    effect->setBand(band_index, band);
+    return true;
+}
+
+ObjectID EffectChain::addEffectConvolutionReverbJSON(const std::string& json_data) {
+    json j;
+    try {
+        j = json::parse(json_data);
+    } catch (json::parse_error& e) {
+        *(m_context->log_stream) << "Error parsing JSON data for ConvolutionReverbEffect: " << e.what() << std::endl;
+        return -1; // Indicate error
+    }
+
+    const ResourceID ir_id = j.value("ir", static_cast<ResourceID>(-1));
+    SampleResource* impulse_response = (m_context->resource_manager) ? m_context->resource_manager->getSample(ir_id) : nullptr;
+    if (!impulse_response) {
+        *(m_context->log_stream) << "ConvolutionReverbEffect: 'ir' must be a sample resource" << std::endl;
+        return -1;
+    }
+    const std::string mode_str = j.value("mode", "parallel");
+    ConvolutionReverbEffect::EMode mode;
+    if (!ConvolutionReverbEffect::getModeFromString(mode_str, mode)) {
+        *(m_context->log_stream) << "Unknown convolution reverb mode: " << mode_str << std::endl;
+        return -1;
+    }
+    if (!ConvolutionReverbEffect::isModeSupported(mode, n_channels, impulse_response->getNumChannels())) {
+        *(m_context->log_stream) << "Convolution reverb mode " << mode_str << " does not fit " << n_channels << " channels and an IR of "
+                                 << impulse_response->getNumChannels() << " channels" << std::endl;
+        return -1;
+    }
+
+    ObjectID id = m_context->getNextObjectID();
+    ConvolutionReverbEffect* effect = new ConvolutionReverbEffect(m_context, id, n_channels, impulse_response, mode, j.value("threaded", false));
+    effect->setDry(j.value("dry", 0.f));
+    effect->setWet(j.value("wet", 1.f));
+
+    // The reverb has no modulation inputs, so no modulation buffer
+    return addEffect(effect, id);
+}
+
+ObjectID EffectChain::addEffectFDNReverbJSON(const std::string& json_data) {
+    json j;
+    try {
+        j = json::parse(json_data);
+    } catch (json::parse_error& e) {
+        *(m_context->log_stream) << "Error parsing JSON data for FDNReverbEffect: " << e.what() << std::endl;
+        return -1; // Indicate error
+    }
+
+    const size_t n_lines = j.value("lines", static_cast<size_t>(8));
+    if ((n_lines != 8 && n_lines != 16) || n_channels > n_lines) {
+        *(m_context->log_stream) << "FDNReverbEffect needs 8 or 16 lines, at least one per channel" << std::endl;
+        return -1;
+    }
+    const std::string matrix_str = j.value("matrix", "householder");
+    FDNReverbEffect::EMatrix matrix;
+    if (!FDNReverbEffect::getMatrixFromString(matrix_str, matrix)) {
+        *(m_context->log_stream) << "Unknown FDN reverb matrix: " << matrix_str << std::endl;
+        return -1;
+    }
+
+    ObjectID id = m_context->getNextObjectID();
+    FDNReverbEffect* effect = new FDNReverbEffect(m_context, id, n_channels, n_lines, matrix);
+    effect->setDecay(j.value("decay", 2.0f));
+    effect->setDamping(j.value("damping", 0.5f));
+    effect->setSize(j.value("size", 1.0f));
+    effect->setModulation(j.value("mod_depth", 0.3f), j.value("mod_rate", 0.5f));
+    effect->setMix(j.value("mix", 0.3f));
+
+    // We only need to create the modulation buffer; audio buffers are assigned by connectEffects. The reverb reads
+    // its modulation once per block, so every channel runs at control rate.
+    SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, FDNReverbEffect::getMaxModulationChannels());
+    for (size_t c = 0; c < FDNReverbEffect::getMaxModulationChannels(); ++c) {
+        mod_buffer->setChannelDivision(c, m_context->control_rate_division);
+        mod_buffer->setConstantValue(c, 0.f); // Default no modulation
+    }
+    effect->setModulationBuffer(mod_buffer);
+    return addEffect(effect, id);
 }
 
 Effect* EffectChain::getEffectByIndex(size_t index) {
@@ -118,12 +264,67 @@ Effect* EffectChain::getEffectByIndex(size_t index) {
     return nullptr;
 }
 
-void EffectChain::processBlock(size_t n_audio_frames) {
+bool EffectChain::isInputSilent() const {
+    if (!input_buffer) {
+        return false;
+    }
+    for (size_t ch = 0; ch < n_channels; ++ch) {
+        if (!input_buffer->isChannelSilent(ch)) {
+            return false;
+        }
+    }
     for (auto* effect : effects) {
-        SignalBuffer* audio_input = effect->getInputBuffer();
-        SignalBuffer* mod_input = effect->getModulationBuffer();
-        SignalBuffer* output = effect->getOutputBuffer();
-        effect->processBlock(audio_input, mod_input, output, n_audio_frames);
+        if (!effect->producesSilenceFromSilence()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EffectChain::processBlock(size_t n_audio_frames) {
+    // Silent input through effects that keep it silent: skip the chain and leave the output silent
+    if (isInputSilent()) {
+        for (auto* effect : effects) {
+            effect->flushTail();
+            effect->skipFrames(n_audio_frames);
+        }
+        if (output_buffer && output_buffer != input_buffer) {
+            for (size_t ch = 0; ch < n_channels; ++ch) {
+                if (output_buffer->isChannelSilent(ch)) {
+                    continue;
+                }
+                float* out_buf = output_buffer->getChannel(ch);
+                if (out_buf) {
+                    std::memset(out_buf + frame_offset, 0, n_audio_frames * sizeof(float));
+                }
+            }
+        }
+        frame_offset += n_audio_frames;
+        return;
+    }
+
+    if (copy_input_to_scratch && input_buffer && scratch_buffer) {
+        for (size_t ch = 0; ch < n_channels; ++ch) {
+            float* in_buf = input_buffer->getChannel(ch);
+            float* scratch_buf = scratch_buffer->getChannelForOverwrite(ch, frame_offset, frame_offset + n_audio_frames);
+            if (in_buf && scratch_buf) {
+                vectorCopy(scratch_buf + frame_offset, in_buf + frame_offset, n_audio_frames);
+            }
+        }
+    }
+
+    for (const auto& step : processing_steps) {
+        if (step.fused_run) {
+            SignalBuffer* audio_input = effects[step.first_effect]->getInputBuffer();
+            SignalBuffer* output = effects[step.first_effect + step.n_effects - 1]->getOutputBuffer();
+            step.fused_run->processBlock(audio_input, output, n_audio_frames, frame_offset);
+        } else {
+            Effect* effect = effects[step.first_effect];
+            SignalBuffer* audio_input = effect->getInputBuffer();
+            SignalBuffer* mod_input = effect->getModulationBuffer();
+            SignalBuffer* output = effect->getOutputBuffer();
+            effect->processBlock(audio_input, mod_input, output, n_audio_frames);
+        }
     }
 
     if(effects.empty()) {
@@ -131,11 +332,9 @@ void EffectChain::processBlock(size_t n_audio_frames) {
         if(input_buffer && output_buffer) {
             for(size_t ch = 0; ch < n_channels; ++ch) {
                 float* in_buf = input_buffer->getChannel(ch);
-                float* out_buf = output_buffer->getChannel(ch);
+                float* out_buf = output_buffer->getChannelForOverwrite(ch, frame_offset, frame_offset + n_audio_frames);
                 if(in_buf && out_buf) {
-                    for(size_t i = 0; i < n_audio_frames; ++i) {
-                        out_buf[i + frame_offset] = in_buf[i + frame_offset];
-                    }
+                    vectorCopy(out_buf + frame_offset, in_buf + frame_offset, n_audio_frames);
                 }
             }
         }
@@ -151,40 +350,98 @@ void EffectChain::setSampleRate(float sample_rate) {
 }
 
 void EffectChain::connectEffects() {
-    for(size_t i = 0; i < effects.size(); ++i) {
+    // Effects do not own audio buffers. The signal lives in the chain output buffer, and effects that cannot
+    // run in place ping-pong between it and a single scratch buffer.
+    // Walk backwards from the last effect, which always writes the chain output: an effect that runs in place
+    // wants its input where its output goes, any other effect wants it in the other buffer.
+    const size_t n_effects = effects.size();
+    std::vector<bool> writes_scratch(n_effects, false);
+    bool needs_scratch = false;
+    for (size_t i = n_effects; i-- > 1;) {
+        const bool output_is_scratch = writes_scratch[i];
+        writes_scratch[i - 1] = effects[i]->canProcessInPlace() ? output_is_scratch : !output_is_scratch;
+        needs_scratch = needs_scratch || writes_scratch[i - 1];
+    }
+
+    // The first effect reads the chain input. If that is also the buffer it writes and it cannot run in place,
+    // the input is copied to the scratch buffer at the start of every block.
+    copy_input_to_scratch = false;
+    if (n_effects > 0 && !effects[0]->canProcessInPlace() && input_buffer == output_buffer && !writes_scratch[0]) {
+        copy_input_to_scratch = true;
+        needs_scratch = true;
+    }
+
+    if (needs_scratch && !scratch_buffer) {
+        scratch_buffer = new SignalBuffer(SignalBuffer::EType::kAudio, m_context->max_n_frames, n_channels);
+    } else if (!needs_scratch && scratch_buffer) {
+        delete scratch_buffer;
+        scratch_buffer = nullptr;
+    }
+
+    for (size_t i = 0; i < n_effects; ++i) {
         Effect* effect = effects[i];
-        if(i == 0) {
-            // First effect needs connected to voice_effects_input_buffer
-            effect->setInputBuffer(input_buffer);
-        }else {
-            // Connect to previous effect's output
+        if (i == 0) {
+            effect->setInputBuffer(copy_input_to_scratch ? scratch_buffer : input_buffer);
+        } else {
             effect->setInputBuffer(effects[i - 1]->getOutputBuffer());
         }
+        effect->setOutputBuffer(writes_scratch[i] ? scratch_buffer : output_buffer);
     }
 
-    // Connect last effect to voice_effects_output_buffer
-    if(!effects.empty()) {
-        effects.back()->setOutputBuffer(output_buffer);
-    }
+    buildProcessingSteps();
 }
 
-void EffectChain::resizeBuffers(size_t n_frames) {
-    for (auto* effect : effects) {
-        SignalBuffer* input_buffer = effect->getInputBuffer();
-        SignalBuffer* output_buffer = effect->getOutputBuffer();
-        SignalBuffer* mod_buffer = effect->getModulationBuffer();
+void EffectChain::setFusionEnabled(bool enabled) {
+    fusion_enabled = enabled;
+    buildProcessingSteps();
+}
+
+void EffectChain::buildProcessingSteps() {
+    clearProcessingSteps();
 
-        if (input_buffer) {
-            for (size_t ch = 0; ch < input_buffer->getNumChannels(); ++ch) {
-                input_buffer->setChannel(ch, n_frames, 1, input_buffer->getBufferId(ch));
+    size_t i = 0;
+    while (i < effects.size()) {
+        // Find the longest run of fusible effects starting here
+        size_t run_end = i;
+        if (fusion_enabled) {
+            while (run_end < effects.size() && FusedEffectRun::isFusible(effects[run_end])) {
+                ++run_end;
             }
         }
 
-        if (output_buffer) {
-            for (size_t ch = 0; ch < output_buffer->getNumChannels(); ++ch) {
-                output_buffer->setChannel(ch, n_frames, 1, output_buffer->getBufferId(ch));
+        if (run_end - i >= 2) {
+            FusedEffectRun* run = new FusedEffectRun(n_channels);
+            for (size_t e = i; e < run_end; ++e) {
+                run->addStage(effects[e]);
             }
+            processing_steps.push_back({i, run_end - i, run});
+            i = run_end;
+        } else {
+            processing_steps.push_back({i, 1, nullptr});
+            ++i;
+        }
+    }
+}
+
+void EffectChain::clearProcessingSteps() {
+    for (auto& step : processing_steps) {
+        if (step.fused_run) {
+            delete step.fused_run;
         }
+    }
+    processing_steps.clear();
+}
+
+void EffectChain::resizeBuffers(size_t n_frames) {
+    // The chain input and output belong to the voice or synthesizer and are resized there
+    if (scratch_buffer) {
+        for (size_t ch = 0; ch < scratch_buffer->getNumChannels(); ++ch) {
+            scratch_buffer->setChannel(ch, n_frames, 1, scratch_buffer->getBufferId(ch));
+        }
+    }
+
+    for (auto* effect : effects) {
+        SignalBuffer* mod_buffer = effect->getModulationBuffer();
 
         if (mod_buffer) {
             for (size_t ch = 0; ch < mod_buffer->getNumChannels(); ++ch) {
@@ -195,21 +452,15 @@ void EffectChain::resizeBuffers(size_t n_frames) {
 }
 
 Effect* EffectChain::getEffectByObjectID(ObjectID id) {
-    for (size_t i = 0; i < effects.size(); ++i) {
-        if (effect_ids[i] == id) {
-            return effects[i];
-        }
-    }
-    return nullptr;
+    return m_context->object_registry.find<Effect>(id, EObjectType::kEffect, this);
 }
 
 int EffectChain::getEffectIndexByObjectID(ObjectID id) {
-    for (size_t i = 0; i < effects.size(); ++i) {
-        if (effect_ids[i] == id) {
-            return i;
-        }
+    const ObjectRegistry::Entry& entry = m_context->object_registry.get(id);
+    if (entry.type != EObjectType::kEffect || entry.owner != this) {
+        return -1; // Not found
     }
-    return -1; // Not found
+    return static_cast<int>(entry.index);
 }
 
 void EffectChain::zeroOutModulationBuffers() {
@@ -221,12 +472,40 @@ void EffectChain::zeroOutModulationBuffers() {
     }
 }
 
+void EffectChain::collectBuffers(std::vector<SignalBuffer*>& out) const {
+    if (input_buffer) {
+        out.push_back(input_buffer);
+    }
+    for (auto* effect : effects) {
+        if (effect->getModulationBuffer()) {
+            out.push_back(effect->getModulationBuffer());
+        }
+    }
+    if (scratch_buffer) {
+        out.push_back(scratch_buffer);
+    }
+    if (output_buffer) {
+        out.push_back(output_buffer);
+    }
+}
+
 EffectChain::~EffectChain() {
+    for (ObjectID id : effect_ids) {
+        m_context->object_registry.remove(id);
+    }
+    clearProcessingSteps();
+    if (scratch_buffer) {
+        delete scratch_buffer;
+    }
     for (auto* effect : effects) {
         delete effect;
     }
 }
 
+void EffectChain::matchEffectsWith(const EffectChain& running, HotReloadPlan& plan) {
+    plan.matchObjects(running.m_context->object_registry, running.effects, running.effect_ids, m_context->object_registry, effects, effect_ids, plan.effects);
+}
+
 void EffectChain::beginBlock() {
     frame_offset = 0;
     for (auto* effect : effects) {
@@ -2,6 +2,8 @@
 
 #include "context.h"
 #include "effect.h"
+#include "effect_fusion.h"
+#include "hot_reload.h"
 
 
 namespace OrangeSodium {
@@ -10,16 +12,26 @@ class EffectChain {
 public:
     EffectChain(Context* context, size_t n_channels, EffectChainIndex id);
     ~EffectChain();
-    ObjectID addEffectFilter(const std::string& filter_object_type, float frequency, float resonance);
+    ObjectID addEffectFilter(const std::string& filter_object_type, float frequency, float resonance, const std::string& mode = "lowpass");
     ObjectID addEffectFilterJSON(const std::string& json_data);
     ObjectID addEffectDistortionJSON(const std::string& json_data);
     ObjectID addEffectFreqDiffuseJSON(const std::string& json_data);
+    /// @brief Add a parametric EQ: {"bands": [{"type", "frequency", "q", "gain"}, ...]} or {"n_bands": n}
+    ObjectID addEffectEQJSON(const std::string& json_data);
+    /// @brief Change one band of an EQ effect of this chain; keys left out keep their value
+    bool setEQBandJSON(ObjectID effect_id, size_t band_index, const std::string& json_data);
+    /// @brief Add a convolution reverb: {"ir": sample resource, "mode", "dry", "wet", "threaded"}
+    ObjectID addEffectConvolutionReverbJSON(const std::string& json_data);
+    /// @brief Add a feedback delay network reverb: {"lines", "matrix", "decay", "damping", "size", "mod_depth", "mod_rate", "mix"}
+    ObjectID addEffectFDNReverbJSON(const std::string& json_data);
     Effect* getEffectByIndex(size_t index);
     size_t getNumEffects() const { return effects.size(); }
     void setIO(SignalBuffer* input, SignalBuffer* output) {
         input_buffer = input;
         output_buffer = output;
     }
+    SignalBuffer* getInputBuffer() const { return input_buffer; }
+    SignalBuffer* getOutputBuffer() const { return output_buffer; }
     EffectChainIndex getIndex() const { return index; }
     void setSampleRate(float sample_rate);
     void connectEffects();
@@ -27,12 +39,8 @@ public:
     void processBlock(size_t n_audio_frames);
 
     bool hasEffect(ObjectID id) const {
-        for (const auto& eff_id : effect_ids) {
-            if (eff_id == id) {
-                return true;
-            }
-        }
-        return false;
+        const ObjectRegistry::Entry& entry = m_context->object_registry.get(id);
+        return entry.type == EObjectType::kEffect && entry.owner == this;
     }
 
     bool objectIDIsEffect(ObjectID id) const {
@@ -51,11 +59,21 @@ public:
 
     void zeroOutModulationBuffers();
 
+    /// @brief Append every buffer the chain touches to out, in processing order (input, effect mod inputs, scratch, output)
+    void collectBuffers(std::vector<SignalBuffer*>& out) const;
+
+    /// @brief Pair this chain's effects with those of the same chain in the running synthesizer, for a hot reload
+    void matchEffectsWith(const EffectChain& running, HotReloadPlan& plan);
+
     void beginBlock();
     size_t getFrameOffset() const {
         return frame_offset;
     }
 
+    /// @brief Enable or disable fusing runs of per-sample effects (enabled by default)
+    void setFusionEnabled(bool enabled);
+    bool isFusionEnabled() const { return fusion_enabled; }
+
 private:
     Context* m_context;
     size_t n_channels;
@@ -64,8 +82,29 @@ private:
     std::vector<ObjectID> effect_ids;
     SignalBuffer* input_buffer = nullptr;
     SignalBuffer* output_buffer = nullptr;
+    SignalBuffer* scratch_buffer = nullptr; // Ping-pong buffer, only allocated if an effect cannot run in place
+    bool copy_input_to_scratch = false; // Set when the chain input is also its output and the first effect cannot run in place
 
     size_t frame_offset; // To allow for per-sample MIDI events, we keep track of the current frame offset within the block being processed
+
+    // A processing step is either a single effect or a fused run of consecutive effects
+    struct ProcessingStep {
+        size_t first_effect;
+        size_t n_effects;
+        FusedEffectRun* fused_run; // nullptr if the step is a single effect
+    };
+    std::vector<ProcessingStep> processing_steps;
+    bool fusion_enabled = true;
+
+    /// @brief Group the effects into processing steps. Called after the effects are connected.
+    void buildProcessingSteps();
+    void clearProcessingSteps();
+
+    /// @brief Take ownership of a new effect and register it under its ID
+    ObjectID addEffect(Effect* effect, ObjectID id);
+
+    /// @brief True if every input channel is silent and every effect would keep it silent
+    bool isInputSilent() const;
 };
 
 }
\ No newline at end of file
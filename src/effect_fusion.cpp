@@ -0,0 +1,156 @@
+#include "effect_fusion.h"
+#include "effects/effect_filter.h"
+#include "effects/effect_distortion.h"
+#include "filters/ZDF_filter.h"
+
+namespace OrangeSodium {
+
+// Per-sample step of a single stage. The stage type is a template parameter so that the kernels
+// compile down to straight-line code with no dispatch inside the sample loop. Kernels pass a local
+// copy of the stage so its parameters stay in registers instead of being reloaded after every store.
+template <FusedEffectRun::EStageType T, typename StageT>
+static inline float tickStage(StageT& stage, float x, size_t channel, size_t i) {
+    if constexpr (T == FusedEffectRun::EStageType::kZDFFilter) {
+        return stage.filter->tick(x, channel, stage.gain_coeffs[i], stage.k_coeffs[i]);
+    } else if constexpr (T == FusedEffectRun::EStageType::kTanh) {
+        return DistortionEffect::tickTyped<DistortionEffect::EDistortionType::kTanh>(x, stage.drive, stage.mix, stage.output_gain);
+    } else if constexpr (T == FusedEffectRun::EStageType::kHardClip) {
+        return DistortionEffect::tickTyped<DistortionEffect::EDistortionType::kHardClip>(x, stage.drive, stage.mix, stage.output_gain);
+    } else {
+        return DistortionEffect::tickTyped<DistortionEffect::EDistortionType::kUnknown>(x, stage.drive, stage.mix, stage.output_gain);
+    }
+}
+
+#define OS_FUSED_SINGLE(A) &FusedEffectRun::processSingle<FusedEffectRun::EStageType::A>
+#define OS_FUSED_PAIR(A, B) &FusedEffectRun::processPair<FusedEffectRun::EStageType::A, FusedEffectRun::EStageType::B>
+#define OS_FUSED_PAIR_ROW(A) { OS_FUSED_PAIR(A, kZDFFilter), OS_FUSED_PAIR(A, kTanh), OS_FUSED_PAIR(A, kHardClip), OS_FUSED_PAIR(A, kLinear) }
+
+// Indexed by EStageType
+const FusedEffectRun::StageKernel FusedEffectRun::single_kernels[static_cast<size_t>(EStageType::kNumStageTypes)] = {
+    OS_FUSED_SINGLE(kZDFFilter), OS_FUSED_SINGLE(kTanh), OS_FUSED_SINGLE(kHardClip), OS_FUSED_SINGLE(kLinear)
+};
+
+const FusedEffectRun::StageKernel FusedEffectRun::pair_kernels[static_cast<size_t>(EStageType::kNumStageTypes)][static_cast<size_t>(EStageType::kNumStageTypes)] = {
+    OS_FUSED_PAIR_ROW(kZDFFilter),
+    OS_FUSED_PAIR_ROW(kTanh),
+    OS_FUSED_PAIR_ROW(kHardClip),
+    OS_FUSED_PAIR_ROW(kLinear)
+};
+
+#undef OS_FUSED_PAIR_ROW
+#undef OS_FUSED_PAIR
+#undef OS_FUSED_SINGLE
+
+FusedEffectRun::FusedEffectRun(size_t n_channels) : n_channels(n_channels) {
+}
+
+bool FusedEffectRun::isFusible(Effect* effect) {
+    if (!effect) {
+        return false;
+    }
+    switch (effect->getEffectType()) {
+        case Effect::EEffectType::kDistortion:
+            return true;
+        case Effect::EEffectType::kFilter: {
+            // Coefficients are computed once per sub-block, so the per-sample part is just the SVF
+            FilterEffect* filter_effect = static_cast<FilterEffect*>(effect);
+            return filter_effect->getFilter() && filter_effect->getFilterObjectType() == Filter::EFilterObjects::kZDF;
+        }
+        default:
+            return false;
+    }
+}
+
+void FusedEffectRun::addStage(Effect* effect) {
+    Stage stage;
+    stage.effect = effect;
+    if (effect->getEffectType() == Effect::EEffectType::kFilter) {
+        stage.type = EStageType::kZDFFilter;
+        stage.filter = static_cast<ZDFFilter*>(static_cast<FilterEffect*>(effect)->getFilter());
+    } else {
+        stage.type = EStageType::kTanh;
+        stage.distortion = static_cast<DistortionEffect*>(effect);
+    }
+    stages.push_back(stage);
+}
+
+void FusedEffectRun::resolveStages(size_t n_audio_frames, size_t frame_offset) {
+    for (auto& stage : stages) {
+        if (stage.distortion) {
+            stage.drive = stage.distortion->getDrive();
+            stage.mix = stage.distortion->getMix();
+            stage.output_gain = stage.distortion->getOutputGain();
+
+            // The distortion type can be changed at any time, so the kernel is picked per block
+            switch (stage.distortion->getDistortionType()) {
+                case DistortionEffect::EDistortionType::kHardClip:
+                    stage.type = EStageType::kHardClip;
+                    break;
+                case DistortionEffect::EDistortionType::kUnknown:
+                    stage.type = EStageType::kLinear;
+                    break;
+                default:
+                    stage.type = EStageType::kTanh;
+                    break;
+            }
+            continue;
+        }
+
+        // Filter coefficients are shared by all channels, so they are computed once before the channel loop
+        stage.filter->prepareCoefficients(stage.effect->getModulationBuffer(), n_audio_frames, frame_offset);
+        stage.gain_coeffs = stage.filter->getGainCoefficients();
+        stage.k_coeffs = stage.filter->getResonanceCoefficients();
+    }
+}
+
+template <FusedEffectRun::EStageType A>
+void FusedEffectRun::processSingle(Stage* stages, const float* in, float* out, size_t channel, size_t n_audio_frames, size_t frame_offset) {
+    Stage first = stages[0];
+    for (size_t i = 0; i < n_audio_frames; ++i) {
+        out[i + frame_offset] = tickStage<A>(first, in[i + frame_offset], channel, i);
+    }
+}
+
+template <FusedEffectRun::EStageType A, FusedEffectRun::EStageType B>
+void FusedEffectRun::processPair(Stage* stages, const float* in, float* out, size_t channel, size_t n_audio_frames, size_t frame_offset) {
+    Stage first = stages[0];
+    Stage second = stages[1];
+    for (size_t i = 0; i < n_audio_frames; ++i) {
+        float x = in[i + frame_offset];
+        x = tickStage<A>(first, x, channel, i);
+        x = tickStage<B>(second, x, channel, i);
+        out[i + frame_offset] = x;
+    }
+}
+
+void FusedEffectRun::processBlock(SignalBuffer* input, SignalBuffer* output, size_t n_audio_frames, size_t frame_offset) {
+    if (!input || !output || stages.empty()) {
+        return;
+    }
+    resolveStages(n_audio_frames, frame_offset);
+
+    for (size_t c = 0; c < n_channels; ++c) {
+        const float* in = input->getChannel(c);
+        float* out = output->getChannelForOverwrite(c, frame_offset, frame_offset + n_audio_frames);
+        if (!in || !out) {
+            continue;
+        }
+
+        // The first kernel reads the run input; any further kernels work in place on the run output
+        size_t s = 0;
+        while (s < stages.size()) {
+            const size_t a = static_cast<size_t>(stages[s].type);
+            if (s + 1 < stages.size()) {
+                const size_t b = static_cast<size_t>(stages[s + 1].type);
+                pair_kernels[a][b](&stages[s], in, out, c, n_audio_frames, frame_offset);
+                s += 2;
+            } else {
+                single_kernels[a](&stages[s], in, out, c, n_audio_frames, frame_offset);
+                s += 1;
+            }
+            in = out;
+        }
+    }
+}
+
+}
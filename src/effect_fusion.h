@@ -0,0 +1,82 @@
+// Fused execution of consecutive per-sample effects
+#pragma once
+#include "effect.h"
+#include "signal_buffer.h"
+#include <vector>
+
+/*
+Running an effect chain one effect at a time means every stage writes a full block to its output buffer and
+the next stage reads it straight back. For effects that work sample by sample (ZDF filter, distortion) this
+round trip is pure memory traffic. A FusedEffectRun takes a run of such effects and processes them two
+stages at a time in one loop per channel: each sample is read once, passed through both stages while it
+stays in a register, and written once. Every pair kernel is a template instantiation for its two stage types,
+so the sample loop has no dispatch in it. Runs longer than two stages chain pair kernels in place on the run
+output. Intermediate effect output buffers are never touched.
+*/
+
+namespace OrangeSodium {
+
+class ZDFFilter;
+class DistortionEffect;
+
+class FusedEffectRun {
+public:
+    enum class EStageType {
+        kZDFFilter = 0,
+        kTanh,      // DistortionEffect, tanh shaper
+        kHardClip,  // DistortionEffect, hard clipper
+        kLinear,    // DistortionEffect with no shaper (drive, mix and gain only)
+        kNumStageTypes
+    };
+
+    FusedEffectRun(size_t n_channels);
+    ~FusedEffectRun() = default;
+
+    /// @brief Returns true if the effect has a per-sample path that can be fused with its neighbours
+    static bool isFusible(Effect* effect);
+
+    /// @brief Append an effect to the run. The effect must be fusible.
+    void addStage(Effect* effect);
+
+    size_t getNumStages() const { return stages.size(); }
+
+    /// @brief Process every stage of the run
+    /// @param input Input of the first effect in the run
+    /// @param output Output of the last effect in the run
+    /// @param n_audio_frames Number of frames to process
+    /// @param frame_offset Offset of this sub-block within the current block
+    void processBlock(SignalBuffer* input, SignalBuffer* output, size_t n_audio_frames, size_t frame_offset);
+
+private:
+    struct Stage {
+        EStageType type;
+        Effect* effect;
+        ZDFFilter* filter = nullptr;
+        DistortionEffect* distortion = nullptr;
+
+        // Resolved from the effect at the start of every processBlock
+        float drive = 1.f;
+        float mix = 1.f;
+        float output_gain = 1.f;
+        const float* gain_coeffs = nullptr; // ZDF coefficients of the current sub-block
+        const float* k_coeffs = nullptr;
+    };
+
+    size_t n_channels;
+    std::vector<Stage> stages;
+
+    /// @brief Refresh stage types and parameters from the effects and compute filter coefficients; called at the start of every processBlock
+    void resolveStages(size_t n_audio_frames, size_t frame_offset);
+
+    typedef void (*StageKernel)(Stage* stages, const float* in, float* out, size_t channel, size_t n_audio_frames, size_t frame_offset);
+
+    template <EStageType A>
+    static void processSingle(Stage* stages, const float* in, float* out, size_t channel, size_t n_audio_frames, size_t frame_offset);
+    template <EStageType A, EStageType B>
+    static void processPair(Stage* stages, const float* in, float* out, size_t channel, size_t n_audio_frames, size_t frame_offset);
+
+    static const StageKernel single_kernels[static_cast<size_t>(EStageType::kNumStageTypes)];
+    static const StageKernel pair_kernels[static_cast<size_t>(EStageType::kNumStageTypes)][static_cast<size_t>(EStageType::kNumStageTypes)];
+};
+
+}
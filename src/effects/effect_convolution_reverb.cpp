@@ -0,0 +1,159 @@
+#include "effect_convolution_reverb.h"
+#include "../dsp/vector_ops.h"
+#include <algorithm>
+
+namespace OrangeSodium {
+
+ConvolutionReverbEffect::ConvolutionReverbEffect(Context* context, ObjectID id, size_t n_channels, SampleResource* impulse_response, EMode mode, bool threaded_tail)
+    : Effect(context, id, n_channels), impulse_response(impulse_response), mode(mode), threaded_tail(threaded_tail) {
+    effect_type = EEffectType::kConvolutionReverb;
+    wet_buffers = new float[n_channels * kChunk]();
+    mono = new float[kChunk]();
+    scratch = new float[kChunk]();
+    in_channels.resize(n_channels);
+    out_channels.resize(n_channels);
+    buildRoutes();
+
+    // No modulation inputs
+    modulation_source_names.resize(0);
+}
+
+ConvolutionReverbEffect::~ConvolutionReverbEffect() {
+    clearRoutes();
+    delete[] wet_buffers;
+    delete[] mono;
+    delete[] scratch;
+}
+
+bool ConvolutionReverbEffect::getModeFromString(const std::string& mode_string, EMode& out) {
+    if (mode_string == "parallel") {
+        out = EMode::kParallel;
+    } else if (mode_string == "mono_to_stereo") {
+        out = EMode::kMonoToStereo;
+    } else if (mode_string == "true_stereo") {
+        out = EMode::kTrueStereo;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ConvolutionReverbEffect::isModeSupported(EMode mode, size_t n_channels, size_t n_ir_channels) {
+    if (n_channels == 0 || n_ir_channels == 0) {
+        return false;
+    }
+    if (mode == EMode::kTrueStereo) {
+        return n_channels == 2 && n_ir_channels == 4;
+    }
+    return true;
+}
+
+void ConvolutionReverbEffect::buildRoutes() {
+    const size_t n_ir_channels = (impulse_response) ? impulse_response->getNumChannels() : 0;
+    if (!isModeSupported(mode, n_channels, n_ir_channels)) {
+        return;
+    }
+    switch (mode) {
+    case EMode::kParallel:
+        for (size_t c = 0; c < n_channels; ++c) {
+            routes.push_back({ c, c, std::min(c, n_ir_channels - 1), false, nullptr });
+        }
+        break;
+    case EMode::kMonoToStereo:
+        for (size_t c = 0; c < n_channels; ++c) {
+            routes.push_back({ n_channels, c, c % n_ir_channels, false, nullptr });
+        }
+        break;
+    case EMode::kTrueStereo:
+        routes.push_back({ 0, 0, 0, false, nullptr });
+        routes.push_back({ 0, 1, 1, false, nullptr });
+        routes.push_back({ 1, 0, 2, true, nullptr });
+        routes.push_back({ 1, 1, 3, true, nullptr });
+        break;
+    }
+}
+
+void ConvolutionReverbEffect::clearRoutes() {
+    for (Route& route : routes) {
+        delete route.convolver;
+        route.convolver = nullptr;
+    }
+}
+
+void ConvolutionReverbEffect::onSampleRateChange(float new_sample_rate) {
+    this->sample_rate = new_sample_rate;
+    // The kernels at the new rate are shared with every other user of the IR; only the state is this instance's
+    clearRoutes();
+    for (Route& route : routes) {
+        std::shared_ptr<const ConvolutionKernel> kernel = impulse_response->getConvolutionKernel(route.ir_channel, new_sample_rate);
+        if (kernel) {
+            route.convolver = new Convolver(kernel, 1, threaded_tail, m_context->max_n_frames);
+        }
+    }
+}
+
+bool ConvolutionReverbEffect::producesSilenceFromSilence() const {
+    for (const Route& route : routes) {
+        if (route.convolver && !route.convolver->isSilent()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ConvolutionReverbEffect::processBlock(SignalBuffer* audio_inputs, SignalBuffer* /*mod_inputs*/, SignalBuffer* outputs, size_t n_audio_frames) {
+    for (size_t c = 0; c < n_channels; ++c) {
+        float* in_buffer = audio_inputs->getChannel(c);
+        float* out_buffer = outputs->getChannelForOverwrite(c, frame_offset, frame_offset + n_audio_frames);
+        in_channels[c] = (in_buffer) ? in_buffer + frame_offset : nullptr;
+        out_channels[c] = (out_buffer) ? out_buffer + frame_offset : nullptr;
+    }
+
+    const float mono_gain = 1.f / static_cast<float>(n_channels);
+    for (size_t start = 0; start < n_audio_frames; start += kChunk) {
+        const size_t n = std::min(kChunk, n_audio_frames - start);
+        std::fill(wet_buffers, wet_buffers + n_channels * kChunk, 0.f);
+
+        if (mode == EMode::kMonoToStereo) {
+            std::fill(mono, mono + n, 0.f);
+            for (size_t c = 0; c < n_channels; ++c) {
+                if (in_channels[c]) {
+                    vectorAdd(mono, in_channels[c] + start, n);
+                }
+            }
+            for (size_t i = 0; i < n; ++i) {
+                mono[i] *= mono_gain;
+            }
+        }
+
+        for (Route& route : routes) {
+            if (!route.convolver) {
+                continue;
+            }
+            const float* route_input = (route.input == n_channels) ? mono : ((in_channels[route.input]) ? in_channels[route.input] + start : nullptr);
+            float* wet_buffer = wet_buffers + route.output * kChunk;
+            float* route_output = (route.accumulate) ? scratch : wet_buffer;
+            route.convolver->process(&route_input, &route_output, n);
+            if (route.accumulate) {
+                vectorAdd(wet_buffer, scratch, n);
+            }
+        }
+
+        // Each input frame is read before the output frame at the same index is written, so this runs in place
+        for (size_t c = 0; c < n_channels; ++c) {
+            float* out = out_channels[c];
+            if (!out) {
+                continue;
+            }
+            out += start;
+            const float* in = (in_channels[c]) ? in_channels[c] + start : nullptr;
+            const float* w = wet_buffers + c * kChunk;
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = ((in) ? dry * in[i] : 0.f) + wet * w[i];
+            }
+        }
+    }
+    frame_offset += n_audio_frames;
+}
+
+} // namespace OrangeSodium
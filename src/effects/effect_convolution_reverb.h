@@ -0,0 +1,82 @@
+#pragma once
+#include "../effect.h"
+#include "../resource_manager.h"
+#include "../dsp/convolution.h"
+#include <vector>
+#include <string>
+
+/*
+Convolution reverb with an impulse response from a sample resource. The partition spectra come from
+SampleResource::getConvolutionKernel, so every instance and voice using the same IR at the same rate shares them;
+an instance only holds its delay lines and windows.
+
+Modes (each pairs an input with an output through one IR channel):
+- parallel: channel c through IR channel c (the last IR channel for the channels past it)
+- mono_to_stereo: the input channels mixed to mono, then output c through IR channel c (wrapping around the IR channels)
+- true_stereo: two channels and a 4-channel IR, in the order L->L, L->R, R->L, R->R
+
+The convolution has no latency. The cost per block is the head taps plus the partition FFTs, so it stays modest for
+IRs of several seconds, but the longer partitions land on a few block boundaries only; with threaded_tail they run
+on a background thread instead, which keeps every block close to the same cost. That thread (ConvolutionWorker) is
+shared by every threaded instance of the process, so a reverb in each voice does not start a thread per voice.
+*/
+
+namespace OrangeSodium {
+
+class ConvolutionReverbEffect : public Effect {
+public:
+    enum class EMode {
+        kParallel = 0,
+        kMonoToStereo,
+        kTrueStereo,
+    };
+
+    ConvolutionReverbEffect(Context* context, ObjectID id, size_t n_channels, SampleResource* impulse_response, EMode mode, bool threaded_tail);
+    ~ConvolutionReverbEffect();
+
+    void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
+    void onSampleRateChange(float new_sample_rate) override;
+    bool canProcessInPlace() const override { return true; }
+    bool producesSilenceFromSilence() const override;
+    const char* getTypeName() const override { return "convolution_reverb_effect"; }
+
+    /// @brief Output = dry * input + wet * reverb
+    void setDry(float gain) { dry = gain; }
+    void setWet(float gain) { wet = gain; }
+    float getDry() const { return dry; }
+    float getWet() const { return wet; }
+    EMode getMode() const { return mode; }
+
+    static bool getModeFromString(const std::string& mode_string, EMode& out);
+    /// @brief True if a mode can run with n_channels channels and an IR of n_ir_channels channels
+    static bool isModeSupported(EMode mode, size_t n_channels, size_t n_ir_channels);
+
+private:
+    static constexpr size_t kChunk = 256; // Frames per pass
+
+    // One input convolved with one IR channel into one output
+    struct Route {
+        size_t input;  // n_channels for the mono mix
+        size_t output;
+        size_t ir_channel;
+        bool accumulate; // Another route already wrote the output
+        Convolver* convolver;
+    };
+
+    SampleResource* impulse_response;
+    EMode mode;
+    bool threaded_tail;
+    float dry = 0.f;
+    float wet = 1.f;
+    std::vector<Route> routes;
+    float* wet_buffers; // [channel * kChunk]
+    float* mono;        // kChunk
+    float* scratch;     // kChunk
+    std::vector<const float*> in_channels;
+    std::vector<float*> out_channels;
+
+    void buildRoutes();
+    void clearRoutes();
+};
+
+} // namespace OrangeSodium
@@ -1,6 +1,7 @@
 #include "effect_distortion.h"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace OrangeSodium {
 
@@ -23,25 +24,26 @@ DistortionEffect::DistortionEffect(Context* context, ObjectID id, size_t n_chann
 void DistortionEffect::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
 
     for(size_t c = 0; c < n_channels; ++c) {
+        // Silent input gives silent output
+        if (audio_inputs->isChannelSilent(c)) {
+            if (outputs != audio_inputs && !outputs->isChannelSilent(c)) {
+                float* out_buffer = outputs->getChannel(c);
+                if (out_buffer) {
+                    std::memset(out_buffer + frame_offset, 0, n_audio_frames * sizeof(float));
+                }
+            }
+            continue;
+        }
+
         float* in_buffer = audio_inputs->getChannel(c);
-        float* out_buffer = outputs->getChannel(c);
+        float* out_buffer = outputs->getChannelForOverwrite(c, frame_offset, frame_offset + n_audio_frames);
 
         if (!in_buffer || !out_buffer) {
             continue; // Skip if input or output buffer is null
         }
 
         for (size_t i = 0; i < n_audio_frames; ++i) {
-            // Apply distortion effect
-            float driven_sample = in_buffer[i + frame_offset] * drive;
-
-            // Simple tanh distortion
-            float distorted_sample = processSample(driven_sample, c);
-
-            // Mix dry and wet signals
-            out_buffer[i + frame_offset] = (1.0f - mix) * in_buffer[i + frame_offset] + mix * distorted_sample;
-
-            // Apply output gain
-            out_buffer[i + frame_offset] *= output_gain;
+            out_buffer[i + frame_offset] = tick(in_buffer[i + frame_offset]);
         }
     }
     frame_offset += n_audio_frames;
@@ -60,21 +62,4 @@ DistortionEffect::EDistortionType DistortionEffect::getDistortionTypeFromString(
     return EDistortionType::kUnknown;
 }
 
-float DistortionEffect::processSample(float input_sample, int channel) {
-    switch (distortion_type) {
-        case EDistortionType::kTanh:
-            return std::tanh(input_sample);
-        case EDistortionType::kHardClip:
-            return processHardClip(input_sample);
-        case EDistortionType::kUnknown:
-            return input_sample; // No distortion
-        default:
-            return std::tanh(input_sample);
-    }
-}
-
-float DistortionEffect::processHardClip(float x){
-    return std::max(-1.0f, std::min(1.0f, x));
-}
-
 }
\ No newline at end of file
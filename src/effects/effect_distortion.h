@@ -3,6 +3,8 @@
 #include "../modulation_router.h"
 #include <map>
 #include <memory>
+#include <cmath>
+#include <algorithm>
 
 namespace OrangeSodium {
 
@@ -18,6 +20,9 @@ public:
 
     void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
     void onSampleRateChange(float new_sample_rate) override {sample_rate = new_sample_rate; }
+    bool canProcessInPlace() const override { return true; }
+    bool producesSilenceFromSilence() const override { return true; } // Stateless, and every shaper maps 0 to 0
+    const char* getTypeName() const override { return "distortion_effect"; }
     void setDrive(float d) { drive = d; }
     void setMix(float m) { mix = m; }
     void setOutputGain(float g) { output_gain = g; }
@@ -26,6 +31,32 @@ public:
     static EDistortionType getDistortionTypeFromString(const std::string& type_string);
     static size_t getMaxModulationChannels() { return 3; } // drive, mix, output_gain
 
+    /// @brief Process a single sample (drive, shape, mix, output gain)
+    inline float tick(float x) {
+        const float distorted_sample = processSample(x * drive, 0);
+        return ((1.0f - mix) * x + mix * distorted_sample) * output_gain;
+    }
+
+    float getDrive() const { return drive; }
+    float getMix() const { return mix; }
+    float getOutputGain() const { return output_gain; }
+
+    /// @brief Same as tick, with the distortion type fixed at compile time and the parameters passed by value,
+    /// so callers can keep them in registers across a whole block. Used by fused effect runs.
+    template <EDistortionType T>
+    static inline float tickTyped(float x, float drive, float mix, float output_gain) {
+        const float driven_sample = x * drive;
+        float distorted_sample;
+        if constexpr (T == EDistortionType::kHardClip) {
+            distorted_sample = std::max(-1.0f, std::min(1.0f, driven_sample));
+        } else if constexpr (T == EDistortionType::kUnknown) {
+            distorted_sample = driven_sample;
+        } else {
+            distorted_sample = std::tanh(driven_sample);
+        }
+        return ((1.0f - mix) * x + mix * distorted_sample) * output_gain;
+    }
+
 private:
     float drive; // Distortion drive amount
     float mix;   // Dry/Wet mix
@@ -36,4 +67,21 @@ private:
     inline float processHardClip(float x);
 };
 
+float DistortionEffect::processSample(float input_sample, int /*channel*/) {
+    switch (distortion_type) {
+        case EDistortionType::kTanh:
+            return std::tanh(input_sample);
+        case EDistortionType::kHardClip:
+            return processHardClip(input_sample);
+        case EDistortionType::kUnknown:
+            return input_sample; // No distortion
+        default:
+            return std::tanh(input_sample);
+    }
+}
+
+float DistortionEffect::processHardClip(float x){
+    return std::max(-1.0f, std::min(1.0f, x));
+}
+
 }
\ No newline at end of file
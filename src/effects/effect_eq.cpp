@@ -0,0 +1,66 @@
+#include "effect_eq.h"
+#include <algorithm>
+
+namespace OrangeSodium {
+
+EQEffect::EQEffect(Context* context, ObjectID id, size_t n_channels, size_t n_bands)
+    : Effect(context, id, n_channels) {
+    effect_type = EEffectType::kEQ;
+    bands.resize(std::min(std::max(n_bands, static_cast<size_t>(1)), kMaxBands));
+    bank = new BiquadBank(n_channels, bands.size(), context->max_n_frames);
+    in_channels.resize(n_channels);
+    out_channels.resize(n_channels);
+
+    // No modulation inputs
+    modulation_source_names.resize(0);
+}
+
+EQEffect::~EQEffect() {
+    delete bank;
+}
+
+void EQEffect::setBand(size_t index, const Band& band) {
+    if (index >= bands.size()) {
+        return;
+    }
+    bands[index] = band;
+    updateBand(index, (has_run) ? kRampFrames : 0);
+}
+
+void EQEffect::updateBand(size_t index, size_t ramp_frames) {
+    const Band& band = bands[index];
+    bank->setCoefficients(index, BiquadFilter::design(band.type, band.frequency, band.q, band.gain_db, sample_rate), ramp_frames);
+}
+
+void EQEffect::processBlock(SignalBuffer* audio_inputs, SignalBuffer* /*mod_inputs*/, SignalBuffer* outputs, size_t n_audio_frames) {
+    has_run = true;
+    for (size_t c = 0; c < n_channels; ++c) {
+        float* in_buffer = audio_inputs->getChannel(c);
+        float* out_buffer = outputs->getChannelForOverwrite(c, frame_offset, frame_offset + n_audio_frames);
+        // Channels that are missing either side keep their output untouched
+        in_channels[c] = (in_buffer && out_buffer) ? in_buffer + frame_offset : nullptr;
+        out_channels[c] = (in_buffer && out_buffer) ? out_buffer + frame_offset : nullptr;
+    }
+
+    // The bank was sized for the block size at construction, which the block may have outgrown
+    const size_t chunk = bank->getMaxFrames();
+    for (size_t start = 0; start < n_audio_frames; start += chunk) {
+        bank->process(in_channels.data(), out_channels.data(), std::min(chunk, n_audio_frames - start));
+        for (size_t c = 0; c < n_channels; ++c) {
+            if (in_channels[c]) {
+                in_channels[c] += chunk;
+                out_channels[c] += chunk;
+            }
+        }
+    }
+    frame_offset += n_audio_frames;
+}
+
+void EQEffect::onSampleRateChange(float new_sample_rate) {
+    this->sample_rate = new_sample_rate;
+    for (size_t i = 0; i < bands.size(); ++i) {
+        updateBand(i, 0);
+    }
+}
+
+} // namespace OrangeSodium
@@ -0,0 +1,59 @@
+#pragma once
+#include "../effect.h"
+#include "../dsp/biquad_bank.h"
+#include <vector>
+#include <string>
+
+/*
+Multi-band parametric EQ: every band is one biquad (peak, shelf, low/high-pass, band-pass or notch), and the bands
+run in series on every channel. The channels go through a BiquadBank together, so a stereo EQ is one SIMD pass
+per band. Changed bands ramp to their new coefficients over kRampFrames frames, and bands at 0 dB are skipped,
+so an EQ with nothing dialled in costs a copy at most.
+*/
+
+namespace OrangeSodium {
+
+class EQEffect : public Effect {
+public:
+    struct Band {
+        BiquadFilter::EFilterType type = BiquadFilter::EFilterType::kPeak;
+        float frequency = 1000.f;
+        float q = 0.707f;
+        float gain_db = 0.f; // Peak and shelf bands only
+    };
+
+    static constexpr size_t kMaxBands = 32;
+    static constexpr size_t kRampFrames = 256; // Frames a changed band takes to reach its new response
+
+    EQEffect(Context* context, ObjectID id, size_t n_channels, size_t n_bands);
+    ~EQEffect();
+
+    void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
+    void onSampleRateChange(float new_sample_rate) override;
+    bool canProcessInPlace() const override { return true; }
+    bool producesSilenceFromSilence() const override { return bank->isSilent(1e-7f); }
+    void flushTail() override { bank->reset(); }
+    const char* getTypeName() const override { return "eq_effect"; }
+
+    /// @brief Take over the band states if the number of bands is the same
+    void copyStateFrom(const Effect& other) override {
+        const EQEffect& running = static_cast<const EQEffect&>(other);
+        bank->copyStateFrom(*running.bank);
+    }
+
+    /// @brief Set one band; the response glides to it unless the effect has not run yet
+    void setBand(size_t index, const Band& band);
+    const Band& getBand(size_t index) const { return bands[index]; }
+    size_t getNumBands() const { return bands.size(); }
+
+private:
+    std::vector<Band> bands;
+    BiquadBank* bank;
+    bool has_run = false; // Bands set before the first block snap instead of ramping
+    std::vector<const float*> in_channels;
+    std::vector<float*> out_channels;
+
+    void updateBand(size_t index, size_t ramp_frames);
+};
+
+} // namespace OrangeSodium
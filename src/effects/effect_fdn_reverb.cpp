@@ -0,0 +1,346 @@
+#include "effect_fdn_reverb.h"
+#include "../dsp/vector_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+namespace OrangeSodium {
+
+static constexpr float kPi = 3.14159265358979f;
+static constexpr float kShortestLine = 0.029f; // Line lengths at size 1, in seconds
+static constexpr float kLongestLine = 0.087f;
+static constexpr float kSilence = 1e-7f;
+
+static float* allocateAligned(size_t n) {
+    float* data = static_cast<float*>(::operator new(n * sizeof(float), std::align_val_t(OS_SIMD_ALIGNMENT)));
+    std::fill(data, data + n, 0.f);
+    return data;
+}
+
+static void freeAligned(float* data) {
+    ::operator delete(data, std::align_val_t(OS_SIMD_ALIGNMENT));
+}
+
+FDNReverbEffect::FDNReverbEffect(Context* context, ObjectID id, size_t n_channels, size_t n_lines, EMatrix matrix)
+    : Effect(context, id, n_channels), n_lines((n_lines > 8) ? 16 : 8), matrix_type(matrix), lfo_phase(0.f) {
+    static_assert(8 % OS_SIMD_WIDTH == 0, "The lines fill whole vectors");
+    effect_type = EEffectType::kFDNReverb;
+
+    // Lengths spread geometrically between the shortest and the longest line, nudged off the exact ratios so
+    // the lines share as few resonances as possible
+    for (size_t l = 0; l < this->n_lines; ++l) {
+        const float nudge = 0.5f * (static_cast<float>(l) * 0.618034f - std::floor(static_cast<float>(l) * 0.618034f));
+        const float position = (static_cast<float>(l) + nudge) / static_cast<float>(this->n_lines);
+        line_lengths[l] = kShortestLine * std::pow(kLongestLine / kShortestLine, position);
+        delays[l] = 0.f;
+        damping_b[l] = 0.f;
+        damping_a[l] = 0.f;
+        damping_state[l] = 0.f;
+    }
+
+    hadamard = allocateAligned(this->n_lines * this->n_lines);
+    input_taps = allocateAligned(n_channels * this->n_lines);
+    output_taps = allocateAligned(n_channels * this->n_lines);
+    frames = allocateAligned(kSubBlock * this->n_lines);
+    wet = allocateAligned(n_channels * kSubBlock);
+    totals = allocateAligned(kSubBlock);
+    sums = new os_simd_t[(n_channels + 1) * kSubBlock];
+    in_channels.resize(n_channels);
+    out_channels.resize(n_channels);
+    buildHadamard();
+
+    // Channel c feeds and reads the lines l % n_channels == c, read with alternating signs
+    const size_t lines_per_channel = std::max<size_t>(this->n_lines / std::max<size_t>(n_channels, 1), 1);
+    const float output_gain = 1.f / std::sqrt(static_cast<float>(lines_per_channel));
+    for (size_t l = 0; l < this->n_lines; ++l) {
+        const size_t c = l % n_channels;
+        input_taps[c * this->n_lines + l] = 1.f;
+        output_taps[c * this->n_lines + l] = ((l / n_channels) % 2 == 0) ? output_gain : -output_gain;
+    }
+
+    modulation_source_names.resize(0);
+    modulation_source_names.push_back("decay");
+    modulation_source_names.push_back("damping");
+    modulation_source_names.push_back("size");
+    modulation_source_names.push_back("mix");
+}
+
+FDNReverbEffect::~FDNReverbEffect() {
+    for (DelayLine* line : lines) {
+        delete line;
+    }
+    freeAligned(hadamard);
+    freeAligned(input_taps);
+    freeAligned(output_taps);
+    freeAligned(frames);
+    freeAligned(wet);
+    freeAligned(totals);
+    delete[] sums;
+}
+
+bool FDNReverbEffect::getMatrixFromString(const std::string& matrix_string, EMatrix& out) {
+    if (matrix_string == "hadamard") {
+        out = EMatrix::kHadamard;
+    } else if (matrix_string == "householder") {
+        out = EMatrix::kHouseholder;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void FDNReverbEffect::buildHadamard() {
+    // Sylvester's Hadamard matrix scaled by 1 / sqrt(n): entry (r, c) is negative when r & c has an odd number of
+    // bits. The Householder reflection I - 2/n is applied without the matrix.
+    const float scale = 1.f / std::sqrt(static_cast<float>(n_lines));
+    for (size_t column = 0; column < n_lines; ++column) {
+        for (size_t row = 0; row < n_lines; ++row) {
+            size_t bits = row & column;
+            bool negative = false;
+            while (bits) {
+                negative = !negative;
+                bits &= bits - 1;
+            }
+            hadamard[column * n_lines + row] = (negative) ? -scale : scale;
+        }
+    }
+}
+
+void FDNReverbEffect::allocateLines() {
+    for (DelayLine* line : lines) {
+        delete line;
+    }
+    lines.clear();
+    // Room for the longest line at the largest size, swung by the deepest modulation
+    const size_t max_delay = static_cast<size_t>(std::ceil((kLongestLine * kMaxSize + kMaxModDepthMs * 0.001f) * sample_rate)) + kSubBlock + 2;
+    for (size_t l = 0; l < n_lines; ++l) {
+        lines.push_back(new DelayLine(max_delay));
+    }
+    std::fill(damping_state, damping_state + kMaxLines, 0.f);
+    has_run = false;
+    cached_decay = -1.f;
+}
+
+void FDNReverbEffect::onSampleRateChange(float new_sample_rate) {
+    this->sample_rate = new_sample_rate;
+    allocateLines();
+}
+
+void FDNReverbEffect::updateDamping(float block_decay, float block_damping, float block_size) {
+    if (block_decay == cached_decay && block_damping == cached_damping && block_size == cached_size) {
+        return;
+    }
+    cached_decay = block_decay;
+    cached_damping = block_damping;
+    cached_size = block_size;
+
+    // A line of d frames loses 60 dB over the decay time: its gain is 10^(-3 d / (rate * time)), at DC for the
+    // decay time and at Nyquist for the damped one. The one-pole b / (1 - a z^-1) meets both.
+    const float high_decay = block_decay / (1.f + 9.f * block_damping);
+    for (size_t l = 0; l < n_lines; ++l) {
+        const float length = line_lengths[l] * block_size;
+        const float dc_gain = std::pow(10.f, -3.f * length / block_decay);
+        const float nyquist_gain = std::pow(10.f, -3.f * length / high_decay);
+        const float pole = (dc_gain - nyquist_gain) / (dc_gain + nyquist_gain);
+        damping_a[l] = pole;
+        damping_b[l] = dc_gain * (1.f - pole);
+    }
+}
+
+bool FDNReverbEffect::producesSilenceFromSilence() const {
+    // Three decay times take the tail 180 dB down
+    const size_t tail_frames = static_cast<size_t>((3.f * std::max(cached_decay, decay) + kLongestLine * kMaxSize) * sample_rate);
+    return silent_frames >= tail_frames;
+}
+
+void FDNReverbEffect::flushTail() {
+    // Flush once; the lines stay clear until the input comes back
+    if (silent_frames == static_cast<size_t>(-1)) {
+        return;
+    }
+    for (DelayLine* line : lines) {
+        line->reset();
+    }
+    std::fill(damping_state, damping_state + kMaxLines, 0.f);
+    silent_frames = static_cast<size_t>(-1);
+}
+
+void FDNReverbEffect::copyStateFrom(const Effect& other) {
+    // The delay lines only carry over if they are laid out the same
+    const FDNReverbEffect& running = static_cast<const FDNReverbEffect&>(other);
+    if (running.n_lines != n_lines || running.sample_rate != sample_rate || running.lines.size() != lines.size()) {
+        return;
+    }
+    for (size_t l = 0; l < lines.size(); ++l) {
+        lines[l]->copyStateFrom(*running.lines[l]);
+    }
+    std::copy(running.damping_state, running.damping_state + kMaxLines, damping_state);
+    std::copy(running.delays, running.delays + kMaxLines, delays);
+    lfo_phase = running.lfo_phase;
+    has_run = running.has_run;
+}
+
+template <size_t kLines>
+void FDNReverbEffect::processSubBlock(size_t start, size_t n) {
+    constexpr size_t kVectors = kLines / OS_SIMD_WIDTH;
+    os_simd_t b[kVectors], a[kVectors], state[kVectors];
+    for (size_t v = 0; v < kVectors; ++v) {
+        b[v] = OS_SIMD_LOAD_ALIGNED(damping_b + v * OS_SIMD_WIDTH);
+        a[v] = OS_SIMD_LOAD_ALIGNED(damping_a + v * OS_SIMD_WIDTH);
+        state[v] = OS_SIMD_LOAD_ALIGNED(damping_state + v * OS_SIMD_WIDTH);
+    }
+    os_simd_t* householder_sums = sums + n_channels * kSubBlock;
+
+    // Line outputs: tapped for the wet signal, then damped in place
+    for (size_t i = 0; i < n; ++i) {
+        float* row = frames + i * kLines;
+        os_simd_t x[kVectors];
+        for (size_t v = 0; v < kVectors; ++v) {
+            x[v] = OS_SIMD_LOAD_ALIGNED(row + v * OS_SIMD_WIDTH);
+        }
+        for (size_t c = 0; c < n_channels; ++c) {
+            const float* taps = output_taps + c * kLines;
+            os_simd_t sum = OS_SIMD_MUL(x[0], OS_SIMD_LOAD_ALIGNED(taps));
+            for (size_t v = 1; v < kVectors; ++v) {
+                sum = OS_SIMD_ADD(sum, OS_SIMD_MUL(x[v], OS_SIMD_LOAD_ALIGNED(taps + v * OS_SIMD_WIDTH)));
+            }
+            sums[c * kSubBlock + i] = sum;
+        }
+        os_simd_t total = OS_SIMD_SET1(0.f);
+        for (size_t v = 0; v < kVectors; ++v) {
+            state[v] = OS_SIMD_ADD(OS_SIMD_MUL(b[v], x[v]), OS_SIMD_MUL(a[v], state[v]));
+            total = OS_SIMD_ADD(total, state[v]);
+            OS_SIMD_STORE_ALIGNED(row + v * OS_SIMD_WIDTH, state[v]);
+        }
+        householder_sums[i] = total;
+    }
+    for (size_t v = 0; v < kVectors; ++v) {
+        OS_SIMD_STORE_ALIGNED(damping_state + v * OS_SIMD_WIDTH, state[v]);
+    }
+    for (size_t c = 0; c < n_channels; ++c) {
+        vectorHorizontalSums(sums + c * kSubBlock, wet + c * kSubBlock, n);
+    }
+    if (matrix_type == EMatrix::kHouseholder) {
+        vectorHorizontalSums(householder_sums, totals, n);
+    }
+
+    // Feedback through the matrix, plus the input: the line inputs replace the outputs in frames
+    const os_simd_t householder_scale = OS_SIMD_SET1(-2.f / static_cast<float>(kLines));
+    for (size_t i = 0; i < n; ++i) {
+        float* row = frames + i * kLines;
+        os_simd_t y[kVectors];
+        if (matrix_type == EMatrix::kHouseholder) {
+            const os_simd_t reflection = OS_SIMD_MUL(OS_SIMD_SET1(totals[i]), householder_scale);
+            for (size_t v = 0; v < kVectors; ++v) {
+                y[v] = OS_SIMD_ADD(OS_SIMD_LOAD_ALIGNED(row + v * OS_SIMD_WIDTH), reflection);
+            }
+        } else {
+            for (size_t v = 0; v < kVectors; ++v) {
+                y[v] = OS_SIMD_SET1(0.f);
+            }
+            for (size_t j = 0; j < kLines; ++j) {
+                const os_simd_t s = OS_SIMD_SET1(row[j]);
+                const float* column = hadamard + j * kLines;
+                for (size_t v = 0; v < kVectors; ++v) {
+                    y[v] = OS_SIMD_ADD(y[v], OS_SIMD_MUL(s, OS_SIMD_LOAD_ALIGNED(column + v * OS_SIMD_WIDTH)));
+                }
+            }
+        }
+        for (size_t c = 0; c < n_channels; ++c) {
+            if (!in_channels[c]) {
+                continue;
+            }
+            const os_simd_t x = OS_SIMD_SET1(in_channels[c][start + i]);
+            const float* taps = input_taps + c * kLines;
+            for (size_t v = 0; v < kVectors; ++v) {
+                y[v] = OS_SIMD_ADD(y[v], OS_SIMD_MUL(x, OS_SIMD_LOAD_ALIGNED(taps + v * OS_SIMD_WIDTH)));
+            }
+        }
+        for (size_t v = 0; v < kVectors; ++v) {
+            OS_SIMD_STORE_ALIGNED(row + v * OS_SIMD_WIDTH, y[v]);
+        }
+    }
+}
+
+void FDNReverbEffect::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
+    if (lines.empty()) {
+        // No sample rate yet
+        frame_offset += n_audio_frames;
+        return;
+    }
+    bool silent = true;
+    for (size_t c = 0; c < n_channels; ++c) {
+        float* in_buffer = audio_inputs->getChannel(c);
+        float* out_buffer = outputs->getChannelForOverwrite(c, frame_offset, frame_offset + n_audio_frames);
+        in_channels[c] = (in_buffer && !audio_inputs->isChannelSilent(c)) ? in_buffer + frame_offset : nullptr;
+        out_channels[c] = (out_buffer) ? out_buffer + frame_offset : nullptr;
+        for (size_t i = 0; i < n_audio_frames && silent && in_channels[c]; ++i) {
+            silent = std::abs(in_channels[c][i]) <= kSilence;
+        }
+    }
+    silent_frames = (silent) ? ((silent_frames == static_cast<size_t>(-1)) ? silent_frames : silent_frames + n_audio_frames) : 0;
+
+    // The parameters and their modulation are read once per block
+    auto modulation = [&](EModChannel channel) {
+        const size_t index = static_cast<size_t>(channel);
+        return (mod_inputs) ? mod_inputs->getElement(index, frame_offset / mod_inputs->getChannelDivision(index)) : 0.f;
+    };
+    const float block_decay = std::min(std::max(decay + modulation(EModChannel::kDecay), 0.05f), 100.f);
+    const float block_damping = std::min(std::max(damping + modulation(EModChannel::kDamping), 0.f), 1.f);
+    const float block_size = std::min(std::max(size + modulation(EModChannel::kSize), 0.1f), kMaxSize);
+    const float block_mix = std::min(std::max(mix + modulation(EModChannel::kMix), 0.f), 1.f);
+    updateDamping(block_decay, block_damping, block_size);
+
+    // Line lengths at the end of the block; the block glides to them from the last block's
+    lfo_phase += mod_rate * static_cast<float>(n_audio_frames) / sample_rate;
+    lfo_phase -= std::floor(lfo_phase);
+    const float depth = std::min(std::max(mod_depth_ms, 0.f), kMaxModDepthMs) * 0.001f * sample_rate;
+    const float shortest = static_cast<float>(kSubBlock + 2);
+    const float longest = static_cast<float>(lines[0]->getMaxDelayTime() - 1);
+    float targets[kMaxLines];
+    for (size_t l = 0; l < n_lines; ++l) {
+        const float swing = depth * std::sin(2.f * kPi * (lfo_phase + static_cast<float>(l) / static_cast<float>(n_lines)));
+        targets[l] = std::min(std::max(line_lengths[l] * block_size * sample_rate + swing, shortest), longest);
+        if (!has_run) {
+            delays[l] = targets[l];
+        }
+    }
+    has_run = true;
+
+    const float inv_frames = 1.f / static_cast<float>(n_audio_frames);
+    for (size_t start = 0; start < n_audio_frames; start += kSubBlock) {
+        const size_t n = std::min(kSubBlock, n_audio_frames - start);
+        const float from = static_cast<float>(start) * inv_frames;
+        const float to = static_cast<float>(start + n) * inv_frames;
+        for (size_t l = 0; l < n_lines; ++l) {
+            const float glide = targets[l] - delays[l];
+            lines[l]->readRamped(frames + l, n, delays[l] + glide * from, delays[l] + glide * to, n_lines);
+        }
+        if (n_lines == 16) {
+            processSubBlock<16>(start, n);
+        } else {
+            processSubBlock<8>(start, n);
+        }
+        for (size_t l = 0; l < n_lines; ++l) {
+            lines[l]->write(frames + l, n, n_lines);
+        }
+
+        // Each input frame is read before the output frame at the same index is written, so this runs in place
+        for (size_t c = 0; c < n_channels; ++c) {
+            float* out = out_channels[c];
+            if (!out) {
+                continue;
+            }
+            const float* in = in_channels[c];
+            const float* reverb = wet + c * kSubBlock;
+            for (size_t i = 0; i < n; ++i) {
+                out[start + i] = ((in) ? (1.f - block_mix) * in[start + i] : 0.f) + block_mix * reverb[i];
+            }
+        }
+    }
+    std::copy(targets, targets + n_lines, delays);
+    frame_offset += n_audio_frames;
+}
+
+} // namespace OrangeSodium
@@ -0,0 +1,117 @@
+#pragma once
+#include "../effect.h"
+#include "../simd.h"
+#include "../dsp/delay_line.h"
+#include <vector>
+#include <string>
+
+/*
+Feedback delay network reverb: 8 or 16 delay lines whose outputs go through a damping filter each, are mixed by an
+orthogonal matrix (Hadamard or Householder) and fed back with the input. Channel c feeds and is read from the lines
+l with l % n_channels == c.
+
+Every line's damping is a one-pole low-pass with a DC gain and a Nyquist gain set from the decay times of its
+length, so the whole network decays at the same rate at any delay (Jot). The lines are processed in sub-blocks no
+longer than the shortest delay: every line's outputs for the sub-block are read in one go into a frame-major buffer,
+the damping filters and the matrix run across the lines OS_SIMD_WIDTH at a time, and the new inputs are written
+back in one go.
+
+Decay, damping, size and mix can be modulated; they are read once per block. Size changes and the slow
+modulation of the line lengths glide over the block.
+*/
+
+namespace OrangeSodium {
+
+class FDNReverbEffect : public Effect {
+public:
+    enum class EMatrix {
+        kHadamard = 0,
+        kHouseholder,
+    };
+
+    enum class EModChannel {
+        kDecay = 0,
+        kDamping,
+        kSize,
+        kMix,
+    };
+
+    static constexpr size_t kMaxLines = 16;
+    static constexpr size_t kSubBlock = 64;      // Frames per pass; every line is longer
+    static constexpr float kMaxSize = 2.f;
+    static constexpr float kMaxModDepthMs = 5.f;
+
+    FDNReverbEffect(Context* context, ObjectID id, size_t n_channels, size_t n_lines, EMatrix matrix);
+    ~FDNReverbEffect();
+
+    void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
+    void onSampleRateChange(float new_sample_rate) override;
+    bool canProcessInPlace() const override { return true; }
+    bool producesSilenceFromSilence() const override;
+    void flushTail() override;
+    const char* getTypeName() const override { return "fdn_reverb_effect"; }
+    void copyStateFrom(const Effect& other) override;
+
+    /// @brief Time (s) the tail takes to fall by 60 dB at low frequencies
+    void setDecay(float seconds) { decay = seconds; }
+    /// @brief 0: high frequencies decay as slowly as low ones; 1: ten times faster
+    void setDamping(float amount) { damping = amount; }
+    /// @brief Scales every line length (0.1 to kMaxSize)
+    void setSize(float new_size) { size = new_size; }
+    /// @brief Depth (ms) and rate (Hz) of the slow line length modulation that breaks up metallic resonances
+    void setModulation(float depth_ms, float rate_hz) { mod_depth_ms = depth_ms; mod_rate = rate_hz; }
+    /// @brief Output = (1 - mix) * input + mix * reverb
+    void setMix(float new_mix) { mix = new_mix; }
+
+    float getDecay() const { return decay; }
+    float getDamping() const { return damping; }
+    float getSize() const { return size; }
+    float getMix() const { return mix; }
+    size_t getNumLines() const { return n_lines; }
+
+    static bool getMatrixFromString(const std::string& matrix_string, EMatrix& out);
+    static size_t getMaxModulationChannels() { return 4; } // decay, damping, size, mix
+
+private:
+    size_t n_lines;
+    EMatrix matrix_type;
+    float decay = 2.f;
+    float damping = 0.5f;
+    float size = 1.f;
+    float mod_depth_ms = 0.3f;
+    float mod_rate = 0.5f;
+    float mix = 0.3f;
+
+    std::vector<DelayLine*> lines;
+    float line_lengths[kMaxLines];  // Unmodulated lengths at size 1, in seconds
+    float delays[kMaxLines];        // Delay (frames) of every line at the end of the last block
+    float lfo_phase;                // In cycles; line l is offset by l / n_lines
+    bool has_run = false;           // The first block starts at its delays instead of gliding to them
+
+    // Coefficients and state of the damping filters, one lane per line: state = b * x + a * state
+    alignas(OS_SIMD_ALIGNMENT) float damping_b[kMaxLines];
+    alignas(OS_SIMD_ALIGNMENT) float damping_a[kMaxLines];
+    alignas(OS_SIMD_ALIGNMENT) float damping_state[kMaxLines];
+    float cached_decay = -1.f;      // Decay, damping and delays the coefficients were worked out for
+    float cached_damping = -1.f;
+    float cached_size = -1.f;
+
+    float* hadamard;                // [column * n_lines + row], columns contiguous; n_lines * n_lines
+    float* input_taps;              // [channel * n_lines + line]: 1 for the lines the channel feeds
+    float* output_taps;             // [channel * n_lines + line]: signed gains of the lines the channel reads
+    float* frames;                  // [frame * n_lines + line]: line outputs, then line inputs, of a sub-block
+    os_simd_t* sums;                // kSubBlock per channel, then kSubBlock for the Householder sums
+    float* wet;                     // [channel * kSubBlock]
+    float* totals;                  // kSubBlock
+    std::vector<const float*> in_channels;
+    std::vector<float*> out_channels;
+    size_t silent_frames = 0;       // Frames of silent input since the last sound
+
+    void allocateLines();
+    void buildHadamard();
+    void updateDamping(float block_decay, float block_damping, float block_size);
+    template <size_t kLines>
+    void processSubBlock(size_t start, size_t n);
+};
+
+} // namespace OrangeSodium
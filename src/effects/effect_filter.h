@@ -12,6 +12,28 @@ public:
     ~FilterEffect();
     void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
     void onSampleRateChange(float new_sample_rate) override;
+    bool canProcessInPlace() const override { return filter != nullptr && filter->canProcessInPlace(); }
+    bool producesSilenceFromSilence() const override { return filter == nullptr || filter->producesSilenceFromSilence(); }
+    void flushTail() override {
+        if (filter) {
+            filter->flushTail();
+        }
+    }
+    const char* getTypeName() const override { return "filter_effect"; }
+
+    void copyStateFrom(const Effect& other) override {
+        const FilterEffect& running = static_cast<const FilterEffect&>(other);
+        if (filter && running.filter && filter_object_type == running.filter_object_type) {
+            filter->copyStateFrom(*running.filter);
+        }
+    }
+
+    void skipFrames(size_t n_audio_frames) override {
+        frame_offset += n_audio_frames;
+        if (filter) {
+            filter->skipFrames(n_audio_frames);
+        }
+    }
 
     void setInputBuffer(SignalBuffer* buffer) override {
         this->input_buffer = buffer;
@@ -40,6 +62,10 @@ public:
         return filter;
     }
 
+    Filter::EFilterObjects getFilterObjectType() const {
+        return filter_object_type;
+    }
+
     void beginBlock() override {
         frame_offset = 0;
         if (filter) {
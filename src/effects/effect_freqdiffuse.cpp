@@ -9,7 +9,7 @@ namespace OrangeSodium {
 
 FreqDiffuseEffect::FreqDiffuseEffect(Context* context, ObjectID id, size_t n_channels, size_t num_stages)
     : Effect(context, id, n_channels), num_stages_(num_stages) {
-    effect_type = EEffectType::kFilter;
+    effect_type = EEffectType::kFreqDiffuse;
 
     modulation_source_names.resize(0);
 
@@ -53,7 +53,7 @@ void FreqDiffuseEffect::setupFrequencyDispersion(float freq_min, float freq_max)
 void FreqDiffuseEffect::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
     for (size_t c = 0; c < n_channels; ++c) {
         float* in_buffer = audio_inputs->getChannel(c);
-        float* out_buffer = outputs->getChannel(c);
+        float* out_buffer = outputs->getChannelForOverwrite(c, frame_offset, frame_offset + n_audio_frames);
 
         if (!in_buffer || !out_buffer) {
             continue;
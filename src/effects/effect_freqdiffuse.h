@@ -12,6 +12,16 @@ public:
 
     void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
     void onSampleRateChange(float new_sample_rate) override;
+    bool canProcessInPlace() const override { return true; }
+    const char* getTypeName() const override { return "freqdiffuse_effect"; }
+
+    void copyStateFrom(const Effect& other) override {
+        // The state is blocked by channel, so it only carries over if the layout is the same
+        const FreqDiffuseEffect& running = static_cast<const FreqDiffuseEffect&>(other);
+        if (running.z_.size() == z_.size()) {
+            std::copy(running.z_.begin(), running.z_.end(), z_.begin());
+        }
+    }
     void setGeometricA(float a0, float r) {
         a0 = std::clamp(a0, 0.0f, 0.9999f);
         r  = std::clamp(r,  0.0f, 0.9999f);
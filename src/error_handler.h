@@ -9,7 +9,9 @@ enum ErrorCode{
     kModulationSourceNotFound,
     kModulationDestinationNotFound,
     kModulationSourceParamNotFound,
-    kModulationDestinationParamNotFound
+    kModulationDestinationParamNotFound,
+    kObjectNotFound,
+    kUnsupportedByObject
 };
 
 static std::string OSGetErrorMessage(ErrorCode code){
@@ -26,6 +28,10 @@ static std::string OSGetErrorMessage(ErrorCode code){
             return "Modulation source parameter not found.";
         case ErrorCode::kModulationDestinationParamNotFound:
             return "Modulation destination parameter not found.";
+        case ErrorCode::kObjectNotFound:
+            return "Object not found.";
+        case ErrorCode::kUnsupportedByObject:
+            return "Operation not supported by this object.";
         default:
             {
                 std::string msg = "Unknown error code: " + std::to_string(static_cast<int>(code));
@@ -7,6 +7,7 @@ Filter::Filter(Context* context, ObjectID id, size_t n_channels) : m_context(con
     param_cutoff = static_cast<float>(1000.0); // Default cutoff 1kHz
     param_resonance = static_cast<float>(0.0); // Default resonance 0
     min_frequency = 8.f;
+    max_frequency = std::min(sample_rate / 2.f, 22050.f);
 }
 
 Filter::EFilterObjects Filter::getFilterObjectTypeFromString(const std::string type_str) {
@@ -19,4 +20,13 @@ Filter::EFilterObjects Filter::getFilterObjectTypeFromString(const std::string t
     return EFilterObjects::kZDF;
 }
 
+Filter::EFilterType Filter::getFilterTypeFromString(const std::string& type_str) {
+    if (type_str == "highpass") {
+        return EFilterType::kHighPass;
+    } else if (type_str == "bandpass") {
+        return EFilterType::kBandPass;
+    }
+    return EFilterType::kLowPass;
+}
+
 } // namespace OrangeSodium
\ No newline at end of file
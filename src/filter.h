@@ -36,6 +36,27 @@ public:
     virtual void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_frames) = 0;
     virtual void onSampleRateChange(float new_sample_rate) = 0;
 
+    /// @brief Returns true if audio_inputs and outputs may be the same buffer
+    virtual bool canProcessInPlace() const { return false; }
+
+    /// @brief Returns true if silent input would give silent output, i.e. the filter state has died out
+    virtual bool producesSilenceFromSilence() const { return false; }
+
+    /// @brief Clear the remains of a state that producesSilenceFromSilence reported as dead
+    virtual void flushTail() {}
+
+    /// @brief Take over the running state of a filter of the same object type from the previous build of the program
+    virtual void copyStateFrom(const Filter& /*other*/) {}
+
+    /// @brief Select the response (low-pass, high-pass, band-pass) for filters with several
+    virtual void setFilterType(EFilterType /*type*/) {}
+
+    /// @brief Parse a filter type name ("lowpass", "highpass", "bandpass"); low-pass if unknown
+    static EFilterType getFilterTypeFromString(const std::string& type_str);
+
+    /// @brief Advance past frames that were not processed because the input was silent
+    virtual void skipFrames(size_t n_frames) { frame_offset += n_frames; }
+
     /// @brief Get the current sample rate of the filter
     /// @return The current sample rate
     float getSampleRate() const { return sample_rate; }
@@ -57,8 +78,6 @@ public:
 
     static EFilterObjects getFilterObjectTypeFromString(const std::string type_str);
 
-    static int getDefaultDivisions() { return 1; }
-
     void beginBlock() { frame_offset = 0; }
     size_t getFrameOffset() const { return frame_offset; }
 
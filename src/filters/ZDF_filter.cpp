@@ -10,23 +10,25 @@ namespace OrangeSodium {
 
 ZDFFilter::ZDFFilter(Context* context, ObjectID id, size_t n_channels)
     : Filter(context, id, n_channels) {
-    // Initialize state variables for each channel
-    // ZDF SVF requires two integrator states per channel (fixed order-2)
-    ic1eq = new float[n_channels];
-    ic2eq = new float[n_channels];
-    ic3eq = new float[n_channels];
-    ic4eq = new float[n_channels];
-    g_smooth = new float[n_channels];
+    // Four integrator states per channel; padded so the last lanes of processBlock stay in bounds
+    const size_t n_state = (n_channels + kLanes - 1) / kLanes * kLanes;
+    ic1eq = new float[n_state];
+    ic2eq = new float[n_state];
+    ic3eq = new float[n_state];
+    ic4eq = new float[n_state];
 
-    for (size_t c = 0; c < n_channels; ++c) {
+    for (size_t c = 0; c < n_state; ++c) {
         ic1eq[c] = 0.0f;
         ic2eq[c] = 0.0f;
         ic3eq[c] = 0.0f;
         ic4eq[c] = 0.0f;
-        g_smooth[c] = 0.0f;
     }
-    
-    g_smooth_coeff = 1.f / sample_rate;
+
+    coeff_capacity = context->max_n_frames;
+    gain_coeffs = new float[coeff_capacity];
+    k_coeffs = new float[coeff_capacity];
+    silent_lane = new float[coeff_capacity]();
+    discarded_lane = new float[coeff_capacity];
 
     // Initialize filter parameters
     param_cutoff = 1000.0f;  // Default cutoff frequency in Hz
@@ -38,75 +40,227 @@ ZDFFilter::ZDFFilter(Context* context, ObjectID id, size_t n_channels)
     modulation_source_names.push_back("resonance");
 }
 
-void ZDFFilter::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_frames) {
+void ZDFFilter::setRampTarget(float g_target, float inv_n_frames) {
+    const float gain_target = g_target / (1.f + g_target);
+    if (!g_ramp_primed) {
+        g_ramp = g_target;
+        gain_ramp = gain_target;
+        g_ramp_primed = true;
+    }
+    g_ramp_step = (g_target - g_ramp) * inv_n_frames;
+    gain_ramp_step = (gain_target - gain_ramp) * inv_n_frames;
+}
+
+void ZDFFilter::prepareCoefficients(SignalBuffer* mod_inputs, size_t n_frames, size_t sub_block_offset) {
+    // Only reallocates if the block size grew since construction
+    if (n_frames > coeff_capacity) {
+        delete[] gain_coeffs;
+        delete[] k_coeffs;
+        delete[] silent_lane;
+        delete[] discarded_lane;
+        coeff_capacity = n_frames;
+        gain_coeffs = new float[coeff_capacity];
+        k_coeffs = new float[coeff_capacity];
+        silent_lane = new float[coeff_capacity]();
+        discarded_lane = new float[coeff_capacity];
+    }
 
-    // Get modulation buffers
     // mod_inputs[0] = cutoff [0, 1]
     // mod_inputs[1] = resonance [0, 1]
-    float* cutoff_buffer = mod_inputs->getChannel(0);
-    float* resonance_buffer = mod_inputs->getChannel(1);
-    const size_t cutoff_divisions = mod_inputs->getChannelDivision(0);
-    const size_t resonance_divisions = mod_inputs->getChannelDivision(1);
+    // Flat channels (silent or constant) are read through their hint and never written out
+    const SignalBuffer::ChannelHint* cutoff_hint = (mod_inputs) ? &mod_inputs->getChannelHint(0) : nullptr;
+    const SignalBuffer::ChannelHint* resonance_hint = (mod_inputs) ? &mod_inputs->getChannelHint(1) : nullptr;
+    const bool cutoff_flat = !cutoff_hint || cutoff_hint->type == SignalBuffer::EChannelHint::kSilent || cutoff_hint->type == SignalBuffer::EChannelHint::kConstant;
+    const bool resonance_flat = !resonance_hint || resonance_hint->type == SignalBuffer::EChannelHint::kSilent || resonance_hint->type == SignalBuffer::EChannelHint::kConstant;
+    const size_t cutoff_divisions = (mod_inputs) ? mod_inputs->getChannelDivision(0) : 1;
+    const size_t resonance_divisions = (mod_inputs) ? mod_inputs->getChannelDivision(1) : 1;
+    const float inv_cutoff_divisions = 1.f / static_cast<float>(cutoff_divisions);
+    if (param_cutoff != cached_cutoff) {
+        cached_cutoff = param_cutoff;
+        cached_cutoff_knob = frequencyToKnobValue(param_cutoff);
+    }
+    const float cutoff_knob_base = cached_cutoff_knob;
+    const float flat_g_target = (cutoff_flat) ? computeG(cutoff_knob_base, (cutoff_hint) ? SignalBuffer::getHintValue(*cutoff_hint, 0) : 0.f) : 0.f;
+    const float* resonance_buffer = (resonance_flat) ? nullptr : mod_inputs->getChannel(1);
+    const float flat_resonance = (resonance_flat && resonance_hint) ? SignalBuffer::getHintValue(*resonance_hint, 0) : 0.f;
 
-    for (size_t c = 0; c < n_channels; ++c) {
-        float* in_buffer = audio_inputs->getChannel(c);
-        float* out_buffer = outputs->getChannel(c);
+    // Settled: g has reached a constant cutoff and nothing varies within the sub-block
+    if (cutoff_flat && resonance_flat && g_ramp_primed && g_ramp == flat_g_target) {
+        g_ramp_step = 0.f;
+        gain_ramp_step = 0.f;
+        const float g = g_ramp;
+        const float resonance = std::clamp(flat_resonance + param_resonance, 0.0f, 1.0f);
+        const float k = resonance * 4.f * (1.f - 1.5f * g + 0.5f * g * g);
+        std::fill(gain_coeffs, gain_coeffs + n_frames, gain_ramp);
+        std::fill(k_coeffs, k_coeffs + n_frames, k);
+        return;
+    }
 
-        if (!in_buffer || !out_buffer) {
-            continue;
-        }
+    // A sub-block starting between control points still snaps to the cutoff of the current one
+    if (!g_ramp_primed) {
+        setRampTarget((cutoff_flat) ? flat_g_target : computeG(cutoff_knob_base, mod_inputs->getElement(0, sub_block_offset / cutoff_divisions)), 0.f);
+    }
 
-        size_t last_cutoff_index = -1;
-        float g = 0.0f;
-        float cutoff_hz;
-        for (size_t i = 0; i < n_frames; ++i) {
-            // Get modulated parameters
-            
-            if(true || cutoff_divisions == 1 || i / cutoff_divisions != last_cutoff_index) {
-                // Cutoff: map [0, 1] to frequency in Hz
-                const float cutoff_mod = (cutoff_buffer) ? cutoff_buffer[i / cutoff_divisions + frame_offset / cutoff_divisions] : 0.f;
-                const float param_cutoff_knob_value = frequencyToKnobValue(param_cutoff);
-                const float cutoff_knob = std::clamp(cutoff_mod + param_cutoff_knob_value, 0.0f, 1.0f);
-                cutoff_hz = knobValueToFrequency(cutoff_knob);
-                g = std::tan(static_cast<float>(M_PI) * std::clamp(cutoff_hz / sample_rate, 0.0f, 0.499f));
-                last_cutoff_index = i / cutoff_divisions;
-                
-                // If this is the first frame, also set the smoothed g value.
-                // This is to prevent large jumps in the beginning that can mess up transients.
-                if(i == 0) {
-                    g_smooth[c] = g;
-                }
-            }
+    // Walk the sub-block a control point at a time, so nothing but the ramps and the resonance runs per frame
+    size_t resonance_index = sub_block_offset / resonance_divisions;
+    size_t resonance_count = sub_block_offset % resonance_divisions;
+    size_t i = 0;
+    while (i < n_frames) {
+        const size_t frame = i + sub_block_offset;
+        const size_t into_division = frame % cutoff_divisions;
 
-            g = g_smooth[c] + g_smooth_coeff * (g - g_smooth[c]);
-            g_smooth[c] = g;
+        // New control point: aim the ramps at its g
+        if (into_division == 0) {
+            setRampTarget((cutoff_flat) ? flat_g_target : computeG(cutoff_knob_base, mod_inputs->getElement(0, frame / cutoff_divisions)), inv_cutoff_divisions);
+        }
+
+        const size_t segment_end = std::min(n_frames, i + (cutoff_divisions - into_division));
+        for (; i < segment_end; ++i) {
+            g_ramp += g_ramp_step;
+            gain_ramp += gain_ramp_step;
+            const float g = g_ramp;
 
             // Resonance: map [0, 1] to resonance coefficient
-            const float resonance_mod = (resonance_buffer) ? resonance_buffer[i / resonance_divisions + frame_offset / resonance_divisions] : 0.f;
+            const float resonance_mod = (resonance_buffer) ? resonance_buffer[resonance_index] : flat_resonance;
+            if (++resonance_count == resonance_divisions) {
+                resonance_count = 0;
+                ++resonance_index;
+            }
             const float resonance = std::clamp(resonance_mod + param_resonance, 0.0f, 1.0f);
+            const float kmax = 4.f * (1.f - 1.5f * g + 0.5f * g * g);
 
-            // Compute ZDF SVF coefficients
-            // g = tan(pi * fc / fs)
-            const float kmax = 4.f * (1.f - 1.5f * g + 0.5 * g * g);
-            const float k = resonance * kmax;
-            //const float k = 0.4f;
+            gain_coeffs[i] = gain_ramp;
+            k_coeffs[i] = resonance * kmax;
+        }
+    }
 
-            // ZDF SVF processing (Topology-Preserving Transform)
-            const float input_signal = in_buffer[i + frame_offset] - k * ic4eq[c];
+    // Snap to the target once the ramp is within rounding, so the settled path above can take over
+    if (cutoff_flat && std::abs(g_ramp - flat_g_target) <= 1e-6f * flat_g_target) {
+        g_ramp = flat_g_target;
+        gain_ramp = flat_g_target / (1.f + flat_g_target);
+        g_ramp_step = 0.f;
+        gain_ramp_step = 0.f;
+    }
+}
 
-            float v0 = (input_signal * g + ic1eq[c]) / (1.0f + g);
-            ic1eq[c] = 2.f * v0 - ic1eq[c];
-            float v1 = (v0 * g + ic2eq[c]) / (1.0f + g);
-            ic2eq[c] = 2.f * v1 - ic2eq[c];
-            float v2 = (v1 * g + ic3eq[c]) / (1.0f + g);
-            ic3eq[c] = 2.f * v2 - ic3eq[c];
-            float v3 = (v2 * g + ic4eq[c]) / (1.0f + g);
-            ic4eq[c] = 2.f * v3 - ic4eq[c];
+bool ZDFFilter::producesSilenceFromSilence() const {
+    constexpr float kSilence = 1e-7f;
+    for (size_t c = 0; c < n_channels; ++c) {
+        if (std::abs(ic1eq[c]) > kSilence || std::abs(ic2eq[c]) > kSilence || std::abs(ic3eq[c]) > kSilence || std::abs(ic4eq[c]) > kSilence) {
+            return false;
+        }
+    }
+    return true;
+}
 
-            // Select output based on filter type
-            float output_signal = v3;
+void ZDFFilter::flushTail() {
+    for (size_t c = 0; c < n_channels; ++c) {
+        ic1eq[c] = 0.0f;
+        ic2eq[c] = 0.0f;
+        ic3eq[c] = 0.0f;
+        ic4eq[c] = 0.0f;
+    }
+}
+
+template <Filter::EFilterType kType>
+void ZDFFilter::processLanes(SignalBuffer* audio_inputs, SignalBuffer* outputs, size_t first_channel, size_t n_frames) {
+    // Lane l runs channel first_channel + l. Missing channels read silence, write to scratch and keep their state.
+    const float* in[kLanes];
+    float* out[kLanes];
+    bool active[kLanes];
+    for (size_t l = 0; l < kLanes; ++l) {
+        const size_t c = first_channel + l;
+        float* in_buffer = (c < n_channels) ? audio_inputs->getChannel(c) : nullptr;
+        float* out_buffer = (c < n_channels) ? outputs->getChannelForOverwrite(c, frame_offset, frame_offset + n_frames) : nullptr;
+        active[l] = in_buffer && out_buffer;
+        in[l] = (active[l]) ? in_buffer + frame_offset : silent_lane;
+        out[l] = (active[l]) ? out_buffer + frame_offset : discarded_lane;
+    }
+
+    __m128 s1 = _mm_loadu_ps(ic1eq + first_channel);
+    __m128 s2 = _mm_loadu_ps(ic2eq + first_channel);
+    __m128 s3 = _mm_loadu_ps(ic3eq + first_channel);
+    __m128 s4 = _mm_loadu_ps(ic4eq + first_channel);
+    const __m128 two = _mm_set1_ps(2.f);
+    const __m128 four = _mm_set1_ps(4.f);
+    const __m128 six = _mm_set1_ps(6.f);
+
+    // One frame of every lane; same arithmetic as tick
+    auto step = [&](__m128 x, size_t i) {
+        const __m128 gain = _mm_set1_ps(gain_coeffs[i]);
+        const __m128 u = _mm_sub_ps(x, _mm_mul_ps(_mm_set1_ps(k_coeffs[i]), s4));
+        const __m128 v0 = _mm_add_ps(s1, _mm_mul_ps(gain, _mm_sub_ps(u, s1)));
+        s1 = _mm_sub_ps(_mm_mul_ps(two, v0), s1);
+        const __m128 v1 = _mm_add_ps(s2, _mm_mul_ps(gain, _mm_sub_ps(v0, s2)));
+        s2 = _mm_sub_ps(_mm_mul_ps(two, v1), s2);
+        const __m128 v2 = _mm_add_ps(s3, _mm_mul_ps(gain, _mm_sub_ps(v1, s3)));
+        s3 = _mm_sub_ps(_mm_mul_ps(two, v2), s3);
+        const __m128 v3 = _mm_add_ps(s4, _mm_mul_ps(gain, _mm_sub_ps(v2, s4)));
+        s4 = _mm_sub_ps(_mm_mul_ps(two, v3), s4);
+        if constexpr (kType == EFilterType::kHighPass) {
+            return _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_sub_ps(u, _mm_mul_ps(four, v0)), _mm_mul_ps(six, v1)), _mm_mul_ps(four, v2)), v3);
+        } else if constexpr (kType == EFilterType::kBandPass) {
+            return _mm_mul_ps(four, _mm_add_ps(_mm_sub_ps(v1, _mm_mul_ps(two, v2)), v3));
+        } else {
+            return v3;
+        }
+    };
+
+    // Four frames at a time: a 4x4 transpose turns four frames of each channel into four frames of all lanes
+    size_t i = 0;
+    for (; i + 4 <= n_frames; i += 4) {
+        __m128 x0 = _mm_loadu_ps(in[0] + i);
+        __m128 x1 = _mm_loadu_ps(in[1] + i);
+        __m128 x2 = _mm_loadu_ps(in[2] + i);
+        __m128 x3 = _mm_loadu_ps(in[3] + i);
+        _MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+        __m128 y0 = step(x0, i);
+        __m128 y1 = step(x1, i + 1);
+        __m128 y2 = step(x2, i + 2);
+        __m128 y3 = step(x3, i + 3);
+        _MM_TRANSPOSE4_PS(y0, y1, y2, y3);
+        _mm_storeu_ps(out[0] + i, y0);
+        _mm_storeu_ps(out[1] + i, y1);
+        _mm_storeu_ps(out[2] + i, y2);
+        _mm_storeu_ps(out[3] + i, y3);
+    }
+    alignas(16) float lanes[kLanes];
+    for (; i < n_frames; ++i) {
+        _mm_store_ps(lanes, step(_mm_setr_ps(in[0][i], in[1][i], in[2][i], in[3][i]), i));
+        for (size_t l = 0; l < kLanes; ++l) {
+            out[l][i] = lanes[l];
+        }
+    }
+
+    alignas(16) float states[4][kLanes];
+    _mm_store_ps(states[0], s1);
+    _mm_store_ps(states[1], s2);
+    _mm_store_ps(states[2], s3);
+    _mm_store_ps(states[3], s4);
+    for (size_t l = 0; l < kLanes; ++l) {
+        if (active[l]) {
+            ic1eq[first_channel + l] = states[0][l];
+            ic2eq[first_channel + l] = states[1][l];
+            ic3eq[first_channel + l] = states[2][l];
+            ic4eq[first_channel + l] = states[3][l];
+        }
+    }
+}
+
+void ZDFFilter::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_frames) {
+    prepareCoefficients(mod_inputs, n_frames, frame_offset);
 
-            out_buffer[i + frame_offset] = output_signal;
+    for (size_t c = 0; c < n_channels; c += kLanes) {
+        switch (filter_type) {
+            case EFilterType::kHighPass:
+                processLanes<EFilterType::kHighPass>(audio_inputs, outputs, c, n_frames);
+                break;
+            case EFilterType::kBandPass:
+                processLanes<EFilterType::kBandPass>(audio_inputs, outputs, c, n_frames);
+                break;
+            default:
+                processLanes<EFilterType::kLowPass>(audio_inputs, outputs, c, n_frames);
+                break;
         }
     }
     frame_offset += n_frames;
@@ -114,7 +268,25 @@ void ZDFFilter::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_input
 
 void ZDFFilter::onSampleRateChange(float new_sample_rate) {
     sample_rate = new_sample_rate;
-    g_smooth_coeff = 1.f / sample_rate * 500.f;
+    // Both cached evaluations depend on the rate (through max_frequency and the prewarp)
+    cached_cutoff = -1.f;
+    cached_g_knob = -1.f;
+}
+
+void ZDFFilter::copyStateFrom(const Filter& other) {
+    const ZDFFilter& running = static_cast<const ZDFFilter&>(other);
+    const size_t n = std::min(n_channels, running.n_channels);
+    for (size_t c = 0; c < n; ++c) {
+        ic1eq[c] = running.ic1eq[c];
+        ic2eq[c] = running.ic2eq[c];
+        ic3eq[c] = running.ic3eq[c];
+        ic4eq[c] = running.ic4eq[c];
+    }
+    g_ramp = running.g_ramp;
+    g_ramp_step = running.g_ramp_step;
+    gain_ramp = running.gain_ramp;
+    gain_ramp_step = running.gain_ramp_step;
+    g_ramp_primed = running.g_ramp_primed;
 }
 
 void ZDFFilter::setFilterType(EFilterType type) {
@@ -126,7 +298,10 @@ ZDFFilter::~ZDFFilter() {
     delete[] ic2eq;
     delete[] ic3eq;
     delete[] ic4eq;
-    delete[] g_smooth;
+    delete[] gain_coeffs;
+    delete[] k_coeffs;
+    delete[] silent_lane;
+    delete[] discarded_lane;
 }
 
 } // namespace OrangeSodium
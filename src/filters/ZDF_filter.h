@@ -1,5 +1,22 @@
 #pragma once
 #include "../filter.h"
+#include "../simd.h"
+#include <cmath>
+#include <algorithm>
+
+/*
+Four-stage ladder of one-pole ZDF (topology-preserving transform) integrators with resonance feedback from the
+last stage. The low-pass output is the last stage; the high-pass and band-pass outputs are mixes of the stage
+outputs of the same pass (Zavalishin, "The Art of VA Filter Design", 5.4):
+    high-pass (4-pole) = u - 4 y1 + 6 y2 - 4 y3 + y4
+    band-pass (2+2-pole) = 4 (y2 - 2 y3 + y4)
+where u is the input after feedback and yn the output of stage n.
+
+Coefficients are shared by every channel. The cutoff is turned into g (log10, pow and tan) once per control point
+of the cutoff channel, and only if it differs from the last one; g and the one-pole gain g / (1 + g) then ramp
+linearly over the frames of the control point, so nothing but the ramp runs per frame. processBlock runs four
+channels at a time in SSE lanes, so a stereo pair goes through the ladder together.
+*/
 
 namespace OrangeSodium{
 
@@ -10,24 +27,117 @@ public:
 
     void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_frames) override;
     void onSampleRateChange(float new_sample_rate) override;
+    bool canProcessInPlace() const override { return true; }
+
+    /// @brief True once every integrator has decayed below the denormal range
+    bool producesSilenceFromSilence() const override;
+    void flushTail() override;
+
+    /// @brief Take over the integrators and the g ramp, so a changed cutoff glides from the running value
+    void copyStateFrom(const Filter& other) override;
 
     /// @brief Set the filter type (low-pass, high-pass, band-pass)
     /// @param type The filter type
-    void setFilterType(EFilterType type);
+    void setFilterType(EFilterType type) override;
+    EFilterType getFilterType() const { return filter_type; }
+
+    /// @brief Compute the per-frame coefficients of a (sub-)block. They are shared by every channel.
+    /// The cutoff is only evaluated once per control point of the cutoff channel (tan, log10 and pow), and only
+    /// when it changed; g and g / (1 + g) ramp linearly to it over the frames of the control point. Once g has
+    /// settled with a constant resonance the coefficients are a plain fill.
+    /// @param mod_inputs Modulation inputs (cutoff, resonance); may be nullptr
+    /// @param n_frames Number of frames to compute
+    /// @param sub_block_offset Offset of this sub-block within the current block
+    void prepareCoefficients(SignalBuffer* mod_inputs, size_t n_frames, size_t sub_block_offset);
+
+    /// @brief Coefficients written by the last prepareCoefficients call, indexed by frame within the sub-block
+    const float* getGainCoefficients() const { return gain_coeffs; }
+    const float* getResonanceCoefficients() const { return k_coeffs; }
+
+    /// @brief Process a single sample of one channel. Used by processBlock and by fused effect runs.
+    /// @param x Input sample
+    /// @param channel Channel index (selects the integrator state)
+    /// @param gain One-pole gain g / (1 + g), from getGainCoefficients
+    /// @param k Resonance feedback, from getResonanceCoefficients
+    inline float tick(float x, size_t channel, float gain, float k);
 
 private:
+    static constexpr size_t kLanes = 4; // Channels per SSE pass
 
-    // ZDF SVF state variables (per channel)
-    // Fixed order-2 filter needs 2 integrator states per channel
+    // Integrator states per channel, padded to a whole number of lanes
     float* ic1eq;  // Integrator 1 state [channel]
     float* ic2eq;  // Integrator 2 state [channel]
     float* ic3eq;  // Integrator 3 state [channel]
     float* ic4eq;  // Integrator 4 state [channel]
 
-    float* g_smooth; // Smoothed g values per channel
-    float g_smooth_coeff;
+    // Control-rate ramps of g and of the one-pole gain g / (1 + g); shared by all channels because the modulation
+    // inputs are
+    float g_ramp = 0.f;
+    float g_ramp_step = 0.f;
+    float gain_ramp = 0.f;
+    float gain_ramp_step = 0.f;
+    bool g_ramp_primed = false; // The first control point snaps g instead of ramping from 0
+
+    // Last evaluations of the cutoff, so unchanged values skip log10, pow and tan
+    float cached_cutoff = -1.f;       // param_cutoff that cached_cutoff_knob is for
+    float cached_cutoff_knob = 0.f;
+    float cached_g_knob = -1.f;       // Knob value (with modulation) that cached_g is for; negative when out of date
+    float cached_g = 0.f;
+
+    // Zero input and discarded output for lanes past the last channel
+    float* silent_lane = nullptr;
+    float* discarded_lane = nullptr;
+
+    // Per-frame coefficients of the current sub-block
+    float* gain_coeffs = nullptr;
+    float* k_coeffs = nullptr;
+    size_t coeff_capacity = 0;
 
     EFilterType filter_type;
+
+    float computeG(float cutoff_knob_base, float cutoff_mod) {
+        const float cutoff_knob = std::clamp(cutoff_mod + cutoff_knob_base, 0.0f, 1.0f);
+        if (cutoff_knob == cached_g_knob) {
+            return cached_g;
+        }
+        const float cutoff_hz = knobValueToFrequency(cutoff_knob);
+        cached_g_knob = cutoff_knob;
+        cached_g = std::tan(3.14159265358979323846f * std::clamp(cutoff_hz / sample_rate, 0.0f, 0.499f));
+        return cached_g;
+    }
+
+    /// @brief Aim the ramps at g_target, reached after 1 / inv_n_frames frames (snapping on the first control point)
+    void setRampTarget(float g_target, float inv_n_frames);
+
+    /// @brief Run the channels [first_channel, first_channel + kLanes) through the ladder together
+    template <EFilterType kType>
+    void processLanes(SignalBuffer* audio_inputs, SignalBuffer* outputs, size_t first_channel, size_t n_frames);
 };
 
-}
\ No newline at end of file
+float ZDFFilter::tick(float x, size_t channel, float gain, float k) {
+    const size_t c = channel;
+
+    // ZDF SVF processing (Topology-Preserving Transform)
+    // Each stage is v = (u * g + s) / (1 + g), written as s + gain * (u - s) with gain = g / (1 + g)
+    const float input_signal = x - k * ic4eq[c];
+
+    float v0 = ic1eq[c] + gain * (input_signal - ic1eq[c]);
+    ic1eq[c] = 2.f * v0 - ic1eq[c];
+    float v1 = ic2eq[c] + gain * (v0 - ic2eq[c]);
+    ic2eq[c] = 2.f * v1 - ic2eq[c];
+    float v2 = ic3eq[c] + gain * (v1 - ic3eq[c]);
+    ic3eq[c] = 2.f * v2 - ic3eq[c];
+    float v3 = ic4eq[c] + gain * (v2 - ic4eq[c]);
+    ic4eq[c] = 2.f * v3 - ic4eq[c];
+
+    switch (filter_type) {
+        case EFilterType::kHighPass:
+            return input_signal - 4.f * v0 + 6.f * v1 - 4.f * v2 + v3;
+        case EFilterType::kBandPass:
+            return 4.f * (v1 - 2.f * v2 + v3);
+        default:
+            return v3;
+    }
+}
+
+}
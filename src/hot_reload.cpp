@@ -0,0 +1,76 @@
+#include "hot_reload.h"
+#include "voice.h"
+#include <cstring>
+
+namespace OrangeSodium {
+
+std::vector<std::string> HotReloadPlan::getStableNames(const ObjectRegistry& registry, const std::vector<ObjectID>& ids, const std::vector<const char*>& type_names) {
+    std::vector<std::string> names(type_names.size());
+    for (size_t i = 0; i < type_names.size(); ++i) {
+        const std::string& script_name = (i < ids.size()) ? registry.get(ids[i]).name : std::string();
+        if (!script_name.empty()) {
+            names[i] = script_name;
+            continue;
+        }
+        // Position among the unnamed objects of the same type, so naming or moving a named object does not shift the rest
+        size_t ordinal = 0;
+        for (size_t j = 0; j < i; ++j) {
+            const bool named = j < ids.size() && !registry.get(ids[j]).name.empty();
+            if (!named && std::strcmp(type_names[j], type_names[i]) == 0) {
+                ++ordinal;
+            }
+        }
+        names[i] = std::string(type_names[i]) + "#" + std::to_string(ordinal);
+    }
+    return names;
+}
+
+std::vector<std::pair<size_t, size_t>> HotReloadPlan::matchNames(const std::vector<std::string>& running_names, const std::vector<const char*>& running_types,
+                                                                 const std::vector<std::string>& reloaded_names, const std::vector<const char*>& reloaded_types) {
+    std::vector<std::pair<size_t, size_t>> pairs;
+    std::vector<bool> taken(running_names.size(), false);
+    for (size_t r = 0; r < reloaded_names.size(); ++r) {
+        for (size_t o = 0; o < running_names.size(); ++o) {
+            if (!taken[o] && running_names[o] == reloaded_names[r] && std::strcmp(running_types[o], reloaded_types[r]) == 0) {
+                taken[o] = true;
+                pairs.push_back({o, r});
+                break;
+            }
+        }
+    }
+    return pairs;
+}
+
+void HotReloadPlan::apply() const {
+    // Voices first, so new producers see whether their voice is held
+    for (const auto& match : voices) {
+        match.reloaded->copyStateFrom(*match.running);
+    }
+    for (const auto& match : oscillators) {
+        match.reloaded->copyStateFrom(*match.running);
+    }
+    for (const auto& match : producers) {
+        match.reloaded->copyStateFrom(*match.running);
+    }
+    for (const auto& match : effects) {
+        match.reloaded->copyStateFrom(*match.running);
+    }
+
+    // A new envelope would sit idle until the next note on; start it for notes that are still held
+    for (const auto& entry : new_producers) {
+        if (entry.first->isPlaying() && !entry.first->isReleasing()) {
+            entry.second->onRetrigger();
+        }
+    }
+}
+
+void HotReloadPlan::clear() {
+    voices.clear();
+    oscillators.clear();
+    producers.clear();
+    effects.clear();
+    new_producers.clear();
+    n_new_objects = 0;
+}
+
+}
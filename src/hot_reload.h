@@ -0,0 +1,90 @@
+// Carrying the running state of a synthesizer over to a new build of its program
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <utility>
+#include "utilities.h"
+#include "object_registry.h"
+
+/*
+Reloading a program builds a complete new synthesizer, which is slow (Lua, allocations, FFTs) and must stay off
+the audio thread. A fresh build would start every note, phase, envelope and filter from zero, so a HotReloadPlan
+pairs each object of the new build with the object that plays the same role in the running one. The audio thread
+then only has to copy the running state into the new objects and swap synthesizers at a block boundary.
+
+Objects are paired by stable name. An object named by the script (set_object_name) is called by that name;
+any other object is called by its type and its position among unnamed objects of that type in its owner, e.g.
+"sine_osc#1" for the second sine oscillator of a voice. Effects are named within their effect chain, and effect
+chains and voices are paired by position. Pairs must also have the same type, so an object that changed type
+starts fresh. Objects without a pair start fresh too; envelopes of a held voice are retriggered so that adding
+one does not silence the note.
+*/
+
+namespace OrangeSodium{
+
+class Voice;
+class Oscillator;
+class ModulationProducer;
+class Effect;
+
+class HotReloadPlan {
+public:
+    template <typename T>
+    struct Match {
+        const T* running; // Object in the synthesizer that is playing now
+        T* reloaded;      // Object in the new build that takes over its state
+    };
+
+    std::vector<Match<Voice>> voices;
+    std::vector<Match<Oscillator>> oscillators;
+    std::vector<Match<ModulationProducer>> producers;
+    std::vector<Match<Effect>> effects;
+
+    /// @brief Producers of the new build with no running counterpart, and the voice they belong to
+    std::vector<std::pair<Voice*, ModulationProducer*>> new_producers;
+
+    size_t n_new_objects = 0; // Objects of the new build that start fresh
+
+    /// @brief Pair the objects of one owner in the running synthesizer with those of its counterpart in the new build
+    /// @param running_registry Registry of the running synthesizer, for names given by the script
+    /// @param out List the pairs are appended to
+    /// @return For every object of the new build, whether it was paired
+    template <typename T>
+    std::vector<bool> matchObjects(const ObjectRegistry& running_registry, const std::vector<T*>& running_objects, const std::vector<ObjectID>& running_ids,
+                                   const ObjectRegistry& registry, const std::vector<T*>& objects, const std::vector<ObjectID>& ids, std::vector<Match<T>>& out) {
+        std::vector<const char*> running_types;
+        std::vector<const char*> types;
+        for (const T* object : running_objects) {
+            running_types.push_back(object->getTypeName());
+        }
+        for (const T* object : objects) {
+            types.push_back(object->getTypeName());
+        }
+        const auto pairs = matchNames(getStableNames(running_registry, running_ids, running_types), running_types, getStableNames(registry, ids, types), types);
+
+        std::vector<bool> matched(objects.size(), false);
+        for (const auto& pair : pairs) {
+            out.push_back({running_objects[pair.first], objects[pair.second]});
+            matched[pair.second] = true;
+        }
+        n_new_objects += objects.size() - pairs.size();
+        return matched;
+    }
+
+    /// @brief Copy the running state into the new build. Does not allocate; called on the audio thread at a block boundary.
+    void apply() const;
+
+    void clear();
+    size_t getNumMatches() const { return voices.size() + oscillators.size() + producers.size() + effects.size(); }
+
+private:
+    /// @brief Stable names of an owner's objects, in the owner's order
+    static std::vector<std::string> getStableNames(const ObjectRegistry& registry, const std::vector<ObjectID>& ids, const std::vector<const char*>& type_names);
+
+    /// @brief Pair objects by stable name and type; pairs are (running index, reloaded index)
+    static std::vector<std::pair<size_t, size_t>> matchNames(const std::vector<std::string>& running_names, const std::vector<const char*>& running_types,
+                                                             const std::vector<std::string>& reloaded_names, const std::vector<const char*>& reloaded_types);
+};
+
+}
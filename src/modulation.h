@@ -3,29 +3,26 @@
 // Defines structure for a modulation
 
 #include "utilities.h"
+#include "signal_buffer.h"
 
 namespace OrangeSodium{
 
+// Description of one routing from a modulation producer output to a modulation destination channel.
+// Routings are owned and executed by a ModulationRouter.
 struct Modulation{
-    // bool centered = false;
-    // float amount = 0; // Modulation amount, in range [-1, 1]
-    // ObjectID mod_source_id = 0; // ObjectID of modulation source
-    // size_t param_index = 0; // Index of parameter being modulated
-    // size_t impl_index = 0; // Index of implementation variable being modulated
-
-
-    void* modulation_source = nullptr; // Pointer to modulation producer sources
+    ObjectID source_id = 0; // ObjectID of the modulation producer
     size_t source_index = 0; // Index of modulation source channel
-    void* modulation_destination = nullptr; // Pointer to modulation destination
+    ObjectID dest_id = 0; // ObjectID of the destination (oscillator or effect)
     size_t dest_index = 0; // Index of destination modulation channel
     float amount = 0.0f; // Modulation amount
-    EObjectType dest_type;
-
-    bool dest_is_effect;
+    EObjectType dest_type = EObjectType::kUndefined;
 
     // Used only if the destination is an effect inside an effect chain
-    EffectChainIndex effect_chain_index;
-    size_t effect_index;
+    EffectChainIndex effect_chain_index = -1;
+    size_t effect_index = 0;
+
+    SignalBuffer* source_buffer = nullptr; // Output buffer of the modulation source
+    SignalBuffer* dest_buffer = nullptr; // Modulation buffer of the destination
 };
 
-};
\ No newline at end of file
+};
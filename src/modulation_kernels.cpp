@@ -0,0 +1,139 @@
+#include "modulation_kernels.h"
+#include "signal_buffer.h"
+#include "simd.h"
+
+namespace OrangeSodium {
+
+// Largest division (as a shift) that gets a specialised kernel: 1 << 5 = 32 frames
+static constexpr size_t kMaxKernelShift = 5;
+
+// Destination elements whose frame falls inside [frame_offset, frame_offset + n_audio_frames)
+static inline void destRange(size_t dest_shift, size_t dest_length, size_t n_audio_frames, size_t frame_offset, size_t& begin, size_t& end) {
+    const size_t dest_division = static_cast<size_t>(1) << dest_shift;
+    begin = (frame_offset + dest_division - 1) >> dest_shift;
+    end = (frame_offset + n_audio_frames + dest_division - 1) >> dest_shift;
+    if (end > dest_length) {
+        end = dest_length;
+    }
+}
+
+// Lane index of every SIMD lane, used to build ramps
+alignas(OS_SIMD_ALIGNMENT) static const float lane_offsets[OS_SIMD_WIDTH] = {
+#ifdef OS_AVX
+    0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f
+#else
+    0.f, 1.f, 2.f, 3.f
+#endif
+};
+
+template <size_t SourceShift, size_t DestShift>
+static void applyModulation(const float* source, float* dest, float amount, size_t, size_t, size_t dest_length, float previous, size_t n_audio_frames, size_t frame_offset) {
+    size_t begin, end;
+    destRange(DestShift, dest_length, n_audio_frames, frame_offset, begin, end);
+    if (begin >= end) {
+        return;
+    }
+
+    if constexpr (SourceShift == DestShift) {
+        // Same rate: dest[j] += amount * source[j]
+        const os_simd_t amount_v = OS_SIMD_SET1(amount);
+        size_t j = begin;
+        for (; j + OS_SIMD_WIDTH <= end; j += OS_SIMD_WIDTH) {
+            const os_simd_t s = OS_SIMD_LOAD(source + j);
+            const os_simd_t d = OS_SIMD_LOAD(dest + j);
+            OS_SIMD_STORE(dest + j, OS_SIMD_ADD(d, OS_SIMD_MUL(amount_v, s)));
+        }
+        for (; j < end; ++j) {
+            dest[j] += amount * source[j];
+        }
+    } else if constexpr (SourceShift > DestShift) {
+        // Slower source: source element k covers 1 << kShift destination elements, which ramp from
+        // source[k - 1] (or previous, for k == 0) towards source[k]
+        constexpr size_t kShift = SourceShift - DestShift;
+        constexpr size_t kSpan = static_cast<size_t>(1) << kShift;
+        constexpr float kInvSpan = 1.f / static_cast<float>(kSpan);
+        size_t j = begin;
+        while (j < end) {
+            const size_t k = j >> kShift;
+            const size_t span_begin = k << kShift;
+            const size_t span_end = (span_begin + kSpan) < end ? (span_begin + kSpan) : end;
+            const float start = amount * ((k > 0) ? source[k - 1] : previous);
+            const float slope = (amount * source[k] - start) * kInvSpan;
+            if constexpr (kSpan >= OS_SIMD_WIDTH) {
+                const os_simd_t lanes_v = OS_SIMD_MUL(OS_SIMD_LOAD_ALIGNED(lane_offsets), OS_SIMD_SET1(slope));
+                for (; j + OS_SIMD_WIDTH <= span_end; j += OS_SIMD_WIDTH) {
+                    const os_simd_t ramp_v = OS_SIMD_ADD(OS_SIMD_SET1(start + slope * static_cast<float>(j - span_begin)), lanes_v);
+                    OS_SIMD_STORE(dest + j, OS_SIMD_ADD(OS_SIMD_LOAD(dest + j), ramp_v));
+                }
+            }
+            for (; j < span_end; ++j) {
+                dest[j] += start + slope * static_cast<float>(j - span_begin);
+            }
+        }
+    } else {
+        // Faster source: read every (1 << (DestShift - SourceShift))th source value
+        constexpr size_t kShift = DestShift - SourceShift;
+        for (size_t j = begin; j < end; ++j) {
+            dest[j] += amount * source[j << kShift];
+        }
+    }
+}
+
+// Fallback for divisions that are not powers of two, or larger than the specialised range
+static void applyModulationGeneric(const float* source, float* dest, float amount, size_t source_division, size_t dest_division, size_t dest_length, float previous, size_t n_audio_frames, size_t frame_offset) {
+    size_t begin, end;
+    SignalBuffer::getElementRange(dest_division, dest_length, n_audio_frames, frame_offset, begin, end);
+    size_t frame = begin * dest_division;
+    if (source_division <= dest_division) {
+        for (size_t j = begin; j < end; ++j, frame += dest_division) {
+            dest[j] += amount * source[frame / source_division];
+        }
+        return;
+    }
+
+    // Slower source: ramp between control points as in the specialised kernels
+    const float inv_division = 1.f / static_cast<float>(source_division);
+    for (size_t j = begin; j < end; ++j, frame += dest_division) {
+        const size_t k = frame / source_division;
+        const float start = (k > 0) ? source[k - 1] : previous;
+        const float t = static_cast<float>(frame - k * source_division) * inv_division;
+        dest[j] += amount * (start + (source[k] - start) * t);
+    }
+}
+
+#define OS_MOD_KERNEL(S, D) &applyModulation<S, D>
+#define OS_MOD_KERNEL_ROW(S) { OS_MOD_KERNEL(S, 0), OS_MOD_KERNEL(S, 1), OS_MOD_KERNEL(S, 2), OS_MOD_KERNEL(S, 3), OS_MOD_KERNEL(S, 4), OS_MOD_KERNEL(S, 5) }
+
+// Indexed by [source shift][dest shift]
+static const ModulationKernel modulation_kernels[kMaxKernelShift + 1][kMaxKernelShift + 1] = {
+    OS_MOD_KERNEL_ROW(0),
+    OS_MOD_KERNEL_ROW(1),
+    OS_MOD_KERNEL_ROW(2),
+    OS_MOD_KERNEL_ROW(3),
+    OS_MOD_KERNEL_ROW(4),
+    OS_MOD_KERNEL_ROW(5)
+};
+
+#undef OS_MOD_KERNEL_ROW
+#undef OS_MOD_KERNEL
+
+static bool divisionToShift(size_t division, size_t& shift) {
+    if (division == 0 || (division & (division - 1)) != 0) {
+        return false;
+    }
+    shift = 0;
+    while ((static_cast<size_t>(1) << shift) < division) {
+        ++shift;
+    }
+    return shift <= kMaxKernelShift;
+}
+
+ModulationKernel selectModulationKernel(size_t source_division, size_t dest_division) {
+    size_t source_shift, dest_shift;
+    if (divisionToShift(source_division, source_shift) && divisionToShift(dest_division, dest_shift)) {
+        return modulation_kernels[source_shift][dest_shift];
+    }
+    return &applyModulationGeneric;
+}
+
+}
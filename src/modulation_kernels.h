@@ -0,0 +1,32 @@
+// Kernels that apply a modulation source channel to a destination modulation channel
+#pragma once
+#include <cstddef>
+
+/*
+A routing kernel adds amount * source to a destination channel over one (sub-)block. Source and destination
+may run at different channel divisions; destination element j lives at audio frame j * dest_division and reads
+the source element covering that frame. Kernels are template instantiations over the two divisions (as
+power-of-two shifts), so there is no integer division or bounds check in the inner loop:
+  - equal divisions: a straight SIMD multiply-add
+  - slower source (e.g. a control-rate source into an audio-rate destination): the destination ramps linearly
+    from the previous control point to the current one over the frames the current one covers. This trails
+    the source by one control period but has no steps, so control-rate envelopes do not cause zipper noise.
+  - faster source: the source is read with a constant stride
+A kernel is picked once, when the modulation is added. Non-power-of-two divisions use a generic fallback.
+*/
+
+namespace OrangeSodium {
+
+/// @brief Apply amount * source to dest for the frames [frame_offset, frame_offset + n_audio_frames)
+/// @param source Source channel data (start of the channel)
+/// @param dest Destination channel data (start of the channel)
+/// @param source_division Channel division of the source (only read by the generic fallback)
+/// @param dest_division Channel division of the destination (only read by the generic fallback)
+/// @param dest_length Length of the destination channel, in elements
+/// @param previous Last source value of the previous block; the ramp into source element 0 starts there
+typedef void (*ModulationKernel)(const float* source, float* dest, float amount, size_t source_division, size_t dest_division, size_t dest_length, float previous, size_t n_audio_frames, size_t frame_offset);
+
+/// @brief Pick the routing kernel for a pair of channel divisions. Never returns nullptr.
+ModulationKernel selectModulationKernel(size_t source_division, size_t dest_division);
+
+}
@@ -36,13 +36,22 @@ void BasicEnvelope::processBlock(SignalBuffer* mod_inputs, SignalBuffer* outputs
         is_retriggered = false;
     }
     float* output_buffer = outputs->getChannel(0);
-    for (size_t i = 0; i < n_frames; ++i) {
+
+    // The envelope runs at the output channel's division: one value per control point, and every
+    // control point advances the envelope by division audio frames. Consumers ramp between the points.
+    const size_t division = outputs->getChannelDivision(0);
+    const float step_seconds = static_cast<float>(division) / sample_rate;
+    size_t begin, end;
+    SignalBuffer::getElementRange(division, outputs->getChannelLength(0), n_frames, frame_offset, begin, end);
+    const EStage start_stage = current_stage;
+
+    for (size_t j = begin; j < end; ++j) {
         switch (current_stage) {
             case EStage::kIdle:
                 state = 0.0f;
                 break;
             case EStage::kAttack:
-                state += 1.0f / (attack_time * sample_rate);
+                state += step_seconds / attack_time;
                 release_level = state;
                 if (state >= 1.0f) {
                     state = 1.0f;
@@ -50,7 +59,7 @@ void BasicEnvelope::processBlock(SignalBuffer* mod_inputs, SignalBuffer* outputs
                 }
                 break;
             case EStage::kDecay:
-                state -= (1.0f - sustain_level) / (decay_time * sample_rate);
+                state -= (1.0f - sustain_level) * step_seconds / decay_time;
                 release_level = state;
                 if (state <= sustain_level) {
                     state = sustain_level;
@@ -64,22 +73,43 @@ void BasicEnvelope::processBlock(SignalBuffer* mod_inputs, SignalBuffer* outputs
                 release_level = state;
                 break;
             case EStage::kRelease:
-                state -= release_level / (release_time * sample_rate);
+                state -= release_level * step_seconds / release_time;
                 if (state <= 0.0f) {
                     state = 0.0f;
                     current_stage = EStage::kIdle;
                 }
                 break;
         }
-        output_buffer[i + frame_offset] = state;
+        output_buffer[j] = state;
+    }
+
+    // Describe the range for consumers. Every stage is linear, so a range that stays in one stage is a ramp.
+    if (begin < end && current_stage == start_stage) {
+        SignalBuffer::ChannelHint hint;
+        switch (current_stage) {
+            case EStage::kIdle:
+                hint.type = SignalBuffer::EChannelHint::kSilent;
+                break;
+            case EStage::kSustain:
+                hint.type = SignalBuffer::EChannelHint::kConstant;
+                hint.value = sustain_level;
+                break;
+            default:
+                hint.type = SignalBuffer::EChannelHint::kRamp;
+                hint.value = output_buffer[begin];
+                hint.step = (end - begin > 1) ? (output_buffer[end - 1] - output_buffer[begin]) / static_cast<float>(end - 1 - begin) : 0.f;
+                hint.begin = begin;
+                hint.end = end;
+                break;
+        }
+        outputs->setChannelHint(0, hint);
     }
     frame_offset += n_frames;
 }
 
 void BasicEnvelope::onSampleRateChange(float new_sample_rate) {
-    sample_rate = new_sample_rate / static_cast<float>(output_buffer->getChannelDivision(0));
+    // Keep the audio rate; the control rate follows from the output division in processBlock
+    sample_rate = new_sample_rate;
 }
 
-    
-
 } // namespace OrangeSodium
\ No newline at end of file
@@ -9,7 +9,7 @@
 *                  [2] - Sustain level (0.0 to 1.0)
 *                  [3] - Release time (seconds)
 * Outputs:
-*                  [0] - Envelope output (0.0 to 1.0)
+*                  [0] - Envelope output (0.0 to 1.0), one value per control point of the output division
 */
 
 namespace OrangeSodium {
@@ -28,6 +28,14 @@ public:
     void onRelease() override {
         current_stage = EStage::kRelease;
     }
+    const char* getTypeName() const override { return "basic_envelope"; }
+    void copyStateFrom(const ModulationProducer& other) override {
+        const BasicEnvelope& running = static_cast<const BasicEnvelope&>(other);
+        is_retriggered = running.is_retriggered;
+        release_level = running.release_level;
+        state = running.state;
+        current_stage = running.current_stage;
+    }
     void retrigger() {
         is_retriggered = true;
         current_stage = EStage::kAttack;
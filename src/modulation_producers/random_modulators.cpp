@@ -0,0 +1,79 @@
+#include "random_modulators.h"
+
+namespace OrangeSodium {
+
+RandomModulator::RandomModulator(Context* context, ObjectID id, size_t voice_index, float rate)
+    : ModulationProducer(context, id),
+      random(CounterRandom::makeKey(voice_index, id)),
+      rate(rate) {
+    output_buffer = nullptr;
+
+    modulation_output_names.resize(0);
+    modulation_output_names.push_back("output");
+}
+
+void RandomModulator::onSampleRateChange(float new_sample_rate) {
+    // Keep the audio rate; the control rate follows from the output division in processBlock
+    sample_rate = new_sample_rate;
+}
+
+bool RandomModulator::advance(float step_seconds) {
+    if (is_retriggered) {
+        is_retriggered = false;
+        phase = 0.f;
+        previous_value = value;
+        value = random.nextBipolar();
+        return true;
+    }
+    phase += rate * step_seconds;
+    if (phase < 1.f) {
+        return false;
+    }
+    phase -= static_cast<float>(static_cast<int>(phase));
+    previous_value = value;
+    value = random.nextBipolar();
+    return true;
+}
+
+void SampleAndHold::processBlock(SignalBuffer* /*mod_inputs*/, SignalBuffer* outputs, size_t n_frames) {
+    float* output_buffer = outputs->getChannel(0);
+
+    // One value per control point, as for the envelopes
+    const size_t division = outputs->getChannelDivision(0);
+    const float step_seconds = static_cast<float>(division) / sample_rate;
+    size_t begin, end;
+    SignalBuffer::getElementRange(division, outputs->getChannelLength(0), n_frames, frame_offset, begin, end);
+
+    bool changed = false;
+    for (size_t j = begin; j < end; ++j) {
+        changed |= advance(step_seconds) && j > begin;
+        output_buffer[j] = value;
+    }
+
+    // A range without a new value is constant
+    if (begin < end && !changed) {
+        SignalBuffer::ChannelHint hint;
+        hint.type = SignalBuffer::EChannelHint::kConstant;
+        hint.value = output_buffer[begin];
+        outputs->setChannelHint(0, hint);
+    }
+    frame_offset += n_frames;
+}
+
+void SmoothRandom::processBlock(SignalBuffer* /*mod_inputs*/, SignalBuffer* outputs, size_t n_frames) {
+    float* output_buffer = outputs->getChannel(0);
+
+    const size_t division = outputs->getChannelDivision(0);
+    const float step_seconds = static_cast<float>(division) / sample_rate;
+    size_t begin, end;
+    SignalBuffer::getElementRange(division, outputs->getChannelLength(0), n_frames, frame_offset, begin, end);
+
+    for (size_t j = begin; j < end; ++j) {
+        advance(step_seconds);
+        const float t = phase * phase * (3.f - 2.f * phase);
+        output_buffer[j] = previous_value + (value - previous_value) * t;
+    }
+    frame_offset += n_frames;
+}
+
+} // namespace OrangeSodium
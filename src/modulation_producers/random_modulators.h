@@ -0,0 +1,66 @@
+#pragma once
+#include "../modulator_producer.h"
+#include "../dsp/random.h"
+/*
+* Random Modulation Producers
+* A new random value is drawn rate times per second from the producer's own stream (see CounterRandom), keyed
+* by the voice and the producer's ObjectID, so the values do not depend on how voices are scheduled. A new
+* note draws a new value immediately.
+*
+* SampleAndHold: holds each value until the next one.
+* SmoothRandom: glides from the previous value to the next with a smoothstep curve, so the slope is continuous.
+*
+* Outputs:
+*                  [0] - Random value (-1.0 to 1.0), one value per control point of the output division
+*/
+
+namespace OrangeSodium {
+
+class RandomModulator : public ModulationProducer {
+public:
+    RandomModulator(Context* context, ObjectID id, size_t voice_index, float rate);
+
+    void onSampleRateChange(float new_sample_rate) override;
+    void onRetrigger() override {
+        is_retriggered = true;
+    }
+    void onRelease() override {}
+    void copyStateFrom(const ModulationProducer& other) override {
+        const RandomModulator& running = static_cast<const RandomModulator&>(other);
+        random.setCounter(running.random.getCounter());
+        phase = running.phase;
+        previous_value = running.previous_value;
+        value = running.value;
+        is_retriggered = running.is_retriggered;
+    }
+
+    void setRate(float new_rate) { rate = new_rate; }
+    float getRate() const { return rate; }
+
+protected:
+    CounterRandom random;
+    float rate;                  // New values per second
+    float phase = 0.f;           // [0, 1) through the current value
+    float previous_value = 0.f;
+    float value = 0.f;
+    bool is_retriggered = true;  // The first block draws a value
+
+    /// @brief Move on by one control point of step_seconds; returns true if a new value was drawn
+    bool advance(float step_seconds);
+};
+
+class SampleAndHold : public RandomModulator {
+public:
+    using RandomModulator::RandomModulator;
+    void processBlock(SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_frames) override;
+    const char* getTypeName() const override { return "sample_hold"; }
+};
+
+class SmoothRandom : public RandomModulator {
+public:
+    using RandomModulator::RandomModulator;
+    void processBlock(SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_frames) override;
+    const char* getTypeName() const override { return "smooth_random"; }
+};
+
+} // namespace OrangeSodium
@@ -0,0 +1,278 @@
+#include "modulation_router.h"
+#include "simd.h"
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+namespace OrangeSodium {
+
+ModulationRouter::ModulationRouter(Context* context) : m_context(context) {
+}
+
+ModulationRouter::~ModulationRouter() {
+}
+
+void ModulationRouter::addModulation(const Modulation& modulation) {
+    if (!modulation.source_buffer || !modulation.dest_buffer) {
+        return;
+    }
+    m_modulations.push_back(modulation);
+    rebuild();
+}
+
+void ModulationRouter::clear() {
+    m_modulations.clear();
+    rebuild();
+}
+
+static bool isSameRate(const Modulation& mod) {
+    return mod.source_buffer->getChannelDivision(mod.source_index) == mod.dest_buffer->getChannelDivision(mod.dest_index);
+}
+
+void ModulationRouter::rebuild() {
+    // Group by destination channel; within a destination, same-rate routings first so they form one fused group
+    std::stable_sort(m_modulations.begin(), m_modulations.end(), [](const Modulation& a, const Modulation& b) {
+        if (a.dest_buffer != b.dest_buffer) {
+            return std::less<SignalBuffer*>()(a.dest_buffer, b.dest_buffer);
+        }
+        if (a.dest_index != b.dest_index) {
+            return a.dest_index < b.dest_index;
+        }
+        return isSameRate(a) && !isSameRate(b);
+    });
+
+    const size_t n = m_modulations.size();
+    source_divisions.resize(n);
+    amounts.resize(n);
+    kernels.resize(n);
+    ramp_previous.assign(n, 0.f);
+    groups.clear();
+
+    for (size_t i = 0; i < n; ++i) {
+        const Modulation& mod = m_modulations[i];
+        const size_t dest_division = mod.dest_buffer->getChannelDivision(mod.dest_index);
+        source_divisions[i] = mod.source_buffer->getChannelDivision(mod.source_index);
+        amounts[i] = mod.amount;
+        kernels[i] = selectModulationKernel(source_divisions[i], dest_division);
+
+        const bool same_rate = source_divisions[i] == dest_division;
+        if (!groups.empty()) {
+            Group& last = groups.back();
+            const Modulation& prev = m_modulations[last.first];
+            if (prev.dest_buffer == mod.dest_buffer && prev.dest_index == mod.dest_index && last.same_rate && same_rate) {
+                ++last.count;
+                continue;
+            }
+        }
+        groups.push_back({i, 1, same_rate, false});
+    }
+
+    resolveChannels();
+}
+
+void ModulationRouter::resolveChannels() {
+    const size_t n = m_modulations.size();
+    sources.resize(n);
+    source_lengths.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        const Modulation& mod = m_modulations[i];
+        sources[i] = mod.source_buffer->getChannel(mod.source_index);
+        source_lengths[i] = mod.source_buffer->getChannelLength(mod.source_index);
+    }
+
+    dests.resize(groups.size());
+    dest_lengths.resize(groups.size());
+    dest_divisions.resize(groups.size());
+    for (size_t g = 0; g < groups.size(); ++g) {
+        const Modulation& mod = m_modulations[groups[g].first];
+        dests[g] = mod.dest_buffer->getChannel(mod.dest_index);
+        dest_lengths[g] = mod.dest_buffer->getChannelLength(mod.dest_index);
+        dest_divisions[g] = mod.dest_buffer->getChannelDivision(mod.dest_index);
+
+        groups[g].fused = groups[g].same_rate;
+        for (size_t r = groups[g].first; r < groups[g].first + groups[g].count; ++r) {
+            groups[g].fused = groups[g].fused && sources[r];
+        }
+    }
+}
+
+bool ModulationRouter::hasDestination(const SignalBuffer* buffer, size_t channel) const {
+    for (const Modulation& mod : m_modulations) {
+        if (mod.dest_buffer == buffer && mod.dest_index == channel) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ModulationRouter::beginBlock(size_t previous_block_frames) {
+    if (previous_block_frames == 0) {
+        return;
+    }
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!sources[i] || source_lengths[i] == 0) {
+            continue;
+        }
+        const Modulation& mod = m_modulations[i];
+        const size_t last = std::min((previous_block_frames - 1) / source_divisions[i], source_lengths[i] - 1);
+        ramp_previous[i] = mod.source_buffer->getElement(mod.source_index, last);
+    }
+}
+
+float ModulationRouter::getPreviousSourceValue(size_t routing, size_t k) const {
+    const Modulation& mod = m_modulations[routing];
+    return (k > 0) ? mod.source_buffer->getElement(mod.source_index, k - 1) : ramp_previous[routing];
+}
+
+static inline bool isFlat(const SignalBuffer::ChannelHint& hint) {
+    return hint.type == SignalBuffer::EChannelHint::kSilent || hint.type == SignalBuffer::EChannelHint::kConstant;
+}
+
+static inline bool nearlyEqual(float a, float b) {
+    return std::abs(a - b) <= 1e-5f * (1.f + std::abs(a));
+}
+
+bool ModulationRouter::processHintedGroup(size_t g, size_t n_audio_frames, size_t frame_offset) {
+    const Group& group = groups[g];
+    SignalBuffer* dest_buffer = m_modulations[group.first].dest_buffer;
+    const size_t dest_index = m_modulations[group.first].dest_index;
+    const size_t dest_division = dest_divisions[g];
+
+    size_t begin, end;
+    SignalBuffer::getElementRange(dest_division, dest_lengths[g], n_audio_frames, frame_offset, begin, end);
+    if (begin >= end) {
+        return true;
+    }
+
+    // Every source flat over the range (slower sources also need their ramp start to match): the group adds a constant
+    bool all_flat = true;
+    float sum = 0.f;
+    for (size_t r = group.first; r < group.first + group.count && all_flat; ++r) {
+        const Modulation& mod = m_modulations[r];
+        const SignalBuffer::ChannelHint& hint = mod.source_buffer->getChannelHint(mod.source_index);
+        if (!isFlat(hint)) {
+            all_flat = false;
+            break;
+        }
+        const float value = SignalBuffer::getHintValue(hint, 0);
+        if (source_divisions[r] > dest_division) {
+            const size_t k_first = (begin * dest_division) / source_divisions[r];
+            all_flat = nearlyEqual(getPreviousSourceValue(r, k_first), value);
+        }
+        sum += amounts[r] * value;
+    }
+
+    const SignalBuffer::ChannelHint& dest_hint = dest_buffer->getChannelHint(dest_index);
+    if (all_flat) {
+        if (sum == 0.f) {
+            return true;
+        }
+        if (isFlat(dest_hint)) {
+            dest_buffer->setChannelConstant(dest_index, SignalBuffer::getHintValue(dest_hint, 0) + sum);
+            return true;
+        }
+        float* dest = dest_buffer->getChannel(dest_index);
+        const os_simd_t sum_v = OS_SIMD_SET1(sum);
+        size_t j = begin;
+        for (; j + OS_SIMD_WIDTH <= end; j += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE(dest + j, OS_SIMD_ADD(OS_SIMD_LOAD(dest + j), sum_v));
+        }
+        for (; j < end; ++j) {
+            dest[j] += sum;
+        }
+        return true;
+    }
+
+    // A single ramp source into a flat destination leaves the destination a ramp. Dest element j reads the
+    // source at position j * dest_division / source_division (one element earlier for slower sources, which
+    // ramp towards their control points).
+    if (group.count != 1 || !isFlat(dest_hint)) {
+        return false;
+    }
+    const size_t r = group.first;
+    const Modulation& mod = m_modulations[r];
+    const SignalBuffer::ChannelHint& hint = mod.source_buffer->getChannelHint(mod.source_index);
+    const size_t source_division = source_divisions[r];
+    if (hint.type != SignalBuffer::EChannelHint::kRamp ||
+        (source_division % dest_division != 0 && dest_division % source_division != 0)) {
+        return false;
+    }
+    const size_t k_first = (begin * dest_division) / source_division;
+    const size_t k_last = ((end - 1) * dest_division) / source_division;
+    if (k_first < hint.begin || k_last >= hint.end) {
+        return false;
+    }
+    const float ratio = static_cast<float>(dest_division) / static_cast<float>(source_division);
+    float position = static_cast<float>(begin) * ratio;
+    if (source_division > dest_division) {
+        position -= 1.f;
+        if (!nearlyEqual(getPreviousSourceValue(r, k_first), SignalBuffer::getHintValue(hint, k_first) - hint.step)) {
+            return false;
+        }
+    }
+    const float value = hint.value + hint.step * (position - static_cast<float>(hint.begin));
+    dest_buffer->setChannelRamp(dest_index, SignalBuffer::getHintValue(dest_hint, 0) + amounts[r] * value,
+                                amounts[r] * hint.step * ratio, begin, end);
+    return true;
+}
+
+void ModulationRouter::processFusedGroup(const Group& group, float* dest, size_t dest_division, size_t dest_length, size_t n_audio_frames, size_t frame_offset) {
+    size_t begin, end;
+    SignalBuffer::getElementRange(dest_division, dest_length, n_audio_frames, frame_offset, begin, end);
+
+    const float* const* group_sources = sources.data() + group.first;
+    const float* group_amounts = amounts.data() + group.first;
+
+    // dest[j] += sum of amount * source[j] over the group, with one load and one store of dest
+    size_t j = begin;
+    for (; j + OS_SIMD_WIDTH <= end; j += OS_SIMD_WIDTH) {
+        os_simd_t acc = OS_SIMD_LOAD(dest + j);
+        for (size_t r = 0; r < group.count; ++r) {
+            acc = OS_SIMD_ADD(acc, OS_SIMD_MUL(OS_SIMD_SET1(group_amounts[r]), OS_SIMD_LOAD(group_sources[r] + j)));
+        }
+        OS_SIMD_STORE(dest + j, acc);
+    }
+    for (; j < end; ++j) {
+        float acc = dest[j];
+        for (size_t r = 0; r < group.count; ++r) {
+            acc += group_amounts[r] * group_sources[r][j];
+        }
+        dest[j] = acc;
+    }
+}
+
+void ModulationRouter::process(size_t n_audio_frames, size_t frame_offset) {
+    for (size_t g = 0; g < groups.size(); ++g) {
+        const Group& group = groups[g];
+        float* dest = dests[g];
+        if (!dest) {
+            continue;
+        }
+        if (processHintedGroup(g, n_audio_frames, frame_offset)) {
+            continue;
+        }
+
+        // Data path: write out any pending hints so the cached channel pointers hold valid data
+        for (size_t r = group.first; r < group.first + group.count; ++r) {
+            const Modulation& mod = m_modulations[r];
+            if (mod.source_buffer->getChannelHint(mod.source_index).type != SignalBuffer::EChannelHint::kDynamic) {
+                mod.source_buffer->getChannel(mod.source_index);
+            }
+        }
+        const Modulation& dest_mod = m_modulations[group.first];
+        dest_mod.dest_buffer->getChannel(dest_mod.dest_index);
+
+        if (group.fused) {
+            processFusedGroup(group, dest, dest_divisions[g], dest_lengths[g], n_audio_frames, frame_offset);
+            continue;
+        }
+
+        for (size_t r = group.first; r < group.first + group.count; ++r) {
+            if (!sources[r]) continue;
+            kernels[r](sources[r], dest, amounts[r], source_divisions[r], dest_divisions[g], dest_lengths[g],
+                       ramp_previous[r], n_audio_frames, frame_offset);
+        }
+    }
+}
+
+}
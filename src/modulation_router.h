@@ -3,8 +3,18 @@
 /*
 Orange Sodium supports per-sample modulation of parameters. This is achieved by using modulation buffers that are routed from
 modulation producers to modulation destinations (e.g. oscillator pitch, filter cutoff, effect parameters, etc).
-Instead of using a large, unified modulation matrix, Orange Sodium uses a more efficient approach where
-each object (oscillator, filter, effect, etc) reads directly from the modulation buffers it needs.
+Each object (oscillator, filter, effect, etc) reads directly from its own modulation buffer; the router fills those buffers.
+
+The router owns every routing of a voice. Routings are kept sorted by destination channel, and the data the audio
+thread needs (channel pointers, amounts, divisions, kernels, ramp state) is stored as flat arrays in that order.
+Consecutive routings into the same destination form a group:
+  - if every source in the group runs at the destination's division, the group is executed in one SIMD pass that
+    loads the destination once, accumulates all sources into it and stores it once
+  - otherwise each routing runs its own division-specialised kernel (see modulation_kernels.h)
+
+Before touching any data, a group looks at the channel hints (see signal_buffer.h). Silent sources are skipped,
+constant sources into a silent or constant destination leave the destination constant, and a single ramp source
+into a silent or constant destination leaves it a ramp. Only groups that really vary per element read and write data.
 
 In the Lua script, each object is assigned a unique 32-bit id.
 */
@@ -12,6 +22,7 @@ In the Lua script, each object is assigned a unique 32-bit id.
 #pragma once
 #include "context.h"
 #include "modulation.h"
+#include "modulation_kernels.h"
 #include <vector>
 
 namespace OrangeSodium{
@@ -21,15 +32,66 @@ public:
     ModulationRouter(Context* context);
     ~ModulationRouter();
 
-    void registerParamSource(float* param_source, float* impl_source);
+    /// @brief Add a routing. source_buffer and dest_buffer must be set.
     void addModulation(const Modulation& modulation);
 
+    /// @brief Remove every routing
+    void clear();
+
+    size_t getNumModulations() const { return m_modulations.size(); }
+
+    /// @brief Routing descriptions, sorted by destination
+    const std::vector<Modulation>& getModulations() const { return m_modulations; }
+
+    /// @brief Re-read the channel pointers of every routing. Call after the buffers were laid out or resized.
+    void resolveChannels();
+
+    /// @brief Returns true if at least one routing writes into the channel
+    bool hasDestination(const SignalBuffer* buffer, size_t channel) const;
+
+    /// @brief Start a new block
+    /// @param previous_block_frames Length of the previous block; its last control point seeds the control-rate ramps
+    void beginBlock(size_t previous_block_frames);
+
+    /// @brief Apply every routing for the frames [frame_offset, frame_offset + n_audio_frames)
+    void process(size_t n_audio_frames, size_t frame_offset);
 
 private:
-    std::vector<float*> param_source; // Pointers to parameter sources (knobs). These are defined per-implementation for each object (e.g. drive for distortion effect)
-    std::vector<float*> impl_source; // Pointer to variable used in DSP code. These are the results of applying modulation to param_source
-    std::vector<Modulation> m_modulations;
+    struct Group {
+        size_t first; // First routing of the group
+        size_t count;
+        bool same_rate; // All sources share the destination division
+        bool fused; // same_rate and every source channel is allocated; set by resolveChannels
+    };
+
     Context* m_context;
+
+    std::vector<Modulation> m_modulations; // Sorted by destination buffer and channel
+
+    // Per routing, in the order of m_modulations
+    std::vector<const float*> sources;
+    std::vector<size_t> source_lengths;
+    std::vector<size_t> source_divisions;
+    std::vector<float> amounts;
+    std::vector<ModulationKernel> kernels;
+    std::vector<float> ramp_previous; // Last source value of the previous block
+
+    // Per group
+    std::vector<Group> groups;
+    std::vector<float*> dests;
+    std::vector<size_t> dest_lengths;
+    std::vector<size_t> dest_divisions;
+
+    /// @brief Re-sort the routings and rebuild the flat arrays and groups
+    void rebuild();
+
+    /// @brief Value of source element k - 1 as seen by the ramp towards element k
+    float getPreviousSourceValue(size_t routing, size_t k) const;
+
+    /// @brief Apply a group through the channel hints only. Returns false if the group needs the data path.
+    bool processHintedGroup(size_t g, size_t n_audio_frames, size_t frame_offset);
+
+    void processFusedGroup(const Group& group, float* dest, size_t dest_division, size_t dest_length, size_t n_audio_frames, size_t frame_offset);
 };
 
-}
\ No newline at end of file
+}
@@ -11,7 +11,7 @@ namespace OrangeSodium {
 class ModulationProducer {
 public:
     ModulationProducer(Context* context, ObjectID id);
-    ~ModulationProducer();
+    virtual ~ModulationProducer();
 
     /// @brief Run the modulation
     /// @param mod_inputs External modulation inputs; mod_inputs[0] is a retrigger signal; everything else is implementation specific
@@ -21,6 +21,13 @@ public:
     virtual void onRetrigger() = 0;
     virtual void onRelease() = 0;
 
+    /// @brief Name of the producer type, as used by the Lua API. Hot reloads only match objects of the same type.
+    virtual const char* getTypeName() const = 0;
+
+    /// @brief Take over the running state (stage, level, etc) of the same producer in the previous build of the
+    /// program. Parameters set by the script are kept. other always has the same type name as this producer.
+    virtual void copyStateFrom(const ModulationProducer& /*other*/) {}
+
     void setModBuffer(SignalBuffer* buffer) {
         modulation_buffer = buffer;
     }
@@ -41,22 +48,13 @@ public:
     }
 
     void resizeBuffers(size_t n_frames) {
+        // Producers usually run at control rate, so keep the channel divisions
         if (modulation_buffer) {
-            // Get temporary channel divisions
-            size_t* channel_divisions = new size_t[modulation_buffer->getNumChannels()];
-            for (size_t c = 0; c < modulation_buffer->getNumChannels(); ++c) {
-                channel_divisions[c] = modulation_buffer->getChannelDivision(c);
-            }
-            modulation_buffer->resize(modulation_buffer->getNumChannels(), n_frames);
-            // Restore channel divisions
-            for (size_t c = 0; c < modulation_buffer->getNumChannels(); ++c) {
-                modulation_buffer->setChannelDivision(c, channel_divisions[c]);
-            }
-            delete[] channel_divisions;
+            modulation_buffer->resizeFrames(n_frames);
         }
 
         if(output_buffer) {
-            output_buffer->resize(output_buffer->getNumChannels(), n_frames);
+            output_buffer->resizeFrames(n_frames);
         }
     }
 
@@ -0,0 +1,34 @@
+#include "object_registry.h"
+
+namespace OrangeSodium {
+
+const ObjectRegistry::Entry ObjectRegistry::undefined_entry = ObjectRegistry::Entry();
+
+void ObjectRegistry::add(ObjectID id, EObjectType type, void* object, const void* owner, size_t index) {
+    if (id >= entries.size()) {
+        // IDs are handed out in order, so this grows by one entry at a time; let the vector double
+        entries.resize(static_cast<size_t>(id) + 1);
+    }
+    Entry& entry = entries[id];
+    entry.type = type;
+    entry.object = object;
+    entry.owner = owner;
+    entry.index = index;
+    entry.name.clear();
+}
+
+bool ObjectRegistry::setName(ObjectID id, const std::string& name) {
+    if (id >= entries.size() || entries[id].type == EObjectType::kUndefined) {
+        return false;
+    }
+    entries[id].name = name;
+    return true;
+}
+
+void ObjectRegistry::remove(ObjectID id) {
+    if (id < entries.size()) {
+        entries[id] = Entry();
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+// Dense ObjectID lookup table shared by the whole program
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <string>
+#include "utilities.h"
+
+/*
+Every object that scripts refer to by ObjectID (oscillators, modulation producers, effects, audio buffers) is
+registered here when it is created. ObjectIDs come from Context::getNextObjectID, which counts up from 0, so the
+table is a plain vector indexed by ID and every lookup is O(1). Building a patch calls these lookups from every
+Lua binding, so a linear search per lookup would make builds quadratic in the number of objects.
+
+Each entry records the object's type, a pointer to it, its owner (the Voice or Synthesizer for top-level objects,
+the EffectChain for effects) and its position in the owner's list. Owners check that an entry belongs to them
+before using it, and remove their entries when they are destroyed. Scripts can also give an object a name, which
+hot reloads use to recognise the object in the next build of the program.
+*/
+
+namespace OrangeSodium{
+
+class ObjectRegistry {
+public:
+    struct Entry {
+        EObjectType type = EObjectType::kUndefined;
+        void* object = nullptr;
+        const void* owner = nullptr;
+        size_t index = 0; // Position of the object in its owner's list
+        std::string name; // Set by the script with set_object_name; empty if unnamed
+    };
+
+    /// @brief Register an object under its ID. Re-registering an ID replaces the entry.
+    void add(ObjectID id, EObjectType type, void* object, const void* owner, size_t index);
+
+    /// @brief Name a registered object. Returns false if the ID was never registered.
+    bool setName(ObjectID id, const std::string& name);
+
+    /// @brief Forget one ID
+    void remove(ObjectID id);
+
+    /// @brief Forget every object
+    void clear() { entries.clear(); }
+
+    /// @brief Entry of an ID; an undefined entry if the ID was never registered
+    const Entry& get(ObjectID id) const { return (id < entries.size()) ? entries[id] : undefined_entry; }
+
+    /// @brief Object of the given type and owner, or nullptr
+    template <typename T>
+    T* find(ObjectID id, EObjectType type, const void* owner) const {
+        const Entry& entry = get(id);
+        return (entry.type == type && entry.owner == owner) ? static_cast<T*>(entry.object) : nullptr;
+    }
+
+    size_t getCapacity() const { return entries.size(); }
+
+private:
+    std::vector<Entry> entries; // Indexed by ObjectID
+    static const Entry undefined_entry;
+};
+
+}
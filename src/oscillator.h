@@ -6,6 +6,7 @@
 #include "utilities.h"
 #include <vector>
 #include <string>
+#include <cstring>
 
 namespace OrangeSodium{
 
@@ -19,6 +20,13 @@ public:
     enum class EOscillatorType{
         kSine = 0,
         kWaveform,
+        kAdditive,
+        kVirtualAnalog,
+        kFM,
+        kSampler,
+        kGranular,
+        kNoise,
+        kWavetable,
     };
 
     Oscillator(Context* context, ObjectID id, size_t n_channels, float amplitude = 1.0f);
@@ -30,13 +38,30 @@ public:
     /// @param outputs Audio output of oscillator
     virtual void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) = 0;
     virtual void onSampleRateChange(float new_sample_rate) = 0;
+    /// @brief Called when the voice starts a new note (not on legato glides)
+    virtual void onRetrigger() {}
     void setSampleRate(float rate) { sample_rate = rate; onSampleRateChange(rate); }
+
+    /// @brief Name of the oscillator type, as used by the Lua API. Hot reloads only match objects of the same type.
+    virtual const char* getTypeName() const = 0;
+
+    /// @brief Take over the running state (phase, etc) of the same oscillator in the previous build of the program.
+    /// Parameters set by the script are kept. other always has the same type name as this oscillator.
+    virtual void copyStateFrom(const Oscillator& /*other*/) {}
     void setOutputBuffer(SignalBuffer* buffer) {
         output_buffer = buffer;
     }
     inline SignalBuffer* getOutputBuffer() const {
         return output_buffer;
     }
+    /// @brief Audio passed to processBlock as audio_inputs, e.g. to frequency or phase modulate this oscillator.
+    /// It must be written by oscillators that run before this one.
+    void setInputBuffer(SignalBuffer* buffer) {
+        input_buffer = buffer;
+    }
+    inline SignalBuffer* getInputBuffer() const {
+        return input_buffer;
+    }
     void setModBuffer(SignalBuffer* buffer) {
         mod_buffer = buffer;
     }
@@ -49,17 +74,7 @@ public:
             output_buffer->resize(output_buffer->getNumChannels(), n_frames);
         }
         if (mod_buffer) {
-            // Get temporary channel divisions
-            size_t* channel_divisions = new size_t[mod_buffer->getNumChannels()];
-            for (size_t c = 0; c < mod_buffer->getNumChannels(); ++c) {
-                channel_divisions[c] = mod_buffer->getChannelDivision(c);
-            }
-            mod_buffer->resize(mod_buffer->getNumChannels(), n_frames);
-            // Restore channel divisions
-            for (size_t c = 0; c < mod_buffer->getNumChannels(); ++c) {
-                mod_buffer->setChannelDivision(c, channel_divisions[c]);
-            }
-            delete[] channel_divisions;
+            mod_buffer->resizeFrames(n_frames);
         }
     }
 
@@ -67,6 +82,11 @@ public:
         return modulation_source_names;
     }
 
+    /// @brief Set by the voice's write plan: true if this oscillator is the first writer of its output buffer in
+    /// execution order, so it overwrites its range instead of adding to it
+    void setOverwriteOutput(bool overwrite) { overwrite_output = overwrite; }
+    bool getOverwriteOutput() const { return overwrite_output; }
+
     float getFrequencyOffset() const { return frequency_offset; }
     void setFrequencyOffset(float midi_note_offset) { frequency_offset = midi_note_offset; }
 
@@ -85,15 +105,68 @@ protected:
     size_t n_channels = 0; // Number of output channels
     SignalBuffer* output_buffer = nullptr; // Output buffer for the oscillator
     SignalBuffer* mod_buffer = nullptr;
+    SignalBuffer* input_buffer = nullptr; // Audio input of the oscillator (see setInputBuffer)
     EObjectType object_type;
     float amplitude; // [0, 1] Amplitude of the oscillator output
     float frequency_offset; // Frequency offset (in MIDI note numbers)
+    bool overwrite_output = false; // First writer of the output buffer (see setOverwriteOutput)
 
     size_t frame_offset; // To allow for per-sample MIDI events, we keep track of the current frame offset within the block being processed
     
     // Names of modulation sources connected to this oscillator. This is used for linking modulation sources by name in Lua.
     std::vector<std::string> modulation_source_names;
 
+    /// @brief Reads one modulation channel of the current sub-block. Silent, constant and ramp channels are read
+    /// through their hint, so their data is never written out.
+    struct ModInput {
+        const float* data = nullptr; // Only set for dynamic channels
+        SignalBuffer::ChannelHint hint;
+        size_t division = 1;
+
+        bool isFlat() const { return !data && hint.type != SignalBuffer::EChannelHint::kRamp; }
+        inline float operator()(size_t frame) const {
+            return (data) ? data[frame / division] : SignalBuffer::getHintValue(hint, frame / division);
+        }
+    };
+
+    static ModInput getModInput(SignalBuffer* mod_inputs, EModChannel channel) {
+        ModInput input;
+        const size_t index = static_cast<size_t>(channel);
+        if (!mod_inputs || index >= mod_inputs->getNumChannels()) {
+            input.hint.type = SignalBuffer::EChannelHint::kSilent;
+            return input;
+        }
+        input.hint = mod_inputs->getChannelHint(index);
+        input.division = mod_inputs->getChannelDivision(index);
+        if (input.hint.type == SignalBuffer::EChannelHint::kDynamic) {
+            input.data = mod_inputs->getChannel(index);
+            if (!input.data) {
+                input.hint.type = SignalBuffer::EChannelHint::kSilent;
+            }
+        }
+        return input;
+    }
+
+    /// @brief Output channel for the current sub-block. The first writer gets it without its previous contents.
+    float* getOutputChannel(SignalBuffer* outputs, size_t channel, size_t n_frames) {
+        return (overwrite_output) ? outputs->getChannelForOverwrite(channel, frame_offset, frame_offset + n_frames) : outputs->getChannel(channel);
+    }
+
+    /// @brief Output a silent sub-block on one channel. Only the first writer has anything to do.
+    void writeSilence(SignalBuffer* outputs, size_t channel, size_t n_frames) {
+        if (!overwrite_output) {
+            return;
+        }
+        if (frame_offset == 0) {
+            outputs->setChannelSilent(channel);
+        } else if (!outputs->isChannelSilent(channel)) {
+            float* out = outputs->getChannel(channel);
+            if (out) {
+                std::memset(out + frame_offset, 0, n_frames * sizeof(float));
+            }
+        }
+    }
+
     float getHzFromMIDINote(float midi_note) {
         return 440.0f * std::pow(2.0f, (midi_note - 69.f) / 12.0f);
     }
@@ -0,0 +1,227 @@
+#include "additive_osc.h"
+#include "../dsp/fast_math.h"
+#include "../dsp/vector_ops.h"
+#include <algorithm>
+#include <new>
+#include <utility>
+
+namespace OrangeSodium {
+
+static constexpr size_t kNumArrays = 8; // ratios, amplitudes, gains, increments, rotation cos/sin, state cos/sin
+static constexpr float kFadeStart = 0.45f; // Partials fade out from here (in cycles per frame) to Nyquist
+
+AdditiveOscillator::AdditiveOscillator(Context* context, ObjectID id, ResourceID table_id, size_t n_channels, float amplitude)
+    : Oscillator(context, id, n_channels, amplitude) {
+    // Audible partials of the table, sorted by ratio so culling only has to shorten the loop
+    std::vector<std::pair<float, float>> partials;
+    PartialTableResource* table = (m_context->resource_manager) ? m_context->resource_manager->getPartialTable(table_id) : nullptr;
+    if (table) {
+        for (size_t i = 0; i < table->getNumPartials(); ++i) {
+            if (table->getRatios()[i] > 0.f && table->getAmplitudes()[i] != 0.f) {
+                partials.push_back({table->getRatios()[i], table->getAmplitudes()[i]});
+            }
+        }
+        std::sort(partials.begin(), partials.end());
+    }
+
+    n_partials = partials.size();
+    n_vectors = (n_partials + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH;
+    const size_t stride = n_vectors * OS_SIMD_WIDTH;
+    if (stride > 0) {
+        float* block = static_cast<float*>(::operator new(kNumArrays * stride * sizeof(float), std::align_val_t(OS_SIMD_ALIGNMENT)));
+        std::fill(block, block + kNumArrays * stride, 0.f);
+        ratios = block;
+        amplitudes = block + stride;
+        gains = block + 2 * stride;
+        increments = block + 3 * stride;
+        rotation_cos = block + 4 * stride;
+        rotation_sin = block + 5 * stride;
+        state_cos = block + 6 * stride;
+        state_sin = block + 7 * stride;
+        for (size_t k = 0; k < stride; ++k) {
+            ratios[k] = (k < n_partials) ? partials[k].first : 0.f;
+            amplitudes[k] = (k < n_partials) ? partials[k].second : 0.f;
+            rotation_cos[k] = 1.f;
+            state_cos[k] = 1.f; // Every partial starts at phase 0
+        }
+    }
+
+    // Add modulation source names
+    modulation_source_names.resize(0);
+    modulation_source_names.push_back("pitch");
+    modulation_source_names.push_back("amplitude");
+}
+
+AdditiveOscillator::~AdditiveOscillator() {
+    if (ratios) {
+        ::operator delete(ratios, std::align_val_t(OS_SIMD_ALIGNMENT));
+    }
+}
+
+float AdditiveOscillator::getHz(float midi_note) const {
+    return 440.0f * fastExp2((midi_note - 69.f) / 12.0f);
+}
+
+void AdditiveOscillator::updateRotations(float hz) {
+    if (hz == last_hz) {
+        return;
+    }
+    last_hz = hz;
+
+    // Sorted ratios: the audible partials are a prefix
+    const float nyquist_ratio = 0.5f * sample_rate / std::max(hz, 1e-6f);
+    n_active_partials = static_cast<size_t>(std::lower_bound(ratios, ratios + n_partials, nyquist_ratio) - ratios);
+    n_active_vectors = (n_active_partials + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH;
+
+    const os_simd_t cycles_per_ratio = OS_SIMD_SET1(hz / sample_rate);
+    const os_simd_t fade_scale = OS_SIMD_SET1(1.f / (0.5f - kFadeStart));
+    const os_simd_t zero = OS_SIMD_SET1(0.f);
+    const os_simd_t one = OS_SIMD_SET1(1.f);
+    for (size_t v = 0; v < n_active_vectors; ++v) {
+        const size_t k = v * OS_SIMD_WIDTH;
+        const os_simd_t increment = OS_SIMD_MUL(OS_SIMD_LOAD_ALIGNED(ratios + k), cycles_per_ratio);
+        const os_simd_t fade = OS_SIMD_MIN(OS_SIMD_MAX(OS_SIMD_MUL(OS_SIMD_SUB(OS_SIMD_SET1(0.5f), increment), fade_scale), zero), one);
+        OS_SIMD_STORE_ALIGNED(increments + k, increment);
+        OS_SIMD_STORE_ALIGNED(gains + k, OS_SIMD_MUL(OS_SIMD_LOAD_ALIGNED(amplitudes + k), fade));
+        OS_SIMD_STORE_ALIGNED(rotation_sin + k, simdSin2Pi(increment));
+        OS_SIMD_STORE_ALIGNED(rotation_cos + k, simdSin2Pi(OS_SIMD_ADD(increment, OS_SIMD_SET1(0.25f))));
+    }
+}
+
+void AdditiveOscillator::renderChunk(float* samples, size_t n_frames) {
+    os_simd_t sums[kChunkFrames];
+    for (size_t i = 0; i < n_frames; ++i) {
+        sums[i] = OS_SIMD_SET1(0.f);
+    }
+
+    // One vector of partials at a time, so its state stays in registers for the whole chunk
+    for (size_t v = 0; v < n_active_vectors; ++v) {
+        const size_t k = v * OS_SIMD_WIDTH;
+        const os_simd_t c = OS_SIMD_LOAD_ALIGNED(rotation_cos + k);
+        const os_simd_t s = OS_SIMD_LOAD_ALIGNED(rotation_sin + k);
+        const os_simd_t gain = OS_SIMD_LOAD_ALIGNED(gains + k);
+        os_simd_t x = OS_SIMD_LOAD_ALIGNED(state_cos + k);
+        os_simd_t y = OS_SIMD_LOAD_ALIGNED(state_sin + k);
+        for (size_t i = 0; i < n_frames; ++i) {
+            const os_simd_t next_x = OS_SIMD_SUB(OS_SIMD_MUL(x, c), OS_SIMD_MUL(y, s));
+            y = OS_SIMD_ADD(OS_SIMD_MUL(x, s), OS_SIMD_MUL(y, c));
+            x = next_x;
+            sums[i] = OS_SIMD_ADD(sums[i], OS_SIMD_MUL(y, gain));
+        }
+        OS_SIMD_STORE_ALIGNED(state_cos + k, x);
+        OS_SIMD_STORE_ALIGNED(state_sin + k, y);
+    }
+
+    alignas(OS_SIMD_ALIGNMENT) float lanes[OS_SIMD_WIDTH];
+    for (size_t i = 0; i < n_frames; ++i) {
+        OS_SIMD_STORE_ALIGNED(lanes, sums[i]);
+        float sum = 0.f;
+        for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+            sum += lanes[l];
+        }
+        samples[i] = sum;
+    }
+}
+
+void AdditiveOscillator::skipFrames(size_t n_frames) {
+    const os_simd_t frames = OS_SIMD_SET1(static_cast<float>(n_frames));
+    for (size_t v = 0; v < n_active_vectors; ++v) {
+        const size_t k = v * OS_SIMD_WIDTH;
+        const os_simd_t angle = OS_SIMD_MUL(OS_SIMD_LOAD_ALIGNED(increments + k), frames);
+        const os_simd_t c = simdSin2Pi(OS_SIMD_ADD(angle, OS_SIMD_SET1(0.25f)));
+        const os_simd_t s = simdSin2Pi(angle);
+        const os_simd_t x = OS_SIMD_LOAD_ALIGNED(state_cos + k);
+        const os_simd_t y = OS_SIMD_LOAD_ALIGNED(state_sin + k);
+        OS_SIMD_STORE_ALIGNED(state_cos + k, OS_SIMD_SUB(OS_SIMD_MUL(x, c), OS_SIMD_MUL(y, s)));
+        OS_SIMD_STORE_ALIGNED(state_sin + k, OS_SIMD_ADD(OS_SIMD_MUL(x, s), OS_SIMD_MUL(y, c)));
+    }
+}
+
+void AdditiveOscillator::normalise() {
+    // One Newton step of 1 / sqrt(r2), which is exact enough since r2 stays within rounding of 1
+    for (size_t v = 0; v < n_active_vectors; ++v) {
+        const size_t k = v * OS_SIMD_WIDTH;
+        const os_simd_t x = OS_SIMD_LOAD_ALIGNED(state_cos + k);
+        const os_simd_t y = OS_SIMD_LOAD_ALIGNED(state_sin + k);
+        const os_simd_t r2 = OS_SIMD_ADD(OS_SIMD_MUL(x, x), OS_SIMD_MUL(y, y));
+        const os_simd_t scale = OS_SIMD_SUB(OS_SIMD_SET1(1.5f), OS_SIMD_MUL(OS_SIMD_SET1(0.5f), r2));
+        OS_SIMD_STORE_ALIGNED(state_cos + k, OS_SIMD_MUL(x, scale));
+        OS_SIMD_STORE_ALIGNED(state_sin + k, OS_SIMD_MUL(y, scale));
+    }
+}
+
+void AdditiveOscillator::processBlock(SignalBuffer* /*audio_inputs*/, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
+    const size_t n_frames = n_audio_frames; // Will always be lower than or equal to context->max_n_frames
+    const ModInput pitch = getModInput(mod_inputs, EModChannel::kPitch);
+    const ModInput amplitude_mod = getModInput(mod_inputs, EModChannel::kAmplitude);
+    const bool flat_pitch = pitch.isFlat();
+    const bool flat_amplitude = amplitude_mod.isFlat();
+    const float flat_amp = (flat_amplitude) ? amplitude + amplitude_mod(frame_offset) : 0.f;
+    const size_t chunk_frames = (flat_pitch) ? kChunkFrames : kDynamicPitchFrames;
+
+    // Flat zero amplitude adds nothing; the partials only move on
+    if (n_partials == 0 || (flat_amplitude && flat_amp == 0.f)) {
+        for (size_t start = 0; start < n_frames; start += chunk_frames) {
+            updateRotations(getHz(pitch(frame_offset + start) + frequency_offset));
+            skipFrames((flat_pitch) ? n_frames : std::min(chunk_frames, n_frames - start));
+            if (flat_pitch) {
+                break;
+            }
+        }
+        normalise();
+        for (size_t c = 0; c < n_channels; ++c) {
+            writeSilence(outputs, c, n_frames);
+        }
+        frame_offset += n_frames;
+        return;
+    }
+
+    alignas(OS_SIMD_ALIGNMENT) float samples[kChunkFrames];
+    for (size_t start = 0; start < n_frames; start += chunk_frames) {
+        const size_t n = std::min(chunk_frames, n_frames - start);
+        const size_t first_frame = frame_offset + start;
+        if (!flat_pitch || start == 0) {
+            updateRotations(getHz(pitch(first_frame) + frequency_offset));
+        }
+        renderChunk(samples, n);
+        normalise();
+
+        if (flat_amplitude) {
+            for (size_t i = 0; i < n; ++i) {
+                samples[i] *= flat_amp;
+            }
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                samples[i] *= amplitude + amplitude_mod(first_frame + i);
+            }
+        }
+
+        for (size_t c = 0; c < n_channels; ++c) {
+            float* out_buffer = getOutputChannel(outputs, c, n_frames);
+            if (!out_buffer) {
+                continue;
+            }
+            if (overwrite_output) {
+                vectorCopy(out_buffer + first_frame, samples, n);
+            } else {
+                vectorAdd(out_buffer + first_frame, samples, n);
+            }
+        }
+    }
+    frame_offset += n_frames;
+}
+
+void AdditiveOscillator::onSampleRateChange(float new_sample_rate) {
+    this->sample_rate = new_sample_rate;
+    last_hz = -1.f;
+}
+
+void AdditiveOscillator::copyStateFrom(const Oscillator& other) {
+    const AdditiveOscillator& running = static_cast<const AdditiveOscillator&>(other);
+    const size_t n = std::min(n_partials, running.n_partials);
+    for (size_t k = 0; k < n; ++k) {
+        state_cos[k] = running.state_cos[k];
+        state_sin[k] = running.state_sin[k];
+    }
+}
+}
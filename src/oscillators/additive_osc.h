@@ -0,0 +1,70 @@
+// Additive oscillator: a bank of sine partials at fixed ratios of the played note
+#pragma once
+#include "../oscillator.h"
+#include "resource_manager.h"
+
+/*
+A stack of SineOscillators costs a mod buffer, an output pass and a pitch conversion per partial. This oscillator
+runs the whole bank in one object, OS_SIMD_WIDTH partials per vector:
+
+- Every partial is a rotating (cos, sin) pair. Each frame multiplies it by the partial's rotation (cos t, sin t),
+  with t = 2 * pi * ratio * f / sample_rate, so a frame costs 4 multiplies and 2 adds per partial and no sine.
+  The rotation is only recomputed when the pitch moves: once per sub-block for a flat pitch, and every
+  kDynamicPitchFrames frames for an audio-rate pitch.
+- The pairs are renormalised to unit length after every chunk, so rounding never makes a partial grow or decay.
+- Partials are sorted by ratio. Those at or above Nyquist are culled: the loop stops at the last vector holding an
+  audible partial, and partials in the top 10% below Nyquist fade out so culling never clicks.
+
+Ratios and amplitudes come from a partial table resource and are copied at construction, so the table can be
+shared by many voices. Every output channel plays the same signal.
+*/
+
+namespace OrangeSodium {
+class AdditiveOscillator : public Oscillator {
+public:
+    AdditiveOscillator(Context* context, ObjectID id, ResourceID table_id, size_t n_channels, float amplitude);
+    ~AdditiveOscillator();
+
+    void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
+    void onSampleRateChange(float new_sample_rate) override;
+    const char* getTypeName() const override { return "additive_osc"; }
+    void copyStateFrom(const Oscillator& other) override;
+
+    size_t getNumPartials() const { return n_partials; }
+    size_t getNumActivePartials() const { return n_active_partials; } // Partials below Nyquist at the last pitch
+
+private:
+    static constexpr size_t kChunkFrames = 64;        // Frames summed per pass over the bank
+    static constexpr size_t kDynamicPitchFrames = 16; // Frames between rotation updates when the pitch moves at audio rate
+
+    size_t n_partials = 0;
+    size_t n_vectors = 0;         // n_partials rounded up to whole vectors
+    size_t n_active_vectors = 0;  // Vectors up to the last partial below Nyquist
+    size_t n_active_partials = 0;
+
+    // One aligned block of n_vectors * OS_SIMD_WIDTH floats per array; the padding partials have zero amplitude
+    float* ratios = nullptr;
+    float* amplitudes = nullptr;
+    float* gains = nullptr;      // Amplitude after the Nyquist fade
+    float* increments = nullptr; // Phase increment in cycles per frame
+    float* rotation_cos = nullptr;
+    float* rotation_sin = nullptr;
+    float* state_cos = nullptr;
+    float* state_sin = nullptr;
+    float last_hz = -1.f;        // Pitch the rotations were computed for
+
+    /// @brief Recompute rotations, gains and the active range for a new pitch
+    void updateRotations(float hz);
+
+    /// @brief Sum of every active partial for n_frames frames (at most kChunkFrames), advancing the bank
+    void renderChunk(float* samples, size_t n_frames);
+
+    /// @brief Advance the bank by n_frames frames without output, with one rotation per partial
+    void skipFrames(size_t n_frames);
+
+    /// @brief Bring every active pair back to unit length
+    void normalise();
+
+    float getHz(float midi_note) const;
+};
+}
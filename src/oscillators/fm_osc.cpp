@@ -0,0 +1,291 @@
+#include "fm_osc.h"
+#include "../dsp/fast_math.h"
+#include "../dsp/vector_ops.h"
+#include <algorithm>
+#include <string>
+
+namespace OrangeSodium {
+
+static constexpr float kInvTwoPi = 0.15915494309189535f; // Indices are in radians, phases in cycles
+
+FMOscillator::FMOscillator(Context* context, ObjectID id, size_t n_operators, size_t n_channels, float amplitude)
+    : Oscillator(context, id, n_channels, amplitude), n_operators(std::min(std::max(n_operators, static_cast<size_t>(1)), kMaxOperators)) {
+    for (size_t i = 0; i < kMaxOperators; ++i) {
+        for (size_t j = 0; j < kMaxOperators; ++j) {
+            routes[i][j] = 0.f;
+        }
+        order[i] = i;
+        phase[i] = 0.f;
+        feedback_history[i][0] = 0.f;
+        feedback_history[i][1] = 0.f;
+    }
+    // Until told otherwise, operator 1 is a plain sine carrier
+    operators[0].output_level = 1.f;
+
+    // Add modulation source names
+    modulation_source_names.resize(0);
+    modulation_source_names.push_back("pitch");
+    modulation_source_names.push_back("amplitude");
+    for (size_t k = 0; k < this->n_operators; ++k) {
+        modulation_source_names.push_back("op" + std::to_string(k + 1) + "_level");
+    }
+}
+
+FMOscillator::~FMOscillator() {}
+
+void FMOscillator::setOperator(size_t op, float ratio, float level, float feedback, float output_level) {
+    if (op >= n_operators) {
+        return;
+    }
+    operators[op].ratio = ratio;
+    operators[op].level = level;
+    operators[op].feedback = feedback;
+    operators[op].output_level = output_level;
+}
+
+bool FMOscillator::setRoute(size_t source, size_t dest, float index) {
+    if (source >= n_operators || dest >= n_operators || source == dest) {
+        return false;
+    }
+    const float previous = routes[dest][source];
+    routes[dest][source] = index;
+    if (!updateOrder()) {
+        routes[dest][source] = previous;
+        updateOrder();
+        return false;
+    }
+    return true;
+}
+
+void FMOscillator::setInputRoute(size_t op, float pm_index, float fm_depth) {
+    if (op >= n_operators) {
+        return;
+    }
+    operators[op].input_pm = pm_index;
+    operators[op].input_fm = fm_depth;
+}
+
+bool FMOscillator::updateOrder() {
+    // Kahn's algorithm over the routes; ties go to the lowest operator so the order is stable
+    size_t n_modulators[kMaxOperators];
+    for (size_t i = 0; i < n_operators; ++i) {
+        n_modulators[i] = 0;
+        for (size_t j = 0; j < n_operators; ++j) {
+            n_modulators[i] += (routes[i][j] != 0.f) ? 1 : 0;
+        }
+    }
+    bool placed[kMaxOperators] = {};
+    for (size_t n = 0; n < n_operators; ++n) {
+        size_t next = n_operators;
+        for (size_t i = 0; i < n_operators; ++i) {
+            if (!placed[i] && n_modulators[i] == 0) {
+                next = i;
+                break;
+            }
+        }
+        if (next == n_operators) {
+            return false; // The rest modulate each other in a loop
+        }
+        placed[next] = true;
+        order[n] = next;
+        for (size_t i = 0; i < n_operators; ++i) {
+            n_modulators[i] -= (routes[i][next] != 0.f) ? 1 : 0;
+        }
+    }
+    return true;
+}
+
+void FMOscillator::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
+    const size_t n_frames = n_audio_frames; // Will always be lower than or equal to context->max_n_frames
+    const ModInput pitch = getModInput(mod_inputs, EModChannel::kPitch);
+    const ModInput amplitude_mod = getModInput(mod_inputs, EModChannel::kAmplitude);
+    const bool flat_amplitude = amplitude_mod.isFlat();
+    const float flat_amp = (flat_amplitude) ? amplitude + amplitude_mod(frame_offset) : 0.f;
+
+    ModInput level_mods[kMaxOperators];
+    for (size_t k = 0; k < n_operators; ++k) {
+        level_mods[k] = getModInput(mod_inputs, static_cast<EModChannel>(kFirstLevelChannel + k));
+    }
+
+    // A silent input is no input at all
+    const float* input = nullptr;
+    if (audio_inputs && audio_inputs->getNumChannels() > 0 && !audio_inputs->isChannelSilent(0)) {
+        input = audio_inputs->getChannel(0);
+    }
+
+    alignas(OS_SIMD_ALIGNMENT) float increments[kChunkFrames]; // Phase increment of the played note, in cycles
+    alignas(OS_SIMD_ALIGNMENT) float note_phase[kChunkFrames];  // Phase of the played note since the chunk started
+    alignas(OS_SIMD_ALIGNMENT) float op_out[kMaxOperators][kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float phases[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float levels[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float mix[kChunkFrames];
+
+    auto fillIncrements = [&](size_t first_frame, size_t n) {
+        if (pitch.isFlat()) {
+            std::fill(increments, increments + n, getHzFromMIDINote(pitch(first_frame) + frequency_offset) / sample_rate);
+            return;
+        }
+        const size_t n_padded = (n + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH * OS_SIMD_WIDTH;
+        for (size_t i = 0; i < n_padded; ++i) {
+            increments[i] = pitch(first_frame + std::min(i, n - 1)) + frequency_offset;
+        }
+        const os_simd_t inv_sample_rate = OS_SIMD_SET1(1.f / sample_rate);
+        for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE_ALIGNED(increments + i, OS_SIMD_MUL(simdMidiNoteToHz(OS_SIMD_LOAD_ALIGNED(increments + i)), inv_sample_rate));
+        }
+    };
+
+    // Flat zero amplitude adds nothing; the operators only move on
+    if (flat_amplitude && flat_amp == 0.f) {
+        float total_increment = 0.f;
+        for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+            const size_t n = std::min(kChunkFrames, n_frames - start);
+            fillIncrements(frame_offset + start, n);
+            for (size_t i = 0; i < n; ++i) {
+                total_increment += increments[i];
+            }
+        }
+        for (size_t k = 0; k < n_operators; ++k) {
+            phase[k] += total_increment * operators[k].ratio;
+            phase[k] -= std::floor(phase[k]);
+        }
+        for (size_t c = 0; c < n_channels; ++c) {
+            writeSilence(outputs, c, n_frames);
+        }
+        frame_offset += n_frames;
+        return;
+    }
+
+    for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+        const size_t n = std::min(kChunkFrames, n_frames - start);
+        const size_t n_padded = (n + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH * OS_SIMD_WIDTH;
+        const size_t first_frame = frame_offset + start;
+        const float* chunk_input = (input) ? input + first_frame : nullptr;
+        fillIncrements(first_frame, n);
+
+        // One running sum shared by every operator without frequency modulation: operator k is at
+        // phase[k] + ratio * note_phase[i]
+        float sum = 0.f;
+        for (size_t i = 0; i < n; ++i) {
+            sum += increments[i];
+            note_phase[i] = sum;
+        }
+        std::fill(note_phase + n, note_phase + n_padded, sum);
+        std::fill(mix, mix + n_padded, 0.f);
+
+        for (size_t o = 0; o < n_operators; ++o) {
+            const size_t k = order[o];
+            const Operator& op = operators[k];
+            float* out = op_out[k];
+
+            // Phase of every frame, before modulation
+            if (chunk_input && op.input_fm != 0.f) {
+                float p = phase[k];
+                for (size_t i = 0; i < n; ++i) {
+                    p += increments[i] * op.ratio * (1.f + op.input_fm * chunk_input[i]);
+                    phases[i] = p;
+                }
+                std::fill(phases + n, phases + n_padded, p);
+                phase[k] = p - std::floor(p);
+            } else {
+                const os_simd_t start_phase = OS_SIMD_SET1(phase[k]);
+                const os_simd_t ratio = OS_SIMD_SET1(op.ratio);
+                for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+                    OS_SIMD_STORE_ALIGNED(phases + i, OS_SIMD_ADD(start_phase, OS_SIMD_MUL(ratio, OS_SIMD_LOAD_ALIGNED(note_phase + i))));
+                }
+                phase[k] += op.ratio * sum;
+                phase[k] -= std::floor(phase[k]);
+            }
+
+            // Phase modulation from the audio input and the operator's modulators, converted to cycles
+            if (chunk_input && op.input_pm != 0.f) {
+                for (size_t i = 0; i < n; ++i) {
+                    phases[i] += op.input_pm * kInvTwoPi * chunk_input[i];
+                }
+            }
+            for (size_t j = 0; j < n_operators; ++j) {
+                if (routes[k][j] == 0.f) {
+                    continue;
+                }
+                const os_simd_t index = OS_SIMD_SET1(routes[k][j] * kInvTwoPi);
+                for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+                    OS_SIMD_STORE_ALIGNED(phases + i, OS_SIMD_ADD(OS_SIMD_LOAD_ALIGNED(phases + i), OS_SIMD_MUL(index, OS_SIMD_LOAD_ALIGNED(op_out[j] + i))));
+                }
+            }
+
+            const ModInput& level_mod = level_mods[k];
+            const bool flat_level = level_mod.isFlat();
+            const float flat_level_value = (flat_level) ? op.level + level_mod(first_frame) : 0.f;
+            if (!flat_level) {
+                for (size_t i = 0; i < n; ++i) {
+                    levels[i] = op.level + level_mod(first_frame + i);
+                }
+                std::fill(levels + n, levels + n_padded, levels[n - 1]);
+            }
+
+            if (op.feedback != 0.f) {
+                // Each frame depends on the last: one frame at a time
+                const float feedback = 0.5f * op.feedback * kInvTwoPi;
+                float y1 = feedback_history[k][0];
+                float y2 = feedback_history[k][1];
+                for (size_t i = 0; i < n; ++i) {
+                    const float level = (flat_level) ? flat_level_value : levels[i];
+                    const float y = level * fastSin2Pi(phases[i] + feedback * (y1 + y2));
+                    y2 = y1;
+                    y1 = y;
+                    out[i] = y;
+                }
+                std::fill(out + n, out + n_padded, 0.f);
+                feedback_history[k][0] = y1;
+                feedback_history[k][1] = y2;
+            } else if (flat_level && flat_level_value == 0.f) {
+                std::fill(out, out + n_padded, 0.f);
+            } else {
+                const os_simd_t flat_level_vec = OS_SIMD_SET1(flat_level_value);
+                for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+                    const os_simd_t level = (flat_level) ? flat_level_vec : OS_SIMD_LOAD_ALIGNED(levels + i);
+                    OS_SIMD_STORE_ALIGNED(out + i, OS_SIMD_MUL(level, simdSin2Pi(OS_SIMD_LOAD_ALIGNED(phases + i))));
+                }
+            }
+
+            if (op.output_level != 0.f) {
+                const os_simd_t output_level = OS_SIMD_SET1(op.output_level);
+                for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+                    OS_SIMD_STORE_ALIGNED(mix + i, OS_SIMD_ADD(OS_SIMD_LOAD_ALIGNED(mix + i), OS_SIMD_MUL(output_level, OS_SIMD_LOAD_ALIGNED(out + i))));
+                }
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            mix[i] *= (flat_amplitude) ? flat_amp : amplitude + amplitude_mod(first_frame + i);
+        }
+
+        for (size_t c = 0; c < n_channels; ++c) {
+            float* out_buffer = getOutputChannel(outputs, c, n_frames);
+            if (!out_buffer) {
+                continue;
+            }
+            if (overwrite_output) {
+                vectorCopy(out_buffer + first_frame, mix, n);
+            } else {
+                vectorAdd(out_buffer + first_frame, mix, n);
+            }
+        }
+    }
+    frame_offset += n_frames;
+}
+
+void FMOscillator::onSampleRateChange(float new_sample_rate) {
+    this->sample_rate = new_sample_rate;
+}
+
+void FMOscillator::copyStateFrom(const Oscillator& other) {
+    const FMOscillator& running = static_cast<const FMOscillator&>(other);
+    const size_t n = std::min(n_operators, running.n_operators);
+    for (size_t k = 0; k < n; ++k) {
+        phase[k] = running.phase[k];
+        feedback_history[k][0] = running.feedback_history[k][0];
+        feedback_history[k][1] = running.feedback_history[k][1];
+    }
+}
+}
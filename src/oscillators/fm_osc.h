@@ -0,0 +1,71 @@
+// FM/PM operator stack: sine operators modulating each other's phase, rendered by one fused kernel
+#pragma once
+#include "../oscillator.h"
+
+/*
+An FMOscillator holds up to kMaxOperators sine operators. Each operator runs at a ratio of the played note and
+has a level, an output level (operators with output 0 are pure modulators) and a feedback amount. Routes add the
+output of one operator to the phase of another, scaled by a modulation index in radians; routes may not form a
+loop, so the operators are run in an order where every operator comes after its modulators. Feedback is the
+only loop: an operator's phase is modulated by the average of its own last two outputs.
+
+The whole graph is rendered chunk by chunk. For each chunk every operator is computed over all its frames
+before the next one, with SIMD over frames, and the operator outputs stay in small local arrays instead of
+passing through SignalBuffers. Operators with feedback are necessarily evaluated one frame at a time.
+
+Channel 0 of audio_inputs (see Voice::assignOscillatorInputBuffer) can modulate any operator too, either as
+phase modulation (an index in radians) or as linear frequency modulation (a depth relative to the operator's
+frequency). Every output channel plays the same signal.
+*/
+
+namespace OrangeSodium {
+class FMOscillator : public Oscillator {
+public:
+    static constexpr size_t kMaxOperators = 8;
+    static constexpr size_t kFirstLevelChannel = 2; // Mod channel of operator 0's level; operator k is on channel 2 + k
+
+    FMOscillator(Context* context, ObjectID id, size_t n_operators, size_t n_channels, float amplitude);
+    ~FMOscillator();
+
+    void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
+    void onSampleRateChange(float new_sample_rate) override;
+    const char* getTypeName() const override { return "fm_osc"; }
+    void copyStateFrom(const Oscillator& other) override;
+
+    size_t getNumOperators() const { return n_operators; }
+
+    /// @brief Set an operator's frequency ratio to the played note, level, feedback index (radians) and output level
+    void setOperator(size_t op, float ratio, float level, float feedback, float output_level);
+
+    /// @brief Modulate dest's phase by source's output with the given index (radians). Returns false if the route
+    /// would close a loop; use feedback for an operator modulating itself.
+    bool setRoute(size_t source, size_t dest, float index);
+
+    /// @brief Modulate an operator by channel 0 of the audio input: pm_index in radians, fm_depth relative to the
+    /// operator's frequency
+    void setInputRoute(size_t op, float pm_index, float fm_depth);
+
+private:
+    static constexpr size_t kChunkFrames = 32; // Frames per pass through the operators; a multiple of OS_SIMD_WIDTH
+
+    struct Operator {
+        float ratio = 1.f;
+        float level = 1.f;
+        float feedback = 0.f;     // Index in radians
+        float output_level = 0.f; // Contribution to the oscillator output
+        float input_pm = 0.f;     // Index in radians of the audio input
+        float input_fm = 0.f;     // Frequency deviation per unit of audio input, relative to the operator's frequency
+    };
+
+    size_t n_operators;
+    Operator operators[kMaxOperators];
+    float routes[kMaxOperators][kMaxOperators]; // routes[dest][source], index in radians
+    size_t order[kMaxOperators];                // Execution order: every operator after its modulators
+
+    float phase[kMaxOperators];                // In cycles
+    float feedback_history[kMaxOperators][2];  // Last two outputs of each operator
+
+    /// @brief Sort the operators so that every one comes after its modulators; returns false if routes form a loop
+    bool updateOrder();
+};
+}
@@ -0,0 +1,376 @@
+#include "granular_osc.h"
+#include "../dsp/fast_math.h"
+#include "../dsp/interpolation.h"
+#include "../dsp/vector_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace OrangeSodium {
+
+/// @brief Grain windows, kWindowSize points over the grain. Two zero guard points follow, so a grain at its end
+/// (window phase 1) reads silence and the interpolation never wraps.
+struct GrainWindowTables {
+    static constexpr size_t kWindowSize = 1024;
+    static constexpr size_t kNumWindows = 4;
+    static constexpr size_t kStride = kWindowSize + OS_SIMD_WIDTH; // Room for the guard points, keeping rows aligned
+
+    alignas(OS_SIMD_ALIGNMENT) float tables[kNumWindows * kStride];
+
+    static const GrainWindowTables& get() {
+        static const GrainWindowTables instance;
+        return instance;
+    }
+
+    const float* getTable(GranularOscillator::EWindow window) const {
+        return tables + static_cast<size_t>(window) * kStride;
+    }
+
+private:
+    GrainWindowTables() {
+        const double pi = 3.14159265358979323846;
+        const double sigma = 0.15; // Gaussian width, as a fraction of the grain
+        const double gaussian_edge = std::exp(-0.5 * (0.5 / sigma) * (0.5 / sigma));
+        const double taper = 0.25; // Tukey: fraction of the grain in each cosine taper
+        std::memset(tables, 0, sizeof(tables));
+        for (size_t i = 0; i < kWindowSize; ++i) {
+            const double x = static_cast<double>(i) / static_cast<double>(kWindowSize);
+            const double gaussian = std::exp(-0.5 * ((x - 0.5) / sigma) * ((x - 0.5) / sigma));
+            const double edge_distance = std::min(x, 1.0 - x);
+            tables[static_cast<size_t>(GranularOscillator::EWindow::kHann) * kStride + i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * x));
+            tables[static_cast<size_t>(GranularOscillator::EWindow::kGaussian) * kStride + i] = static_cast<float>((gaussian - gaussian_edge) / (1.0 - gaussian_edge));
+            tables[static_cast<size_t>(GranularOscillator::EWindow::kTukey) * kStride + i] =
+                static_cast<float>((edge_distance >= taper) ? 1.0 : 0.5 - 0.5 * std::cos(pi * edge_distance / taper));
+            tables[static_cast<size_t>(GranularOscillator::EWindow::kTriangle) * kStride + i] = static_cast<float>(1.0 - std::abs(2.0 * x - 1.0));
+        }
+    }
+};
+
+/// @brief a[l] = base[l][indices[l]], b[l] = base[l][indices[l] + 1]. There is no gather in AVX, so each lane
+/// reads its pair of neighbouring points with one 64-bit load, then the pairs are split.
+static inline void gatherPairs(const float* const* base, const int* indices, os_simd_t& a, os_simd_t& b) {
+#ifdef OS_AVX
+    __m128 pairs[4];
+    for (size_t l = 0; l < 4; ++l) {
+        const __m64* p0 = reinterpret_cast<const __m64*>(base[2 * l] + indices[2 * l]);
+        const __m64* p1 = reinterpret_cast<const __m64*>(base[2 * l + 1] + indices[2 * l + 1]);
+        pairs[l] = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), p0), p1);
+    }
+    a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_shuffle_ps(pairs[0], pairs[1], _MM_SHUFFLE(2, 0, 2, 0))),
+                             _mm_shuffle_ps(pairs[2], pairs[3], _MM_SHUFFLE(2, 0, 2, 0)), 1);
+    b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_shuffle_ps(pairs[0], pairs[1], _MM_SHUFFLE(3, 1, 3, 1))),
+                             _mm_shuffle_ps(pairs[2], pairs[3], _MM_SHUFFLE(3, 1, 3, 1)), 1);
+#else
+    __m128 pairs[2];
+    for (size_t l = 0; l < 2; ++l) {
+        const __m64* p0 = reinterpret_cast<const __m64*>(base[2 * l] + indices[2 * l]);
+        const __m64* p1 = reinterpret_cast<const __m64*>(base[2 * l + 1] + indices[2 * l + 1]);
+        pairs[l] = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), p0), p1);
+    }
+    a = _mm_shuffle_ps(pairs[0], pairs[1], _MM_SHUFFLE(2, 0, 2, 0));
+    b = _mm_shuffle_ps(pairs[0], pairs[1], _MM_SHUFFLE(3, 1, 3, 1));
+#endif
+}
+
+GranularOscillator::GranularOscillator(Context* context, ObjectID id, ResourceID sample_id, size_t n_channels, float amplitude)
+    : Oscillator(context, id, n_channels, amplitude), sample_id(sample_id) {
+    static_assert(kMaxGrains % OS_SIMD_WIDTH == 0, "The grain pool is rendered in whole vectors");
+    static_assert(kChunkFrames % OS_SIMD_WIDTH == 0, "Chunks are reduced in whole vectors");
+    if (m_context->resource_manager) {
+        sample = m_context->resource_manager->getSample(sample_id);
+    }
+    GrainWindowTables::get(); // Build the shared tables now rather than on the audio thread
+    random_state = 0x9E3779B9u ^ static_cast<uint32_t>(id);
+    for (size_t g = 0; g < kMaxGrains; ++g) {
+        resetGrain(g);
+    }
+
+    // Add modulation source names
+    modulation_source_names.resize(0);
+    modulation_source_names.push_back("pitch");
+    modulation_source_names.push_back("amplitude");
+    modulation_source_names.push_back("density");
+    modulation_source_names.push_back("position");
+    modulation_source_names.push_back("spray");
+}
+
+GranularOscillator::~GranularOscillator() {}
+
+bool GranularOscillator::getWindowFromName(const char* name, EWindow& out) {
+    if (std::strcmp(name, "hann") == 0) {
+        out = EWindow::kHann;
+    } else if (std::strcmp(name, "gaussian") == 0) {
+        out = EWindow::kGaussian;
+    } else if (std::strcmp(name, "tukey") == 0) {
+        out = EWindow::kTukey;
+    } else if (std::strcmp(name, "triangle") == 0) {
+        out = EWindow::kTriangle;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void GranularOscillator::setGrainSize(float milliseconds) {
+    grain_size = std::min(std::max(milliseconds, 1.f), 10000.f);
+}
+
+void GranularOscillator::setMaxGrains(size_t n_grains) {
+    max_grains = std::min(std::max(n_grains, static_cast<size_t>(1)), kMaxGrains);
+}
+
+void GranularOscillator::setStereoSpread(float spread) {
+    stereo_spread = std::min(std::max(spread, 0.f), 1.f);
+}
+
+void GranularOscillator::resetGrain(size_t g) {
+    // Silent, and past the end of its window, so it reads nothing and renders nothing
+    read_position[g] = 0.0;
+    increment[g] = 0.f;
+    window_phase[g] = 1.f;
+    window_increment[g] = 0.f;
+    gain_left[g] = 0.f;
+    gain_right[g] = 0.f;
+}
+
+float GranularOscillator::nextRandom() {
+    // xorshift32
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return static_cast<float>(random_state >> 8) * (2.f / 16777216.f) - 1.f;
+}
+
+void GranularOscillator::onRetrigger() {
+    next_grain = 0.f;
+}
+
+void GranularOscillator::scheduleGrains(const ModInput& pitch, const ModInput& density_mod, const ModInput& position_mod, const ModInput& spray_mod, size_t first_frame, size_t n_frames) {
+    const float n = static_cast<float>(n_frames);
+    const float n_sample_frames = static_cast<float>(sample->getNumFrames());
+    const float rate_ratio = sample->getSampleRate() / sample_rate;
+    const float root_note = sample->getRootNote();
+    const float window_increment_value = 1000.f / (grain_size * sample_rate);
+    const bool stereo = (n_channels == 2);
+
+    while (next_grain < n) {
+        const float start = std::max(next_grain, 0.f); // Frame of the chunk the grain starts on
+        const size_t frame = first_frame + static_cast<size_t>(start);
+        const float grains_per_second = std::min(density + density_mod(frame), sample_rate);
+        if (grains_per_second <= 0.f) {
+            next_grain = n; // Checked again at the next chunk
+            break;
+        }
+        next_grain += sample_rate / grains_per_second;
+
+        if (n_active >= max_grains) {
+            continue; // The pool is full: skip the grain rather than let the cost grow
+        }
+        const size_t g = n_active++;
+        const float centre = std::min(std::max(position + position_mod(frame), 0.f), 1.f) * n_sample_frames;
+        const float jitter = nextRandom() * std::max(spray + spray_mod(frame), 0.f) * sample->getSampleRate();
+        const double first_read = std::min(std::max(centre + jitter, 0.f), n_sample_frames - 1.f);
+        increment[g] = fastExp2((pitch(frame) + frequency_offset - root_note) * (1.f / 12.f)) * rate_ratio;
+        window_increment[g] = window_increment_value;
+        // Positions are kept relative to the start of the chunk, so the grain is silent until its start frame
+        read_position[g] = first_read - static_cast<double>(start) * increment[g];
+        window_phase[g] = -start * window_increment_value;
+
+        const float pan = (stereo) ? stereo_spread * nextRandom() : 0.f;
+        gain_left[g] = (pan > 0.f) ? 1.f - pan : 1.f;
+        gain_right[g] = (pan < 0.f) ? 1.f + pan : 1.f;
+    }
+    next_grain -= n;
+}
+
+void GranularOscillator::renderChunk(float* left, float* right, size_t n_frames) {
+    const bool stereo = (n_channels == 2);
+    const float* source = sample->getChannel(0);
+    const float* window_table = GrainWindowTables::get().getTable(window);
+    const float n_sample_frames = static_cast<float>(sample->getNumFrames());
+    const os_simd_t window_size = OS_SIMD_SET1(static_cast<float>(GrainWindowTables::kWindowSize));
+    const os_simd_t zero = OS_SIMD_SET1(0.f);
+    const os_simd_t one = OS_SIMD_SET1(1.f);
+
+    alignas(OS_SIMD_ALIGNMENT) os_simd_t sums_left[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) os_simd_t sums_right[kChunkFrames];
+    for (size_t i = 0; i < n_frames; ++i) {
+        sums_left[i] = zero;
+        sums_right[i] = zero;
+    }
+
+    alignas(OS_SIMD_ALIGNMENT) float start_fraction[OS_SIMD_WIDTH];
+    alignas(OS_SIMD_ALIGNMENT) float lowest[OS_SIMD_WIDTH];
+    alignas(OS_SIMD_ALIGNMENT) float highest[OS_SIMD_WIDTH];
+    alignas(OS_SIMD_ALIGNMENT) int sample_indices[OS_SIMD_WIDTH];
+    alignas(OS_SIMD_ALIGNMENT) int window_indices[OS_SIMD_WIDTH];
+    const float* sample_bases[OS_SIMD_WIDTH];
+    const float* window_bases[OS_SIMD_WIDTH];
+    for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+        window_bases[l] = window_table;
+    }
+
+    const size_t n_vectors = (n_active + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH;
+    for (size_t v = 0; v < n_vectors; ++v) {
+        const size_t k = v * OS_SIMD_WIDTH;
+        // Within a chunk each grain reads relative to a whole frame of the sample, so positions stay small enough
+        // for floats. Reads are clamped to the sample; frame n_frames and the one after are its zero padding.
+        for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+            const double whole = std::floor(read_position[k + l]);
+            sample_bases[l] = source + static_cast<long long>(whole);
+            start_fraction[l] = static_cast<float>(read_position[k + l] - whole);
+            lowest[l] = static_cast<float>(-whole);
+            highest[l] = n_sample_frames - static_cast<float>(whole);
+        }
+        const os_simd_t fraction = OS_SIMD_LOAD_ALIGNED(start_fraction);
+        const os_simd_t low = OS_SIMD_LOAD_ALIGNED(lowest);
+        const os_simd_t high = OS_SIMD_LOAD_ALIGNED(highest);
+        const os_simd_t inc = OS_SIMD_LOAD_ALIGNED(increment + k);
+        const os_simd_t w = OS_SIMD_LOAD_ALIGNED(window_phase + k);
+        const os_simd_t w_inc = OS_SIMD_LOAD_ALIGNED(window_increment + k);
+        const os_simd_t g_left = OS_SIMD_LOAD_ALIGNED(gain_left + k);
+        const os_simd_t g_right = OS_SIMD_LOAD_ALIGNED(gain_right + k);
+
+        for (size_t i = 0; i < n_frames; ++i) {
+            const os_simd_t t = OS_SIMD_SET1(static_cast<float>(i));
+            // Before its start frame (negative phase) and after its end, a grain's window reads zero
+            const os_simd_t phase = OS_SIMD_MIN(OS_SIMD_MAX(OS_SIMD_ADD(w, OS_SIMD_MUL(t, w_inc)), zero), one);
+            const os_simd_t window_position = OS_SIMD_MUL(phase, window_size);
+            const os_simd_t window_whole = simdFloorToIndices(window_position, window_indices);
+            const os_simd_t read = OS_SIMD_MIN(OS_SIMD_MAX(OS_SIMD_ADD(fraction, OS_SIMD_MUL(t, inc)), low), high);
+            const os_simd_t read_whole = simdFloorToIndices(read, sample_indices);
+
+            os_simd_t a, b;
+            gatherPairs(window_bases, window_indices, a, b);
+            const os_simd_t gain = OS_SIMD_ADD(a, OS_SIMD_MUL(OS_SIMD_SUB(window_position, window_whole), OS_SIMD_SUB(b, a)));
+            gatherPairs(sample_bases, sample_indices, a, b);
+            const os_simd_t value = OS_SIMD_MUL(gain, OS_SIMD_ADD(a, OS_SIMD_MUL(OS_SIMD_SUB(read, read_whole), OS_SIMD_SUB(b, a))));
+
+            sums_left[i] = OS_SIMD_ADD(sums_left[i], OS_SIMD_MUL(value, g_left));
+            if (stereo) {
+                sums_right[i] = OS_SIMD_ADD(sums_right[i], OS_SIMD_MUL(value, g_right));
+            }
+        }
+    }
+
+    vectorHorizontalSums(sums_left, left, n_frames);
+    if (stereo) {
+        vectorHorizontalSums(sums_right, right, n_frames);
+    }
+}
+
+void GranularOscillator::advanceGrains(size_t n_frames) {
+    const float n = static_cast<float>(n_frames);
+    size_t g = 0;
+    while (g < n_active) {
+        read_position[g] += static_cast<double>(n) * increment[g];
+        window_phase[g] += n * window_increment[g];
+        if (window_phase[g] < 1.f) {
+            ++g;
+            continue;
+        }
+        // Finished: the last grain takes its slot
+        const size_t last = --n_active;
+        read_position[g] = read_position[last];
+        increment[g] = increment[last];
+        window_phase[g] = window_phase[last];
+        window_increment[g] = window_increment[last];
+        gain_left[g] = gain_left[last];
+        gain_right[g] = gain_right[last];
+        resetGrain(last);
+    }
+}
+
+void GranularOscillator::processBlock(SignalBuffer* /*audio_inputs*/, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
+    const size_t n_frames = n_audio_frames; // Will always be lower than or equal to context->max_n_frames
+    if (!sample || sample->getNumFrames() == 0) {
+        for (size_t c = 0; c < n_channels; ++c) {
+            writeSilence(outputs, c, n_frames);
+        }
+        frame_offset += n_frames;
+        return;
+    }
+
+    const ModInput pitch = getModInput(mod_inputs, EModChannel::kPitch);
+    const ModInput amplitude_mod = getModInput(mod_inputs, EModChannel::kAmplitude);
+    const ModInput density_mod = getModInput(mod_inputs, static_cast<EModChannel>(EGranularModChannel::kDensity));
+    const ModInput position_mod = getModInput(mod_inputs, static_cast<EModChannel>(EGranularModChannel::kPosition));
+    const ModInput spray_mod = getModInput(mod_inputs, static_cast<EModChannel>(EGranularModChannel::kSpray));
+    const bool flat_amplitude = amplitude_mod.isFlat();
+    const float flat_amp = (flat_amplitude) ? amplitude + amplitude_mod(frame_offset) : 0.f;
+
+    // Flat zero amplitude adds nothing; grains still start and play on
+    if (flat_amplitude && flat_amp == 0.f) {
+        for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+            const size_t n = std::min(kChunkFrames, n_frames - start);
+            scheduleGrains(pitch, density_mod, position_mod, spray_mod, frame_offset + start, n);
+            advanceGrains(n);
+        }
+        for (size_t c = 0; c < n_channels; ++c) {
+            writeSilence(outputs, c, n_frames);
+        }
+        frame_offset += n_frames;
+        return;
+    }
+
+    alignas(OS_SIMD_ALIGNMENT) float left[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float right[kChunkFrames];
+    for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+        const size_t n = std::min(kChunkFrames, n_frames - start);
+        const size_t first_frame = frame_offset + start;
+        scheduleGrains(pitch, density_mod, position_mod, spray_mod, first_frame, n);
+        renderChunk(left, right, n);
+        advanceGrains(n);
+
+        for (size_t i = 0; i < n; ++i) {
+            left[i] *= (flat_amplitude) ? flat_amp : amplitude + amplitude_mod(first_frame + i);
+        }
+        if (n_channels == 2) {
+            for (size_t i = 0; i < n; ++i) {
+                right[i] *= (flat_amplitude) ? flat_amp : amplitude + amplitude_mod(first_frame + i);
+            }
+        }
+
+        // Stereo outputs get the panned grains; any other layout gets the same sum on every channel
+        for (size_t c = 0; c < n_channels; ++c) {
+            float* out_buffer = getOutputChannel(outputs, c, n_frames);
+            if (!out_buffer) {
+                continue;
+            }
+            const float* samples = (c == 1 && n_channels == 2) ? right : left;
+            if (overwrite_output) {
+                vectorCopy(out_buffer + first_frame, samples, n);
+            } else {
+                vectorAdd(out_buffer + first_frame, samples, n);
+            }
+        }
+    }
+    frame_offset += n_frames;
+}
+
+void GranularOscillator::onSampleRateChange(float new_sample_rate) {
+    this->sample_rate = new_sample_rate;
+}
+
+void GranularOscillator::copyStateFrom(const Oscillator& other) {
+    const GranularOscillator& running = static_cast<const GranularOscillator&>(other);
+    if (running.sample_id != sample_id) {
+        return; // Grains of a different sample are dropped
+    }
+    n_active = std::min(running.n_active, max_grains);
+    for (size_t g = 0; g < kMaxGrains; ++g) {
+        if (g >= n_active) {
+            resetGrain(g);
+            continue;
+        }
+        read_position[g] = running.read_position[g];
+        increment[g] = running.increment[g];
+        window_phase[g] = running.window_phase[g];
+        window_increment[g] = running.window_increment[g];
+        gain_left[g] = running.gain_left[g];
+        gain_right[g] = running.gain_right[g];
+    }
+    next_grain = running.next_grain;
+    random_state = running.random_state;
+}
+}
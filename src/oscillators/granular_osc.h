@@ -0,0 +1,114 @@
+// Granular oscillator over a sample resource
+#pragma once
+#include "../oscillator.h"
+#include "../resource_manager.h"
+#include "../simd.h"
+#include <cstdint>
+
+/*
+Plays a stream of short windowed grains read from a sample resource. Grains start at a steady rate (density,
+in grains per second) around a read position in the sample, spread randomly by the spray. Each grain plays the
+sample at the pitch of the note when it started (relative to the sample's root note), for the grain size, and
+is shaped by a window read from a precomputed table. The sample's first channel is read; on stereo outputs every
+grain gets a random pan within the stereo spread.
+
+Grains live in a fixed pool of at most kMaxGrains, stored as one array per field so kernels can load
+OS_SIMD_WIDTH grains at once. Grains [0, n_active) are playing; a finished grain is replaced by the last one,
+and the freed slot is reset to a silent grain, so whole vectors can always be rendered. Once the pool (or the
+cap set with setMaxGrains) is full, new grains are skipped, which keeps the cost of a block bounded.
+
+The modulation channels after pitch and amplitude are added to the values set from Lua: density (grains per
+second), position (0 is the start of the sample, 1 its end) and spray (seconds). All of them are read when a
+grain starts.
+
+A new note restarts the grain stream; grains already playing finish on their own.
+*/
+
+namespace OrangeSodium {
+class GranularOscillator : public Oscillator {
+public:
+    enum class EWindow {
+        kHann = 0,
+        kGaussian,
+        kTukey,
+        kTriangle
+    };
+
+    enum class EGranularModChannel {
+        kDensity = 2,
+        kPosition,
+        kSpray,
+    };
+
+    static constexpr size_t kMaxGrains = 256;
+    static constexpr size_t kNumModChannels = 5;
+
+    GranularOscillator(Context* context, ObjectID id, ResourceID sample_id, size_t n_channels, float amplitude);
+    ~GranularOscillator();
+
+    void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
+    void onSampleRateChange(float new_sample_rate) override;
+    void onRetrigger() override;
+    const char* getTypeName() const override { return "granular_osc"; }
+    void copyStateFrom(const Oscillator& other) override;
+
+    void setGrainSize(float milliseconds);
+    float getGrainSize() const { return grain_size; }
+    void setDensity(float grains_per_second) { density = grains_per_second; }
+    float getDensity() const { return density; }
+    /// @brief Cap on grains playing at once, at most kMaxGrains
+    void setMaxGrains(size_t n_grains);
+    size_t getMaxGrains() const { return max_grains; }
+    void setPosition(float new_position) { position = new_position; }
+    float getPosition() const { return position; }
+    void setSpray(float seconds) { spray = seconds; }
+    float getSpray() const { return spray; }
+    void setStereoSpread(float spread);
+    float getStereoSpread() const { return stereo_spread; }
+    void setWindow(EWindow new_window) { window = new_window; }
+    EWindow getWindow() const { return window; }
+
+    size_t getActiveGrains() const { return n_active; }
+    ResourceID getSampleResourceID() const { return sample_id; }
+
+    /// @brief Parse a window name ("hann", "gaussian", "tukey", "triangle"); returns false if unknown
+    static bool getWindowFromName(const char* name, EWindow& out);
+
+private:
+    static constexpr size_t kChunkFrames = 32; // Frames rendered per pass; a multiple of OS_SIMD_WIDTH
+
+    ResourceID sample_id;
+    SampleResource* sample = nullptr;
+
+    float grain_size = 80.f;    // Milliseconds
+    float density = 20.f;       // Grains per second
+    float position = 0.f;       // [0, 1] of the sample
+    float spray = 0.f;          // Seconds
+    float stereo_spread = 0.f;  // [0, 1]
+    size_t max_grains = 64;
+    EWindow window = EWindow::kHann;
+
+    // Grain pool, one array per field
+    size_t n_active = 0;
+    double read_position[kMaxGrains];                              // Sample frames
+    alignas(OS_SIMD_ALIGNMENT) float increment[kMaxGrains];        // Sample frames per output frame
+    alignas(OS_SIMD_ALIGNMENT) float window_phase[kMaxGrains];     // [0, 1] over the grain; the grain ends at 1
+    alignas(OS_SIMD_ALIGNMENT) float window_increment[kMaxGrains];
+    alignas(OS_SIMD_ALIGNMENT) float gain_left[kMaxGrains];        // Gain into the first output channel (every channel unless stereo)
+    alignas(OS_SIMD_ALIGNMENT) float gain_right[kMaxGrains];       // Gain into the second output channel
+
+    float next_grain = 0.f; // Frames from the current position until the next grain starts
+    uint32_t random_state;
+
+    void resetGrain(size_t g);
+    /// @brief Random value in [-1, 1)
+    float nextRandom();
+
+    /// @brief Start the grains due in the chunk of n_frames frames starting at first_frame
+    void scheduleGrains(const ModInput& pitch, const ModInput& density_mod, const ModInput& position_mod, const ModInput& spray_mod, size_t first_frame, size_t n_frames);
+    /// @brief Mix n_frames frames of every playing grain into left and right
+    void renderChunk(float* left, float* right, size_t n_frames);
+    /// @brief Move every grain n_frames frames on and drop the finished ones
+    void advanceGrains(size_t n_frames);
+};
+}
@@ -0,0 +1,192 @@
+#include "noise_osc.h"
+#include "../dsp/vector_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace OrangeSodium {
+
+// Paul Kellet's refined pink filter, designed at 44.1 kHz: six one-poles summed with the input and a one-sample
+// delayed copy of it. The last pole is negative and shapes the top octave, so it stays as it is.
+static constexpr float kPinkDesignRate = 44100.f;
+static constexpr float kPinkPoles44k[6] = { 0.99886f, 0.99332f, 0.96900f, 0.86650f, 0.55000f, -0.7616f };
+static constexpr float kPinkInputGains[6] = { 0.0555179f, 0.0750759f, 0.1538520f, 0.3104856f, 0.5329522f, -0.0168980f };
+static constexpr float kPinkDirectGain = 0.5362f;
+static constexpr float kPinkDelayedGain = 0.115926f;
+static constexpr float kPinkOutputGain = 0.11f; // Brings the sum back to about the level of the white noise
+
+NoiseOscillator::NoiseOscillator(Context* context, ObjectID id, EColor color, size_t n_channels, float amplitude, size_t voice_index)
+    : Oscillator(context, id, n_channels, amplitude), color(color) {
+    channels.resize(n_channels);
+    for (size_t c = 0; c < n_channels; ++c) {
+        channels[c].random = CounterRandom(CounterRandom::makeKey(voice_index, id, static_cast<uint32_t>(c)));
+    }
+    onSampleRateChange(m_context->sample_rate);
+
+    // Add modulation source names
+    modulation_source_names.resize(0);
+    modulation_source_names.push_back("pitch");
+    modulation_source_names.push_back("amplitude");
+}
+
+NoiseOscillator::~NoiseOscillator() {}
+
+bool NoiseOscillator::getColorFromName(const char* name, EColor& out) {
+    if (std::strcmp(name, "white") == 0) {
+        out = EColor::kWhite;
+    } else if (std::strcmp(name, "pink") == 0) {
+        out = EColor::kPink;
+    } else if (std::strcmp(name, "band") == 0) {
+        out = EColor::kBand;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void NoiseOscillator::setBandwidth(float octaves) {
+    bandwidth = std::min(std::max(octaves, 0.01f), 8.f);
+    band_centre = -1.f; // Recompute the filter
+}
+
+void NoiseOscillator::renderPink(ChannelState& state, float* samples, size_t n_frames) const {
+    // Locals, so the six independent one-poles stay in registers
+    float b[kPinkPoles + 1];
+    float poles[kPinkPoles];
+    std::memcpy(b, state.pink, sizeof(b));
+    std::memcpy(poles, pink_poles, sizeof(poles));
+    for (size_t i = 0; i < n_frames; ++i) {
+        const float white = samples[i];
+        float sum = white * kPinkDirectGain + b[kPinkPoles];
+        for (size_t k = 0; k < kPinkPoles; ++k) {
+            b[k] = poles[k] * b[k] + white * kPinkInputGains[k];
+            sum += b[k];
+        }
+        b[kPinkPoles] = white * kPinkDelayedGain;
+        samples[i] = sum * kPinkOutputGain;
+    }
+    std::memcpy(state.pink, b, sizeof(b));
+}
+
+void NoiseOscillator::updateBandCoefficients(float centre_hz) {
+    if (centre_hz == band_centre) {
+        return;
+    }
+    band_centre = centre_hz;
+    // Zero-delay feedback state variable filter; k * band-pass has unity gain at the centre
+    const float pi = 3.14159265358979f;
+    const float centre = std::min(std::max(centre_hz, 10.f), 0.45f * sample_rate);
+    const float width = std::pow(2.f, bandwidth);
+    const float k = (width - 1.f) / std::sqrt(width); // 1 / Q
+    const float g = std::tan(pi * centre / sample_rate);
+    band.a1 = 1.f / (1.f + g * (g + k));
+    band.a2 = g * band.a1;
+    band.a3 = g * band.a2;
+    // White noise through a unity-peak band-pass keeps pi * centre * k / sample_rate of its power
+    band.gain = k * std::min(std::sqrt(sample_rate / (pi * centre * k)), 32.f);
+}
+
+void NoiseOscillator::renderBand(ChannelState& state, float* samples, size_t n_frames) const {
+    const float a1 = band.a1;
+    const float a2 = band.a2;
+    const float a3 = band.a3;
+    const float gain = band.gain;
+    float s1 = state.band_state[0];
+    float s2 = state.band_state[1];
+    for (size_t i = 0; i < n_frames; ++i) {
+        const float v3 = samples[i] - s2;
+        const float v1 = a1 * s1 + a2 * v3;
+        const float v2 = s2 + a2 * s1 + a3 * v3;
+        s1 = 2.f * v1 - s1;
+        s2 = 2.f * v2 - s2;
+        samples[i] = v1 * gain;
+    }
+    state.band_state[0] = s1;
+    state.band_state[1] = s2;
+}
+
+void NoiseOscillator::processBlock(SignalBuffer* /*audio_inputs*/, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
+    const size_t n_frames = n_audio_frames; // Will always be lower than or equal to context->max_n_frames
+    const ModInput pitch = getModInput(mod_inputs, EModChannel::kPitch);
+    const ModInput amplitude_mod = getModInput(mod_inputs, EModChannel::kAmplitude);
+    const bool flat_amplitude = amplitude_mod.isFlat();
+    const float flat_amp = (flat_amplitude) ? amplitude + amplitude_mod(frame_offset) : 0.f;
+
+    // Flat zero amplitude adds nothing. The streams still move on so the noise does not depend on when it was muted.
+    if (flat_amplitude && flat_amp == 0.f) {
+        for (size_t c = 0; c < n_channels; ++c) {
+            CounterRandom& random = channels[c].random;
+            random.setCounter(random.getCounter() + static_cast<uint32_t>(n_frames));
+            writeSilence(outputs, c, n_frames);
+        }
+        frame_offset += n_frames;
+        return;
+    }
+
+    alignas(OS_SIMD_ALIGNMENT) float samples[kChunkFrames];
+    for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+        const size_t n = std::min(kChunkFrames, n_frames - start);
+        const size_t first_frame = frame_offset + start;
+        if (color == EColor::kBand) {
+            updateBandCoefficients(getHzFromMIDINote(pitch(first_frame) + frequency_offset));
+        }
+
+        for (size_t c = 0; c < n_channels; ++c) {
+            ChannelState& state = channels[c];
+            state.random.fillBipolar(samples, n);
+            if (color == EColor::kPink) {
+                renderPink(state, samples, n);
+            } else if (color == EColor::kBand) {
+                renderBand(state, samples, n);
+            }
+
+            if (flat_amplitude) {
+                const os_simd_t amp = OS_SIMD_SET1(flat_amp);
+                size_t i = 0;
+                for (; i + OS_SIMD_WIDTH <= n; i += OS_SIMD_WIDTH) {
+                    OS_SIMD_STORE_ALIGNED(samples + i, OS_SIMD_MUL(OS_SIMD_LOAD_ALIGNED(samples + i), amp));
+                }
+                for (; i < n; ++i) {
+                    samples[i] *= flat_amp;
+                }
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    samples[i] *= amplitude + amplitude_mod(first_frame + i);
+                }
+            }
+
+            float* out_buffer = getOutputChannel(outputs, c, n_frames);
+            if (!out_buffer) {
+                continue;
+            }
+            if (overwrite_output) {
+                vectorCopy(out_buffer + first_frame, samples, n);
+            } else {
+                vectorAdd(out_buffer + first_frame, samples, n);
+            }
+        }
+    }
+    frame_offset += n_frames;
+}
+
+void NoiseOscillator::onSampleRateChange(float new_sample_rate) {
+    this->sample_rate = new_sample_rate;
+    band_centre = -1.f; // Recompute the filter
+    // Same time constant at any rate: p^(44100 / rate). The negative pole is left alone.
+    for (size_t k = 0; k < kPinkPoles; ++k) {
+        pink_poles[k] = (kPinkPoles44k[k] > 0.f && new_sample_rate > 0.f)
+                            ? std::pow(kPinkPoles44k[k], kPinkDesignRate / new_sample_rate)
+                            : kPinkPoles44k[k];
+    }
+}
+
+void NoiseOscillator::copyStateFrom(const Oscillator& other) {
+    const NoiseOscillator& running = static_cast<const NoiseOscillator&>(other);
+    const size_t n = std::min(channels.size(), running.channels.size());
+    for (size_t c = 0; c < n; ++c) {
+        channels[c].random.setCounter(running.channels[c].random.getCounter());
+        std::memcpy(channels[c].pink, running.channels[c].pink, sizeof(channels[c].pink));
+        std::memcpy(channels[c].band_state, running.channels[c].band_state, sizeof(channels[c].band_state));
+    }
+}
+}
@@ -0,0 +1,70 @@
+// Noise oscillator: white, pink and band-limited noise
+#pragma once
+#include "../oscillator.h"
+#include "../dsp/random.h"
+
+/*
+Every output channel plays its own noise stream (see CounterRandom), keyed by the voice, the oscillator's
+ObjectID and the channel, so channels are uncorrelated and a voice sounds the same however it is scheduled.
+
+- kWhite: uniform noise in [-1, 1), generated OS_SIMD_WIDTH values at a time.
+- kPink: white noise through Paul Kellet's refined pink filter (-3 dB per octave within 0.05 dB above 10 Hz).
+  The poles were designed for 44.1 kHz and are moved to keep the same time constants at other rates.
+- kBand: white noise through a band-pass state variable filter centred on the played note, bandwidth octaves
+  wide. The gain follows the bandwidth so the loudness stays close to the white noise.
+*/
+
+namespace OrangeSodium {
+class NoiseOscillator : public Oscillator {
+public:
+    enum class EColor {
+        kWhite = 0,
+        kPink,
+        kBand
+    };
+
+    NoiseOscillator(Context* context, ObjectID id, EColor color, size_t n_channels, float amplitude, size_t voice_index);
+    ~NoiseOscillator();
+
+    void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
+    void onSampleRateChange(float new_sample_rate) override;
+    const char* getTypeName() const override { return "noise_osc"; }
+    void copyStateFrom(const Oscillator& other) override;
+
+    EColor getColor() const { return color; }
+    /// @brief Width of the band of kBand noise, in octaves
+    void setBandwidth(float octaves);
+    float getBandwidth() const { return bandwidth; }
+
+    /// @brief Parse a color name ("white", "pink", "band"); returns false if unknown
+    static bool getColorFromName(const char* name, EColor& out);
+
+private:
+    static constexpr size_t kChunkFrames = 64;
+    static constexpr size_t kPinkPoles = 6;
+
+    struct ChannelState {
+        CounterRandom random;
+        float pink[kPinkPoles + 1] = {}; // One-pole states, then the one-sample delayed term
+        float band_state[2] = {};        // State variable filter integrators
+    };
+
+    struct BandCoefficients {
+        float a1 = 0.f;
+        float a2 = 0.f;
+        float a3 = 0.f;
+        float gain = 0.f;
+    };
+
+    EColor color;
+    float bandwidth = 1.f;
+    std::vector<ChannelState> channels;
+    float pink_poles[kPinkPoles];
+    BandCoefficients band;
+    float band_centre = -1.f; // Centre frequency band was computed for; negative when out of date
+
+    void updateBandCoefficients(float centre_hz);
+    void renderPink(ChannelState& state, float* samples, size_t n_frames) const;
+    void renderBand(ChannelState& state, float* samples, size_t n_frames) const;
+};
+}
@@ -0,0 +1,228 @@
+#include "sampler_osc.h"
+#include "../dsp/interpolation.h"
+#include "../dsp/sinc_interpolator.h"
+#include "../dsp/fast_math.h"
+#include "../dsp/vector_ops.h"
+#include <algorithm>
+#include <cstring>
+
+namespace OrangeSodium {
+
+SamplerOscillator::SamplerOscillator(Context* context, ObjectID id, ResourceID sample_id, size_t n_channels, float amplitude)
+    : Oscillator(context, id, n_channels, amplitude), sample_id(sample_id) {
+    if (m_context->resource_manager) {
+        sample = m_context->resource_manager->getSample(sample_id);
+    }
+    SincInterpolator::get(); // Build the shared tables now rather than on the audio thread
+
+    // Add modulation source names
+    modulation_source_names.resize(0);
+    modulation_source_names.push_back("pitch");
+    modulation_source_names.push_back("amplitude");
+}
+
+SamplerOscillator::~SamplerOscillator() {}
+
+bool SamplerOscillator::getQualityFromName(const char* name, EQuality& out) {
+    if (std::strcmp(name, "sinc") == 0) {
+        out = EQuality::kSinc;
+    } else if (std::strcmp(name, "hermite") == 0) {
+        out = EQuality::kHermite;
+    } else if (std::strcmp(name, "cubic") == 0) {
+        out = EQuality::kCubic;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void SamplerOscillator::onRetrigger() {
+    position = 0;
+    fraction = 0.f;
+    looped = false;
+    finished = false;
+}
+
+size_t SamplerOscillator::advance(const float* increments, size_t* positions, float* fractions, size_t n_frames, size_t& looped_from) {
+    const bool looping = sample->isLooping();
+    const size_t loop_start = sample->getLoopStart();
+    const size_t loop_end = sample->getLoopEnd();
+    const size_t n_sample_frames = sample->getNumFrames();
+    looped_from = (looped) ? 0 : n_frames;
+    for (size_t i = 0; i < n_frames; ++i) {
+        if (finished) {
+            return i;
+        }
+        positions[i] = position;
+        fractions[i] = fraction;
+        fraction += increments[i];
+        const size_t step = static_cast<size_t>(fraction);
+        position += step;
+        fraction -= static_cast<float>(step);
+        if (looping && position >= loop_end) {
+            position = loop_start + (position - loop_end) % (loop_end - loop_start);
+            looped_from = std::min(looped_from, i + 1);
+            looped = true;
+        } else if (!looping && position >= n_sample_frames) {
+            finished = true;
+        }
+    }
+    return n_frames;
+}
+
+template <SamplerOscillator::EQuality kQuality>
+void SamplerOscillator::readChannel(const float* source, const size_t* positions, const float* fractions, float* out, size_t n_frames, size_t looped_from, size_t cutoff) const {
+    const SincInterpolator& sinc = SincInterpolator::get();
+    constexpr size_t kBefore = SincInterpolator::kTapsBefore;
+    constexpr size_t kAfter = SincInterpolator::kTaps - kBefore;
+    const bool looping = sample->isLooping();
+    const size_t loop_start = sample->getLoopStart();
+    const size_t loop_end = sample->getLoopEnd();
+    const size_t loop_length = loop_end - loop_start;
+
+    auto interpolate = [&](const float* x, float frac) {
+        if constexpr (kQuality == EQuality::kSinc) {
+            return sinc.interpolate(x, frac, cutoff);
+        } else if constexpr (kQuality == EQuality::kHermite) {
+            return interpolateHermite6(x - 2, frac);
+        } else {
+            return interpolateCubic(x[-1], x[0], x[1], x[2], frac);
+        }
+    };
+
+    for (size_t i = 0; i < n_frames; ++i) {
+        const size_t pos = positions[i];
+        // Near a loop boundary the neighbours come from the other end of the loop. Frames before the loop start
+        // only follow the loop end once it has wrapped.
+        const bool near_end = looping && pos + kAfter >= loop_end;
+        const bool near_start = looping && i >= looped_from && pos >= loop_start && pos < loop_start + kBefore;
+        if (!near_end && !near_start) {
+            out[i] = interpolate(source + pos, fractions[i]);
+            continue;
+        }
+        float window[SincInterpolator::kTaps];
+        for (size_t j = 0; j < SincInterpolator::kTaps; ++j) {
+            long long index = static_cast<long long>(pos + j) - static_cast<long long>(kBefore);
+            if (index >= static_cast<long long>(loop_end)) {
+                index -= static_cast<long long>(loop_length);
+            } else if (near_start && index < static_cast<long long>(loop_start)) {
+                index += static_cast<long long>(loop_length);
+            }
+            window[j] = source[index]; // Frames just before 0 are the resource's silent padding
+        }
+        out[i] = interpolate(window + kBefore, fractions[i]);
+    }
+}
+
+void SamplerOscillator::processBlock(SignalBuffer* /*audio_inputs*/, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
+    const size_t n_frames = n_audio_frames; // Will always be lower than or equal to context->max_n_frames
+    if (!sample || finished) {
+        for (size_t c = 0; c < n_channels; ++c) {
+            writeSilence(outputs, c, n_frames);
+        }
+        frame_offset += n_frames;
+        return;
+    }
+
+    const ModInput pitch = getModInput(mod_inputs, EModChannel::kPitch);
+    const ModInput amplitude_mod = getModInput(mod_inputs, EModChannel::kAmplitude);
+    const bool flat_amplitude = amplitude_mod.isFlat();
+    const float flat_amp = (flat_amplitude) ? amplitude + amplitude_mod(frame_offset) : 0.f;
+    const float rate_ratio = sample->getSampleRate() / sample_rate;
+    const float root_note = sample->getRootNote();
+    const size_t n_sample_channels = sample->getNumChannels();
+
+    alignas(OS_SIMD_ALIGNMENT) float increments[kChunkFrames]; // Source frames per output frame
+    size_t positions[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float fractions[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float samples[kChunkFrames];
+
+    auto fillIncrements = [&](size_t first_frame, size_t n) {
+        if (pitch.isFlat()) {
+            std::fill(increments, increments + n, std::pow(2.f, (pitch(first_frame) + frequency_offset - root_note) / 12.f) * rate_ratio);
+            return;
+        }
+        const size_t n_padded = (n + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH * OS_SIMD_WIDTH;
+        for (size_t i = 0; i < n_padded; ++i) {
+            increments[i] = (pitch(first_frame + std::min(i, n - 1)) + frequency_offset - root_note) * (1.f / 12.f);
+        }
+        const os_simd_t ratio = OS_SIMD_SET1(rate_ratio);
+        for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE_ALIGNED(increments + i, OS_SIMD_MUL(simdExp2(OS_SIMD_LOAD_ALIGNED(increments + i)), ratio));
+        }
+    };
+
+    // Flat zero amplitude adds nothing; the sample only plays on
+    if (flat_amplitude && flat_amp == 0.f) {
+        for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+            const size_t n = std::min(kChunkFrames, n_frames - start);
+            fillIncrements(frame_offset + start, n);
+            size_t looped_from = 0;
+            advance(increments, positions, fractions, n, looped_from);
+        }
+        for (size_t c = 0; c < n_channels; ++c) {
+            writeSilence(outputs, c, n_frames);
+        }
+        frame_offset += n_frames;
+        return;
+    }
+
+    for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+        const size_t n = std::min(kChunkFrames, n_frames - start);
+        const size_t first_frame = frame_offset + start;
+        fillIncrements(first_frame, n);
+        size_t looped_from = 0;
+        const size_t n_playing = advance(increments, positions, fractions, n, looped_from);
+        const size_t cutoff = SincInterpolator::getCutoffForRatio(*std::max_element(increments, increments + n));
+
+        size_t rendered_channel = n_sample_channels; // None yet
+        for (size_t c = 0; c < n_channels; ++c) {
+            float* out_buffer = getOutputChannel(outputs, c, n_frames);
+            if (!out_buffer) {
+                continue;
+            }
+            const size_t source_channel = std::min(c, n_sample_channels - 1);
+            if (source_channel != rendered_channel) {
+                const float* source = sample->getChannel(source_channel);
+                switch (quality) {
+                    case EQuality::kSinc:
+                        readChannel<EQuality::kSinc>(source, positions, fractions, samples, n_playing, looped_from, cutoff);
+                        break;
+                    case EQuality::kHermite:
+                        readChannel<EQuality::kHermite>(source, positions, fractions, samples, n_playing, looped_from, cutoff);
+                        break;
+                    case EQuality::kCubic:
+                        readChannel<EQuality::kCubic>(source, positions, fractions, samples, n_playing, looped_from, cutoff);
+                        break;
+                }
+                std::fill(samples + n_playing, samples + n, 0.f);
+                for (size_t i = 0; i < n_playing; ++i) {
+                    samples[i] *= (flat_amplitude) ? flat_amp : amplitude + amplitude_mod(first_frame + i);
+                }
+                rendered_channel = source_channel;
+            }
+            if (overwrite_output) {
+                vectorCopy(out_buffer + first_frame, samples, n);
+            } else {
+                vectorAdd(out_buffer + first_frame, samples, n);
+            }
+        }
+    }
+    frame_offset += n_frames;
+}
+
+void SamplerOscillator::onSampleRateChange(float new_sample_rate) {
+    this->sample_rate = new_sample_rate;
+}
+
+void SamplerOscillator::copyStateFrom(const Oscillator& other) {
+    const SamplerOscillator& running = static_cast<const SamplerOscillator&>(other);
+    if (running.sample_id != sample_id) {
+        return; // A different sample starts over
+    }
+    position = running.position;
+    fraction = running.fraction;
+    looped = running.looped;
+    finished = running.finished;
+}
+}
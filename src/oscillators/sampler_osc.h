@@ -0,0 +1,68 @@
+// Sample playback oscillator
+#pragma once
+#include "../oscillator.h"
+#include "../resource_manager.h"
+
+/*
+Plays a sample resource, restarting at every new note. The played note sets the speed relative to the sample's
+root note (and its own sample rate), so the sample is resampled continuously; the read position is kept as a
+whole frame plus a fraction so long samples do not lose precision.
+
+The resampling quality is selectable:
+- kSinc: 32-point polyphase windowed sinc (SincInterpolator), with its cutoff lowered when playing above the
+  sample's own rate. Transparent, and the default.
+- kHermite: 6-point, 5th-order Hermite (interpolateHermite6).
+- kCubic: 4-point Hermite (interpolateCubic).
+
+A looping sample jumps back to its loop start at the loop end; interpolators reading across the loop boundary
+see the loop as continuous. A sample without a loop plays once and then stays silent until the next note.
+Output channel c plays sample channel c; channels past the sample's last channel repeat it.
+*/
+
+namespace OrangeSodium {
+class SamplerOscillator : public Oscillator {
+public:
+    enum class EQuality {
+        kCubic = 0,
+        kHermite,
+        kSinc
+    };
+
+    SamplerOscillator(Context* context, ObjectID id, ResourceID sample_id, size_t n_channels, float amplitude);
+    ~SamplerOscillator();
+
+    void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
+    void onSampleRateChange(float new_sample_rate) override;
+    void onRetrigger() override;
+    const char* getTypeName() const override { return "sampler_osc"; }
+    void copyStateFrom(const Oscillator& other) override;
+
+    void setQuality(EQuality new_quality) { quality = new_quality; }
+    EQuality getQuality() const { return quality; }
+    ResourceID getSampleResourceID() const { return sample_id; }
+
+    /// @brief Parse a quality name ("sinc", "hermite", "cubic"); returns false if unknown
+    static bool getQualityFromName(const char* name, EQuality& out);
+
+private:
+    static constexpr size_t kChunkFrames = 64;
+
+    ResourceID sample_id;
+    SampleResource* sample = nullptr;
+    EQuality quality = EQuality::kSinc;
+
+    size_t position = 0;   // Whole frames into the sample
+    float fraction = 0.f;  // [0, 1)
+    bool looped = false;   // The loop has wrapped at least once, so frames before the loop start now precede the loop end
+    bool finished = false; // Played to the end without a loop
+
+    /// @brief Advance the read position by n_frames frames at the given increments (source frames per frame),
+    /// recording the position of each frame and the first frame read after the loop wrapped (n_frames if none).
+    /// Returns the number of frames before the sample ran out.
+    size_t advance(const float* increments, size_t* positions, float* fractions, size_t n_frames, size_t& looped_from);
+
+    /// @brief Interpolate n_frames frames of one sample channel at the given positions
+    template <EQuality kQuality>
+    void readChannel(const float* source, const size_t* positions, const float* fractions, float* out, size_t n_frames, size_t looped_from, size_t cutoff) const;
+};
+}
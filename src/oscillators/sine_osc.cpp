@@ -1,9 +1,8 @@
 #include "sine_osc.h"
+#include "../dsp/fast_math.h"
+#include "../dsp/vector_ops.h"
 #include <cmath>
-
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+#include <algorithm>
 
 namespace OrangeSodium {
 SineOscillator::SineOscillator(Context* context, ObjectID id, size_t n_channels, float amplitude)
@@ -24,28 +23,147 @@ SineOscillator::~SineOscillator() {
 }
 
 
+void SineOscillator::fillIncrements(const ModInput& pitch, size_t first_frame, size_t n_frames, size_t n_padded, float* increments) const {
+    for (size_t i = 0; i < n_frames; ++i) {
+        increments[i] = pitch(first_frame + i) + frequency_offset;
+    }
+    for (size_t i = n_frames; i < n_padded; ++i) {
+        increments[i] = increments[n_frames - 1];
+    }
+    const os_simd_t inv_sample_rate = OS_SIMD_SET1(1.f / sample_rate);
+    for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+        OS_SIMD_STORE_ALIGNED(increments + i, OS_SIMD_MUL(simdMidiNoteToHz(OS_SIMD_LOAD_ALIGNED(increments + i)), inv_sample_rate));
+    }
+}
+
+template <bool kFlatPitch, bool kFlatAmplitude>
+void SineOscillator::processChannels(const ModInput& pitch, const ModInput& amplitude_mod, SignalBuffer* outputs, size_t n_frames) {
+    // Phase is kept in cycles, so wrapping is a subtraction of the integer part
+    const float flat_increment = (kFlatPitch) ? getHzFromMIDINote(pitch(frame_offset) + frequency_offset) / sample_rate : 0.f;
+    const float flat_amp = (kFlatAmplitude) ? amplitude + amplitude_mod(frame_offset) : 0.f;
+    const bool overwrite = overwrite_output;
+
+    alignas(OS_SIMD_ALIGNMENT) float increments[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float amps[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float phases[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float samples[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float lane_steps[OS_SIMD_WIDTH];
+    for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+        lane_steps[l] = static_cast<float>(l + 1);
+    }
+
+    // Every channel plays the same pitch, so channels in phase share one generated signal
+    bool shared_phase = true;
+    for (size_t c = 1; c < n_channels; ++c) {
+        shared_phase = shared_phase && phase[c] == phase[0];
+    }
+    const size_t n_generated = (shared_phase && n_channels > 0) ? 1 : n_channels;
+
+    // Flat zero amplitude adds nothing; only the phase moves
+    if (kFlatAmplitude && flat_amp == 0.f) {
+        for (size_t c = 0; c < n_generated; ++c) {
+            if constexpr (kFlatPitch) {
+                const float advanced = phase[c] + flat_increment * static_cast<float>(n_frames);
+                phase[c] = advanced - std::floor(advanced);
+            } else {
+                for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+                    const size_t n = std::min(kChunkFrames, n_frames - start);
+                    fillIncrements(pitch, frame_offset + start, n, (n + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH * OS_SIMD_WIDTH, increments);
+                    for (size_t i = 0; i < n; ++i) {
+                        phase[c] += increments[i];
+                    }
+                    phase[c] -= std::floor(phase[c]);
+                }
+            }
+        }
+        for (size_t c = 0; c < n_channels; ++c) {
+            if (shared_phase) {
+                phase[c] = phase[0];
+            }
+            writeSilence(outputs, c, n_frames);
+        }
+        return;
+    }
+
+    for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+        const size_t n = std::min(kChunkFrames, n_frames - start);
+        const size_t n_padded = (n + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH * OS_SIMD_WIDTH;
+        const size_t first_frame = frame_offset + start;
+
+        if constexpr (!kFlatPitch) {
+            fillIncrements(pitch, first_frame, n, n_padded, increments);
+        }
+        if constexpr (!kFlatAmplitude) {
+            for (size_t i = 0; i < n; ++i) {
+                amps[i] = amplitude + amplitude_mod(first_frame + i);
+            }
+            for (size_t i = n; i < n_padded; ++i) {
+                amps[i] = 0.f;
+            }
+        }
+
+        for (size_t c = 0; c < n_generated; ++c) {
+            // Phase of every frame of the chunk, wrapped to [0, 1)
+            if constexpr (kFlatPitch) {
+                const os_simd_t increment = OS_SIMD_SET1(flat_increment);
+                const os_simd_t lanes = OS_SIMD_LOAD_ALIGNED(lane_steps);
+                for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+                    const os_simd_t steps = OS_SIMD_ADD(lanes, OS_SIMD_SET1(static_cast<float>(i)));
+                    OS_SIMD_STORE_ALIGNED(phases + i, simdFrac(OS_SIMD_ADD(OS_SIMD_SET1(phase[c]), OS_SIMD_MUL(steps, increment))));
+                }
+            } else {
+                float p = phase[c];
+                for (size_t i = 0; i < n_padded; ++i) {
+                    p += increments[i];
+                    if (p >= 1.f) {
+                        p -= std::floor(p);
+                    }
+                    phases[i] = p;
+                }
+            }
+            phase[c] = phases[n - 1];
+
+            const os_simd_t flat_amp_v = OS_SIMD_SET1(flat_amp);
+            for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+                const os_simd_t amp = (kFlatAmplitude) ? flat_amp_v : OS_SIMD_LOAD_ALIGNED(amps + i);
+                OS_SIMD_STORE_ALIGNED(samples + i, OS_SIMD_MUL(amp, simdSin2Pi(OS_SIMD_LOAD_ALIGNED(phases + i))));
+            }
+
+            const size_t first_channel = (shared_phase) ? 0 : c;
+            const size_t end_channel = (shared_phase) ? n_channels : c + 1;
+            for (size_t out_c = first_channel; out_c < end_channel; ++out_c) {
+                phase[out_c] = phase[c];
+                float* out_buffer = getOutputChannel(outputs, out_c, n_frames);
+                if (!out_buffer) {
+                    continue;
+                }
+                if (overwrite) {
+                    vectorCopy(out_buffer + first_frame, samples, n);
+                } else {
+                    vectorAdd(out_buffer + first_frame, samples, n);
+                }
+            }
+        }
+    }
+}
+
 void SineOscillator::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
     const size_t n_frames = n_audio_frames; // Will always be lower than or equal to context->max_n_frames
 
-    // Get pitch buffer from mod_inputs
-    float* pitch_buffer = mod_inputs->getChannel(static_cast<size_t>(EModChannel::kPitch));
-    float* amplitude_buffer = mod_inputs->getChannel(static_cast<size_t>(EModChannel::kAmplitude));
-    const size_t pitch_buffer_divisions = mod_inputs->getChannelDivision(static_cast<size_t>(EModChannel::kPitch));
-    const size_t amplitude_buffer_divisions = mod_inputs->getChannelDivision(static_cast<size_t>(EModChannel::kAmplitude));
-    for(size_t c = 0; c < n_channels; ++c) {
-        float* out_buffer = outputs->getChannel(c);
-        if (!out_buffer) {
-            continue;
+    // Pick the inner loop once per sub-block from the channel hints
+    const ModInput pitch = getModInput(mod_inputs, EModChannel::kPitch);
+    const ModInput amplitude_mod = getModInput(mod_inputs, EModChannel::kAmplitude);
+    if (pitch.isFlat()) {
+        if (amplitude_mod.isFlat()) {
+            processChannels<true, true>(pitch, amplitude_mod, outputs, n_frames);
+        } else {
+            processChannels<true, false>(pitch, amplitude_mod, outputs, n_frames);
         }
-
-        for (size_t i = 0; i < n_frames; ++i) {
-            const float pitch_hz = getHzFromMIDINote(pitch_buffer[i / pitch_buffer_divisions] + frequency_offset);
-            const float pitch_norm = pitch_hz / (sample_rate);
-            float phase_increment = 2.0f * static_cast<float>(M_PI) * pitch_norm;
-            phase[c] += phase_increment;
-            phase[c] = std::fmod(phase[c], 2.0f * static_cast<float>(M_PI));
-            const float amp = amplitude + ((amplitude_buffer) ? amplitude_buffer[i / amplitude_buffer_divisions] : 0.0f);
-            out_buffer[i + frame_offset] += amp * std::sin(phase[c]);
+    } else {
+        if (amplitude_mod.isFlat()) {
+            processChannels<false, true>(pitch, amplitude_mod, outputs, n_frames);
+        } else {
+            processChannels<false, false>(pitch, amplitude_mod, outputs, n_frames);
         }
     }
     frame_offset += n_frames;
@@ -54,4 +172,12 @@ void SineOscillator::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_
 void SineOscillator::onSampleRateChange(float new_sample_rate) {
     this->sample_rate = new_sample_rate;
 }
+
+void SineOscillator::copyStateFrom(const Oscillator& other) {
+    const SineOscillator& running = static_cast<const SineOscillator&>(other);
+    const size_t n = std::min(n_channels, running.n_channels);
+    for (size_t c = 0; c < n; ++c) {
+        phase[c] = running.phase[c];
+    }
+}
 }
\ No newline at end of file
@@ -9,8 +9,21 @@ public:
 
     void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
     void onSampleRateChange(float new_sample_rate) override;
+    const char* getTypeName() const override { return "sine_osc"; }
+    void copyStateFrom(const Oscillator& other) override;
 
 private:
-    float* phase;
+    float* phase; // In cycles, [0, 1)
+
+    static constexpr size_t kChunkFrames = 64; // Frames generated per pass through the SIMD kernels; a multiple of OS_SIMD_WIDTH
+
+    /// @brief Inner loop, specialised on which modulation inputs are flat for the sub-block. Phases, pitch and sine
+    /// are computed OS_SIMD_WIDTH frames at a time, and channels with the same phase share one generated signal.
+    template <bool kFlatPitch, bool kFlatAmplitude>
+    void processChannels(const ModInput& pitch, const ModInput& amplitude_mod, SignalBuffer* outputs, size_t n_frames);
+
+    /// @brief Phase increments (in cycles) of a dynamic pitch channel for n_frames frames; the padding up to
+    /// n_padded repeats the last increment
+    void fillIncrements(const ModInput& pitch, size_t first_frame, size_t n_frames, size_t n_padded, float* increments) const;
 };
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+// Unison voice layout shared by the oscillators that run their voices in SIMD lanes
+#pragma once
+#include "../simd.h"
+#include <cmath>
+#include <cstddef>
+
+namespace OrangeSodium {
+
+/*
+An oscillator with unison runs n_voices copies of itself, one per SIMD lane, each detuned and panned. Voice k of
+n is offset by detune * (k / (n - 1) - 1/2) semitones and panned to spread * (2k / (n - 1) - 1), so the voices
+span the detune width and the stereo spread evenly. Lanes past n_voices have zero gain, so kernels can always
+process whole vectors.
+
+Panning uses the balance law (the far side is turned down, the near side stays at 1), so one centred voice
+plays at unity like an oscillator without unison. Voices are scaled by 1 / sqrt(n) to keep the loudness of
+uncorrelated voices constant. Outputs other than stereo get the unpanned sum on every channel.
+*/
+struct UnisonVoices {
+    static constexpr size_t kMaxVoices = 16;
+
+    size_t n_voices = 1;
+    size_t n_vectors = 1; // n_voices rounded up to whole vectors
+    float detune = 0.f;   // Total width in semitones
+    float spread = 0.f;   // Stereo spread [0, 1]
+
+    alignas(OS_SIMD_ALIGNMENT) float ratio[kMaxVoices];      // Frequency relative to the played note
+    alignas(OS_SIMD_ALIGNMENT) float gain_left[kMaxVoices];  // Gain into the first output channel (every channel unless stereo)
+    alignas(OS_SIMD_ALIGNMENT) float gain_right[kMaxVoices]; // Gain into the second output channel
+
+    UnisonVoices() { configure(1, 0.f, 0.f, 1); }
+
+    void configure(size_t voices, float detune_semitones, float stereo_spread, size_t n_channels) {
+        n_voices = (voices < 1) ? 1 : (voices > kMaxVoices) ? kMaxVoices : voices;
+        n_vectors = (n_voices + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH;
+        detune = detune_semitones;
+        spread = (stereo_spread < 0.f) ? 0.f : (stereo_spread > 1.f) ? 1.f : stereo_spread;
+
+        const float level = 1.f / std::sqrt(static_cast<float>(n_voices));
+        for (size_t k = 0; k < kMaxVoices; ++k) {
+            if (k >= n_voices) {
+                ratio[k] = 1.f;
+                gain_left[k] = 0.f;
+                gain_right[k] = 0.f;
+                continue;
+            }
+            const float position = (n_voices > 1) ? static_cast<float>(k) / static_cast<float>(n_voices - 1) : 0.5f;
+            ratio[k] = std::pow(2.f, detune * (position - 0.5f) / 12.f);
+            const float pan = (n_channels == 2) ? spread * (2.f * position - 1.f) : 0.f;
+            gain_left[k] = level * ((pan > 0.f) ? 1.f - pan : 1.f);
+            gain_right[k] = level * ((pan < 0.f) ? 1.f + pan : 1.f);
+        }
+    }
+
+    /// @brief Start phase of voice k, in cycles. Spread by the golden ratio so voices do not start in phase; voice 0 starts at 0.
+    static float getStartPhase(size_t k) {
+        const float phase = static_cast<float>(k) * 0.6180339887f;
+        return phase - std::floor(phase);
+    }
+
+    float getMaxRatio() const {
+        float max_ratio = 1.f;
+        for (size_t k = 0; k < n_voices; ++k) {
+            max_ratio = (ratio[k] > max_ratio) ? ratio[k] : max_ratio;
+        }
+        return max_ratio;
+    }
+};
+
+}
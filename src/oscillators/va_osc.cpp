@@ -0,0 +1,336 @@
+#include "va_osc.h"
+#include "../dsp/fast_math.h"
+#include "../dsp/vector_ops.h"
+#include <algorithm>
+#include <cstring>
+
+namespace OrangeSodium {
+
+static constexpr float kMaxIncrement = 0.49f; // Events must be at least a sample apart for the two-sample residuals
+
+static inline os_simd_t simdAbs(os_simd_t x) {
+#ifdef OS_AVX
+    return _mm256_andnot_ps(OS_SIMD_SET1(-0.f), x);
+#else
+    return _mm_andnot_ps(OS_SIMD_SET1(-0.f), x);
+#endif
+}
+
+static inline os_simd_t simdAnd(os_simd_t a, os_simd_t b) {
+#ifdef OS_AVX
+    return _mm256_and_ps(a, b);
+#else
+    return _mm_and_ps(a, b);
+#endif
+}
+
+/// @brief x where mask is set, else 0
+static inline os_simd_t simdMask(os_simd_t mask, os_simd_t x) {
+    return simdAnd(mask, x);
+}
+
+template <VAOscillator::EShape kShape>
+static inline os_simd_t naiveShape(os_simd_t t, os_simd_t width) {
+    if constexpr (kShape == VAOscillator::EShape::kSaw) {
+        return OS_SIMD_SUB(OS_SIMD_ADD(t, t), OS_SIMD_SET1(1.f));
+    } else if constexpr (kShape == VAOscillator::EShape::kPulse) {
+        return OS_SIMD_BLEND(OS_SIMD_CMPLT(t, width), OS_SIMD_SET1(-1.f), OS_SIMD_SET1(1.f));
+    } else {
+        return OS_SIMD_SUB(OS_SIMD_SET1(1.f), OS_SIMD_MUL(OS_SIMD_SET1(4.f), simdAbs(OS_SIMD_SUB(t, OS_SIMD_SET1(0.5f)))));
+    }
+}
+
+/// @brief Slope of the triangle in value per cycle
+static inline os_simd_t triangleSlope(os_simd_t t) {
+    return OS_SIMD_BLEND(OS_SIMD_CMPLT(t, OS_SIMD_SET1(0.5f)), OS_SIMD_SET1(-4.f), OS_SIMD_SET1(4.f));
+}
+
+/// @brief Add the PolyBLEP residuals of a jump of height h, a fraction a of the way to the next sample
+static inline void addBlep(os_simd_t mask, os_simd_t a, os_simd_t h, os_simd_t& pre, os_simd_t& post) {
+    const os_simd_t half_h = OS_SIMD_MUL(OS_SIMD_SET1(0.5f), h);
+    const os_simd_t b = OS_SIMD_SUB(OS_SIMD_SET1(1.f), a);
+    pre = OS_SIMD_ADD(pre, simdMask(mask, OS_SIMD_MUL(half_h, OS_SIMD_MUL(b, b))));
+    post = OS_SIMD_SUB(post, simdMask(mask, OS_SIMD_MUL(half_h, OS_SIMD_MUL(a, a))));
+}
+
+/// @brief Add the PolyBLAMP residuals of a change of slope s (in value per sample), a fraction a of the way to the next sample
+static inline void addBlamp(os_simd_t mask, os_simd_t a, os_simd_t s, os_simd_t& pre, os_simd_t& post) {
+    const os_simd_t sixth_s = OS_SIMD_MUL(OS_SIMD_SET1(1.f / 6.f), s);
+    const os_simd_t b = OS_SIMD_SUB(OS_SIMD_SET1(1.f), a);
+    pre = OS_SIMD_ADD(pre, simdMask(mask, OS_SIMD_MUL(sixth_s, OS_SIMD_MUL(b, OS_SIMD_MUL(b, b)))));
+    post = OS_SIMD_ADD(post, simdMask(mask, OS_SIMD_MUL(sixth_s, OS_SIMD_MUL(a, OS_SIMD_MUL(a, a)))));
+}
+
+VAOscillator::VAOscillator(Context* context, ObjectID id, EShape shape, size_t n_channels, float amplitude)
+    : Oscillator(context, id, n_channels, amplitude), shape(shape) {
+    for (size_t k = 0; k < UnisonVoices::kMaxVoices; ++k) {
+        phase[k] = UnisonVoices::getStartPhase(k);
+        master_phase[k] = 0.f;
+        carry[k] = 0.f;
+    }
+    unison.configure(1, 0.f, 0.f, n_channels);
+
+    // Add modulation source names
+    modulation_source_names.resize(0);
+    modulation_source_names.push_back("pitch");
+    modulation_source_names.push_back("amplitude");
+    modulation_source_names.push_back("pulse_width");
+    modulation_source_names.push_back("sync");
+}
+
+VAOscillator::~VAOscillator() {}
+
+void VAOscillator::setUnison(size_t n_voices, float detune_semitones, float stereo_spread) {
+    unison.configure(n_voices, detune_semitones, stereo_spread, n_channels);
+}
+
+bool VAOscillator::getShapeFromName(const char* name, EShape& out) {
+    if (std::strcmp(name, "saw") == 0 || std::strcmp(name, "sawtooth") == 0) {
+        out = EShape::kSaw;
+    } else if (std::strcmp(name, "pulse") == 0 || std::strcmp(name, "square") == 0) {
+        out = EShape::kPulse;
+    } else if (std::strcmp(name, "triangle") == 0) {
+        out = EShape::kTriangle;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+template <VAOscillator::EShape kShape, bool kSync>
+void VAOscillator::renderChunk(const float* increments, const float* widths, const float* sync_ratios, float* left, float* right, size_t n_frames) {
+    const os_simd_t zero = OS_SIMD_SET1(0.f);
+    const os_simd_t one = OS_SIMD_SET1(1.f);
+    const os_simd_t half = OS_SIMD_SET1(0.5f);
+    const os_simd_t max_increment = OS_SIMD_SET1(kMaxIncrement);
+
+    os_simd_t sums_left[kChunkFrames];
+    os_simd_t sums_right[kChunkFrames];
+    for (size_t i = 0; i < n_frames; ++i) {
+        sums_left[i] = zero;
+        sums_right[i] = zero;
+    }
+
+    for (size_t v = 0; v < unison.n_vectors; ++v) {
+        const size_t k = v * OS_SIMD_WIDTH;
+        const os_simd_t ratio = OS_SIMD_LOAD_ALIGNED(unison.ratio + k);
+        const os_simd_t gain_left = OS_SIMD_LOAD_ALIGNED(unison.gain_left + k);
+        const os_simd_t gain_right = OS_SIMD_LOAD_ALIGNED(unison.gain_right + k);
+        os_simd_t t = OS_SIMD_LOAD_ALIGNED(phase + k);
+        os_simd_t m = OS_SIMD_LOAD_ALIGNED(master_phase + k);
+        os_simd_t c = OS_SIMD_LOAD_ALIGNED(carry + k);
+
+        for (size_t i = 0; i < n_frames; ++i) {
+            const os_simd_t dm = OS_SIMD_MIN(OS_SIMD_MUL(OS_SIMD_SET1(increments[i]), ratio), max_increment);
+            const os_simd_t ds = (kSync) ? OS_SIMD_MIN(OS_SIMD_MUL(dm, OS_SIMD_SET1(sync_ratios[i])), max_increment) : dm;
+            const os_simd_t inv_ds = OS_SIMD_DIV(one, ds);
+            // Keep both pulse edges at least a sample from the reset
+            const os_simd_t width = (kShape == EShape::kPulse) ? OS_SIMD_MIN(OS_SIMD_MAX(OS_SIMD_SET1(widths[i]), ds), OS_SIMD_SUB(one, ds)) : half;
+
+            const os_simd_t y = OS_SIMD_ADD(naiveShape<kShape>(t, width), c);
+            const os_simd_t next = OS_SIMD_ADD(t, ds);
+
+            // Events of the free-running cycle between this sample and the next
+            os_simd_t pre = zero;
+            os_simd_t post = zero;
+            const os_simd_t wrap = OS_SIMD_CMPGE(next, one);
+            const os_simd_t a_wrap = OS_SIMD_MUL(OS_SIMD_SUB(one, t), inv_ds);
+            if constexpr (kShape == EShape::kSaw) {
+                addBlep(wrap, a_wrap, OS_SIMD_SET1(-2.f), pre, post);
+            } else if constexpr (kShape == EShape::kPulse) {
+                addBlep(wrap, a_wrap, OS_SIMD_SET1(2.f), pre, post);
+                const os_simd_t edge = simdAnd(OS_SIMD_CMPLT(t, width), OS_SIMD_CMPGE(next, width));
+                addBlep(edge, OS_SIMD_MUL(OS_SIMD_SUB(width, t), inv_ds), OS_SIMD_SET1(-2.f), pre, post);
+            } else {
+                addBlamp(wrap, a_wrap, OS_SIMD_MUL(OS_SIMD_SET1(8.f), ds), pre, post);
+                const os_simd_t corner = simdAnd(OS_SIMD_CMPLT(t, half), OS_SIMD_CMPGE(next, half));
+                addBlamp(corner, OS_SIMD_MUL(OS_SIMD_SUB(half, t), inv_ds), OS_SIMD_MUL(OS_SIMD_SET1(-8.f), ds), pre, post);
+            }
+            os_simd_t next_phase = OS_SIMD_SUB(next, simdMask(wrap, one));
+
+            if constexpr (kSync) {
+                // The master wraps before the next sample: the cycle restarts from wherever it had got to
+                const os_simd_t next_m = OS_SIMD_ADD(m, dm);
+                const os_simd_t reset = OS_SIMD_CMPGE(next_m, one);
+                const os_simd_t a_reset = OS_SIMD_DIV(OS_SIMD_SUB(one, m), dm);
+                const os_simd_t t_reset = simdFrac(OS_SIMD_ADD(t, OS_SIMD_MUL(a_reset, ds)));
+                os_simd_t sync_pre = zero;
+                os_simd_t sync_post = zero;
+                addBlep(reset, a_reset, OS_SIMD_SUB(naiveShape<kShape>(zero, width), naiveShape<kShape>(t_reset, width)), sync_pre, sync_post);
+                if constexpr (kShape == EShape::kTriangle) {
+                    addBlamp(reset, a_reset, OS_SIMD_MUL(OS_SIMD_SUB(triangleSlope(zero), triangleSlope(t_reset)), ds), sync_pre, sync_post);
+                }
+                // Events of the free-running cycle are dropped on a reset sample
+                pre = OS_SIMD_BLEND(reset, pre, sync_pre);
+                post = OS_SIMD_BLEND(reset, post, sync_post);
+                next_phase = OS_SIMD_BLEND(reset, next_phase, OS_SIMD_MUL(OS_SIMD_SUB(one, a_reset), ds));
+                m = OS_SIMD_SUB(next_m, simdMask(reset, one));
+            }
+
+            const os_simd_t sample = OS_SIMD_ADD(y, pre);
+            sums_left[i] = OS_SIMD_ADD(sums_left[i], OS_SIMD_MUL(sample, gain_left));
+            sums_right[i] = OS_SIMD_ADD(sums_right[i], OS_SIMD_MUL(sample, gain_right));
+            c = post;
+            t = next_phase;
+        }
+        OS_SIMD_STORE_ALIGNED(phase + k, t);
+        OS_SIMD_STORE_ALIGNED(master_phase + k, m);
+        OS_SIMD_STORE_ALIGNED(carry + k, c);
+    }
+
+    alignas(OS_SIMD_ALIGNMENT) float lanes[OS_SIMD_WIDTH];
+    for (size_t i = 0; i < n_frames; ++i) {
+        OS_SIMD_STORE_ALIGNED(lanes, sums_left[i]);
+        float sum = 0.f;
+        for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+            sum += lanes[l];
+        }
+        left[i] = sum;
+        OS_SIMD_STORE_ALIGNED(lanes, sums_right[i]);
+        sum = 0.f;
+        for (size_t l = 0; l < OS_SIMD_WIDTH; ++l) {
+            sum += lanes[l];
+        }
+        right[i] = sum;
+    }
+}
+
+void VAOscillator::skipFrames(float total_increment, float sync_ratio, bool sync) {
+    for (size_t l = 0; l < unison.n_voices; ++l) {
+        const float master_advance = total_increment * unison.ratio[l];
+        const float next_m = master_phase[l] + master_advance;
+        if (sync && next_m >= 1.f) {
+            // Time since the last master wrap, at the synced rate
+            const float since_reset = next_m - std::floor(next_m);
+            phase[l] = since_reset * sync_ratio;
+        } else {
+            phase[l] += master_advance * ((sync) ? sync_ratio : 1.f);
+        }
+        phase[l] -= std::floor(phase[l]);
+        master_phase[l] = next_m - std::floor(next_m);
+        carry[l] = 0.f;
+    }
+}
+
+void VAOscillator::processBlock(SignalBuffer* /*audio_inputs*/, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
+    const size_t n_frames = n_audio_frames; // Will always be lower than or equal to context->max_n_frames
+    const ModInput pitch = getModInput(mod_inputs, EModChannel::kPitch);
+    const ModInput amplitude_mod = getModInput(mod_inputs, EModChannel::kAmplitude);
+    const ModInput width_mod = getModInput(mod_inputs, static_cast<EModChannel>(EVAModChannel::kPulseWidth));
+    const ModInput sync_mod = getModInput(mod_inputs, static_cast<EModChannel>(EVAModChannel::kSync));
+    const bool flat_amplitude = amplitude_mod.isFlat();
+    const float flat_amp = (flat_amplitude) ? amplitude + amplitude_mod(frame_offset) : 0.f;
+    const bool sync = !(sync_mod.isFlat() && sync_mod(frame_offset) <= 0.f);
+
+    alignas(OS_SIMD_ALIGNMENT) float increments[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float widths[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float sync_ratios[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float left[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float right[kChunkFrames];
+
+    // Phase increment (in cycles) and sync ratio of every frame of a chunk
+    auto fillChunk = [&](size_t first_frame, size_t n) {
+        const size_t n_padded = (n + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH * OS_SIMD_WIDTH;
+        if (pitch.isFlat()) {
+            std::fill(increments, increments + n_padded, getHzFromMIDINote(pitch(first_frame) + frequency_offset) / sample_rate);
+        } else {
+            for (size_t i = 0; i < n_padded; ++i) {
+                increments[i] = pitch(first_frame + std::min(i, n - 1)) + frequency_offset;
+            }
+            const os_simd_t inv_sample_rate = OS_SIMD_SET1(1.f / sample_rate);
+            for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+                OS_SIMD_STORE_ALIGNED(increments + i, OS_SIMD_MUL(simdMidiNoteToHz(OS_SIMD_LOAD_ALIGNED(increments + i)), inv_sample_rate));
+            }
+        }
+        if (sync) {
+            for (size_t i = 0; i < n_padded; ++i) {
+                sync_ratios[i] = std::max(sync_mod(first_frame + std::min(i, n - 1)), 0.f) * (1.f / 12.f);
+            }
+            for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+                OS_SIMD_STORE_ALIGNED(sync_ratios + i, simdExp2(OS_SIMD_LOAD_ALIGNED(sync_ratios + i)));
+            }
+        }
+        if (shape == EShape::kPulse) {
+            for (size_t i = 0; i < n; ++i) {
+                widths[i] = pulse_width + width_mod(first_frame + i);
+            }
+        }
+    };
+
+    // Flat zero amplitude adds nothing; the phases only move on
+    if (flat_amplitude && flat_amp == 0.f) {
+        float total_increment = 0.f;
+        float sync_ratio = 1.f;
+        for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+            const size_t n = std::min(kChunkFrames, n_frames - start);
+            fillChunk(frame_offset + start, n);
+            for (size_t i = 0; i < n; ++i) {
+                total_increment += increments[i];
+            }
+            sync_ratio = (sync) ? sync_ratios[n - 1] : 1.f;
+        }
+        skipFrames(total_increment, sync_ratio, sync);
+        for (size_t c = 0; c < n_channels; ++c) {
+            writeSilence(outputs, c, n_frames);
+        }
+        frame_offset += n_frames;
+        return;
+    }
+
+    for (size_t start = 0; start < n_frames; start += kChunkFrames) {
+        const size_t n = std::min(kChunkFrames, n_frames - start);
+        const size_t first_frame = frame_offset + start;
+        fillChunk(first_frame, n);
+
+        switch (shape) {
+            case EShape::kSaw:
+                (sync) ? renderChunk<EShape::kSaw, true>(increments, widths, sync_ratios, left, right, n)
+                       : renderChunk<EShape::kSaw, false>(increments, widths, sync_ratios, left, right, n);
+                break;
+            case EShape::kPulse:
+                (sync) ? renderChunk<EShape::kPulse, true>(increments, widths, sync_ratios, left, right, n)
+                       : renderChunk<EShape::kPulse, false>(increments, widths, sync_ratios, left, right, n);
+                break;
+            case EShape::kTriangle:
+                (sync) ? renderChunk<EShape::kTriangle, true>(increments, widths, sync_ratios, left, right, n)
+                       : renderChunk<EShape::kTriangle, false>(increments, widths, sync_ratios, left, right, n);
+                break;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            const float amp = (flat_amplitude) ? flat_amp : amplitude + amplitude_mod(first_frame + i);
+            left[i] *= amp;
+            right[i] *= amp;
+        }
+
+        // Stereo outputs get the panned voices; any other layout gets the same sum on every channel
+        for (size_t c = 0; c < n_channels; ++c) {
+            float* out_buffer = getOutputChannel(outputs, c, n_frames);
+            if (!out_buffer) {
+                continue;
+            }
+            const float* samples = (c == 1 && n_channels == 2) ? right : left;
+            if (overwrite_output) {
+                vectorCopy(out_buffer + first_frame, samples, n);
+            } else {
+                vectorAdd(out_buffer + first_frame, samples, n);
+            }
+        }
+    }
+    frame_offset += n_frames;
+}
+
+void VAOscillator::onSampleRateChange(float new_sample_rate) {
+    this->sample_rate = new_sample_rate;
+}
+
+void VAOscillator::copyStateFrom(const Oscillator& other) {
+    const VAOscillator& running = static_cast<const VAOscillator&>(other);
+    for (size_t l = 0; l < UnisonVoices::kMaxVoices; ++l) {
+        phase[l] = running.phase[l];
+        master_phase[l] = running.master_phase[l];
+        // A different shape would jump anyway; its pending residual would not match
+        carry[l] = (running.shape == shape) ? running.carry[l] : 0.f;
+    }
+}
+}
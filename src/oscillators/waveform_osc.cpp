@@ -1,31 +1,31 @@
 #include "waveform_osc.h"
 #include "constants.h"
+#include "../dsp/fast_math.h"
+#include "../dsp/interpolation.h"
+#include "../dsp/vector_ops.h"
+#include <algorithm>
+#include <cstring>
 namespace OrangeSodium {
 
 WaveformOscillator::WaveformOscillator(Context* context, ObjectID id, ResourceID waveform_id, size_t n_channels, float amplitude)
-    : Oscillator(context, id, n_channels, amplitude), waveform_resource_id(waveform_id), phase(nullptr), playback_buffer(nullptr) {
+    : Oscillator(context, id, n_channels, amplitude), waveform_resource_id(waveform_id), playback_storage(nullptr), playback_buffer(nullptr) {
     fft_manager = context->waveform_fft_manager;
-    // Initialize playback buffer
-    playback_buffer = new float[WAVEFORM_STANDARD_LENGTH];
-    for (size_t i = 0; i < WAVEFORM_STANDARD_LENGTH; ++i) {
-        playback_buffer[i] = 0.0f;
+    // Initialize playback buffer, with guard points on both sides so interpolation never wraps
+    playback_storage = new float[kGuardBefore + WAVEFORM_STANDARD_LENGTH + kGuardAfter];
+    for (size_t i = 0; i < kGuardBefore + WAVEFORM_STANDARD_LENGTH + kGuardAfter; ++i) {
+        playback_storage[i] = 0.0f;
     }
+    playback_buffer = playback_storage + kGuardBefore;
 
     source_buffer = m_context->resource_manager->getWaveformBuffer(waveform_resource_id);
-    phase = new float[n_channels];
-    fft_tick = new int[n_channels];
-    last_pitch = new float[n_channels];
-    last_fft_pitch = new float[n_channels];
-    bin_cutoff = new int[n_channels];
-    for (size_t c = 0; c < n_channels; ++c) {
-        phase[c] = 0.0f;
-        fft_tick[c] = 0;
-        last_pitch[c] = 0.0f;
-        last_fft_pitch[c] = 0.0f;
-        bin_cutoff[c] = 0;
+    for (size_t k = 0; k < UnisonVoices::kMaxVoices; ++k) {
+        phase[k] = UnisonVoices::getStartPhase(k);
     }
+    last_pitch = 0.0f;
+    bin_cutoff = 0;
     copyWaveformToPlaybackBuffer();
     bins_allowed_above_nyquist = 5.f;
+    unison.configure(1, 0.f, 0.f, n_channels);
 
 
     // Add modulation source names
@@ -35,35 +35,62 @@ WaveformOscillator::WaveformOscillator(Context* context, ObjectID id, ResourceID
 }
 
 WaveformOscillator::~WaveformOscillator() {
-    if (playback_buffer) {
-        delete[] playback_buffer;
+    if (playback_storage) {
+        delete[] playback_storage;
+        playback_storage = nullptr;
         playback_buffer = nullptr;
     }
-    if (phase) {
-        delete[] phase;
-        phase = nullptr;
-    }
-    if (fft_tick) {
-        delete[] fft_tick;
-        fft_tick = nullptr;
-    }
-    if (last_pitch) {
-        delete[] last_pitch;
-        last_pitch = nullptr;
-    }
-    if (last_fft_pitch) {
-        delete[] last_fft_pitch;
-        last_fft_pitch = nullptr;
-    }
-    if (bin_cutoff) {
-        delete[] bin_cutoff;
-        bin_cutoff = nullptr;
-    }
 }
 
 void WaveformOscillator::onSampleRateChange(float new_sample_rate) {
     sample_rate = new_sample_rate;
+    bin_cutoff = 0; // Nyquist moved
+}
+
+void WaveformOscillator::setUnison(size_t n_voices, float detune_semitones, float stereo_spread) {
+    unison.configure(n_voices, detune_semitones, stereo_spread, n_channels);
+    bin_cutoff = 0; // The highest voice may have moved
+}
+
+WaveformOscillator::EInterpolation WaveformOscillator::getEffectiveInterpolation() const {
+    if (interpolation != EInterpolation::kDefault) {
+        return interpolation;
+    }
+    switch (m_context->audio_quality) {
+    case kLowQuality:
+        return EInterpolation::kLinear;
+    case kMediumQuality:
+        return EInterpolation::kCubic;
+    default:
+        return EInterpolation::kHermite6;
+    }
+}
+
+bool WaveformOscillator::getInterpolationFromName(const char* name, EInterpolation& out) {
+    if (std::strcmp(name, "default") == 0) {
+        out = EInterpolation::kDefault;
+    } else if (std::strcmp(name, "linear") == 0) {
+        out = EInterpolation::kLinear;
+    } else if (std::strcmp(name, "cubic") == 0) {
+        out = EInterpolation::kCubic;
+    } else if (std::strcmp(name, "catmull_rom") == 0) {
+        out = EInterpolation::kCatmullRom;
+    } else if (std::strcmp(name, "hermite6") == 0) {
+        out = EInterpolation::kHermite6;
+    } else {
+        return false;
+    }
+    return true;
+}
 
+void WaveformOscillator::copyStateFrom(const Oscillator& other) {
+    const WaveformOscillator& running = static_cast<const WaveformOscillator&>(other);
+    for (size_t k = 0; k < UnisonVoices::kMaxVoices; ++k) {
+        phase[k] = running.phase[k];
+    }
+    last_pitch = running.last_pitch;
+    // The waveform may have changed, so the playback buffer is band-limited again on the next sample
+    bin_cutoff = 0;
 }
 
 void WaveformOscillator::copyWaveformToPlaybackBuffer(){
@@ -81,63 +108,186 @@ void WaveformOscillator::copyWaveformToPlaybackBuffer(){
     for(size_t i = 0; i < WAVEFORM_STANDARD_LENGTH; ++i){
         playback_buffer[i] = source_buffer[i];
     }
-
+    fillGuardPoints();
 }
 
-void WaveformOscillator::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
-    const size_t n_frames = n_audio_frames; // Will always be lower than or equal to context->max_n_frames
+void WaveformOscillator::fillGuardPoints() {
+    for (size_t i = 1; i <= kGuardBefore; ++i) {
+        playback_buffer[-static_cast<ptrdiff_t>(i)] = playback_buffer[WAVEFORM_STANDARD_LENGTH - i];
+    }
+    for (size_t i = 0; i < kGuardAfter; ++i) {
+        playback_buffer[WAVEFORM_STANDARD_LENGTH + i] = playback_buffer[i];
+    }
+}
 
-    // Get pitch buffer from mod_inputs
-    float* pitch_buffer = mod_inputs->getChannel(static_cast<size_t>(EModChannel::kPitch));
-    float* amplitude_buffer = mod_inputs->getChannel(static_cast<size_t>(EModChannel::kAmplitude));
-    const size_t pitch_buffer_divisions = mod_inputs->getChannelDivision(static_cast<size_t>(EModChannel::kPitch));
-    const size_t amplitude_buffer_divisions = mod_inputs->getChannelDivision(static_cast<size_t>(EModChannel::kAmplitude));
-    for(size_t c = 0; c < n_channels; ++c) {
-        float* out_buffer = outputs->getChannel(c);
-        if (!out_buffer) {
-            continue;
+void WaveformOscillator::updatePlaybackBuffer(float max_pitch_hz) {
+    // We need to update playback_buffer if the pitch has changed too far from the one it was band-limited for
+    const float bins_above_nyq = getBinsAboveNyquistForFrequency(max_pitch_hz, bin_cutoff);
+    if(bin_cutoff == 0 || bins_above_nyq < 1.f || bins_above_nyq > bins_allowed_above_nyquist){
+        // We need to update the playback buffer so that its bins above nyquist is equal to bins_allowed_above_nyquist
+        bin_cutoff = getBinCutoffForFrequency(max_pitch_hz) + static_cast<int>(bins_allowed_above_nyquist);
+        if (source_buffer && fft_manager) {
+            fft_manager->brickwallWaveform(source_buffer, playback_buffer, bin_cutoff);
+            fillGuardPoints();
         }
+    }
+}
 
+template <WaveformOscillator::EInterpolation kMode>
+void WaveformOscillator::renderChunk(const float* increments, float* left, float* right, size_t n_frames) {
+    const os_simd_t table_length = OS_SIMD_SET1(static_cast<float>(WAVEFORM_STANDARD_LENGTH));
+    const bool stereo = (n_channels == 2);
+
+    alignas(OS_SIMD_ALIGNMENT) os_simd_t sums_left[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) os_simd_t sums_right[kChunkFrames];
+    for (size_t i = 0; i < n_frames; ++i) {
+        sums_left[i] = OS_SIMD_SET1(0.f);
+        sums_right[i] = OS_SIMD_SET1(0.f);
+    }
+
+    alignas(OS_SIMD_ALIGNMENT) int indices[OS_SIMD_WIDTH];
+    for (size_t v = 0; v < unison.n_vectors; ++v) {
+        const size_t k = v * OS_SIMD_WIDTH;
+        const os_simd_t ratio = OS_SIMD_LOAD_ALIGNED(unison.ratio + k);
+        const os_simd_t gain_left = OS_SIMD_LOAD_ALIGNED(unison.gain_left + k);
+        const os_simd_t gain_right = OS_SIMD_LOAD_ALIGNED(unison.gain_right + k);
+        os_simd_t p = OS_SIMD_LOAD_ALIGNED(phase + k);
 
         for (size_t i = 0; i < n_frames; ++i) {
-            // Determine if we need to update the playback buffer based on pitch change
-            // We need to update playback_buffer if the pitch has changed too far from last_fft_pitch
-
-
-            const float pitch_hz = getHzFromMIDINote(pitch_buffer[(i + frame_offset) / pitch_buffer_divisions] + frequency_offset);
-            if(fft_tick[c] >= 4){
-                const float bins_above_nyq = getBinsAboveNyquistForFrequency(pitch_hz, bin_cutoff[c]);
-                if(bins_above_nyq < 1.f || bins_above_nyq > bins_allowed_above_nyquist){
-                    // We need to update the playback buffer so that its bins above nyquist is equal to bins_allowed_above_nyquist
-                    bin_cutoff[c] = getBinCutoffForFrequency(pitch_hz) + static_cast<int>(bins_allowed_above_nyquist);
-                    fft_manager->brickwallWaveform(source_buffer, playback_buffer, bin_cutoff[c]);
-                }
-                fft_tick[c] = 0;
+            p = simdFrac(OS_SIMD_ADD(p, OS_SIMD_MUL(OS_SIMD_SET1(increments[i]), ratio)));
+            // The phase is in [0, 1], so the index is in [0, table length] and the guard points cover every neighbour
+            const os_simd_t position = OS_SIMD_MUL(p, table_length);
+            const os_simd_t frac = OS_SIMD_SUB(position, simdFloorToIndices(position, indices));
+            os_simd_t sample;
+            if constexpr (kMode == EInterpolation::kLinear) {
+                os_simd_t x0, x1;
+                simdGather2(playback_buffer, indices, x0, x1);
+                sample = simdInterpolateLinear(x0, x1, frac);
+            } else if constexpr (kMode == EInterpolation::kHermite6) {
+                os_simd_t x[8];
+                simdGather4(playback_buffer - 2, indices, x);
+                simdGather4(playback_buffer + 2, indices, x + 4);
+                sample = simdInterpolateHermite6(x, frac);
+            } else {
+                os_simd_t x[4];
+                simdGather4(playback_buffer - 1, indices, x);
+                sample = (kMode == EInterpolation::kCubic) ? simdInterpolateLagrange4(x[0], x[1], x[2], x[3], frac)
+                                                           : simdInterpolateCatmullRom(x[0], x[1], x[2], x[3], frac);
+            }
+            sums_left[i] = OS_SIMD_ADD(sums_left[i], OS_SIMD_MUL(sample, gain_left));
+            if (stereo) {
+                sums_right[i] = OS_SIMD_ADD(sums_right[i], OS_SIMD_MUL(sample, gain_right));
             }
-            const float pitch_norm = pitch_hz / (sample_rate);
-            float phase_increment = pitch_norm;
-            phase[c] += phase_increment;
-            phase[c] = std::fmod(phase[c], 1.f);
-            const float amp = amplitude + ((amplitude_buffer) ? amplitude_buffer[(i + frame_offset) / amplitude_buffer_divisions] : 0.0f);
-            out_buffer[i + frame_offset] += amp * getSampleFromWaveform(phase[c]);
-
-            fft_tick[c]++;
-            last_pitch[c] = pitch_hz;
         }
+        OS_SIMD_STORE_ALIGNED(phase + k, p);
+    }
+
+    vectorHorizontalSums(sums_left, left, n_frames);
+    if (stereo) {
+        vectorHorizontalSums(sums_right, right, n_frames);
     }
-    frame_offset += n_frames;
 }
 
-float WaveformOscillator::getSampleFromWaveform(float phase_position) {
-    // phase_position is in [0, 1)
-    float index = phase_position * static_cast<float>(WAVEFORM_STANDARD_LENGTH);
-    size_t index_int = static_cast<size_t>(index);
-    float frac = index - static_cast<float>(index_int);
-    size_t index_next = (index_int + 1) % WAVEFORM_STANDARD_LENGTH;
+void WaveformOscillator::processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
+    const size_t n_frames = n_audio_frames; // Will always be lower than or equal to context->max_n_frames
+    const ModInput pitch = getModInput(mod_inputs, EModChannel::kPitch);
+    const ModInput amplitude_mod = getModInput(mod_inputs, EModChannel::kAmplitude);
+    const bool flat_pitch = pitch.isFlat();
+    const bool flat_amplitude = amplitude_mod.isFlat();
+    const float flat_amp = (flat_amplitude) ? amplitude + amplitude_mod(frame_offset) : 0.f;
+    const size_t chunk_frames = (flat_pitch) ? kChunkFrames : kDynamicPitchFrames;
+    const float max_ratio = unison.getMaxRatio();
+    const EInterpolation mode = getEffectiveInterpolation();
+
+    alignas(OS_SIMD_ALIGNMENT) float increments[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float left[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float right[kChunkFrames];
+
+    // Phase increment (in cycles) of the played note for every frame of a chunk
+    auto fillIncrements = [&](size_t first_frame, size_t n) {
+        if (flat_pitch) {
+            // One pow per sub-block instead of one per sample
+            std::fill(increments, increments + n, getHzFromMIDINote(pitch(first_frame) + frequency_offset) / sample_rate);
+            return;
+        }
+        const size_t n_padded = (n + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH * OS_SIMD_WIDTH;
+        for (size_t i = 0; i < n_padded; ++i) {
+            increments[i] = pitch(first_frame + std::min(i, n - 1)) + frequency_offset;
+        }
+        const os_simd_t inv_sample_rate = OS_SIMD_SET1(1.f / sample_rate);
+        for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE_ALIGNED(increments + i, OS_SIMD_MUL(simdMidiNoteToHz(OS_SIMD_LOAD_ALIGNED(increments + i)), inv_sample_rate));
+        }
+    };
+
+    // Flat zero amplitude adds nothing; only the phases move. The playback buffer is refreshed once sound resumes.
+    if (flat_amplitude && flat_amp == 0.f) {
+        float total_increment = 0.f;
+        for (size_t start = 0; start < n_frames; start += chunk_frames) {
+            const size_t n = std::min(chunk_frames, n_frames - start);
+            fillIncrements(frame_offset + start, n);
+            for (size_t i = 0; i < n; ++i) {
+                total_increment += increments[i];
+            }
+            last_pitch = increments[n - 1] * sample_rate;
+        }
+        for (size_t k = 0; k < unison.n_voices; ++k) {
+            phase[k] += total_increment * unison.ratio[k];
+            phase[k] -= std::floor(phase[k]);
+        }
+        for (size_t c = 0; c < n_channels; ++c) {
+            writeSilence(outputs, c, n_frames);
+        }
+        frame_offset += n_frames;
+        return;
+    }
+
+    for (size_t start = 0; start < n_frames; start += chunk_frames) {
+        const size_t n = std::min(chunk_frames, n_frames - start);
+        const size_t first_frame = frame_offset + start;
+        fillIncrements(first_frame, n);
+        last_pitch = increments[0] * sample_rate;
+        updatePlaybackBuffer(last_pitch * max_ratio);
+        switch (mode) {
+        case EInterpolation::kLinear:
+            renderChunk<EInterpolation::kLinear>(increments, left, right, n);
+            break;
+        case EInterpolation::kCubic:
+            renderChunk<EInterpolation::kCubic>(increments, left, right, n);
+            break;
+        case EInterpolation::kCatmullRom:
+            renderChunk<EInterpolation::kCatmullRom>(increments, left, right, n);
+            break;
+        default:
+            renderChunk<EInterpolation::kHermite6>(increments, left, right, n);
+            break;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            const float amp = (flat_amplitude) ? flat_amp : amplitude + amplitude_mod(first_frame + i);
+            left[i] *= amp;
+        }
+        if (n_channels == 2) {
+            for (size_t i = 0; i < n; ++i) {
+                right[i] *= (flat_amplitude) ? flat_amp : amplitude + amplitude_mod(first_frame + i);
+            }
+        }
 
-    // Linear interpolation
-    float sample = (1.0f - frac) * playback_buffer[index_int] + frac * playback_buffer[index_next];
-    return sample;
+        // Stereo outputs get the panned voices; any other layout gets the same sum on every channel
+        for (size_t c = 0; c < n_channels; ++c) {
+            float* out_buffer = getOutputChannel(outputs, c, n_frames);
+            if (!out_buffer) {
+                continue;
+            }
+            const float* samples = (c == 1 && n_channels == 2) ? right : left;
+            if (overwrite_output) {
+                vectorCopy(out_buffer + first_frame, samples, n);
+            } else {
+                vectorAdd(out_buffer + first_frame, samples, n);
+            }
+        }
+    }
+    frame_offset += n_frames;
 }
 
 int WaveformOscillator::getBinCutoffForFrequency(float frequency) {
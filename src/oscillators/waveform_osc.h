@@ -1,36 +1,87 @@
 #pragma once
 #include "oscillator.h"
 #include "resource_manager.h"
+#include "unison.h"
+
+/*
+Plays a single-cycle waveform resource from a playback table that is band-limited (FFT brickwall) for the current
+pitch. Unison voices run in SIMD lanes: every voice reads the same table, which is band-limited for the highest
+detuned voice, and the voices are mixed straight into the output channels (see UnisonVoices).
+
+The table is read with one of four interpolation tiers, from cheapest to cleanest: linear, cubic (4-point
+Lagrange), Catmull-Rom and 6-point Hermite. By default the tier follows the context's audio quality; setInterpolation
+picks one for this oscillator. The playback table is stored between copies of its own ends (guard points), so
+every tier reads its neighbouring points without wrapping.
+*/
 
 namespace OrangeSodium{
 class WaveformOscillator : public Oscillator {
 public:
+    enum class EInterpolation {
+        kDefault = 0, // Follow the context's audio quality
+        kLinear,
+        kCubic,       // 4-point Lagrange
+        kCatmullRom,
+        kHermite6
+    };
+
     WaveformOscillator(Context* context, ObjectID id, ResourceID waveform_id, size_t n_channels, float amplitude = 1.0f);
     ~WaveformOscillator() override;
 
     void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
     void onSampleRateChange(float new_sample_rate) override;
+    const char* getTypeName() const override { return "waveform_osc"; }
+    void copyStateFrom(const Oscillator& other) override;
 
     void copyWaveformToPlaybackBuffer();
     void setWaveformResourceID(ResourceID resource_id) { waveform_resource_id = resource_id; }
     ResourceID getWaveformResourceID() const { return waveform_resource_id; }
 
+    /// @brief Play n_voices detuned copies over detune_semitones, panned over stereo_spread [0, 1]
+    void setUnison(size_t n_voices, float detune_semitones, float stereo_spread);
+    size_t getUnisonVoices() const { return unison.n_voices; }
+
+    void setInterpolation(EInterpolation mode) { interpolation = mode; }
+    EInterpolation getInterpolation() const { return interpolation; }
+    /// @brief The tier used when rendering: the one set, or else the one the context's audio quality picks
+    EInterpolation getEffectiveInterpolation() const;
+
+    /// @brief Parse a tier name ("default", "linear", "cubic", "catmull_rom", "hermite6"); returns false if unknown
+    static bool getInterpolationFromName(const char* name, EInterpolation& out);
+
 private:
+    static constexpr size_t kChunkFrames = 64;        // Frames per pass through the voices when the pitch is flat
+    static constexpr size_t kDynamicPitchFrames = 16; // Frames between playback table checks when the pitch moves
+    // Guard points around the playback table. A read at index i touches i - 2 to i + 5 at most (6-point Hermite loads
+    // two groups of four), and i can reach the table length when the phase rounds up to a whole cycle.
+    static constexpr size_t kGuardBefore = 2;
+    static constexpr size_t kGuardAfter = 6;
+
     ResourceID waveform_resource_id;
-    float* phase; 
-    float* playback_buffer; // Anti-aliased waveform data
+    UnisonVoices unison;
+    alignas(OS_SIMD_ALIGNMENT) float phase[UnisonVoices::kMaxVoices]; // Per unison voice, in cycles
+    float* playback_storage; // Guard points, then the playback table, then guard points
+    float* playback_buffer;  // Anti-aliased waveform data, inside playback_storage
     float* source_buffer;
     FFTManager* fft_manager;
-    int* fft_tick;
-    float* last_pitch;
-    float* last_fft_pitch;
-    int* bin_cutoff;
+    float last_pitch;
+    int bin_cutoff; // Highest harmonic kept in the playback buffer; 0 forces a rebuild
     float bins_allowed_above_nyquist;
+    EInterpolation interpolation = EInterpolation::kDefault;
+
+    /// @brief Copy the ends of the playback table into the guard points around it
+    void fillGuardPoints();
+
+    /// @brief Band-limit the playback buffer again if the highest voice has moved too far from it
+    void updatePlaybackBuffer(float max_pitch_hz);
 
-    float getSampleFromWaveform(float phase_position);
+    /// @brief Sum of every voice into left and right for n_frames frames; increments holds the played note's
+    /// phase increment (in cycles) for each frame
+    template <EInterpolation kMode>
+    void renderChunk(const float* increments, float* left, float* right, size_t n_frames);
 
     // Get the FFT bin cutoff for a given frequency. Used for anti-aliasing.
     int getBinCutoffForFrequency(float frequency);
     float getBinsAboveNyquistForFrequency(float frequency, int cutoff);
 };
-} // namespace OrangeSodium
\ No newline at end of file
+} // namespace OrangeSodium
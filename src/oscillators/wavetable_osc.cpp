@@ -0,0 +1,193 @@
+#include "wavetable_osc.h"
+#include "../dsp/fast_math.h"
+#include "../dsp/interpolation.h"
+#include "../dsp/vector_ops.h"
+#include <algorithm>
+#include <cmath>
+
+namespace OrangeSodium {
+
+WavetableOscillator::WavetableOscillator(Context* context, ObjectID id, ResourceID wavetable_id, size_t n_channels, float amplitude)
+    : Oscillator(context, id, n_channels, amplitude), wavetable_id(wavetable_id) {
+    static_assert(kChunkFrames % OS_SIMD_WIDTH == 0 && kDynamicPitchFrames % OS_SIMD_WIDTH == 0, "Chunks are rendered in whole vectors");
+    if (m_context->resource_manager) {
+        wavetable = m_context->resource_manager->getWavetable(wavetable_id);
+    }
+
+    // Add modulation source names
+    modulation_source_names.resize(0);
+    modulation_source_names.push_back("pitch");
+    modulation_source_names.push_back("amplitude");
+    modulation_source_names.push_back("position");
+}
+
+WavetableOscillator::~WavetableOscillator() {}
+
+void WavetableOscillator::onSampleRateChange(float new_sample_rate) {
+    sample_rate = new_sample_rate;
+}
+
+void WavetableOscillator::copyStateFrom(const Oscillator& other) {
+    const WavetableOscillator& running = static_cast<const WavetableOscillator&>(other);
+    phase = running.phase;
+}
+
+size_t WavetableOscillator::getMipLevel(float increment) const {
+    // Level m keeps (length / 2) >> m harmonics, and 0.5 / increment of them fit below Nyquist
+    const float ratio = static_cast<float>(WAVEFORM_STANDARD_LENGTH) * increment;
+    size_t mip = (ratio <= 1.f) ? 0 : static_cast<size_t>(std::ceil(std::log2(ratio)));
+    mip = std::min(mip, WavetableData::kNumMips - 1);
+    // Levels still being built are replaced by the closest ready one, which aliases until the build catches up
+    return std::min(mip, wavetable->getReadyMips() - 1);
+}
+
+template <bool kLinear>
+void WavetableOscillator::renderChunk(size_t mip, const float* phases, const float* frame_positions, float* out, size_t n_frames) const {
+    const float* tables = wavetable->getTable(mip, 0);
+    const size_t n_wavetable_frames = wavetable->getNumFrames();
+    const bool morph = n_wavetable_frames > 1;
+    const os_simd_t table_length = OS_SIMD_SET1(static_cast<float>(WAVEFORM_STANDARD_LENGTH));
+    const os_simd_t stride = OS_SIMD_SET1(static_cast<float>(WavetableData::kStride));
+    // The first frame of the pair read; the last frame is reached with a morph of 1
+    const os_simd_t last_pair = OS_SIMD_SET1(static_cast<float>((morph) ? n_wavetable_frames - 2 : 0));
+
+    alignas(OS_SIMD_ALIGNMENT) int indices[OS_SIMD_WIDTH];
+    for (size_t i = 0; i < n_frames; i += OS_SIMD_WIDTH) {
+        const os_simd_t frame_position = OS_SIMD_LOAD_ALIGNED(frame_positions + i);
+        const os_simd_t frame_whole = OS_SIMD_MIN(simdFloorToIndices(frame_position, indices), last_pair);
+        const os_simd_t table_position = OS_SIMD_MUL(OS_SIMD_LOAD_ALIGNED(phases + i), table_length);
+        const os_simd_t table_whole = simdFloorToIndices(table_position, indices);
+        const os_simd_t frac = OS_SIMD_SUB(table_position, table_whole);
+        // Index of every lane from the first table of the level; exact in float up to 2^24 points
+        simdFloorToIndices(OS_SIMD_ADD(OS_SIMD_MUL(frame_whole, stride), table_whole), indices);
+
+        os_simd_t sample;
+        if constexpr (kLinear) {
+            os_simd_t x0, x1;
+            simdGather2(tables, indices, x0, x1);
+            sample = simdInterpolateLinear(x0, x1, frac);
+            if (morph) {
+                simdGather2(tables + WavetableData::kStride, indices, x0, x1);
+                sample = simdInterpolateLinear(sample, simdInterpolateLinear(x0, x1, frac), OS_SIMD_SUB(frame_position, frame_whole));
+            }
+        } else {
+            os_simd_t x[4];
+            simdGather4(tables - 1, indices, x);
+            sample = simdInterpolateLagrange4(x[0], x[1], x[2], x[3], frac);
+            if (morph) {
+                simdGather4(tables + WavetableData::kStride - 1, indices, x);
+                sample = simdInterpolateLinear(sample, simdInterpolateLagrange4(x[0], x[1], x[2], x[3], frac), OS_SIMD_SUB(frame_position, frame_whole));
+            }
+        }
+        OS_SIMD_STORE_ALIGNED(out + i, sample);
+    }
+}
+
+void WavetableOscillator::processBlock(SignalBuffer* /*audio_inputs*/, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) {
+    const size_t n_frames = n_audio_frames; // Will always be lower than or equal to context->max_n_frames
+    if (!wavetable) {
+        for (size_t c = 0; c < n_channels; ++c) {
+            writeSilence(outputs, c, n_frames);
+        }
+        frame_offset += n_frames;
+        return;
+    }
+
+    const ModInput pitch = getModInput(mod_inputs, EModChannel::kPitch);
+    const ModInput amplitude_mod = getModInput(mod_inputs, EModChannel::kAmplitude);
+    const ModInput position_mod = getModInput(mod_inputs, static_cast<EModChannel>(EWavetableModChannel::kPosition));
+    const bool flat_pitch = pitch.isFlat();
+    const bool flat_amplitude = amplitude_mod.isFlat();
+    const bool flat_position = position_mod.isFlat();
+    const float flat_amp = (flat_amplitude) ? amplitude + amplitude_mod(frame_offset) : 0.f;
+    const size_t chunk_frames = (flat_pitch) ? kChunkFrames : kDynamicPitchFrames;
+    const bool linear = (m_context->audio_quality == kLowQuality);
+    const float last_frame = static_cast<float>(wavetable->getNumFrames() - 1);
+
+    alignas(OS_SIMD_ALIGNMENT) float increments[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float phases[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float frame_positions[kChunkFrames];
+    alignas(OS_SIMD_ALIGNMENT) float samples[kChunkFrames];
+
+    for (size_t start = 0; start < n_frames; start += chunk_frames) {
+        const size_t n = std::min(chunk_frames, n_frames - start);
+        const size_t n_padded = (n + OS_SIMD_WIDTH - 1) / OS_SIMD_WIDTH * OS_SIMD_WIDTH; // Frames past n are rendered and dropped
+        const size_t first_frame = frame_offset + start;
+
+        // Phase increment (in cycles) of every frame
+        if (flat_pitch) {
+            // One pow per chunk instead of one per sample
+            std::fill(increments, increments + n_padded, getHzFromMIDINote(pitch(first_frame) + frequency_offset) / sample_rate);
+        } else {
+            for (size_t i = 0; i < n_padded; ++i) {
+                increments[i] = pitch(first_frame + std::min(i, n - 1)) + frequency_offset;
+            }
+            const os_simd_t inv_sample_rate = OS_SIMD_SET1(1.f / sample_rate);
+            for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+                OS_SIMD_STORE_ALIGNED(increments + i, OS_SIMD_MUL(simdMidiNoteToHz(OS_SIMD_LOAD_ALIGNED(increments + i)), inv_sample_rate));
+            }
+        }
+
+        // Phase of every frame: the increments are summed without wrapping, then wrapped a vector at a time. The
+        // padding frames do not move the oscillator on.
+        float offset = 0.f;
+        float max_increment = 0.f;
+        for (size_t i = 0; i < n; ++i) {
+            phases[i] = offset;
+            offset += increments[i];
+            max_increment = std::max(max_increment, increments[i]);
+        }
+        std::fill(phases + n, phases + n_padded, offset);
+        const os_simd_t start_phase = OS_SIMD_SET1(phase);
+        for (size_t i = 0; i < n_padded; i += OS_SIMD_WIDTH) {
+            OS_SIMD_STORE_ALIGNED(phases + i, simdFrac(OS_SIMD_ADD(start_phase, OS_SIMD_LOAD_ALIGNED(phases + i))));
+        }
+        phase += offset;
+        phase -= std::floor(phase);
+
+        // Flat zero amplitude adds nothing; only the phase moves
+        if (flat_amplitude && flat_amp == 0.f) {
+            continue;
+        }
+
+        // Position of every frame, in frames of the wavetable
+        if (flat_position) {
+            std::fill(frame_positions, frame_positions + n_padded, std::min(std::max(position + position_mod(first_frame), 0.f), 1.f) * last_frame);
+        } else {
+            for (size_t i = 0; i < n_padded; ++i) {
+                frame_positions[i] = std::min(std::max(position + position_mod(first_frame + std::min(i, n - 1)), 0.f), 1.f) * last_frame;
+            }
+        }
+
+        const size_t mip = getMipLevel(max_increment);
+        if (linear) {
+            renderChunk<true>(mip, phases, frame_positions, samples, n_padded);
+        } else {
+            renderChunk<false>(mip, phases, frame_positions, samples, n_padded);
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            samples[i] *= (flat_amplitude) ? flat_amp : amplitude + amplitude_mod(first_frame + i);
+        }
+
+        for (size_t c = 0; c < n_channels; ++c) {
+            float* out_buffer = getOutputChannel(outputs, c, n_frames);
+            if (!out_buffer) {
+                continue;
+            }
+            if (overwrite_output) {
+                vectorCopy(out_buffer + first_frame, samples, n);
+            } else {
+                vectorAdd(out_buffer + first_frame, samples, n);
+            }
+        }
+    }
+
+    if (flat_amplitude && flat_amp == 0.f) {
+        for (size_t c = 0; c < n_channels; ++c) {
+            writeSilence(outputs, c, n_frames);
+        }
+    }
+    frame_offset += n_frames;
+}
+}
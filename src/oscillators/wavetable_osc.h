@@ -0,0 +1,59 @@
+// Wavetable oscillator with frame morphing
+#pragma once
+#include "../oscillator.h"
+#include "../resource_manager.h"
+#include "../simd.h"
+
+/*
+Plays a wavetable resource (see WavetableData). The position, from 0 (first frame) to 1 (last frame), picks the
+point between two neighbouring frames; both are read and crossfaded, so sweeping the position morphs smoothly.
+The position set from Lua is added to the position modulation channel, which is read at audio rate.
+
+Each chunk reads the mip level that keeps the harmonics of the played note below Nyquist. The table reads use
+4-point Lagrange interpolation, or linear interpolation when the context's audio quality is low. Frames are
+rendered OS_SIMD_WIDTH at a time: phases and positions are worked out per frame, then every lane gathers its
+points from its own pair of wavetable frames.
+
+The wavetable is shared and read-only; the oscillator only keeps its phase.
+*/
+
+namespace OrangeSodium {
+class WavetableOscillator : public Oscillator {
+public:
+    enum class EWavetableModChannel {
+        kPosition = 2,
+    };
+
+    static constexpr size_t kNumModChannels = 3;
+
+    WavetableOscillator(Context* context, ObjectID id, ResourceID wavetable_id, size_t n_channels, float amplitude);
+    ~WavetableOscillator();
+
+    void processBlock(SignalBuffer* audio_inputs, SignalBuffer* mod_inputs, SignalBuffer* outputs, size_t n_audio_frames) override;
+    void onSampleRateChange(float new_sample_rate) override;
+    const char* getTypeName() const override { return "wavetable_osc"; }
+    void copyStateFrom(const Oscillator& other) override;
+
+    /// @brief Position in the wavetable: 0 is the first frame, 1 the last
+    void setPosition(float new_position) { position = new_position; }
+    float getPosition() const { return position; }
+    ResourceID getWavetableResourceID() const { return wavetable_id; }
+
+private:
+    static constexpr size_t kChunkFrames = 64;        // Frames per pass when the pitch is flat
+    static constexpr size_t kDynamicPitchFrames = 16; // Frames between mip level choices when the pitch moves
+
+    ResourceID wavetable_id;
+    const WavetableData* wavetable = nullptr;
+    float position = 0.f;
+    float phase = 0.f; // In cycles
+
+    /// @brief Mip level for a phase increment (in cycles per frame), limited to the levels built so far
+    size_t getMipLevel(float increment) const;
+
+    /// @brief Render n_frames frames of one mip level into out; phases holds the phase of every frame (in cycles)
+    /// and frame_positions the position of every frame in frames of the wavetable
+    template <bool kLinear>
+    void renderChunk(size_t mip, const float* phases, const float* frame_positions, float* out, size_t n_frames) const;
+};
+}
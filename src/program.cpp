@@ -4,6 +4,7 @@
 #include <iostream>
 #include "console_utility.h"
 #include <sstream>
+#include <cstring>
 #include "synthesizer.h"
 #include "json/include/nlohmann/json.hpp"
 extern "C" {
@@ -231,6 +232,36 @@ static int l_assign_oscillator_audio_buffer(lua_State* L) {
     return 1;
 }
 
+static int l_assign_oscillator_input_buffer(lua_State* L) {
+    // Feed an audio buffer to an oscillator as its audio input (FM/PM). The oscillators writing the buffer must be
+    // added before the one reading it.
+    // Arguments: osc_id (int), buffer_id (int)
+    // Returns: none
+
+    if (lua_gettop(L) < 2 || !lua_isinteger(L, 1) || !lua_isinteger(L, 2)) {
+        luaL_error(L, "assign_oscillator_input_buffer: expected arguments (osc_id, buffer_id)");
+        return 0;
+    }
+    ObjectID osc_id = static_cast<ObjectID>(lua_tointeger(L, 1));
+    ObjectID buffer_id = static_cast<ObjectID>(lua_tointeger(L, 2));
+
+    // Get the template voice pointer from registry
+    lua_pushstring(L, "__template_voice");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* voice_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!voice_ptr) {
+        return 0;
+    }
+
+    Voice* voice = static_cast<Voice*>(voice_ptr);
+    ErrorCode error = voice->assignOscillatorInputBuffer(osc_id, buffer_id);
+    handle_error(L, error);
+
+    return 0;
+}
+
 static int l_get_object_type(lua_State* L){
     // Get the type of object with the given ID
     // Arguments: object_id (int)
@@ -489,6 +520,43 @@ static int l_add_basic_envelope(lua_State* L){
     return 1;
 }
 
+static int add_random_modulator(lua_State* L, const char* function_name, bool smooth) {
+    // Arguments: rate (float, new values per second)
+    // Returns: modulation_producer_id (int) or nil on failure
+    if (lua_gettop(L) < 1 || !lua_isnumber(L, 1) || lua_tonumber(L, 1) <= 0.0) {
+        luaL_error(L, "%s: argument 1 'rate' must be a positive number", function_name);
+        lua_pushnil(L);
+        return 1;
+    }
+    const float rate = static_cast<float>(lua_tonumber(L, 1));
+
+    // Get the template voice pointer from registry
+    lua_pushstring(L, "__template_voice");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* voice_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!voice_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Voice* voice = static_cast<Voice*>(voice_ptr);
+    const ObjectID id = (smooth) ? voice->addSmoothRandom(rate) : voice->addSampleAndHold(rate);
+    lua_pushinteger(L, id);
+    return 1;
+}
+
+static int l_add_sample_hold(lua_State* L) {
+    // Add a sample-and-hold modulation producer: a new random value in [-1, 1] rate times per second
+    return add_random_modulator(L, "add_sample_hold", false);
+}
+
+static int l_add_smooth_random(lua_State* L) {
+    // Add a smooth random modulation producer: glides between random values in [-1, 1], rate per second
+    return add_random_modulator(L, "add_smooth_random", true);
+}
+
 static int l_add_modulation(lua_State* L){
     // Add a modulation from a source to a target parameter
     // Arguments:
@@ -564,6 +632,82 @@ static int l_set_oscillator_frequency_offset(lua_State* L) {
     return 1;
 }
 
+static int l_set_oscillator_unison(lua_State* L) {
+    // Play detuned copies of a waveform or virtual analog oscillator, spread across the stereo field
+    // Arguments: osc_id (int), n_voices (int, 1-16), detune (float, total width in semitones), stereo_spread (float, 0.0-1.0, optional, default 0)
+    // Returns: none
+
+    if (lua_gettop(L) < 3 || !lua_isinteger(L, 1) || !lua_isinteger(L, 2) || !lua_isnumber(L, 3)) {
+        luaL_error(L, "set_oscillator_unison: expected arguments (osc_id, n_voices, detune[, stereo_spread])");
+        return 0;
+    }
+    ObjectID osc_id = static_cast<ObjectID>(lua_tointeger(L, 1));
+    lua_Integer n_voices = lua_tointeger(L, 2);
+    float detune = static_cast<float>(lua_tonumber(L, 3));
+    if (n_voices < 1 || n_voices > static_cast<lua_Integer>(UnisonVoices::kMaxVoices)) {
+        luaL_error(L, "set_oscillator_unison: 'n_voices' must be between 1 and %d", static_cast<int>(UnisonVoices::kMaxVoices));
+        return 0;
+    }
+    float stereo_spread = 0.0f;
+    if (lua_gettop(L) >= 4) {
+        if (!lua_isnumber(L, 4)) {
+            luaL_error(L, "set_oscillator_unison: argument 4 'stereo_spread' must be a number");
+            return 0;
+        }
+        stereo_spread = static_cast<float>(lua_tonumber(L, 4));
+        if (stereo_spread < 0.0f || stereo_spread > 1.0f) {
+            luaL_error(L, "set_oscillator_unison: 'stereo_spread' must be between 0.0 and 1.0");
+            return 0;
+        }
+    }
+
+    // Get the template voice pointer from registry
+    lua_pushstring(L, "__template_voice");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* voice_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!voice_ptr) {
+        return 0;
+    }
+
+    Voice* voice = static_cast<Voice*>(voice_ptr);
+    ErrorCode error = voice->setOscillatorUnison(osc_id, static_cast<size_t>(n_voices), detune, stereo_spread);
+    handle_error(L, error);
+
+    return 0;
+}
+
+static int l_set_object_name(lua_State* L) {
+    // Give an object a name. Hot reloads pair objects of the old and new program by name, so a named object keeps
+    // its running state (phase, envelope, filter memory) even if objects are added or removed before it.
+    // Arguments: object_id (int), name (string)
+    // Returns: none
+
+    if (lua_gettop(L) < 2 || !lua_isinteger(L, 1) || !lua_isstring(L, 2)) {
+        luaL_error(L, "set_object_name: expected arguments (object_id, name)");
+        return 0;
+    }
+    ObjectID object_id = static_cast<ObjectID>(lua_tointeger(L, 1));
+    std::string name = lua_tostring(L, 2);
+
+    // Get the Program instance from registry to access context
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        return 0;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    if (!program->getContext()->object_registry.setName(object_id, name)) {
+        handle_error(L, ErrorCode::kObjectNotFound);
+    }
+    return 0;
+}
+
 static int l_create_sawtooth_waveform(lua_State* L) {
     // Create a sawtooth waveform resource
     // Arguments: none
@@ -601,45 +745,1178 @@ static int l_add_waveform_osc(lua_State* L){
     //   4. buffer_id (int) - OPTIONAL: ObjectID for audio_buffer to route to
     // Returns: oscillator_id (int) or nil on failure
 
-    // Argument 1: n_channels (REQUIRED)
+    // Argument 1: n_channels (REQUIRED)
+    if (lua_gettop(L) < 2) {
+        luaL_error(L, "add_waveform_osc: missing required arguments");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if (!lua_isinteger(L, 1)) {
+        luaL_error(L, "add_waveform_osc: argument 1 'n_channels' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    size_t n_channels = static_cast<size_t>(lua_tointeger(L, 1));
+    if (n_channels < 1) {
+        luaL_error(L, "add_waveform_osc: 'n_channels' must be at least 1");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 2: waveform_id (REQUIRED)
+    if (!lua_isinteger(L, 2)) {
+        luaL_error(L, "add_waveform_osc: argument 2 'waveform_id' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    ResourceID waveform_id = static_cast<ResourceID>(lua_tointeger(L, 2));
+
+    // Argument 3: amplitude (OPTIONAL, default 1.0)
+    float amplitude = 1.0f;
+    if (lua_gettop(L) >= 3) {
+        if (!lua_isnumber(L, 3)) {
+            luaL_error(L, "add_waveform_osc: argument 3 'amplitude' must be a number");
+            lua_pushnil(L);
+            return 1;
+        }
+        amplitude = static_cast<float>(lua_tonumber(L, 3));
+        if (amplitude < 0.0f || amplitude > 1.0f) {
+            luaL_error(L, "add_waveform_osc: 'amplitude' must be between 0.0 and 1.0");
+            lua_pushnil(L);
+            return 1;
+        }
+    }
+
+    // Argument 4: buffer_id (OPTIONAL)
+    ObjectID buffer_id = static_cast<ObjectID>(luaL_optinteger(L, 4, -1));
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    Voice* voice = program->getTemplateVoice();
+    if (!voice) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    ObjectID osc_id = voice->addWaveformOscillator(n_channels, waveform_id, amplitude);
+    // If a buffer ID was provided, assign it to the oscillator
+    if (buffer_id != static_cast<ObjectID>(-1)) {
+        voice->assignOscillatorAudioBuffer(osc_id, buffer_id);
+    }
+    lua_pushinteger(L, osc_id);
+    return 1;
+}
+
+static int l_set_waveform_interpolation(lua_State* L) {
+    // Set how a waveform oscillator reads its table, trading CPU for quality. "default" follows set_audio_quality.
+    // Arguments: osc_id (int), mode (string: "default", "linear", "cubic", "catmull_rom" or "hermite6")
+    // Returns: none
+    WaveformOscillator::EInterpolation mode;
+    if (lua_gettop(L) < 2 || !lua_isinteger(L, 1) || !lua_isstring(L, 2) || !WaveformOscillator::getInterpolationFromName(lua_tostring(L, 2), mode)) {
+        luaL_error(L, "set_waveform_interpolation: expected arguments (osc_id, \"default\" | \"linear\" | \"cubic\" | \"catmull_rom\" | \"hermite6\")");
+        return 0;
+    }
+    const ObjectID osc_id = static_cast<ObjectID>(lua_tointeger(L, 1));
+
+    // Get the template voice pointer from registry
+    lua_pushstring(L, "__template_voice");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* voice_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!voice_ptr) {
+        return 0;
+    }
+
+    Voice* voice = static_cast<Voice*>(voice_ptr);
+    WaveformOscillator* osc = dynamic_cast<WaveformOscillator*>(voice->getOscillatorByID(osc_id));
+    if (!osc) {
+        luaL_error(L, "set_waveform_interpolation: object %d is not a waveform oscillator", static_cast<int>(osc_id));
+        return 0;
+    }
+    osc->setInterpolation(mode);
+    return 0;
+}
+
+static int l_create_partial_table(lua_State* L) {
+    // Create a partial table resource for additive oscillators
+    // Arguments:
+    //   1. amplitudes (table) - REQUIRED: linear amplitude of each partial
+    //   2. ratios (table) - OPTIONAL: frequency ratio of each partial to the played note (default 1, 2, 3, ...)
+    // Returns: resource_id (int) or nil on failure
+    if (lua_gettop(L) < 1 || !lua_istable(L, 1)) {
+        luaL_error(L, "create_partial_table: argument 1 'amplitudes' must be a table");
+        lua_pushnil(L);
+        return 1;
+    }
+    const bool has_ratios = lua_gettop(L) >= 2 && !lua_isnil(L, 2);
+    if (has_ratios && !lua_istable(L, 2)) {
+        luaL_error(L, "create_partial_table: argument 2 'ratios' must be a table");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    const size_t n_partials = static_cast<size_t>(lua_rawlen(L, 1));
+    if (has_ratios && static_cast<size_t>(lua_rawlen(L, 2)) != n_partials) {
+        luaL_error(L, "create_partial_table: 'ratios' and 'amplitudes' must have the same length");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    std::vector<float> amplitudes(n_partials);
+    std::vector<float> ratios(n_partials);
+    for (size_t i = 0; i < n_partials; ++i) {
+        lua_rawgeti(L, 1, static_cast<lua_Integer>(i + 1));
+        if (!lua_isnumber(L, -1)) {
+            luaL_error(L, "create_partial_table: 'amplitudes' must only hold numbers");
+            lua_pushnil(L);
+            return 1;
+        }
+        amplitudes[i] = static_cast<float>(lua_tonumber(L, -1));
+        lua_pop(L, 1);
+        ratios[i] = static_cast<float>(i + 1);
+        if (has_ratios) {
+            lua_rawgeti(L, 2, static_cast<lua_Integer>(i + 1));
+            if (!lua_isnumber(L, -1) || lua_tonumber(L, -1) <= 0.0) {
+                luaL_error(L, "create_partial_table: 'ratios' must only hold positive numbers");
+                lua_pushnil(L);
+                return 1;
+            }
+            ratios[i] = static_cast<float>(lua_tonumber(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    ResourceManager* resource_manager = program->getContext()->resource_manager;
+    if (!resource_manager) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    ResourceID resource_id = resource_manager->createPartialTable(ratios.data(), amplitudes.data(), n_partials);
+    lua_pushinteger(L, resource_id);
+    return 1;
+}
+
+static int l_create_harmonic_table(lua_State* L) {
+    // Create a partial table of harmonics, partial k at ratio k with amplitude k^-slope
+    // Arguments:
+    //   1. n_partials (int) - REQUIRED: number of harmonics
+    //   2. slope (float) - OPTIONAL: amplitude rolloff (default 1.0, a sawtooth spectrum)
+    //   3. odd_only (bool) - OPTIONAL: odd harmonics only (default false; with slope 1.0, a square spectrum)
+    // Returns: resource_id (int) or nil on failure
+    if (lua_gettop(L) < 1 || !lua_isinteger(L, 1)) {
+        luaL_error(L, "create_harmonic_table: argument 1 'n_partials' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    const lua_Integer n_partials = lua_tointeger(L, 1);
+    if (n_partials < 1) {
+        luaL_error(L, "create_harmonic_table: 'n_partials' must be at least 1");
+        lua_pushnil(L);
+        return 1;
+    }
+    const float slope = static_cast<float>(luaL_optnumber(L, 2, 1.0));
+    const bool odd_only = lua_toboolean(L, 3) != 0;
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    ResourceManager* resource_manager = program->getContext()->resource_manager;
+    if (!resource_manager) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    ResourceID resource_id = resource_manager->createHarmonicPartialTable(static_cast<size_t>(n_partials), slope, odd_only);
+    lua_pushinteger(L, resource_id);
+    return 1;
+}
+
+static int l_add_additive_osc(lua_State* L){
+    // Add an additive oscillator to the template voice
+    // Arguments:
+    //   1. n_channels (int) - REQUIRED: number of output channels
+    //   2. table_id (int) - REQUIRED: ResourceID of the partial table to play
+    //   3. amplitude (float) - OPTIONAL: oscillator amplitude (0.0-1.0, default 1.0)
+    //   4. buffer_id (int) - OPTIONAL: ObjectID for audio_buffer to route to
+    // Returns: oscillator_id (int) or nil on failure
+
+    if (lua_gettop(L) < 2) {
+        luaL_error(L, "add_additive_osc: missing required arguments");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 1: n_channels (REQUIRED)
+    if (!lua_isinteger(L, 1)) {
+        luaL_error(L, "add_additive_osc: argument 1 'n_channels' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    size_t n_channels = static_cast<size_t>(lua_tointeger(L, 1));
+    if (n_channels < 1) {
+        luaL_error(L, "add_additive_osc: 'n_channels' must be at least 1");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 2: table_id (REQUIRED)
+    if (!lua_isinteger(L, 2)) {
+        luaL_error(L, "add_additive_osc: argument 2 'table_id' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    ResourceID table_id = static_cast<ResourceID>(lua_tointeger(L, 2));
+
+    // Argument 3: amplitude (OPTIONAL, default 1.0)
+    float amplitude = 1.0f;
+    if (lua_gettop(L) >= 3) {
+        if (!lua_isnumber(L, 3)) {
+            luaL_error(L, "add_additive_osc: argument 3 'amplitude' must be a number");
+            lua_pushnil(L);
+            return 1;
+        }
+        amplitude = static_cast<float>(lua_tonumber(L, 3));
+        if (amplitude < 0.0f || amplitude > 1.0f) {
+            luaL_error(L, "add_additive_osc: 'amplitude' must be between 0.0 and 1.0");
+            lua_pushnil(L);
+            return 1;
+        }
+    }
+
+    // Argument 4: buffer_id (OPTIONAL)
+    ObjectID buffer_id = static_cast<ObjectID>(luaL_optinteger(L, 4, -1));
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    if (!program->getContext()->resource_manager || !program->getContext()->resource_manager->getPartialTable(table_id)) {
+        luaL_error(L, "add_additive_osc: 'table_id' is not a partial table");
+        lua_pushnil(L);
+        return 1;
+    }
+    Voice* voice = program->getTemplateVoice();
+    if (!voice) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    ObjectID osc_id = voice->addAdditiveOscillator(n_channels, table_id, amplitude);
+    // If a buffer ID was provided, assign it to the oscillator
+    if (buffer_id != static_cast<ObjectID>(-1)) {
+        voice->assignOscillatorAudioBuffer(osc_id, buffer_id);
+    }
+    lua_pushinteger(L, osc_id);
+    return 1;
+}
+
+static int l_add_va_osc(lua_State* L){
+    // Add a virtual analog (PolyBLEP) oscillator to the template voice
+    // Arguments:
+    //   1. n_channels (int) - REQUIRED: number of output channels
+    //   2. shape (string) - REQUIRED: "saw", "pulse" (or "square") or "triangle"
+    //   3. amplitude (float) - OPTIONAL: oscillator amplitude (0.0-1.0, default 1.0)
+    //   4. buffer_id (int) - OPTIONAL: ObjectID for audio_buffer to route to
+    //   5. pulse_width (float) - OPTIONAL: pulse width of the "pulse" shape (0.0-1.0, default 0.5)
+    // Returns: oscillator_id (int) or nil on failure
+
+    if (lua_gettop(L) < 2) {
+        luaL_error(L, "add_va_osc: missing required arguments");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 1: n_channels (REQUIRED)
+    if (!lua_isinteger(L, 1)) {
+        luaL_error(L, "add_va_osc: argument 1 'n_channels' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    size_t n_channels = static_cast<size_t>(lua_tointeger(L, 1));
+    if (n_channels < 1) {
+        luaL_error(L, "add_va_osc: 'n_channels' must be at least 1");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 2: shape (REQUIRED)
+    VAOscillator::EShape shape;
+    if (!lua_isstring(L, 2) || !VAOscillator::getShapeFromName(lua_tostring(L, 2), shape)) {
+        luaL_error(L, "add_va_osc: argument 2 'shape' must be \"saw\", \"pulse\", \"square\" or \"triangle\"");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 3: amplitude (OPTIONAL, default 1.0)
+    float amplitude = 1.0f;
+    if (lua_gettop(L) >= 3) {
+        if (!lua_isnumber(L, 3)) {
+            luaL_error(L, "add_va_osc: argument 3 'amplitude' must be a number");
+            lua_pushnil(L);
+            return 1;
+        }
+        amplitude = static_cast<float>(lua_tonumber(L, 3));
+        if (amplitude < 0.0f || amplitude > 1.0f) {
+            luaL_error(L, "add_va_osc: 'amplitude' must be between 0.0 and 1.0");
+            lua_pushnil(L);
+            return 1;
+        }
+    }
+
+    // Argument 4: buffer_id (OPTIONAL)
+    ObjectID buffer_id = static_cast<ObjectID>(luaL_optinteger(L, 4, -1));
+
+    // Argument 5: pulse_width (OPTIONAL, default 0.5)
+    float pulse_width = 0.5f;
+    if (lua_gettop(L) >= 5) {
+        if (!lua_isnumber(L, 5)) {
+            luaL_error(L, "add_va_osc: argument 5 'pulse_width' must be a number");
+            lua_pushnil(L);
+            return 1;
+        }
+        pulse_width = static_cast<float>(lua_tonumber(L, 5));
+        if (pulse_width < 0.0f || pulse_width > 1.0f) {
+            luaL_error(L, "add_va_osc: 'pulse_width' must be between 0.0 and 1.0");
+            lua_pushnil(L);
+            return 1;
+        }
+    }
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    Voice* voice = program->getTemplateVoice();
+    if (!voice) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    ObjectID osc_id = voice->addVAOscillator(n_channels, shape, amplitude, pulse_width);
+    // If a buffer ID was provided, assign it to the oscillator
+    if (buffer_id != static_cast<ObjectID>(-1)) {
+        voice->assignOscillatorAudioBuffer(osc_id, buffer_id);
+    }
+    lua_pushinteger(L, osc_id);
+    return 1;
+}
+
+static int l_load_sample(lua_State* L) {
+    // Load an audio file (WAV or AIFF) as a sample resource. Relative paths are relative to the program file.
+    // Loading the same path again returns the same resource.
+    // Arguments:
+    //   1. path (string) - REQUIRED: path of the audio file
+    //   2. root_note (float) - OPTIONAL: MIDI note at which the sample plays at its own pitch (default 60)
+    // Returns: resource_id (int) or nil on failure
+    if (lua_gettop(L) < 1 || !lua_isstring(L, 1)) {
+        luaL_error(L, "load_sample: argument 1 'path' must be a string");
+        lua_pushnil(L);
+        return 1;
+    }
+    std::string path = lua_tostring(L, 1);
+    const float root_note = static_cast<float>(luaL_optnumber(L, 2, 60.0));
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    ResourceManager* resource_manager = program->getContext()->resource_manager;
+    if (!resource_manager) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    const std::string program_path = program->getProgramPath();
+    const bool is_absolute = !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'));
+    const size_t separator = program_path.find_last_of("/\\");
+    if (!is_absolute && separator != std::string::npos) {
+        path = program_path.substr(0, separator + 1) + path;
+    }
+
+    ResourceID resource_id = resource_manager->loadSample(path);
+    SampleResource* sample = resource_manager->getSample(resource_id);
+    if (!sample) {
+        luaL_error(L, "load_sample: could not load '%s'", path.c_str());
+        lua_pushnil(L);
+        return 1;
+    }
+    sample->setRootNote(root_note);
+    lua_pushinteger(L, resource_id);
+    return 1;
+}
+
+static int l_load_wavetable(lua_State* L) {
+    // Load the first channel of an audio file (WAV or AIFF) as a wavetable: consecutive single-cycle frames of
+    // frame_length samples, at most 256. Relative paths are relative to the program file. The wavetable is loaded
+    // once per process and shared by every synthesizer that loads the same path.
+    // Arguments:
+    //   1. path (string) - REQUIRED: path of the audio file
+    //   2. frame_length (int) - OPTIONAL: samples per frame (default 2048)
+    // Returns: resource_id (int) or nil on failure
+    if (lua_gettop(L) < 1 || !lua_isstring(L, 1)) {
+        luaL_error(L, "load_wavetable: argument 1 'path' must be a string");
+        lua_pushnil(L);
+        return 1;
+    }
+    std::string path = lua_tostring(L, 1);
+    const lua_Integer frame_length = luaL_optinteger(L, 2, WAVEFORM_STANDARD_LENGTH);
+    if (frame_length < 4) {
+        luaL_error(L, "load_wavetable: 'frame_length' must be at least 4");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    ResourceManager* resource_manager = program->getContext()->resource_manager;
+    if (!resource_manager) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    const std::string program_path = program->getProgramPath();
+    const bool is_absolute = !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'));
+    const size_t separator = program_path.find_last_of("/\\");
+    if (!is_absolute && separator != std::string::npos) {
+        path = program_path.substr(0, separator + 1) + path;
+    }
+
+    ResourceID resource_id = resource_manager->loadWavetable(path, static_cast<size_t>(frame_length));
+    if (!resource_manager->getWavetable(resource_id)) {
+        luaL_error(L, "load_wavetable: could not load '%s'", path.c_str());
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushinteger(L, resource_id);
+    return 1;
+}
+
+static int l_set_sample_loop(lua_State* L) {
+    // Loop part of a sample resource
+    // Arguments: sample_id (int), loop_start (int, frames), loop_end (int, frames, exclusive; loop_end <= loop_start turns looping off)
+    // Returns: none
+    if (lua_gettop(L) < 3 || !lua_isinteger(L, 1) || !lua_isinteger(L, 2) || !lua_isinteger(L, 3)) {
+        luaL_error(L, "set_sample_loop: expected arguments (sample_id, loop_start, loop_end)");
+        return 0;
+    }
+    const ResourceID sample_id = static_cast<ResourceID>(lua_tointeger(L, 1));
+    const lua_Integer loop_start = lua_tointeger(L, 2);
+    const lua_Integer loop_end = lua_tointeger(L, 3);
+    if (loop_start < 0 || loop_end < 0) {
+        luaL_error(L, "set_sample_loop: loop points must not be negative");
+        return 0;
+    }
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        return 0;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    ResourceManager* resource_manager = program->getContext()->resource_manager;
+    SampleResource* sample = (resource_manager) ? resource_manager->getSample(sample_id) : nullptr;
+    if (!sample) {
+        luaL_error(L, "set_sample_loop: resource %d is not a sample", static_cast<int>(sample_id));
+        return 0;
+    }
+    sample->setLoop(static_cast<size_t>(loop_start), static_cast<size_t>(loop_end));
+    return 0;
+}
+
+static int l_add_sampler_osc(lua_State* L){
+    // Add a sample playback oscillator to the template voice
+    // Arguments:
+    //   1. n_channels (int) - REQUIRED: number of output channels
+    //   2. sample_id (int) - REQUIRED: ResourceID of the sample to play (see load_sample)
+    //   3. amplitude (float) - OPTIONAL: oscillator amplitude (0.0-1.0, default 1.0)
+    //   4. buffer_id (int) - OPTIONAL: ObjectID for audio_buffer to route to
+    // Returns: oscillator_id (int) or nil on failure
+
+    if (lua_gettop(L) < 2) {
+        luaL_error(L, "add_sampler_osc: missing required arguments");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 1: n_channels (REQUIRED)
+    if (!lua_isinteger(L, 1)) {
+        luaL_error(L, "add_sampler_osc: argument 1 'n_channels' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    size_t n_channels = static_cast<size_t>(lua_tointeger(L, 1));
+    if (n_channels < 1) {
+        luaL_error(L, "add_sampler_osc: 'n_channels' must be at least 1");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 2: sample_id (REQUIRED)
+    if (!lua_isinteger(L, 2)) {
+        luaL_error(L, "add_sampler_osc: argument 2 'sample_id' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    ResourceID sample_id = static_cast<ResourceID>(lua_tointeger(L, 2));
+
+    // Argument 3: amplitude (OPTIONAL, default 1.0)
+    float amplitude = 1.0f;
+    if (lua_gettop(L) >= 3) {
+        if (!lua_isnumber(L, 3)) {
+            luaL_error(L, "add_sampler_osc: argument 3 'amplitude' must be a number");
+            lua_pushnil(L);
+            return 1;
+        }
+        amplitude = static_cast<float>(lua_tonumber(L, 3));
+        if (amplitude < 0.0f || amplitude > 1.0f) {
+            luaL_error(L, "add_sampler_osc: 'amplitude' must be between 0.0 and 1.0");
+            lua_pushnil(L);
+            return 1;
+        }
+    }
+
+    // Argument 4: buffer_id (OPTIONAL)
+    ObjectID buffer_id = static_cast<ObjectID>(luaL_optinteger(L, 4, -1));
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    Voice* voice = program->getTemplateVoice();
+    if (!voice) {
+        lua_pushnil(L);
+        return 1;
+    }
+    if (!program->getContext()->resource_manager || !program->getContext()->resource_manager->getSample(sample_id)) {
+        luaL_error(L, "add_sampler_osc: resource %d is not a sample", static_cast<int>(sample_id));
+        lua_pushnil(L);
+        return 1;
+    }
+
+    ObjectID osc_id = voice->addSamplerOscillator(n_channels, sample_id, amplitude);
+    // If a buffer ID was provided, assign it to the oscillator
+    if (buffer_id != static_cast<ObjectID>(-1)) {
+        voice->assignOscillatorAudioBuffer(osc_id, buffer_id);
+    }
+    lua_pushinteger(L, osc_id);
+    return 1;
+}
+
+static int l_set_sampler_quality(lua_State* L) {
+    // Set the resampling quality of a sampler oscillator
+    // Arguments: osc_id (int), quality (string: "sinc" (default), "hermite" or "cubic")
+    // Returns: none
+    SamplerOscillator::EQuality quality;
+    if (lua_gettop(L) < 2 || !lua_isinteger(L, 1) || !lua_isstring(L, 2) || !SamplerOscillator::getQualityFromName(lua_tostring(L, 2), quality)) {
+        luaL_error(L, "set_sampler_quality: expected arguments (osc_id, \"sinc\" | \"hermite\" | \"cubic\")");
+        return 0;
+    }
+    const ObjectID osc_id = static_cast<ObjectID>(lua_tointeger(L, 1));
+
+    // Get the template voice pointer from registry
+    lua_pushstring(L, "__template_voice");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* voice_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!voice_ptr) {
+        return 0;
+    }
+
+    Voice* voice = static_cast<Voice*>(voice_ptr);
+    SamplerOscillator* osc = dynamic_cast<SamplerOscillator*>(voice->getOscillatorByID(osc_id));
+    if (!osc) {
+        luaL_error(L, "set_sampler_quality: object %d is not a sampler oscillator", static_cast<int>(osc_id));
+        return 0;
+    }
+    osc->setQuality(quality);
+    return 0;
+}
+
+static int l_add_granular_osc(lua_State* L){
+    // Add a granular oscillator reading a sample to the template voice. Grains are set up with set_granular_grains,
+    // set_granular_position and set_granular_window.
+    // Arguments:
+    //   1. n_channels (int) - REQUIRED: number of output channels
+    //   2. sample_id (int) - REQUIRED: ResourceID of the sample to read grains from (see load_sample)
+    //   3. amplitude (float) - OPTIONAL: oscillator amplitude (0.0-1.0, default 1.0)
+    //   4. buffer_id (int) - OPTIONAL: ObjectID for audio_buffer to route to
+    // Returns: oscillator_id (int) or nil on failure
+
+    if (lua_gettop(L) < 2) {
+        luaL_error(L, "add_granular_osc: missing required arguments");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 1: n_channels (REQUIRED)
+    if (!lua_isinteger(L, 1)) {
+        luaL_error(L, "add_granular_osc: argument 1 'n_channels' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    size_t n_channels = static_cast<size_t>(lua_tointeger(L, 1));
+    if (n_channels < 1) {
+        luaL_error(L, "add_granular_osc: 'n_channels' must be at least 1");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 2: sample_id (REQUIRED)
+    if (!lua_isinteger(L, 2)) {
+        luaL_error(L, "add_granular_osc: argument 2 'sample_id' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    ResourceID sample_id = static_cast<ResourceID>(lua_tointeger(L, 2));
+
+    // Argument 3: amplitude (OPTIONAL, default 1.0)
+    float amplitude = 1.0f;
+    if (lua_gettop(L) >= 3) {
+        if (!lua_isnumber(L, 3)) {
+            luaL_error(L, "add_granular_osc: argument 3 'amplitude' must be a number");
+            lua_pushnil(L);
+            return 1;
+        }
+        amplitude = static_cast<float>(lua_tonumber(L, 3));
+        if (amplitude < 0.0f || amplitude > 1.0f) {
+            luaL_error(L, "add_granular_osc: 'amplitude' must be between 0.0 and 1.0");
+            lua_pushnil(L);
+            return 1;
+        }
+    }
+
+    // Argument 4: buffer_id (OPTIONAL)
+    ObjectID buffer_id = static_cast<ObjectID>(luaL_optinteger(L, 4, -1));
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    Voice* voice = program->getTemplateVoice();
+    if (!voice) {
+        lua_pushnil(L);
+        return 1;
+    }
+    if (!program->getContext()->resource_manager || !program->getContext()->resource_manager->getSample(sample_id)) {
+        luaL_error(L, "add_granular_osc: resource %d is not a sample", static_cast<int>(sample_id));
+        lua_pushnil(L);
+        return 1;
+    }
+
+    ObjectID osc_id = voice->addGranularOscillator(n_channels, sample_id, amplitude);
+    // If a buffer ID was provided, assign it to the oscillator
+    if (buffer_id != static_cast<ObjectID>(-1)) {
+        voice->assignOscillatorAudioBuffer(osc_id, buffer_id);
+    }
+    lua_pushinteger(L, osc_id);
+    return 1;
+}
+
+static GranularOscillator* get_granular_osc(lua_State* L, ObjectID osc_id, const char* function_name) {
+    // Get the template voice pointer from registry
+    lua_pushstring(L, "__template_voice");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* voice_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!voice_ptr) {
+        return nullptr;
+    }
+
+    Voice* voice = static_cast<Voice*>(voice_ptr);
+    GranularOscillator* osc = dynamic_cast<GranularOscillator*>(voice->getOscillatorByID(osc_id));
+    if (!osc) {
+        luaL_error(L, "%s: object %d is not a granular oscillator", function_name, static_cast<int>(osc_id));
+    }
+    return osc;
+}
+
+static int l_set_granular_grains(lua_State* L) {
+    // Set the grains of a granular oscillator
+    // Arguments: osc_id (int), size (float, milliseconds), density (float, grains per second),
+    //            max_grains (int, cap on grains playing at once, 1-256, optional, default 64)
+    // Returns: none
+    if (lua_gettop(L) < 3 || !lua_isinteger(L, 1) || !lua_isnumber(L, 2) || !lua_isnumber(L, 3)) {
+        luaL_error(L, "set_granular_grains: expected arguments (osc_id, size_ms, density[, max_grains])");
+        return 0;
+    }
+    const ObjectID osc_id = static_cast<ObjectID>(lua_tointeger(L, 1));
+    const float size = static_cast<float>(lua_tonumber(L, 2));
+    const float density = static_cast<float>(lua_tonumber(L, 3));
+    if (size <= 0.0f || density < 0.0f) {
+        luaL_error(L, "set_granular_grains: 'size_ms' must be positive and 'density' must not be negative");
+        return 0;
+    }
+    lua_Integer max_grains = 64;
+    if (lua_gettop(L) >= 4) {
+        if (!lua_isinteger(L, 4)) {
+            luaL_error(L, "set_granular_grains: argument 4 'max_grains' must be an integer");
+            return 0;
+        }
+        max_grains = lua_tointeger(L, 4);
+        if (max_grains < 1 || max_grains > static_cast<lua_Integer>(GranularOscillator::kMaxGrains)) {
+            luaL_error(L, "set_granular_grains: 'max_grains' must be between 1 and %d", static_cast<int>(GranularOscillator::kMaxGrains));
+            return 0;
+        }
+    }
+
+    GranularOscillator* osc = get_granular_osc(L, osc_id, "set_granular_grains");
+    if (!osc) {
+        return 0;
+    }
+    osc->setGrainSize(size);
+    osc->setDensity(density);
+    osc->setMaxGrains(static_cast<size_t>(max_grains));
+    return 0;
+}
+
+static int l_set_granular_position(lua_State* L) {
+    // Set where a granular oscillator reads its grains
+    // Arguments: osc_id (int), position (float, 0.0 is the start of the sample and 1.0 its end),
+    //            spray (float, random offset of each grain in seconds, optional, default 0),
+    //            stereo_spread (float, random pan of each grain, 0.0-1.0, optional, default 0)
+    // Returns: none
+    if (lua_gettop(L) < 2 || !lua_isinteger(L, 1) || !lua_isnumber(L, 2)) {
+        luaL_error(L, "set_granular_position: expected arguments (osc_id, position[, spray[, stereo_spread]])");
+        return 0;
+    }
+    const ObjectID osc_id = static_cast<ObjectID>(lua_tointeger(L, 1));
+    const float position = static_cast<float>(lua_tonumber(L, 2));
+    if (position < 0.0f || position > 1.0f) {
+        luaL_error(L, "set_granular_position: 'position' must be between 0.0 and 1.0");
+        return 0;
+    }
+    float spray = 0.0f;
+    if (lua_gettop(L) >= 3) {
+        if (!lua_isnumber(L, 3) || lua_tonumber(L, 3) < 0.0) {
+            luaL_error(L, "set_granular_position: argument 3 'spray' must be a non-negative number");
+            return 0;
+        }
+        spray = static_cast<float>(lua_tonumber(L, 3));
+    }
+    float stereo_spread = 0.0f;
+    if (lua_gettop(L) >= 4) {
+        if (!lua_isnumber(L, 4)) {
+            luaL_error(L, "set_granular_position: argument 4 'stereo_spread' must be a number");
+            return 0;
+        }
+        stereo_spread = static_cast<float>(lua_tonumber(L, 4));
+        if (stereo_spread < 0.0f || stereo_spread > 1.0f) {
+            luaL_error(L, "set_granular_position: 'stereo_spread' must be between 0.0 and 1.0");
+            return 0;
+        }
+    }
+
+    GranularOscillator* osc = get_granular_osc(L, osc_id, "set_granular_position");
+    if (!osc) {
+        return 0;
+    }
+    osc->setPosition(position);
+    osc->setSpray(spray);
+    osc->setStereoSpread(stereo_spread);
+    return 0;
+}
+
+static int l_set_granular_window(lua_State* L) {
+    // Set the grain window of a granular oscillator
+    // Arguments: osc_id (int), window (string: "hann" (default), "gaussian", "tukey" or "triangle")
+    // Returns: none
+    GranularOscillator::EWindow window;
+    if (lua_gettop(L) < 2 || !lua_isinteger(L, 1) || !lua_isstring(L, 2) || !GranularOscillator::getWindowFromName(lua_tostring(L, 2), window)) {
+        luaL_error(L, "set_granular_window: expected arguments (osc_id, \"hann\" | \"gaussian\" | \"tukey\" | \"triangle\")");
+        return 0;
+    }
+    GranularOscillator* osc = get_granular_osc(L, static_cast<ObjectID>(lua_tointeger(L, 1)), "set_granular_window");
+    if (!osc) {
+        return 0;
+    }
+    osc->setWindow(window);
+    return 0;
+}
+
+static int l_add_wavetable_osc(lua_State* L){
+    // Add a wavetable oscillator to the template voice. The position in the wavetable is set with
+    // set_wavetable_position and modulated through the "position" channel.
+    // Arguments:
+    //   1. n_channels (int) - REQUIRED: number of output channels
+    //   2. wavetable_id (int) - REQUIRED: ResourceID of the wavetable (see load_wavetable)
+    //   3. amplitude (float) - OPTIONAL: oscillator amplitude (0.0-1.0, default 1.0)
+    //   4. buffer_id (int) - OPTIONAL: ObjectID for audio_buffer to route to
+    // Returns: oscillator_id (int) or nil on failure
+
+    if (lua_gettop(L) < 2) {
+        luaL_error(L, "add_wavetable_osc: missing required arguments");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 1: n_channels (REQUIRED)
+    if (!lua_isinteger(L, 1)) {
+        luaL_error(L, "add_wavetable_osc: argument 1 'n_channels' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    size_t n_channels = static_cast<size_t>(lua_tointeger(L, 1));
+    if (n_channels < 1) {
+        luaL_error(L, "add_wavetable_osc: 'n_channels' must be at least 1");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 2: wavetable_id (REQUIRED)
+    if (!lua_isinteger(L, 2)) {
+        luaL_error(L, "add_wavetable_osc: argument 2 'wavetable_id' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    ResourceID wavetable_id = static_cast<ResourceID>(lua_tointeger(L, 2));
+
+    // Argument 3: amplitude (OPTIONAL, default 1.0)
+    float amplitude = 1.0f;
+    if (lua_gettop(L) >= 3) {
+        if (!lua_isnumber(L, 3)) {
+            luaL_error(L, "add_wavetable_osc: argument 3 'amplitude' must be a number");
+            lua_pushnil(L);
+            return 1;
+        }
+        amplitude = static_cast<float>(lua_tonumber(L, 3));
+        if (amplitude < 0.0f || amplitude > 1.0f) {
+            luaL_error(L, "add_wavetable_osc: 'amplitude' must be between 0.0 and 1.0");
+            lua_pushnil(L);
+            return 1;
+        }
+    }
+
+    // Argument 4: buffer_id (OPTIONAL)
+    ObjectID buffer_id = static_cast<ObjectID>(luaL_optinteger(L, 4, -1));
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    Voice* voice = program->getTemplateVoice();
+    if (!voice) {
+        lua_pushnil(L);
+        return 1;
+    }
+    if (!program->getContext()->resource_manager || !program->getContext()->resource_manager->getWavetable(wavetable_id)) {
+        luaL_error(L, "add_wavetable_osc: resource %d is not a wavetable", static_cast<int>(wavetable_id));
+        lua_pushnil(L);
+        return 1;
+    }
+
+    ObjectID osc_id = voice->addWavetableOscillator(n_channels, wavetable_id, amplitude);
+    // If a buffer ID was provided, assign it to the oscillator
+    if (buffer_id != static_cast<ObjectID>(-1)) {
+        voice->assignOscillatorAudioBuffer(osc_id, buffer_id);
+    }
+    lua_pushinteger(L, osc_id);
+    return 1;
+}
+
+static int l_set_wavetable_position(lua_State* L) {
+    // Set the position of a wavetable oscillator in its wavetable; the "position" modulation is added to it
+    // Arguments: osc_id (int), position (float, 0.0 (first frame) to 1.0 (last frame))
+    // Returns: none
+    if (lua_gettop(L) < 2 || !lua_isinteger(L, 1) || !lua_isnumber(L, 2)) {
+        luaL_error(L, "set_wavetable_position: expected arguments (osc_id, position)");
+        return 0;
+    }
+    const ObjectID osc_id = static_cast<ObjectID>(lua_tointeger(L, 1));
+    const float position = static_cast<float>(lua_tonumber(L, 2));
+    if (position < 0.0f || position > 1.0f) {
+        luaL_error(L, "set_wavetable_position: 'position' must be between 0.0 and 1.0");
+        return 0;
+    }
+
+    // Get the template voice pointer from registry
+    lua_pushstring(L, "__template_voice");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* voice_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!voice_ptr) {
+        return 0;
+    }
+
+    Voice* voice = static_cast<Voice*>(voice_ptr);
+    WavetableOscillator* osc = dynamic_cast<WavetableOscillator*>(voice->getOscillatorByID(osc_id));
+    if (!osc) {
+        luaL_error(L, "set_wavetable_position: object %d is not a wavetable oscillator", static_cast<int>(osc_id));
+        return 0;
+    }
+    osc->setPosition(position);
+    return 0;
+}
+
+static int l_add_noise_osc(lua_State* L){
+    // Add a noise oscillator to the template voice. Every channel plays its own noise.
+    // Arguments:
+    //   1. n_channels (int) - REQUIRED: number of output channels
+    //   2. color (string) - REQUIRED: "white", "pink" or "band" (band-pass noise centred on the played note)
+    //   3. amplitude (float) - OPTIONAL: oscillator amplitude (0.0-1.0, default 1.0)
+    //   4. buffer_id (int) - OPTIONAL: ObjectID for audio_buffer to route to
+    // Returns: oscillator_id (int) or nil on failure
+
+    if (lua_gettop(L) < 2) {
+        luaL_error(L, "add_noise_osc: missing required arguments");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 1: n_channels (REQUIRED)
+    if (!lua_isinteger(L, 1)) {
+        luaL_error(L, "add_noise_osc: argument 1 'n_channels' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    size_t n_channels = static_cast<size_t>(lua_tointeger(L, 1));
+    if (n_channels < 1) {
+        luaL_error(L, "add_noise_osc: 'n_channels' must be at least 1");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 2: color (REQUIRED)
+    NoiseOscillator::EColor color;
+    if (!lua_isstring(L, 2) || !NoiseOscillator::getColorFromName(lua_tostring(L, 2), color)) {
+        luaL_error(L, "add_noise_osc: argument 2 'color' must be \"white\", \"pink\" or \"band\"");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    // Argument 3: amplitude (OPTIONAL, default 1.0)
+    float amplitude = 1.0f;
+    if (lua_gettop(L) >= 3) {
+        if (!lua_isnumber(L, 3)) {
+            luaL_error(L, "add_noise_osc: argument 3 'amplitude' must be a number");
+            lua_pushnil(L);
+            return 1;
+        }
+        amplitude = static_cast<float>(lua_tonumber(L, 3));
+        if (amplitude < 0.0f || amplitude > 1.0f) {
+            luaL_error(L, "add_noise_osc: 'amplitude' must be between 0.0 and 1.0");
+            lua_pushnil(L);
+            return 1;
+        }
+    }
+
+    // Argument 4: buffer_id (OPTIONAL)
+    ObjectID buffer_id = static_cast<ObjectID>(luaL_optinteger(L, 4, -1));
+
+    // Get the Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    Voice* voice = program->getTemplateVoice();
+    if (!voice) {
+        lua_pushnil(L);
+        return 1;
+    }
+    ObjectID osc_id = voice->addNoiseOscillator(n_channels, color, amplitude);
+    // If a buffer ID was provided, assign it to the oscillator
+    if (buffer_id != static_cast<ObjectID>(-1)) {
+        voice->assignOscillatorAudioBuffer(osc_id, buffer_id);
+    }
+    lua_pushinteger(L, osc_id);
+    return 1;
+}
+
+static int l_set_noise_bandwidth(lua_State* L) {
+    // Set the width of the band of a "band" noise oscillator
+    // Arguments: osc_id (int), bandwidth (float, octaves, 0.01-8)
+    // Returns: none
+    if (lua_gettop(L) < 2 || !lua_isinteger(L, 1) || !lua_isnumber(L, 2)) {
+        luaL_error(L, "set_noise_bandwidth: expected arguments (osc_id, octaves)");
+        return 0;
+    }
+    const ObjectID osc_id = static_cast<ObjectID>(lua_tointeger(L, 1));
+    const float octaves = static_cast<float>(lua_tonumber(L, 2));
+    if (octaves < 0.01f || octaves > 8.0f) {
+        luaL_error(L, "set_noise_bandwidth: 'octaves' must be between 0.01 and 8.0");
+        return 0;
+    }
+
+    // Get the template voice pointer from registry
+    lua_pushstring(L, "__template_voice");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* voice_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!voice_ptr) {
+        return 0;
+    }
+
+    Voice* voice = static_cast<Voice*>(voice_ptr);
+    NoiseOscillator* osc = dynamic_cast<NoiseOscillator*>(voice->getOscillatorByID(osc_id));
+    if (!osc) {
+        luaL_error(L, "set_noise_bandwidth: object %d is not a noise oscillator", static_cast<int>(osc_id));
+        return 0;
+    }
+    osc->setBandwidth(octaves);
+    return 0;
+}
+
+static int l_add_fm_osc(lua_State* L){
+    // Add an FM/PM operator stack to the template voice. Operator 1 starts as a sine carrier; the others are
+    // silent until configured with set_fm_operator.
+    // Arguments:
+    //   1. n_channels (int) - REQUIRED: number of output channels
+    //   2. n_operators (int) - REQUIRED: number of operators (1-8)
+    //   3. amplitude (float) - OPTIONAL: oscillator amplitude (0.0-1.0, default 1.0)
+    //   4. buffer_id (int) - OPTIONAL: ObjectID for audio_buffer to route to
+    // Returns: oscillator_id (int) or nil on failure
+
     if (lua_gettop(L) < 2) {
-        luaL_error(L, "add_waveform_osc: missing required arguments");
+        luaL_error(L, "add_fm_osc: missing required arguments");
         lua_pushnil(L);
         return 1;
     }
 
+    // Argument 1: n_channels (REQUIRED)
     if (!lua_isinteger(L, 1)) {
-        luaL_error(L, "add_waveform_osc: argument 1 'n_channels' must be an integer");
+        luaL_error(L, "add_fm_osc: argument 1 'n_channels' must be an integer");
         lua_pushnil(L);
         return 1;
     }
-
     size_t n_channels = static_cast<size_t>(lua_tointeger(L, 1));
     if (n_channels < 1) {
-        luaL_error(L, "add_waveform_osc: 'n_channels' must be at least 1");
+        luaL_error(L, "add_fm_osc: 'n_channels' must be at least 1");
         lua_pushnil(L);
         return 1;
     }
 
-    // Argument 2: waveform_id (REQUIRED)
+    // Argument 2: n_operators (REQUIRED)
     if (!lua_isinteger(L, 2)) {
-        luaL_error(L, "add_waveform_osc: argument 2 'waveform_id' must be an integer");
+        luaL_error(L, "add_fm_osc: argument 2 'n_operators' must be an integer");
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_Integer n_operators = lua_tointeger(L, 2);
+    if (n_operators < 1 || n_operators > static_cast<lua_Integer>(FMOscillator::kMaxOperators)) {
+        luaL_error(L, "add_fm_osc: 'n_operators' must be between 1 and %d", static_cast<int>(FMOscillator::kMaxOperators));
         lua_pushnil(L);
         return 1;
     }
-    ResourceID waveform_id = static_cast<ResourceID>(lua_tointeger(L, 2));
 
     // Argument 3: amplitude (OPTIONAL, default 1.0)
     float amplitude = 1.0f;
     if (lua_gettop(L) >= 3) {
         if (!lua_isnumber(L, 3)) {
-            luaL_error(L, "add_waveform_osc: argument 3 'amplitude' must be a number");
+            luaL_error(L, "add_fm_osc: argument 3 'amplitude' must be a number");
             lua_pushnil(L);
             return 1;
         }
         amplitude = static_cast<float>(lua_tonumber(L, 3));
         if (amplitude < 0.0f || amplitude > 1.0f) {
-            luaL_error(L, "add_waveform_osc: 'amplitude' must be between 0.0 and 1.0");
+            luaL_error(L, "add_fm_osc: 'amplitude' must be between 0.0 and 1.0");
             lua_pushnil(L);
             return 1;
         }
@@ -666,7 +1943,7 @@ static int l_add_waveform_osc(lua_State* L){
         return 1;
     }
 
-    ObjectID osc_id = voice->addWaveformOscillator(n_channels, waveform_id, amplitude);
+    ObjectID osc_id = voice->addFMOscillator(n_channels, static_cast<size_t>(n_operators), amplitude);
     // If a buffer ID was provided, assign it to the oscillator
     if (buffer_id != static_cast<ObjectID>(-1)) {
         voice->assignOscillatorAudioBuffer(osc_id, buffer_id);
@@ -675,11 +1952,110 @@ static int l_add_waveform_osc(lua_State* L){
     return 1;
 }
 
+/// @brief The FM oscillator osc_id of the template voice, or nullptr (after raising a Lua error) if there is none
+static FMOscillator* getFMOscillator(lua_State* L, const char* function_name, ObjectID osc_id) {
+    lua_pushstring(L, "__template_voice");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* voice_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if (!voice_ptr) {
+        return nullptr;
+    }
+
+    Voice* voice = static_cast<Voice*>(voice_ptr);
+    FMOscillator* osc = dynamic_cast<FMOscillator*>(voice->getOscillatorByID(osc_id));
+    if (!osc) {
+        luaL_error(L, "%s: object %d is not an FM oscillator", function_name, static_cast<int>(osc_id));
+    }
+    return osc;
+}
+
+/// @brief Read a 1-based operator number from the stack into a 0-based index; raises a Lua error if out of range
+static bool getFMOperatorIndex(lua_State* L, const char* function_name, int arg, const FMOscillator* osc, size_t& out) {
+    lua_Integer op = lua_tointeger(L, arg);
+    if (op < 1 || op > static_cast<lua_Integer>(osc->getNumOperators())) {
+        luaL_error(L, "%s: operator %d does not exist (the oscillator has %d)", function_name, static_cast<int>(op), static_cast<int>(osc->getNumOperators()));
+        return false;
+    }
+    out = static_cast<size_t>(op - 1);
+    return true;
+}
+
+static int l_set_fm_operator(lua_State* L) {
+    // Configure one operator of an FM oscillator
+    // Arguments: osc_id (int), operator (int, from 1), ratio (float, frequency relative to the note), level (float),
+    //            feedback (float, index in radians, optional, default 0), output (float, level in the oscillator output,
+    //            optional, default 1 for operator 1 and 0 for the others)
+    // Returns: none
+
+    if (lua_gettop(L) < 4 || !lua_isinteger(L, 1) || !lua_isinteger(L, 2) || !lua_isnumber(L, 3) || !lua_isnumber(L, 4)) {
+        luaL_error(L, "set_fm_operator: expected arguments (osc_id, operator, ratio, level[, feedback[, output]])");
+        return 0;
+    }
+    FMOscillator* osc = getFMOscillator(L, "set_fm_operator", static_cast<ObjectID>(lua_tointeger(L, 1)));
+    size_t op = 0;
+    if (!osc || !getFMOperatorIndex(L, "set_fm_operator", 2, osc, op)) {
+        return 0;
+    }
+    float ratio = static_cast<float>(lua_tonumber(L, 3));
+    float level = static_cast<float>(lua_tonumber(L, 4));
+    float feedback = (lua_gettop(L) >= 5 && lua_isnumber(L, 5)) ? static_cast<float>(lua_tonumber(L, 5)) : 0.0f;
+    float output_level = (op == 0) ? 1.0f : 0.0f;
+    if (lua_gettop(L) >= 6 && lua_isnumber(L, 6)) {
+        output_level = static_cast<float>(lua_tonumber(L, 6));
+    }
+    osc->setOperator(op, ratio, level, feedback, output_level);
+    return 0;
+}
+
+static int l_set_fm_route(lua_State* L) {
+    // Modulate the phase of one operator by another. Routes may not form a loop; use the operator's feedback instead.
+    // Arguments: osc_id (int), source_operator (int, from 1), dest_operator (int, from 1), index (float, radians; 0 removes the route)
+    // Returns: none
+
+    if (lua_gettop(L) < 4 || !lua_isinteger(L, 1) || !lua_isinteger(L, 2) || !lua_isinteger(L, 3) || !lua_isnumber(L, 4)) {
+        luaL_error(L, "set_fm_route: expected arguments (osc_id, source_operator, dest_operator, index)");
+        return 0;
+    }
+    FMOscillator* osc = getFMOscillator(L, "set_fm_route", static_cast<ObjectID>(lua_tointeger(L, 1)));
+    size_t source = 0;
+    size_t dest = 0;
+    if (!osc || !getFMOperatorIndex(L, "set_fm_route", 2, osc, source) || !getFMOperatorIndex(L, "set_fm_route", 3, osc, dest)) {
+        return 0;
+    }
+    if (!osc->setRoute(source, dest, static_cast<float>(lua_tonumber(L, 4)))) {
+        luaL_error(L, "set_fm_route: route %d -> %d would form a loop", static_cast<int>(source + 1), static_cast<int>(dest + 1));
+    }
+    return 0;
+}
+
+static int l_set_fm_input(lua_State* L) {
+    // Modulate one operator by the oscillator's audio input (see assign_oscillator_input_buffer)
+    // Arguments: osc_id (int), operator (int, from 1), pm_index (float, radians), fm_depth (float, frequency deviation
+    //            per unit of input relative to the operator's frequency, optional, default 0)
+    // Returns: none
+
+    if (lua_gettop(L) < 3 || !lua_isinteger(L, 1) || !lua_isinteger(L, 2) || !lua_isnumber(L, 3)) {
+        luaL_error(L, "set_fm_input: expected arguments (osc_id, operator, pm_index[, fm_depth])");
+        return 0;
+    }
+    FMOscillator* osc = getFMOscillator(L, "set_fm_input", static_cast<ObjectID>(lua_tointeger(L, 1)));
+    size_t op = 0;
+    if (!osc || !getFMOperatorIndex(L, "set_fm_input", 2, osc, op)) {
+        return 0;
+    }
+    float fm_depth = (lua_gettop(L) >= 4 && lua_isnumber(L, 4)) ? static_cast<float>(lua_tonumber(L, 4)) : 0.0f;
+    osc->setInputRoute(op, static_cast<float>(lua_tonumber(L, 3)), fm_depth);
+    return 0;
+}
+
 static int l_add_effect_filter(lua_State* l){
     // Add a filter effect to the target effects chain
     // Arguments:
     //   Version 1 (JSON): effect_chain_id (int), json_params (string)
-    //   Version 2 (Numeric): effect_chain_id (int), filter_type (string), cutoff (float), resonance (float)
+    //   Version 2 (Numeric): effect_chain_id (int), filter_type (string), cutoff (float), resonance (float)[, mode (string)]
+    //   mode is "lowpass" (default), "highpass" or "bandpass"; JSON takes it as the "mode" key
     // Returns ObjectID of the filter effect or nil on failure
 
     if(lua_gettop(l) < 2 || !lua_isinteger(l, 1)){
@@ -724,7 +2100,8 @@ static int l_add_effect_filter(lua_State* l){
             std::string filter_type = lua_tostring(l, 2);
             float cutoff = static_cast<float>(lua_tonumber(l, 3));
             float resonance = static_cast<float>(lua_tonumber(l, 4));
-            filter_id = effect_chain->addEffectFilter(filter_type, cutoff, resonance);
+            std::string mode = (lua_gettop(l) >= 5 && lua_isstring(l, 5)) ? lua_tostring(l, 5) : "lowpass";
+            filter_id = effect_chain->addEffectFilter(filter_type, cutoff, resonance, mode);
         }
     } else {
         lua_pushnil(l);
@@ -906,6 +2283,86 @@ static int l_set_portamento(lua_State* L) {
     return 1;
 }
 
+static int l_set_control_rate_division(lua_State* L) {
+    // Sets the division of control-rate signals (envelopes, filter modulation)
+    // Only affects objects added after the call
+    // Arguments: division in samples (int, >= 1)
+    // Returns: none
+    if (lua_gettop(L) < 1 || !lua_isinteger(L, 1) || lua_tointeger(L, 1) < 1) {
+        return 0;
+    }
+    size_t division = static_cast<size_t>(lua_tointeger(L, 1));
+
+    // Get Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    if (!program_ptr) {
+        return 0;
+    }
+    Program* program = static_cast<Program*>(program_ptr);
+    program->getContext()->control_rate_division = division;
+    return 0;
+}
+
+static int l_set_audio_quality(lua_State* L) {
+    // Sets the global audio quality, which picks the defaults of quality settings such as waveform interpolation
+    // Arguments: quality (string: "low", "medium" or "high" (default))
+    // Returns: none
+    EAudioQuality quality;
+    const char* name = (lua_gettop(L) >= 1 && lua_isstring(L, 1)) ? lua_tostring(L, 1) : "";
+    if (std::strcmp(name, "low") == 0) {
+        quality = kLowQuality;
+    } else if (std::strcmp(name, "medium") == 0) {
+        quality = kMediumQuality;
+    } else if (std::strcmp(name, "high") == 0) {
+        quality = kHighQuality;
+    } else {
+        luaL_error(L, "set_audio_quality: expected argument (\"low\" | \"medium\" | \"high\")");
+        return 0;
+    }
+
+    // Get Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    if (!program_ptr) {
+        return 0;
+    }
+    Program* program = static_cast<Program*>(program_ptr);
+    program->getContext()->audio_quality = quality;
+    return 0;
+}
+
+static int l_set_oversampling(lua_State* L) {
+    // Sets the oversampling factor of the synthesizer: 2 (default) or 1, for programs that do not alias without it
+    // Takes effect when the synthesizer is prepared; call it before adding buffers
+    // Arguments: factor (int, 1 or 2)
+    // Returns: none
+    if (lua_gettop(L) < 1 || !lua_isinteger(L, 1) || (lua_tointeger(L, 1) != 1 && lua_tointeger(L, 1) != 2)) {
+        luaL_error(L, "set_oversampling: 'factor' must be 1 or 2");
+        return 0;
+    }
+    const int factor = static_cast<int>(lua_tointeger(L, 1));
+
+    // Get Program instance from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    if (!program_ptr) {
+        return 0;
+    }
+    Context* context = static_cast<Program*>(program_ptr)->getContext();
+    // Objects added from here on see the new rate and block size
+    context->sample_rate = context->sample_rate / context->oversampling * factor;
+    context->max_n_frames = context->max_n_frames / context->oversampling * factor;
+    context->oversampling = factor;
+    return 0;
+}
+
 static int l_add_effect_chain(lua_State* L) {
     // Add an effect chain to the synthesizer (NOT THE VOICE)
     // Arguments: n_channels (int), input_buffer_id (int), output_buffer_id (int)
@@ -1295,6 +2752,215 @@ static int l_add_effect_freqdiffuse(lua_State* L) {
 
 }
 
+static int l_add_effect_eq(lua_State* L) {
+    // Add a parametric EQ effect to the target effects chain
+    // Arguments:
+    //  Version 1 (Lua Table) : effect_chain_id (int), lua_table_params (table)
+    //  Version 2 (JSON String) : effect_chain_id (int), json_params (string)
+    // Params: bands = { {type = "peak", frequency = 1000, q = 0.7, gain = 3}, ... } or n_bands = n
+    // Band types: "peak", "lowshelf", "highshelf", "lowpass", "highpass", "bandpass", "notch"
+    // Returns ObjectID of the EQ effect or nil on failure
+    if(lua_gettop(L) < 2 || !lua_isinteger(L, 1)){
+        lua_pushnil(L);
+        return 1;
+    }
+
+    EffectChainIndex effect_chain_id = static_cast<EffectChainIndex>(lua_tointeger(L, 1));
+    ObjectID eq_id = static_cast<ObjectID>(-1);
+
+    // Get program from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    EffectChain* effect_chain = program->getEffectChainByIndex(effect_chain_id);
+    if (!effect_chain) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if (lua_istable(L, 2)) {
+        json j;
+        lua_table_to_json(L, 2, j);
+        eq_id = effect_chain->addEffectEQJSON(j.dump());
+    } else if (lua_isstring(L, 2)) {
+        eq_id = effect_chain->addEffectEQJSON(lua_tostring(L, 2));
+    } else {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if(eq_id == static_cast<ObjectID>(-1)){
+        lua_pushnil(L);
+    } else {
+        lua_pushinteger(L, eq_id);
+    }
+    return 1;
+}
+
+static int l_set_eq_band(lua_State* L) {
+    // Change one band of an EQ effect; the response glides to the new setting
+    // Arguments: effect_chain_id (int), eq_id (int), band (int, from 0), params (table or JSON string)
+    // Params: type, frequency, q, gain; keys left out keep their value
+    // Returns true on success, nil on failure
+    if (lua_gettop(L) < 4 || !lua_isinteger(L, 1) || !lua_isinteger(L, 2) || !lua_isinteger(L, 3)) {
+        luaL_error(L, "set_eq_band: expected (effect_chain_id, eq_id, band, params)");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    Program* program = static_cast<Program*>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+    if (!program) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    EffectChain* effect_chain = program->getEffectChainByIndex(static_cast<EffectChainIndex>(lua_tointeger(L, 1)));
+    const ObjectID eq_id = static_cast<ObjectID>(lua_tointeger(L, 2));
+    const lua_Integer band = lua_tointeger(L, 3);
+    if (!effect_chain || band < 0) {
+        luaL_error(L, "set_eq_band: unknown effect chain or band");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    std::string params;
+    if (lua_istable(L, 4)) {
+        json j;
+        lua_table_to_json(L, 4, j);
+        params = j.dump();
+    } else if (lua_isstring(L, 4)) {
+        params = lua_tostring(L, 4);
+    } else {
+        luaL_error(L, "set_eq_band: argument 4 'params' must be a table or a JSON string");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if (!effect_chain->setEQBandJSON(eq_id, static_cast<size_t>(band), params)) {
+        luaL_error(L, "set_eq_band: %d is not an EQ effect of this chain with a band %d", static_cast<int>(eq_id), static_cast<int>(band));
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static int l_add_effect_convolution_reverb(lua_State* L) {
+    // Add a convolution reverb effect to the target effects chain
+    // Arguments:
+    //  Version 1 (Lua Table) : effect_chain_id (int), lua_table_params (table)
+    //  Version 2 (JSON String) : effect_chain_id (int), json_params (string)
+    // Params: ir = sample resource (see load_sample), mode = "parallel" | "mono_to_stereo" | "true_stereo",
+    //         dry = 0, wet = 1, threaded = false (run the long partitions on a background thread)
+    // true_stereo needs a stereo chain and a 4-channel IR (L->L, L->R, R->L, R->R)
+    // Returns ObjectID of the reverb effect or nil on failure
+    if(lua_gettop(L) < 2 || !lua_isinteger(L, 1)){
+        lua_pushnil(L);
+        return 1;
+    }
+
+    EffectChainIndex effect_chain_id = static_cast<EffectChainIndex>(lua_tointeger(L, 1));
+    ObjectID reverb_id = static_cast<ObjectID>(-1);
+
+    // Get program from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    EffectChain* effect_chain = program->getEffectChainByIndex(effect_chain_id);
+    if (!effect_chain) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if (lua_istable(L, 2)) {
+        json j;
+        lua_table_to_json(L, 2, j);
+        reverb_id = effect_chain->addEffectConvolutionReverbJSON(j.dump());
+    } else if (lua_isstring(L, 2)) {
+        reverb_id = effect_chain->addEffectConvolutionReverbJSON(lua_tostring(L, 2));
+    } else {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if(reverb_id == static_cast<ObjectID>(-1)){
+        lua_pushnil(L);
+    } else {
+        lua_pushinteger(L, reverb_id);
+    }
+    return 1;
+}
+
+static int l_add_effect_fdn_reverb(lua_State* L) {
+    // Add a feedback delay network reverb effect to the target effects chain
+    // Arguments:
+    //  Version 1 (Lua Table) : effect_chain_id (int), lua_table_params (table)
+    //  Version 2 (JSON String) : effect_chain_id (int), json_params (string)
+    // Params: lines = 8 | 16, matrix = "householder" | "hadamard", decay = 2 (s), damping = 0.5 (0 to 1),
+    //         size = 1 (0.1 to 2), mod_depth = 0.3 (ms), mod_rate = 0.5 (Hz), mix = 0.3
+    // Modulation sources: "decay", "damping", "size", "mix" (read once per block)
+    // Returns ObjectID of the reverb effect or nil on failure
+    if(lua_gettop(L) < 2 || !lua_isinteger(L, 1)){
+        lua_pushnil(L);
+        return 1;
+    }
+
+    EffectChainIndex effect_chain_id = static_cast<EffectChainIndex>(lua_tointeger(L, 1));
+    ObjectID reverb_id = static_cast<ObjectID>(-1);
+
+    // Get program from registry
+    lua_pushstring(L, "__program_instance");
+    lua_gettable(L, LUA_REGISTRYINDEX);
+    void* program_ptr = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    if (!program_ptr) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Program* program = static_cast<Program*>(program_ptr);
+    EffectChain* effect_chain = program->getEffectChainByIndex(effect_chain_id);
+    if (!effect_chain) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if (lua_istable(L, 2)) {
+        json j;
+        lua_table_to_json(L, 2, j);
+        reverb_id = effect_chain->addEffectFDNReverbJSON(j.dump());
+    } else if (lua_isstring(L, 2)) {
+        reverb_id = effect_chain->addEffectFDNReverbJSON(lua_tostring(L, 2));
+    } else {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if(reverb_id == static_cast<ObjectID>(-1)){
+        lua_pushnil(L);
+    } else {
+        lua_pushinteger(L, reverb_id);
+    }
+    return 1;
+}
+
 //==========================================================================
 
 Program::Program(Context* context, void* parent_synthesizer) : context(context), parent_synthesizer(parent_synthesizer), program_path(""), program_name("") {
@@ -1324,23 +2990,57 @@ Program::Program(Context* context, void* parent_synthesizer) : context(context),
     // lua_register(getLuaState(L), "config_default_io", l_config_default_io);
     lua_register(getLuaState(L), "get_connected_audio_buffer_for_oscillator", l_get_connected_audio_buffer_for_oscillator);
     lua_register(getLuaState(L), "assign_oscillator_audio_buffer", l_assign_oscillator_audio_buffer);
+    lua_register(getLuaState(L), "assign_oscillator_input_buffer", l_assign_oscillator_input_buffer);
     lua_register(getLuaState(L), "add_voice_output", l_add_voice_audio_buffer_to_master);
     lua_register(getLuaState(L), "add_basic_envelope", l_add_basic_envelope);
+    lua_register(getLuaState(L), "add_sample_hold", l_add_sample_hold);
+    lua_register(getLuaState(L), "add_smooth_random", l_add_smooth_random);
     lua_register(getLuaState(L), "add_modulation", l_add_modulation);
     lua_register(getLuaState(L), "set_oscillator_frequency_offset", l_set_oscillator_frequency_offset);
+    lua_register(getLuaState(L), "set_oscillator_unison", l_set_oscillator_unison);
+    lua_register(getLuaState(L), "set_object_name", l_set_object_name);
     lua_register(getLuaState(L), "create_sawtooth_waveform", l_create_sawtooth_waveform);
     lua_register(getLuaState(L), "add_waveform_osc", l_add_waveform_osc);
+    lua_register(getLuaState(L), "set_waveform_interpolation", l_set_waveform_interpolation);
+    lua_register(getLuaState(L), "create_partial_table", l_create_partial_table);
+    lua_register(getLuaState(L), "create_harmonic_table", l_create_harmonic_table);
+    lua_register(getLuaState(L), "add_additive_osc", l_add_additive_osc);
+    lua_register(getLuaState(L), "add_va_osc", l_add_va_osc);
+    lua_register(getLuaState(L), "add_fm_osc", l_add_fm_osc);
+    lua_register(getLuaState(L), "set_fm_operator", l_set_fm_operator);
+    lua_register(getLuaState(L), "set_fm_route", l_set_fm_route);
+    lua_register(getLuaState(L), "set_fm_input", l_set_fm_input);
+    lua_register(getLuaState(L), "load_sample", l_load_sample);
+    lua_register(getLuaState(L), "set_sample_loop", l_set_sample_loop);
+    lua_register(getLuaState(L), "add_sampler_osc", l_add_sampler_osc);
+    lua_register(getLuaState(L), "set_sampler_quality", l_set_sampler_quality);
+    lua_register(getLuaState(L), "add_granular_osc", l_add_granular_osc);
+    lua_register(getLuaState(L), "set_granular_grains", l_set_granular_grains);
+    lua_register(getLuaState(L), "set_granular_position", l_set_granular_position);
+    lua_register(getLuaState(L), "set_granular_window", l_set_granular_window);
+    lua_register(getLuaState(L), "load_wavetable", l_load_wavetable);
+    lua_register(getLuaState(L), "add_wavetable_osc", l_add_wavetable_osc);
+    lua_register(getLuaState(L), "set_wavetable_position", l_set_wavetable_position);
+    lua_register(getLuaState(L), "add_noise_osc", l_add_noise_osc);
+    lua_register(getLuaState(L), "set_noise_bandwidth", l_set_noise_bandwidth);
     lua_register(getLuaState(L), "add_filter_effect", l_add_effect_filter);
     lua_register(getLuaState(L), "set_voice_rand_detune", l_set_voice_rand_detune);
     lua_register(getLuaState(L), "add_voice_effect_chain", l_add_voice_effect_chain);
     lua_register(getLuaState(L), "add_audio_buffer", l_add_audio_buffer);
     lua_register(getLuaState(L), "add_buffer_to_master", l_add_audio_buffer_to_master);
     lua_register(getLuaState(L), "set_portamento", l_set_portamento);
+    lua_register(getLuaState(L), "set_control_rate_division", l_set_control_rate_division);
+    lua_register(getLuaState(L), "set_audio_quality", l_set_audio_quality);
+    lua_register(getLuaState(L), "set_oversampling", l_set_oversampling);
     lua_register(getLuaState(L), "add_effect_chain", l_add_effect_chain);
     lua_register(getLuaState(L), "json_to_table", lua_json_to_table);
     lua_register(getLuaState(L), "table_to_json", lua_table_to_json);
     lua_register(getLuaState(L), "add_distortion_effect", l_add_effect_distortion);
     lua_register(getLuaState(L), "add_freqdiffuse_effect", l_add_effect_freqdiffuse);
+    lua_register(getLuaState(L), "add_eq_effect", l_add_effect_eq);
+    lua_register(getLuaState(L), "set_eq_band", l_set_eq_band);
+    lua_register(getLuaState(L), "add_convolution_reverb_effect", l_add_effect_convolution_reverb);
+    lua_register(getLuaState(L), "add_fdn_reverb_effect", l_add_effect_fdn_reverb);
 
     // Override Lua print function
     lua_pushcfunction(getLuaState(L), l_cpp_print);
@@ -1372,6 +3072,7 @@ bool Program::loadFromFile(const std::string& path) {
     }
     program_data = std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
     file.close();
+    program_path = path;
     return true;
 }
 
@@ -1424,13 +3125,13 @@ size_t Program::getNumVoicesDefined(){
     return num_voices;
 }
 
-Voice* Program::buildVoice() {
+Voice* Program::buildVoice(size_t voice_index) {
     if (!L) {
         *context->log_stream << "[Program] Cannot build voice: Lua state was closed due to error" << std::endl;
         return nullptr;  // Don't create voice if Lua state is invalid
     }
 
-    Voice* voice = new Voice(context, parent_synthesizer);
+    Voice* voice = new Voice(context, parent_synthesizer, voice_index);
     setTemplateVoice(voice);
     context->next_effect_chain_id = 0;
 
@@ -24,7 +24,7 @@ public:
 
     void throwProgramError(ErrorCode code);
 
-    Voice* buildVoice();
+    Voice* buildVoice(size_t voice_index); // Run build_voice() for voice voice_index of the synthesizer
 
     size_t getNumVoicesDefined();
 
@@ -1,8 +1,29 @@
 #include "resource_manager.h"
 #include "constants.h"
+#include "AudioFile.h"
+#include "dsp/fft.h"
+#include "dsp/convolution.h"
+#include "dsp/interpolation.h"
+#include "dsp/sinc_interpolator.h"
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
 
 namespace OrangeSodium{
 
+/// @brief Key of a file's current contents: its path, size and modification time. A file edited in place (e.g.
+/// between two hot reloads) gets a new key, so the process-wide caches below read it again.
+static std::string getFileVersionKey(const std::string& path) {
+    std::error_code size_error, time_error;
+    const auto size = std::filesystem::file_size(path, size_error);
+    const auto modified = std::filesystem::last_write_time(path, time_error);
+    if (size_error || time_error) {
+        return path;
+    }
+    return path + "#" + std::to_string(size) + "#" + std::to_string(modified.time_since_epoch().count());
+}
+
 Resource::Resource(EType type) : type_(type){}
 Resource::~Resource() {}
 
@@ -24,6 +45,205 @@ void WaveformResource::createSawtooth() {
     }
 }
 
+PartialTableResource::PartialTableResource(size_t n_partials) : Resource(Resource::EType::kPartialTable), n_partials(n_partials) {
+    ratios = new float[n_partials];
+    amplitudes = new float[n_partials];
+    for (size_t i = 0; i < n_partials; ++i) {
+        ratios[i] = static_cast<float>(i + 1);
+        amplitudes[i] = 0.0f;
+    }
+}
+PartialTableResource::~PartialTableResource() {
+    delete[] ratios;
+    delete[] amplitudes;
+}
+
+void PartialTableResource::createHarmonicSeries(float slope, bool odd_only) {
+    for (size_t i = 0; i < n_partials; ++i) {
+        const float harmonic = static_cast<float>((odd_only) ? 2 * i + 1 : i + 1);
+        ratios[i] = harmonic;
+        amplitudes[i] = std::pow(harmonic, -slope);
+    }
+}
+
+SampleResource::SampleResource(size_t n_channels, size_t n_frames, float sample_rate)
+    : Resource(Resource::EType::kSample), n_channels(n_channels), n_frames(n_frames), stride(n_frames + 2 * kPadFrames), sample_rate(sample_rate) {
+    data = new float[n_channels * stride];
+    for (size_t i = 0; i < n_channels * stride; ++i) {
+        data[i] = 0.0f;
+    }
+}
+SampleResource::~SampleResource() {
+    delete[] data;
+    data = nullptr;
+}
+
+void SampleResource::setLoop(size_t start, size_t end) {
+    loop_start = std::min(start, n_frames);
+    loop_end = std::min(end, n_frames);
+}
+
+// Kernels of samples loaded from files, by file version, channel and rate, so every synthesizer instance in the
+// process convolving with the same file shares one set of spectra. The version keeps an IR edited between hot
+// reloads from being served from the kernel the running synthesizer still holds.
+struct ConvolutionKernelFileCache {
+    std::mutex mutex;
+    std::vector<std::pair<std::string, std::weak_ptr<const ConvolutionKernel>>> entries;
+
+    static ConvolutionKernelFileCache& get() {
+        static ConvolutionKernelFileCache cache;
+        return cache;
+    }
+};
+
+std::shared_ptr<const ConvolutionKernel> SampleResource::getConvolutionKernel(size_t channel, float target_sample_rate) {
+    if (channel >= n_channels || target_sample_rate <= 0.f) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(kernel_mutex);
+    for (const CachedKernel& cached : kernels) {
+        if (cached.channel == channel && cached.sample_rate == target_sample_rate) {
+            return cached.kernel;
+        }
+    }
+
+    std::shared_ptr<const ConvolutionKernel> kernel;
+    if (source_path.empty()) {
+        kernel = buildConvolutionKernel(channel, target_sample_rate);
+    } else {
+        const std::string key = source_version + "#" + std::to_string(channel) + "#" + std::to_string(target_sample_rate);
+        ConvolutionKernelFileCache& cache = ConvolutionKernelFileCache::get();
+        std::lock_guard<std::mutex> cache_lock(cache.mutex);
+        for (const auto& entry : cache.entries) {
+            if (entry.first == key) {
+                kernel = entry.second.lock();
+                break;
+            }
+        }
+        if (!kernel) {
+            kernel = buildConvolutionKernel(channel, target_sample_rate);
+            // Drop entries whose kernel is gone, then remember this one
+            cache.entries.erase(std::remove_if(cache.entries.begin(), cache.entries.end(),
+                                               [](const auto& entry) { return entry.second.expired(); }),
+                                cache.entries.end());
+            cache.entries.push_back({ key, kernel });
+        }
+    }
+    kernels.push_back({ channel, target_sample_rate, kernel });
+    return kernel;
+}
+
+std::shared_ptr<const ConvolutionKernel> SampleResource::buildConvolutionKernel(size_t channel, float target_sample_rate) const {
+    const float* source = getChannel(channel);
+    const size_t max_length = static_cast<size_t>(kMaxConvolutionSeconds * target_sample_rate);
+    if (target_sample_rate == sample_rate) {
+        return std::make_shared<ConvolutionKernel>(source, std::min(n_frames, max_length));
+    }
+
+    // The padding lets the interpolators read past both ends. Going down in rate, the source is band-limited by the
+    // sinc interpolator, whose lowest cutoff is an octave down; larger ratios are halved first until they fit.
+    double step = static_cast<double>(sample_rate) / target_sample_rate;
+    const size_t length = std::min(static_cast<size_t>(std::ceil(n_frames / step)), max_length);
+    const SincInterpolator& sinc = SincInterpolator::get();
+    std::vector<float> halved;
+    size_t source_frames = n_frames;
+    while (step > 2.0) {
+        const size_t half = (source_frames + 1) / 2;
+        std::vector<float> next(half + 2 * kPadFrames, 0.f);
+        for (size_t i = 0; i < half; ++i) {
+            next[kPadFrames + i] = sinc.interpolate(source + 2 * i, 0.f, SincInterpolator::kCutoffs - 1);
+        }
+        halved.swap(next);
+        source = halved.data() + kPadFrames;
+        source_frames = half;
+        step *= 0.5;
+    }
+
+    const size_t cutoff = SincInterpolator::getCutoffForRatio(static_cast<float>(step));
+    std::vector<float> resampled(std::max<size_t>(length, 1), 0.f);
+    for (size_t i = 0; i < length; ++i) {
+        const double position = i * step;
+        const size_t index = static_cast<size_t>(position);
+        if (index >= source_frames) {
+            break;
+        }
+        const float frac = static_cast<float>(position - static_cast<double>(index));
+        const float* x = source + index;
+        resampled[i] = (step > 1.0) ? sinc.interpolate(x, frac, cutoff)
+                                    : interpolateLagrange4(x[-1], x[0], x[1], x[2], frac);
+    }
+    return std::make_shared<ConvolutionKernel>(resampled.data(), resampled.size());
+}
+
+WavetableData::WavetableData(const float* frames, size_t n_frames) : n_frames(n_frames), ready_mips(1), cancel_build(false) {
+    const size_t size = kNumMips * n_frames * kStride;
+    data = new float[size];
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = 0.0f;
+    }
+    for (size_t f = 0; f < n_frames; ++f) {
+        float* table = getTableData(0, f);
+        std::copy(frames + f * WAVEFORM_STANDARD_LENGTH, frames + (f + 1) * WAVEFORM_STANDARD_LENGTH, table);
+        fillGuardPoints(table);
+    }
+    builder = std::thread(&WavetableData::buildMips, this);
+}
+
+WavetableData::~WavetableData() {
+    cancel_build.store(true, std::memory_order_relaxed);
+    if (builder.joinable()) {
+        builder.join();
+    }
+    delete[] data;
+    data = nullptr;
+}
+
+void WavetableData::waitForMips() const {
+    while (getReadyMips() < kNumMips) {
+        std::this_thread::yield();
+    }
+}
+
+void WavetableData::fillGuardPoints(float* table) {
+    for (size_t i = 1; i <= kGuardBefore; ++i) {
+        table[-static_cast<ptrdiff_t>(i)] = table[WAVEFORM_STANDARD_LENGTH - i];
+    }
+    for (size_t i = 0; i < kGuardAfter; ++i) {
+        table[WAVEFORM_STANDARD_LENGTH + i] = table[i];
+    }
+}
+
+void WavetableData::buildMips() {
+    // The thread has its own FFT, as FFTManager keeps its scratch buffers in the object
+    FFTManager fft(11); // 2048-point FFT
+    static_assert(WAVEFORM_STANDARD_LENGTH == 2048, "The mip FFT size follows the waveform length");
+    for (size_t mip = 1; mip < kNumMips; ++mip) {
+        const size_t bin_cutoff = (WAVEFORM_STANDARD_LENGTH / 2) >> mip;
+        for (size_t f = 0; f < n_frames; ++f) {
+            if (cancel_build.load(std::memory_order_relaxed)) {
+                return;
+            }
+            float* table = getTableData(mip, f);
+            fft.brickwallWaveform(getTableData(0, f), table, bin_cutoff);
+            fillGuardPoints(table);
+        }
+        ready_mips.store(mip + 1, std::memory_order_release);
+    }
+}
+
+/// @brief Wavetables loaded from files, shared by every ResourceManager of the process. Entries are weak, so a
+/// wavetable is freed with the last resource that uses it. They are keyed by the file's version, as the running
+/// synthesizer keeps the old data alive through a hot reload.
+struct WavetableFileCache {
+    std::mutex mutex;
+    std::vector<std::pair<std::string, std::weak_ptr<WavetableData>>> entries;
+
+    static WavetableFileCache& get() {
+        static WavetableFileCache cache;
+        return cache;
+    }
+};
+
 ResourceManager::ResourceManager() : nextId(0) {}
 ResourceManager::~ResourceManager() {
     for (Resource* res : resources) {
@@ -44,14 +264,167 @@ ResourceID ResourceManager::createSawtoothWaveform() {
     return addResource(waveform);
 }
 
-float* ResourceManager::getWaveformBuffer(ResourceID id) {
-    for (Resource* res : resources) {
-        if (res->getId() == id && res->getType() == Resource::EType::kWaveform) {
-            WaveformResource* waveform = static_cast<WaveformResource*>(res);
-            return waveform->getData();
+ResourceID ResourceManager::createPartialTable(const float* ratios, const float* amplitudes, size_t n_partials) {
+    PartialTableResource* table = new PartialTableResource(n_partials);
+    for (size_t i = 0; i < n_partials; ++i) {
+        table->getRatios()[i] = (ratios) ? ratios[i] : static_cast<float>(i + 1);
+        table->getAmplitudes()[i] = amplitudes[i];
+    }
+    return addResource(table);
+}
+
+ResourceID ResourceManager::createHarmonicPartialTable(size_t n_partials, float slope, bool odd_only) {
+    PartialTableResource* table = new PartialTableResource(n_partials);
+    table->createHarmonicSeries(slope, odd_only);
+    return addResource(table);
+}
+
+ResourceID ResourceManager::createSample(const float* const* channels, size_t n_channels, size_t n_frames, float sample_rate) {
+    SampleResource* sample = new SampleResource(n_channels, n_frames, sample_rate);
+    for (size_t c = 0; c < n_channels; ++c) {
+        std::copy(channels[c], channels[c] + n_frames, sample->getChannel(c));
+    }
+    return addResource(sample);
+}
+
+ResourceID ResourceManager::loadSample(const std::string& path) {
+    // Scripts may ask for the same file from every voice they build
+    for (const auto& loaded : loaded_files) {
+        if (loaded.first == path) {
+            return loaded.second;
+        }
+    }
+
+    const std::string version = getFileVersionKey(path);
+    AudioFile<float> file;
+    if (!file.load(path) || file.getNumChannels() < 1 || file.getNumSamplesPerChannel() < 1) {
+        return static_cast<ResourceID>(-1);
+    }
+    const size_t n_channels = static_cast<size_t>(file.getNumChannels());
+    const size_t n_frames = static_cast<size_t>(file.getNumSamplesPerChannel());
+    SampleResource* sample = new SampleResource(n_channels, n_frames, static_cast<float>(file.getSampleRate()));
+    for (size_t c = 0; c < n_channels; ++c) {
+        std::copy(file.samples[c].begin(), file.samples[c].begin() + n_frames, sample->getChannel(c));
+    }
+    sample->setSourcePath(path, version);
+    const ResourceID id = addResource(sample);
+    loaded_files.push_back({ path, id });
+    return id;
+}
+
+ResourceID ResourceManager::createWavetable(const float* frames, size_t n_frames) {
+    if (n_frames < 1) {
+        return static_cast<ResourceID>(-1);
+    }
+    return addResource(new WavetableResource(std::make_shared<WavetableData>(frames, n_frames)));
+}
+
+ResourceID ResourceManager::loadWavetable(const std::string& path, size_t frame_length) {
+    if (frame_length < 4) {
+        return static_cast<ResourceID>(-1);
+    }
+    const std::string key = path + "#" + std::to_string(frame_length);
+    for (const auto& loaded : loaded_wavetables) {
+        if (loaded.first == key) {
+            return loaded.second;
+        }
+    }
+
+    WavetableFileCache& cache = WavetableFileCache::get();
+    const std::string version_key = getFileVersionKey(path) + "#" + std::to_string(frame_length);
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    std::shared_ptr<WavetableData> data;
+    for (const auto& entry : cache.entries) {
+        if (entry.first == version_key) {
+            data = entry.second.lock();
+            break;
+        }
+    }
+
+    if (!data) {
+        AudioFile<float> file;
+        if (!file.load(path) || file.getNumChannels() < 1 || file.getNumSamplesPerChannel() < 1) {
+            return static_cast<ResourceID>(-1);
         }
+        const std::vector<float>& samples = file.samples[0];
+        // A file shorter than a frame is taken as one frame
+        const size_t length = std::min(frame_length, samples.size());
+        const size_t n_frames = std::min(std::max<size_t>(samples.size() / length, 1), kMaxWavetableFrames);
+
+        std::vector<float> frames(n_frames * WAVEFORM_STANDARD_LENGTH);
+        for (size_t f = 0; f < n_frames; ++f) {
+            const float* frame = samples.data() + f * length;
+            float* out = frames.data() + f * WAVEFORM_STANDARD_LENGTH;
+            if (length == WAVEFORM_STANDARD_LENGTH) {
+                std::copy(frame, frame + length, out);
+                continue;
+            }
+            // One cycle per frame, so the resampling wraps around the frame
+            for (size_t i = 0; i < WAVEFORM_STANDARD_LENGTH; ++i) {
+                const double position = static_cast<double>(i) * length / WAVEFORM_STANDARD_LENGTH;
+                const size_t index = static_cast<size_t>(position);
+                const float frac = static_cast<float>(position - static_cast<double>(index));
+                out[i] = interpolateLagrange4(frame[(index + length - 1) % length], frame[index], frame[(index + 1) % length],
+                                              frame[(index + 2) % length], frac);
+            }
+        }
+        data = std::make_shared<WavetableData>(frames.data(), n_frames);
+
+        // Drop entries whose wavetable is gone, then remember this one
+        cache.entries.erase(std::remove_if(cache.entries.begin(), cache.entries.end(),
+                                           [](const auto& entry) { return entry.second.expired(); }),
+                            cache.entries.end());
+        cache.entries.push_back({ version_key, data });
+    }
+
+    const ResourceID id = addResource(new WavetableResource(data));
+    loaded_wavetables.push_back({ key, id });
+    return id;
+}
+
+float* ResourceManager::getWaveformBuffer(ResourceID id) {
+    // IDs are handed out in order from 0 and resources are never removed, so the ID is the position
+    if (id >= resources.size()) {
+        return nullptr; // Not found
+    }
+    Resource* res = resources[id];
+    if (res->getType() != Resource::EType::kWaveform) {
+        return nullptr;
+    }
+    return static_cast<WaveformResource*>(res)->getData();
+}
+
+PartialTableResource* ResourceManager::getPartialTable(ResourceID id) {
+    if (id >= resources.size()) {
+        return nullptr;
+    }
+    Resource* res = resources[id];
+    if (res->getType() != Resource::EType::kPartialTable) {
+        return nullptr;
+    }
+    return static_cast<PartialTableResource*>(res);
+}
+
+SampleResource* ResourceManager::getSample(ResourceID id) {
+    if (id >= resources.size()) {
+        return nullptr;
+    }
+    Resource* res = resources[id];
+    if (res->getType() != Resource::EType::kSample) {
+        return nullptr;
+    }
+    return static_cast<SampleResource*>(res);
+}
+
+const WavetableData* ResourceManager::getWavetable(ResourceID id) {
+    if (id >= resources.size()) {
+        return nullptr;
+    }
+    Resource* res = resources[id];
+    if (res->getType() != Resource::EType::kWavetable) {
+        return nullptr;
     }
-    return nullptr; // Not found
+    return static_cast<WavetableResource*>(res)->getData();
 }
 
 } // namespace OrangeSodium
\ No newline at end of file
@@ -5,16 +5,25 @@
 */
 
 #include <vector>
+#include <string>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "utilities.h"
+#include "constants.h"
 
 namespace OrangeSodium{
 
+class ConvolutionKernel;
+
 class Resource{
 public:
     enum class EType{
         kWaveform = 0,
         kWavetable,
-        kSample
+        kSample,
+        kPartialTable
     };
     Resource(EType type);
     virtual ~Resource();
@@ -38,6 +47,132 @@ private:
     size_t length;
 };
 
+/// @brief Frequency ratios and amplitudes of the partials of an additive oscillator
+class PartialTableResource : public Resource {
+public:
+    PartialTableResource(size_t n_partials);
+    ~PartialTableResource() override;
+    /// @brief Partial k at ratio (k + 1) with amplitude (k + 1)^-slope; odd_only keeps odd harmonics (square, triangle-like)
+    void createHarmonicSeries(float slope, bool odd_only);
+    float* getRatios() const { return ratios; }         // Frequency of each partial relative to the played note
+    float* getAmplitudes() const { return amplitudes; } // Linear amplitude of each partial
+    size_t getNumPartials() const { return n_partials; }
+private:
+    float* ratios;
+    float* amplitudes;
+    size_t n_partials;
+};
+
+/// @brief Audio for sample playback. Every channel is stored with kPadFrames of silence on both sides, so
+/// interpolators can read a few frames past either end without bounds checks.
+class SampleResource : public Resource {
+public:
+    static constexpr size_t kPadFrames = 16;
+
+    SampleResource(size_t n_channels, size_t n_frames, float sample_rate);
+    ~SampleResource() override;
+    float* getChannel(size_t channel) const { return data + channel * stride + kPadFrames; } // Frame 0 of the channel
+    size_t getNumChannels() const { return n_channels; }
+    size_t getNumFrames() const { return n_frames; }
+    float getSampleRate() const { return sample_rate; }
+
+    float getRootNote() const { return root_note; } // MIDI note at which the sample plays at its own pitch
+    void setRootNote(float note) { root_note = note; }
+
+    /// @brief Loop frames [start, end) once playback reaches end; end <= start turns looping off
+    void setLoop(size_t start, size_t end);
+    bool isLooping() const { return loop_end > loop_start; }
+    size_t getLoopStart() const { return loop_start; }
+    size_t getLoopEnd() const { return loop_end; }
+
+    /// @brief File the sample was loaded from, or empty
+    const std::string& getSourcePath() const { return source_path; }
+    /// @param version Identifies the file's contents when it was read (path, size, modification time); kernels are
+    /// only shared with samples read from the same version
+    void setSourcePath(const std::string& path, const std::string& version) {
+        source_path = path;
+        source_version = version;
+    }
+
+    /// @brief One channel partitioned for convolution at a sample rate (resampled if it differs from the sample's),
+    /// at most kMaxConvolutionSeconds long. Built on the first call and shared by every later caller with the same
+    /// channel and rate; samples loaded from a file also share it with any ResourceManager that loaded the same file.
+    /// Builds FFTs, so call it outside the audio thread.
+    std::shared_ptr<const ConvolutionKernel> getConvolutionKernel(size_t channel, float target_sample_rate);
+
+    static constexpr float kMaxConvolutionSeconds = 20.f;
+private:
+    float* data;
+    size_t n_channels;
+    size_t n_frames;
+    size_t stride; // n_frames plus the padding on both sides
+    float sample_rate;
+    float root_note = 60.0f;
+    size_t loop_start = 0;
+    size_t loop_end = 0;
+    std::string source_path;
+    std::string source_version;
+
+    struct CachedKernel {
+        size_t channel;
+        float sample_rate;
+        std::shared_ptr<const ConvolutionKernel> kernel;
+    };
+    std::mutex kernel_mutex;
+    std::vector<CachedKernel> kernels;
+
+    std::shared_ptr<const ConvolutionKernel> buildConvolutionKernel(size_t channel, float target_sample_rate) const;
+};
+
+/// @brief Frames of a wavetable, WAVEFORM_STANDARD_LENGTH samples each, with band-limited mip levels: level m keeps
+/// the harmonics up to (WAVEFORM_STANDARD_LENGTH / 2) >> m, so the last level is a sine. Every table (a frame at a
+/// level) sits between copies of its other end, so interpolators can read a few points past either end without
+/// wrapping.
+///
+/// Level 0 holds the frames as given and is ready at once. The other levels are built on a background thread and
+/// published in order; readers use the highest ready level at or below the one they want (see getReadyMips). Once
+/// published, a level never changes, so any number of voices can read it without locks.
+class WavetableData {
+public:
+    static constexpr size_t kNumMips = 11;
+    static constexpr size_t kGuardBefore = 1;
+    static constexpr size_t kGuardAfter = 4;
+    static constexpr size_t kStride = kGuardBefore + WAVEFORM_STANDARD_LENGTH + kGuardAfter; // Between tables
+
+    /// @param frames n_frames frames of WAVEFORM_STANDARD_LENGTH samples, one after the other
+    WavetableData(const float* frames, size_t n_frames);
+    ~WavetableData(); // Stops the background build if it is still running
+
+    /// @brief First sample of a frame at a mip level; the frames of a level follow each other kStride apart
+    const float* getTable(size_t mip, size_t frame) const { return data + (mip * n_frames + frame) * kStride + kGuardBefore; }
+    size_t getNumFrames() const { return n_frames; }
+    /// @brief Number of mip levels ready to read, from level 0
+    size_t getReadyMips() const { return ready_mips.load(std::memory_order_acquire); }
+    /// @brief Block until every mip level is ready
+    void waitForMips() const;
+
+private:
+    float* data;
+    size_t n_frames;
+    std::atomic<size_t> ready_mips;
+    std::atomic<bool> cancel_build;
+    std::thread builder;
+
+    float* getTableData(size_t mip, size_t frame) { return data + (mip * n_frames + frame) * kStride + kGuardBefore; }
+    void fillGuardPoints(float* table);
+    void buildMips();
+};
+
+/// @brief A wavetable. The data is shared: loading the same file from any ResourceManager in the process (so from
+/// any synthesizer instance) returns the same WavetableData.
+class WavetableResource : public Resource {
+public:
+    WavetableResource(std::shared_ptr<WavetableData> data) : Resource(Resource::EType::kWavetable), data(std::move(data)) {}
+    const WavetableData* getData() const { return data.get(); }
+private:
+    std::shared_ptr<WavetableData> data;
+};
+
 class ResourceManager{
 public:
     ResourceManager();
@@ -45,12 +180,29 @@ public:
 
     ResourceID addResource(Resource* resource);
     ResourceID createSawtoothWaveform();
+    ResourceID createPartialTable(const float* ratios, const float* amplitudes, size_t n_partials);
+    ResourceID createHarmonicPartialTable(size_t n_partials, float slope, bool odd_only);
+
+    ResourceID createSample(const float* const* channels, size_t n_channels, size_t n_frames, float sample_rate);
+    ResourceID loadSample(const std::string& path); // Load an audio file (WAV or AIFF) once per path; returns -1 on failure
+
+    /// @brief Wavetable of n_frames frames of WAVEFORM_STANDARD_LENGTH samples, one after the other
+    ResourceID createWavetable(const float* frames, size_t n_frames);
+    /// @brief Load the first channel of an audio file as consecutive frames of frame_length samples (at most
+    /// kMaxWavetableFrames), resampled to WAVEFORM_STANDARD_LENGTH if needed. Returns -1 on failure.
+    ResourceID loadWavetable(const std::string& path, size_t frame_length = WAVEFORM_STANDARD_LENGTH);
 
     float* getWaveformBuffer(ResourceID id);
+    PartialTableResource* getPartialTable(ResourceID id); // Returns nullptr if the resource is not a partial table
+    SampleResource* getSample(ResourceID id); // Returns nullptr if the resource is not a sample
+    const WavetableData* getWavetable(ResourceID id); // Returns nullptr if the resource is not a wavetable
 
+    static constexpr size_t kMaxWavetableFrames = 256;
 
 private:
     std::vector<Resource*> resources;
+    std::vector<std::pair<std::string, ResourceID>> loaded_files; // Path of every sample loaded from a file
+    std::vector<std::pair<std::string, ResourceID>> loaded_wavetables; // Path and frame length of every wavetable loaded from a file
     ResourceID nextId;
 
     ResourceID getNextId(){ return nextId++; }
@@ -1,22 +1,29 @@
 #include "signal_buffer.h"
 #include "utilities.h"
 #include <cstring>
+#include <algorithm>
 
 namespace OrangeSodium {
 
+const SignalBuffer::ChannelHint SignalBuffer::dynamic_hint = SignalBuffer::ChannelHint();
+
 SignalBuffer::SignalBuffer(EType type, size_t n_frames, size_t num_channels)
     : buffer(nullptr),
+      owns_channel(nullptr),
       buffer_ids(nullptr),
       channel_lengths(nullptr),
       channel_divisions(nullptr),
+      channel_hints(nullptr),
       n_channels(num_channels),
       type(type) {
 
     if (n_channels > 0) {
         buffer = new float*[n_channels];
+        owns_channel = new bool[n_channels];
         buffer_ids = new ObjectID[n_channels];
         channel_lengths = new size_t[n_channels];
         channel_divisions = new size_t[n_channels];
+        channel_hints = new ChannelHint[n_channels];
 
         for (size_t i = 0; i < n_channels; ++i) {
             if (n_frames > 0) {
@@ -25,6 +32,7 @@ SignalBuffer::SignalBuffer(EType type, size_t n_frames, size_t num_channels)
             } else {
                 buffer[i] = nullptr;
             }
+            owns_channel[i] = true;
             buffer_ids[i] = 0;
             channel_lengths[i] = n_frames;
             channel_divisions[i] = 1; // Default division of 1 (no downsampling)
@@ -35,12 +43,13 @@ SignalBuffer::SignalBuffer(EType type, size_t n_frames, size_t num_channels)
 SignalBuffer::~SignalBuffer() {
     if (buffer) {
         for (size_t i = 0; i < n_channels; ++i) {
-            if (buffer[i]) {
-                delete[] buffer[i];
-            }
+            releaseChannel(i);
         }
         delete[] buffer;
     }
+    if (owns_channel) {
+        delete[] owns_channel;
+    }
     if (buffer_ids) {
         delete[] buffer_ids;
     }
@@ -50,6 +59,9 @@ SignalBuffer::~SignalBuffer() {
     if (channel_divisions) {
         delete[] channel_divisions;
     }
+    if (channel_hints) {
+        delete[] channel_hints;
+    }
 }
 
 void SignalBuffer::resize(size_t* num_channels) {
@@ -61,18 +73,23 @@ void SignalBuffer::resize(size_t* num_channels) {
 
     // Allocate new arrays
     float** new_buffer = nullptr;
+    bool* new_owns_channel = nullptr;
     ObjectID* new_buffer_ids = nullptr;
     size_t* new_channel_lengths = nullptr;
     size_t* new_channel_divisions = nullptr;
+    ChannelHint* new_channel_hints = nullptr;
 
     if (new_n_channels > 0) {
         new_buffer = new float*[new_n_channels];
+        new_owns_channel = new bool[new_n_channels];
         new_buffer_ids = new ObjectID[new_n_channels];
         new_channel_lengths = new size_t[new_n_channels];
         new_channel_divisions = new size_t[new_n_channels];
+        new_channel_hints = new ChannelHint[new_n_channels];
 
         for (size_t i = 0; i < new_n_channels; ++i) {
             new_buffer[i] = nullptr;
+            new_owns_channel[i] = true;
             new_buffer_ids[i] = 0;
             new_channel_lengths[i] = 0;
             new_channel_divisions[i] = 1;
@@ -82,12 +99,13 @@ void SignalBuffer::resize(size_t* num_channels) {
     // Delete old arrays and individual channel buffers
     if (buffer) {
         for (size_t i = 0; i < n_channels; ++i) {
-            if (buffer[i]) {
-                delete[] buffer[i];
-            }
+            releaseChannel(i);
         }
         delete[] buffer;
     }
+    if (owns_channel) {
+        delete[] owns_channel;
+    }
     if (buffer_ids) {
         delete[] buffer_ids;
     }
@@ -97,12 +115,17 @@ void SignalBuffer::resize(size_t* num_channels) {
     if (channel_divisions) {
         delete[] channel_divisions;
     }
+    if (channel_hints) {
+        delete[] channel_hints;
+    }
 
     // Update state
     buffer = new_buffer;
+    owns_channel = new_owns_channel;
     buffer_ids = new_buffer_ids;
     channel_lengths = new_channel_lengths;
     channel_divisions = new_channel_divisions;
+    channel_hints = new_channel_hints;
     n_channels = new_n_channels;
 }
 
@@ -112,62 +135,153 @@ void SignalBuffer::setChannel(size_t channel, size_t length, size_t division, Ob
     }
 
     // Delete old buffer for this channel if it exists
-    if (buffer[channel]) {
-        delete[] buffer[channel];
-        buffer[channel] = nullptr;
-    }
+    releaseChannel(channel);
+
+    // A divided channel only stores one value per division. Round up so the last, partial division still has a value.
+    division = (division > 0) ? division : 1;
+    const size_t n_elements = (length + division - 1) / division;
 
     // Allocate new buffer
-    if (length > 0) {
-        buffer[channel] = new float[length];
-        std::memset(buffer[channel], 0, length * sizeof(float));
+    if (n_elements > 0) {
+        buffer[channel] = new float[n_elements];
+        std::memset(buffer[channel], 0, n_elements * sizeof(float));
     }
 
     // Update metadata
-    channel_lengths[channel] = length;
-    channel_divisions[channel] = (division > 0) ? division : 1;
+    channel_lengths[channel] = n_elements;
+    channel_divisions[channel] = division;
+    channel_hints[channel] = ChannelHint();
     buffer_ids[channel] = id;
+}
 
-
-
-    // UNTESTED CODE - Might screw up stuff if buffer divisions are used
-    if(division > 1){
-        // Restore buffer divisions
-        setChannelDivision(channel, division);
+void SignalBuffer::resizeFrames(size_t n_frames) {
+    for (size_t ch = 0; ch < n_channels; ++ch) {
+        setChannel(ch, n_frames, channel_divisions[ch], buffer_ids[ch]);
     }
 }
 
 void SignalBuffer::assignExistingBuffer(size_t channel, float* data, size_t length, size_t division, ObjectID id) {
     if (channel < n_channels) {
-        if (buffer[channel]) {
-            delete[] buffer[channel];
-        }
+        releaseChannel(channel);
         buffer[channel] = data;
+        owns_channel[channel] = true;
         channel_lengths[channel] = length;
         channel_divisions[channel] = division;
+        channel_hints[channel] = ChannelHint();
         buffer_ids[channel] = id;
     }
 }
 
 void SignalBuffer::zeroOut() {
-    if (!buffer) {
-        return;
-    }
     for (size_t i = 0; i < n_channels; ++i) {
-        if (buffer[i]) {
-            std::memset(buffer[i], 0, channel_lengths[i] * sizeof(float));
-        }
+        setChannelSilent(i);
     }
 }
 
 void SignalBuffer::setConstantValue(size_t channel, float value, size_t offset) {
-    if (channel < n_channels && buffer[channel]) {
+    float* data = getChannel(channel);
+    if (data) {
         for (size_t i = offset; i < channel_lengths[channel]; ++i) {
-            buffer[channel][i] = value;
+            data[i] = value;
         }
     }
 }
 
+void SignalBuffer::setChannelSilent(size_t channel) noexcept {
+    if (channel < n_channels) {
+        channel_hints[channel] = ChannelHint();
+        channel_hints[channel].type = EChannelHint::kSilent;
+    }
+}
+
+void SignalBuffer::setChannelConstant(size_t channel, float value) noexcept {
+    if (channel < n_channels) {
+        channel_hints[channel] = ChannelHint();
+        channel_hints[channel].type = EChannelHint::kConstant;
+        channel_hints[channel].value = value;
+    }
+}
+
+void SignalBuffer::setChannelRamp(size_t channel, float value, float step, size_t begin, size_t end, bool materialized) noexcept {
+    if (channel < n_channels) {
+        ChannelHint& hint = channel_hints[channel];
+        hint.type = EChannelHint::kRamp;
+        hint.value = value;
+        hint.step = step;
+        hint.begin = begin;
+        hint.end = (end < channel_lengths[channel]) ? end : channel_lengths[channel];
+        hint.materialized = materialized;
+    }
+}
+
+void SignalBuffer::setChannelHint(size_t channel, const ChannelHint& hint) noexcept {
+    if (channel < n_channels) {
+        channel_hints[channel] = hint;
+        channel_hints[channel].materialized = true;
+    }
+}
+
+float SignalBuffer::getElement(size_t channel, size_t element) const noexcept {
+    if (channel >= n_channels || element >= channel_lengths[channel]) {
+        return 0.f;
+    }
+    const ChannelHint& hint = channel_hints[channel];
+    if (hint.type == EChannelHint::kDynamic || hint.materialized) {
+        return buffer[channel] ? buffer[channel][element] : 0.f;
+    }
+    if (hint.type == EChannelHint::kRamp && (element < hint.begin || element >= hint.end)) {
+        return buffer[channel] ? buffer[channel][element] : 0.f;
+    }
+    return getHintValue(hint, element);
+}
+
+void SignalBuffer::materializeRange(size_t channel, size_t begin, size_t end) noexcept {
+    const ChannelHint& hint = channel_hints[channel];
+    float* data = buffer[channel];
+    if (!data || hint.materialized) {
+        return;
+    }
+    switch (hint.type) {
+        case EChannelHint::kSilent:
+            if (begin < end) {
+                std::memset(data + begin, 0, (end - begin) * sizeof(float));
+            }
+            break;
+        case EChannelHint::kConstant:
+            for (size_t i = begin; i < end; ++i) {
+                data[i] = hint.value;
+            }
+            break;
+        case EChannelHint::kRamp:
+            for (size_t i = std::max(begin, hint.begin); i < std::min(end, hint.end); ++i) {
+                data[i] = hint.value + hint.step * static_cast<float>(i - hint.begin);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void SignalBuffer::materializeChannel(size_t channel) noexcept {
+    materializeRange(channel, 0, channel_lengths[channel]);
+    channel_hints[channel] = ChannelHint();
+}
+
+float* SignalBuffer::getChannelForOverwrite(size_t channel, size_t begin, size_t end) noexcept {
+    if (channel >= n_channels) {
+        return nullptr;
+    }
+    if (channel_hints[channel].type != EChannelHint::kDynamic) {
+        const size_t length = channel_lengths[channel];
+        begin = std::min(begin, length);
+        end = std::min(std::max(end, begin), length);
+        materializeRange(channel, 0, begin);
+        materializeRange(channel, end, length);
+        channel_hints[channel] = ChannelHint();
+    }
+    return buffer[channel];
+}
+
 void SignalBuffer::setChannelDivision(size_t channel, size_t division) {
     if (channel >= n_channels || division == 0) {
         return;
@@ -176,14 +290,12 @@ void SignalBuffer::setChannelDivision(size_t channel, size_t division) {
     // Calculate the base length (length at division 1)
     size_t base_length = channel_lengths[channel] * channel_divisions[channel];
 
-    // Calculate the new length based on the new division
-    size_t new_length = base_length / division;
+    // Calculate the new length based on the new division. Round up so the last, partial division of the block still has a value.
+    size_t new_length = (base_length + division - 1) / division;
 
     // If the new length is larger than the current buffer, we need to reallocate
     if (new_length > channel_lengths[channel]) {
-        if (buffer[channel]) {
-            delete[] buffer[channel];
-        }
+        releaseChannel(channel);
         buffer[channel] = new float[new_length];
         std::memset(buffer[channel], 0, new_length * sizeof(float));
     }
@@ -196,6 +308,7 @@ void SignalBuffer::setChannelDivision(size_t channel, size_t division) {
     // Update the division and length
     channel_divisions[channel] = division;
     channel_lengths[channel] = new_length;
+    channel_hints[channel] = ChannelHint();
 }
 
 void SignalBuffer::resize(size_t n_channels, size_t n_frames) {
@@ -204,9 +317,7 @@ void SignalBuffer::resize(size_t n_channels, size_t n_frames) {
 
     for (size_t i = 0; i < n_channels; ++i) {
         // Delete old buffer if it exists
-        if (buffer[i]) {
-            delete[] buffer[i];
-        }
+        releaseChannel(i);
 
         // Allocate new buffer
         if (n_frames > 0) {
@@ -218,7 +329,40 @@ void SignalBuffer::resize(size_t n_channels, size_t n_frames) {
 
         channel_lengths[i] = n_frames;
         channel_divisions[i] = 1; // Reset division to default
+        channel_hints[i] = ChannelHint();
+    }
+}
+
+size_t SignalBuffer::getStorageSize(size_t alignment_floats) const noexcept {
+    if (alignment_floats == 0) {
+        alignment_floats = 1;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < n_channels; ++i) {
+        total += (channel_lengths[i] + alignment_floats - 1) / alignment_floats * alignment_floats;
+    }
+    return total;
+}
+
+void SignalBuffer::bindChannelStorage(size_t channel, float* data) {
+    if (channel >= n_channels) {
+        return;
+    }
+    releaseChannel(channel);
+    buffer[channel] = data;
+    owns_channel[channel] = false;
+    channel_hints[channel] = ChannelHint();
+    if (data && channel_lengths[channel] > 0) {
+        std::memset(data, 0, channel_lengths[channel] * sizeof(float));
+    }
+}
+
+void SignalBuffer::releaseChannel(size_t channel) {
+    if (buffer[channel] && owns_channel[channel]) {
+        delete[] buffer[channel];
     }
+    buffer[channel] = nullptr;
+    owns_channel[channel] = true;
 }
 
 }
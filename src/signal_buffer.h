@@ -2,6 +2,20 @@
 #pragma once
 #include <cstddef>
 
+/*
+Channel hints
+Every channel carries a hint describing its contents over the current (sub-)block:
+  - kDynamic: read the data
+  - kSilent: every element is 0
+  - kConstant: every element is hint.value
+  - kRamp: element j in [hint.begin, hint.end) is hint.value + hint.step * (j - hint.begin)
+Producers set hints instead of filling the data (zeroOut() only marks channels silent), and consumers check
+the hint once per block to take a fast path (skip, broadcast or linear ramp). Unless a hint is marked
+materialized, the data behind it is stale. getChannel() hands out the data for reading and writing, so it first
+writes out what the hint describes and resets the hint to kDynamic; code that does not know about hints keeps
+working. Consumers that want the fast path check getChannelHint() before calling getChannel().
+*/
+
 namespace OrangeSodium{
 
 // Forward declaration for ObjectID type
@@ -15,12 +29,72 @@ public:
         kMod,
     };
 
+    enum class EChannelHint{
+        kDynamic = 0,
+        kSilent,
+        kConstant,
+        kRamp,
+    };
+
+    struct ChannelHint{
+        EChannelHint type = EChannelHint::kDynamic;
+        float value = 0.f; // kConstant: the value; kRamp: value of element begin
+        float step = 0.f; // kRamp: increment per element
+        size_t begin = 0; // kRamp: first element described
+        size_t end = 0; // kRamp: one past the last element described
+        bool materialized = false; // The data already holds what the hint describes
+    };
+
     SignalBuffer(EType type, size_t n_frames, size_t n_channels);
     ~SignalBuffer();
 
 
     EType getType() noexcept { return type; }
-    float* getChannel(size_t channel) noexcept { return (channel < n_channels) ? buffer[channel] : nullptr; }
+
+    /// @brief Channel data for reading and writing. A pending hint is written out first and reset to kDynamic.
+    float* getChannel(size_t channel) noexcept {
+        if (channel >= n_channels) {
+            return nullptr;
+        }
+        if (channel_hints[channel].type != EChannelHint::kDynamic) {
+            materializeChannel(channel);
+        }
+        return buffer[channel];
+    }
+
+    /// @brief Channel data for a writer that overwrites elements [begin, end) without reading them. A pending
+    /// hint is only written out for the elements outside that range, so the first writer of a silent channel
+    /// does not pay for zeroing what it is about to overwrite.
+    float* getChannelForOverwrite(size_t channel, size_t begin, size_t end) noexcept;
+
+    const ChannelHint& getChannelHint(size_t channel) const noexcept { return (channel < n_channels) ? channel_hints[channel] : dynamic_hint; }
+    bool isChannelSilent(size_t channel) const noexcept { return channel < n_channels && channel_hints[channel].type == EChannelHint::kSilent; }
+
+    /// @brief Mark a channel as all zeros without touching its data
+    void setChannelSilent(size_t channel) noexcept;
+
+    /// @brief Mark a channel as holding one value everywhere without touching its data
+    void setChannelConstant(size_t channel, float value) noexcept;
+
+    /// @brief Mark elements [begin, end) of a channel as a linear ramp
+    /// @param value Value of element begin
+    /// @param step Increment per element
+    /// @param materialized True if the caller has already written the ramp to the data
+    void setChannelRamp(size_t channel, float value, float step, size_t begin, size_t end, bool materialized = false) noexcept;
+
+    /// @brief Mark a channel whose data the caller has written (e.g. a control-rate producer) with a hint describing it
+    void setChannelHint(size_t channel, const ChannelHint& hint) noexcept;
+
+    /// @brief Value of one element, honouring the hint without materializing it
+    float getElement(size_t channel, size_t element) const noexcept;
+
+    /// @brief Value a non-dynamic hint gives to an element
+    static inline float getHintValue(const ChannelHint& hint, size_t element) noexcept {
+        if (hint.type == EChannelHint::kRamp) {
+            return hint.value + hint.step * (static_cast<float>(element) - static_cast<float>(hint.begin));
+        }
+        return (hint.type == EChannelHint::kConstant) ? hint.value : 0.f;
+    }
     void setBufferId(size_t channel, unsigned int id) { if (channel < n_channels) buffer_ids[channel] = id; }
 
     size_t getChannelLength(size_t channel) noexcept { return (channel < n_channels) ? channel_lengths[channel] : 0; }
@@ -33,31 +107,73 @@ public:
     void setChannelDivision(size_t channel, size_t division);
     void setConstantValue(size_t channel, float value, size_t offset = 0);
 
+    /// @brief Number of floats this buffer needs when packed into a BufferArena
+    /// @param alignment_floats Every channel is padded up to a multiple of this many floats
+    size_t getStorageSize(size_t alignment_floats) const noexcept;
+
+    /// @brief Point a channel at externally owned storage (e.g. a BufferArena block). The channel no longer owns its data.
+    /// @param channel The channel index
+    /// @param data Storage of at least getChannelLength(channel) floats. It is zeroed.
+    void bindChannelStorage(size_t channel, float* data);
+
+    /// @brief Returns true if the channel data is a view into storage owned by someone else
+    bool isChannelView(size_t channel) const noexcept { return (channel < n_channels) ? !owns_channel[channel] : false; }
+
     //void setChannelFromExistingBuffer(size_t channel, float* data, size_t length, size_t division, ObjectID id);
 
-    /// @brief Zero out all buffer data
+    /// @brief Mark every channel silent. The data is only zeroed if somebody asks for it (see getChannel).
     void zeroOut();
 
 
     void resize(size_t* num_channels);
     void resize(size_t n_channels, size_t n_frames);
 
+    /// @brief Reallocate every channel for a new block size, keeping each channel's division
+    /// @param n_frames The new block size (in audio frames)
+    void resizeFrames(size_t n_frames);
+
     /// @brief Set the buffer for a specific channel
     /// @param channel The channel index
-    /// @param length The length of the buffer (in samples)
+    /// @param length The length of the block (in audio frames); the channel holds ceil(length / division) values
     /// @param division The division of the buffer (in samples)
     /// @param id The ID of the buffer source
     void setChannel(size_t channel, size_t length, size_t division, ObjectID id);
 
+    /// @brief Range of channel elements whose frame falls inside [frame_offset, frame_offset + n_frames)
+    /// Element j of a channel with the given division holds the value at audio frame j * division.
+    /// @param division Channel division
+    /// @param length Channel length (in elements); end is clamped to it
+    static inline void getElementRange(size_t division, size_t length, size_t n_frames, size_t frame_offset, size_t& begin, size_t& end) {
+        begin = (frame_offset + division - 1) / division;
+        end = (frame_offset + n_frames + division - 1) / division;
+        if (end > length) {
+            end = length;
+        }
+        if (begin > end) {
+            begin = end;
+        }
+    }
+
 private:
     float** buffer;
-    //bool* is_from_other_buffer;
+    bool* owns_channel;       // False if the channel points into storage owned by someone else (BufferArena)
     ObjectID* buffer_ids;     //IDs that point to the source of each channel (e.g. which oscillator, filter, effect, modulation producer, etc)
     size_t* channel_lengths;  // Length of each channel (in samples)
     size_t* channel_divisions; // For modulation buffers, this indicates how many samples to skip. For example, a division of 4 means the buffer is at 1/4 the sample rate of audio
+    ChannelHint* channel_hints; // Contents of each channel over the current block (see top of file)
+    static const ChannelHint dynamic_hint; // Returned for out of range channels
     size_t n_channels;        // Number of channels
     EType type;
     ObjectID id;
+
+    // Free the channel data if this buffer owns it
+    void releaseChannel(size_t channel);
+
+    // Write out a pending hint and reset it to kDynamic
+    void materializeChannel(size_t channel) noexcept;
+
+    // Write out a pending hint for elements [begin, end) only
+    void materializeRange(size_t channel, size_t begin, size_t end) noexcept;
 };
 
 }
\ No newline at end of file
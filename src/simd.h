@@ -14,9 +14,12 @@
 
 #ifdef OS_AVX
 #define OS_SIMD_WIDTH 8
+#define OS_SIMD_ALIGNMENT 32 // Bytes required by OS_SIMD_LOAD_ALIGNED/OS_SIMD_STORE_ALIGNED
 typedef __m256 os_simd_t;
 #define OS_SIMD_LOAD(x) _mm256_loadu_ps(x)
 #define OS_SIMD_STORE(x, y) _mm256_storeu_ps(x, y)
+#define OS_SIMD_LOAD_ALIGNED(x) _mm256_load_ps(x)
+#define OS_SIMD_STORE_ALIGNED(x, y) _mm256_store_ps(x, y)
 #define OS_SIMD_SET1(x) _mm256_set1_ps(x)
 #define OS_SIMD_ADD(x, y) _mm256_add_ps(x, y)
 #define OS_SIMD_SUB(x, y) _mm256_sub_ps(x, y)
@@ -41,9 +44,12 @@ typedef __m256 os_simd_t;
 #define OS_SIMD_FNMMADD(x, y, z) _mm256_fnmadd_ps(x, y, z)
 #elif defined(OS_SSE)
 #define OS_SIMD_WIDTH 4
+#define OS_SIMD_ALIGNMENT 16 // Bytes required by OS_SIMD_LOAD_ALIGNED/OS_SIMD_STORE_ALIGNED
 typedef __m128 os_simd_t;
 #define OS_SIMD_LOAD(x) _mm_loadu_ps(x)
 #define OS_SIMD_STORE(x, y) _mm_storeu_ps(x, y)
+#define OS_SIMD_LOAD_ALIGNED(x) _mm_load_ps(x)
+#define OS_SIMD_STORE_ALIGNED(x, y) _mm_store_ps(x, y)
 #define OS_SIMD_SET1(x) _mm_set1_ps(x)
 #define OS_SIMD_ADD(x, y) _mm_add_ps(x, y)
 #define OS_SIMD_SUB(x, y) _mm_sub_ps(x, y)
@@ -4,6 +4,7 @@
 #include <fstream>
 #include "filters/ZDF_filter.h"
 #include "console_utility.h"
+#include "dsp/vector_ops.h"
 #include <cassert>
 
 namespace OrangeSodium {
@@ -35,6 +36,9 @@ Synthesizer::Synthesizer(float sample_rate, size_t n_frames) : m_context(nullptr
 }
 
 Synthesizer::~Synthesizer() {
+    // Voices unregister their objects from the context, so they go before it
+    voices.clear();
+
     if (program) {
         delete program;
         program = nullptr;
@@ -110,7 +114,7 @@ void Synthesizer::buildSynthFromProgram() {
 
     voices.resize(0);
     for(size_t i = 0; i < m_context->n_voices; ++i){
-        Voice* new_voice = program->buildVoice();
+        Voice* new_voice = program->buildVoice(i);
         if(!new_voice) {
             ConsoleUtility::logRed(m_context->log_stream, "Error building voice " + std::to_string(i));
             return;
@@ -125,6 +129,45 @@ void Synthesizer::buildSynthFromProgram() {
     connectEffects();
 }
 
+void Synthesizer::prepareHotReload(const Synthesizer& running) {
+    hot_reload_plan.clear();
+    hot_reload_source = nullptr;
+    if (!program_valid || !running.program_valid) {
+        return;
+    }
+
+    // Voices are paired by position; voices beyond the running count start fresh
+    for (size_t i = 0; i < voices.size() && i < running.voices.size(); ++i) {
+        voices[i]->matchObjectsWith(*running.voices[i], hot_reload_plan);
+    }
+    for (size_t i = 0; i < master_effect_chains.size(); ++i) {
+        if (i < running.master_effect_chains.size()) {
+            master_effect_chains[i]->matchEffectsWith(*running.master_effect_chains[i], hot_reload_plan);
+        } else {
+            hot_reload_plan.n_new_objects += master_effect_chains[i]->getNumEffects();
+        }
+    }
+    hot_reload_source = &running;
+
+    *m_context->log_stream << "[synthesizer.cpp] Hot reload: " << hot_reload_plan.getNumMatches() << " objects keep their state, "
+                           << hot_reload_plan.n_new_objects << " start fresh" << std::endl;
+}
+
+void Synthesizer::completeHotReload() {
+    if (!hot_reload_source) {
+        return;
+    }
+    hot_reload_plan.apply();
+
+    // Both builds design their half-band filters the same way, so the delay lines carry over as they are
+    const Synthesizer& running = *hot_reload_source;
+    const size_t n_downsamplers = (m_context->oversampling == running.m_context->oversampling) ? downsamplers.size() : 0;
+    for (size_t c = 0; c < n_downsamplers && c < running.downsamplers.size(); ++c) {
+        downsamplers[c] = running.downsamplers[c];
+    }
+    hot_reload_source = nullptr;
+}
+
 void Synthesizer::processIntermediateBlock(size_t n_channels, size_t n_frames) {
     if (!program_valid) {
         return;
@@ -151,12 +194,24 @@ void Synthesizer::processIntermediateBlock(size_t n_channels, size_t n_frames) {
 
     for(auto* audio_buffer : audio_output_buffer_ptrs) {
         for(size_t c = 0; c < n_channels; ++c) {
-            float* oversampled_data = oversampled_buffer->getChannel(c);
+            if(audio_buffer->isChannelSilent(c)) {
+                continue; // Nothing played into this channel
+            }
             float* audio_buf_data = audio_buffer->getChannel(c);
-            if(oversampled_data && audio_buf_data) {
-                for(size_t f = 0; f < oversampled_frames; ++f) {
-                    oversampled_data[f + frame_offset] += audio_buf_data[f + frame_offset];
+            if(!audio_buf_data) {
+                continue;
+            }
+            // The first buffer to reach a silent channel copies instead of adding to zeros
+            if(oversampled_buffer->isChannelSilent(c)) {
+                float* oversampled_data = oversampled_buffer->getChannelForOverwrite(c, frame_offset, frame_offset + oversampled_frames);
+                if(oversampled_data) {
+                    vectorCopy(oversampled_data + frame_offset, audio_buf_data + frame_offset, oversampled_frames);
                 }
+                continue;
+            }
+            float* oversampled_data = oversampled_buffer->getChannel(c);
+            if(oversampled_data) {
+                vectorAdd(oversampled_data + frame_offset, audio_buf_data + frame_offset, oversampled_frames);
             }
         }
     }
@@ -173,6 +228,11 @@ void Synthesizer::finishBlock(float** output_buffers, size_t n_channels, size_t
         float* output_data = output_buffers[c];
         
         if(oversampled_data && output_data) {
+            if(m_context->oversampling == 1) {
+                // Program runs at the host rate (set_oversampling(1))
+                std::memcpy(master_output_buffer->getChannel(c), oversampled_data, n_frames * sizeof(float));
+                continue;
+            }
             // Process in blocks for HIIR
             downsamplers[c].process_block(master_output_buffer->getChannel(c), oversampled_data, n_frames);
         }
@@ -239,6 +299,7 @@ void Synthesizer::prepare(size_t n_channels, size_t n_frames, float sample_rate)
         effect_chain->setSampleRate(m_context->sample_rate);
     }
 
+    layoutBuffers();
 }
 
 void Synthesizer::processMidiEvent(int midi_note, bool note_on){
@@ -341,19 +402,13 @@ ObjectID Synthesizer::addAudioBuffer(size_t n_channels) {
     SignalBuffer* new_buffer = new SignalBuffer(SignalBuffer::EType::kAudio, m_context->max_n_frames, n_channels);
     ObjectID new_id = m_context->getNextObjectID();
     new_buffer->setId(new_id);
+    m_context->object_registry.add(new_id, EObjectType::kAudioBuffer, new_buffer, this, audio_buffers.size());
     audio_buffers.push_back(new_buffer);
     return new_id;
 }
 
 SignalBuffer* Synthesizer::getAudioBufferByID(ObjectID id) {
-    // Check oversampled buffers first
-    for(auto* buffer : audio_buffers) {
-        if(buffer && buffer->getId() == id) {
-            return buffer;
-        }
-    }
-
-    return nullptr; // Not found
+    return m_context->object_registry.find<SignalBuffer>(id, EObjectType::kAudioBuffer, this);
 }
 
 ErrorCode Synthesizer::assignAudioBufferToOutput(ObjectID buffer_id) {
@@ -389,11 +444,42 @@ void Synthesizer::connectEffects() {
         if(effect_chain) {
             effect_chain->connectEffects();
         }
-    }  
+    }
+
+    layoutBuffers();
+}
+
+void Synthesizer::layoutBuffers() {
+    // Voices mix into audio_buffers, then master chains run, then everything is summed into oversampled_buffer
+    buffer_arena.clear();
+    for(auto* audio_buffer : audio_buffers) {
+        buffer_arena.addBuffer(audio_buffer);
+    }
+
+    std::vector<SignalBuffer*> chain_buffers;
+    for(auto* effect_chain : master_effect_chains) {
+        if(effect_chain) {
+            effect_chain->collectBuffers(chain_buffers);
+        }
+    }
+    for(auto* buffer : chain_buffers) {
+        buffer_arena.addBuffer(buffer);
+    }
+
+    buffer_arena.addBuffer(oversampled_buffer);
+    buffer_arena.addBuffer(master_output_buffer);
+    buffer_arena.layout();
 }
 
 
 EffectChain* Synthesizer::getEffectChainByIndex(EffectChainIndex index) {
+    // Master chain indices count down from -1 in creation order
+    if(index < 0) {
+        const size_t position = getEffectChainIndex(index);
+        if(position < master_effect_chains.size() && master_effect_chains[position] && master_effect_chains[position]->getIndex() == index) {
+            return master_effect_chains[position];
+        }
+    }
     for(auto* effect_chain : master_effect_chains) {
         if(effect_chain && effect_chain->getIndex() == index) {
             return effect_chain;
@@ -420,10 +506,8 @@ void Synthesizer::beginBlock() {
         }
     }
 
-    // Clear buffers
-    if(master_output_buffer) {
-        master_output_buffer->zeroOut();
-    }
+    // Clear buffers. Clearing only marks them silent; the first writer overwrites instead of adding.
+    // master_output_buffer is not cleared, finishBlock overwrites it.
     for(auto* audio_buffer : audio_buffers) {
         if(audio_buffer) {
             audio_buffer->zeroOut();
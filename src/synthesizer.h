@@ -4,6 +4,8 @@
 #include "voice.h"
 #include <memory>
 #include "program.h"
+#include "buffer_arena.h"
+#include "hot_reload.h"
 #include "hiir/PolyphaseIir2Designer.h"
 #include "hiir/Upsampler2xFpu.h"
 #include "hiir/Downsampler2xFpu.h"
@@ -17,6 +19,15 @@ public:
     void loadScript(std::string script_path);
     void loadScriptFromString(const std::string& script_data);
     void buildSynthFromProgram();
+    bool isProgramValid() const { return program_valid; }
+
+    /// @brief Prepare to take over the state of a running synthesizer. Call on a freshly built and prepared
+    /// synthesizer, off the audio thread; running may keep processing meanwhile.
+    void prepareHotReload(const Synthesizer& running);
+
+    /// @brief Copy the running state into this synthesizer. Call on the audio thread between blocks, just before
+    /// this synthesizer replaces the running one; the running one must not have been deleted yet.
+    void completeHotReload();
 
     //void setSampleRate(float sample_rate) { m_context->sample_rate = sample_rate; }
     float getSampleRate() const { return static_cast<float>(m_context->sample_rate) * static_cast<float>(m_context->oversampling); }
@@ -62,6 +73,12 @@ private:
 
     bool program_valid;
 
+    HotReloadPlan hot_reload_plan;
+    const Synthesizer* hot_reload_source = nullptr; // Running synthesizer of a prepared hot reload
+
+    BufferArena buffer_arena; // Contiguous storage for master buffers, laid out in processing order
+    void layoutBuffers();
+
     static constexpr int HIIR_COEFFS = 8; // or 12 for higher quality
     std::vector<hiir::Downsampler2xFpu<HIIR_COEFFS>> downsamplers;
 
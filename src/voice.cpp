@@ -1,10 +1,13 @@
 #include "voice.h"
 #include "oscillators/sine_osc.h"
 #include "oscillators/waveform_osc.h"
+#include "oscillators/additive_osc.h"
 #include "effects/effect_filter.h"
 #include <cassert>
 #include "synthesizer.h"
 #include "console_utility.h"
+#include "dsp/vector_ops.h"
+#include <algorithm>
 
 namespace OrangeSodium{
 
@@ -12,8 +15,9 @@ static Synthesizer* getSynthesizerFromVoice(Voice* voice) {
     return static_cast<Synthesizer*>(voice->getParentSynthesizer());
 }
 
-Voice::Voice(Context* context, void* parent_synthesizer) : m_context(context), parent_synthesizer(parent_synthesizer)
+Voice::Voice(Context* context, void* parent_synthesizer, size_t voice_index) : modulation_router(context), m_context(context), parent_synthesizer(parent_synthesizer)
 {
+    this->voice_index = voice_index;
     //voice_master_audio_buffer = new SignalBuffer(SignalBuffer::EType::kAudio, context->max_n_frames, 2); // Default to stereo
     is_playing = false;
     is_releasing = false;
@@ -23,10 +27,23 @@ Voice::Voice(Context* context, void* parent_synthesizer) : m_context(context), p
     should_reset_portamento = true;
     portamento_g = 0.f;
     should_always_glide = false;
+    frame_offset = 0;
 }
 
 Voice::~Voice()
 {
+    // Forget this voice's objects; effects are removed by their chains
+    ObjectRegistry& registry = m_context->object_registry;
+    for (ObjectID id : oscillator_ids) {
+        registry.remove(id);
+    }
+    for (ObjectID id : modulation_producer_ids) {
+        registry.remove(id);
+    }
+    for (auto* buffer : audio_buffers) {
+        registry.remove(buffer->getId());
+    }
+
     // Clean up oscillators
     for (auto* osc : oscillators) {
         delete osc;
@@ -56,6 +73,7 @@ ObjectID Voice::addSineOscillator(size_t n_channels, float amplitude) {
     mod_buffer->setChannelDivision(0, 1); // Pitch channel at audio rate
     mod_buffer->setChannelDivision(1, 1); // Amplitude channel at audio rate
     osc->setModBuffer(mod_buffer);
+    m_context->object_registry.add(id, EObjectType::kOscillator, osc, this, oscillators.size());
     oscillators.push_back(osc);
     oscillator_ids.push_back(id);
     return id;
@@ -69,21 +87,129 @@ ObjectID Voice::addWaveformOscillator(size_t n_channels, ResourceID waveform_id,
     mod_buffer->setChannelDivision(0, 1); // Pitch channel at audio rate
     mod_buffer->setChannelDivision(1, 1); // Amplitude channel at audio rate
     osc->setModBuffer(mod_buffer);
+    m_context->object_registry.add(id, EObjectType::kOscillator, osc, this, oscillators.size());
+    oscillators.push_back(osc);
+    oscillator_ids.push_back(id);
+    return id;
+}
+
+ObjectID Voice::addAdditiveOscillator(size_t n_channels, ResourceID table_id, float amplitude) {
+    ObjectID id = m_context->getNextObjectID();
+    AdditiveOscillator* osc = new AdditiveOscillator(m_context, id, table_id, n_channels, amplitude);
+    SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, 2); // Additive oscillator uses 2 mod channels (pitch, amplitude)
+    mod_buffer->setChannelDivision(0, 1); // Pitch channel at audio rate
+    mod_buffer->setChannelDivision(1, 1); // Amplitude channel at audio rate
+    osc->setModBuffer(mod_buffer);
+    m_context->object_registry.add(id, EObjectType::kOscillator, osc, this, oscillators.size());
+    oscillators.push_back(osc);
+    oscillator_ids.push_back(id);
+    return id;
+}
+
+ObjectID Voice::addVAOscillator(size_t n_channels, VAOscillator::EShape shape, float amplitude, float pulse_width) {
+    ObjectID id = m_context->getNextObjectID();
+    VAOscillator* osc = new VAOscillator(m_context, id, shape, n_channels, amplitude);
+    osc->setPulseWidth(pulse_width);
+    SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, 4); // VA oscillator uses 4 mod channels (pitch, amplitude, pulse width, sync)
+    for (size_t ch = 0; ch < mod_buffer->getNumChannels(); ++ch) {
+        mod_buffer->setChannelDivision(ch, 1); // All channels at audio rate
+    }
+    osc->setModBuffer(mod_buffer);
+    m_context->object_registry.add(id, EObjectType::kOscillator, osc, this, oscillators.size());
+    oscillators.push_back(osc);
+    oscillator_ids.push_back(id);
+    return id;
+}
+
+ObjectID Voice::addFMOscillator(size_t n_channels, size_t n_operators, float amplitude) {
+    ObjectID id = m_context->getNextObjectID();
+    FMOscillator* osc = new FMOscillator(m_context, id, n_operators, n_channels, amplitude);
+    // Pitch, amplitude, then the level of each operator
+    SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, FMOscillator::kFirstLevelChannel + osc->getNumOperators());
+    for (size_t ch = 0; ch < mod_buffer->getNumChannels(); ++ch) {
+        mod_buffer->setChannelDivision(ch, 1); // All channels at audio rate
+    }
+    osc->setModBuffer(mod_buffer);
+    m_context->object_registry.add(id, EObjectType::kOscillator, osc, this, oscillators.size());
+    oscillators.push_back(osc);
+    oscillator_ids.push_back(id);
+    return id;
+}
+
+ObjectID Voice::addSamplerOscillator(size_t n_channels, ResourceID sample_id, float amplitude) {
+    ObjectID id = m_context->getNextObjectID();
+    SamplerOscillator* osc = new SamplerOscillator(m_context, id, sample_id, n_channels, amplitude);
+    SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, 2); // Sampler uses 2 mod channels (pitch, amplitude)
+    for (size_t ch = 0; ch < mod_buffer->getNumChannels(); ++ch) {
+        mod_buffer->setChannelDivision(ch, 1); // All channels at audio rate
+    }
+    osc->setModBuffer(mod_buffer);
+    m_context->object_registry.add(id, EObjectType::kOscillator, osc, this, oscillators.size());
+    oscillators.push_back(osc);
+    oscillator_ids.push_back(id);
+    return id;
+}
+
+ObjectID Voice::addGranularOscillator(size_t n_channels, ResourceID sample_id, float amplitude) {
+    ObjectID id = m_context->getNextObjectID();
+    GranularOscillator* osc = new GranularOscillator(m_context, id, sample_id, n_channels, amplitude);
+    // Pitch, amplitude, density, position, spray
+    SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, GranularOscillator::kNumModChannels);
+    for (size_t ch = 0; ch < mod_buffer->getNumChannels(); ++ch) {
+        mod_buffer->setChannelDivision(ch, 1); // All channels at audio rate
+    }
+    osc->setModBuffer(mod_buffer);
+    m_context->object_registry.add(id, EObjectType::kOscillator, osc, this, oscillators.size());
+    oscillators.push_back(osc);
+    oscillator_ids.push_back(id);
+    return id;
+}
+
+ObjectID Voice::addWavetableOscillator(size_t n_channels, ResourceID wavetable_id, float amplitude) {
+    ObjectID id = m_context->getNextObjectID();
+    WavetableOscillator* osc = new WavetableOscillator(m_context, id, wavetable_id, n_channels, amplitude);
+    // Pitch, amplitude, position
+    SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, WavetableOscillator::kNumModChannels);
+    for (size_t ch = 0; ch < mod_buffer->getNumChannels(); ++ch) {
+        mod_buffer->setChannelDivision(ch, 1); // All channels at audio rate
+    }
+    osc->setModBuffer(mod_buffer);
+    m_context->object_registry.add(id, EObjectType::kOscillator, osc, this, oscillators.size());
+    oscillators.push_back(osc);
+    oscillator_ids.push_back(id);
+    return id;
+}
+
+ObjectID Voice::addNoiseOscillator(size_t n_channels, NoiseOscillator::EColor color, float amplitude) {
+    ObjectID id = m_context->getNextObjectID();
+    NoiseOscillator* osc = new NoiseOscillator(m_context, id, color, n_channels, amplitude, voice_index);
+    SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, 2); // Noise uses 2 mod channels (pitch, amplitude)
+    for (size_t ch = 0; ch < mod_buffer->getNumChannels(); ++ch) {
+        mod_buffer->setChannelDivision(ch, 1); // All channels at audio rate
+    }
+    osc->setModBuffer(mod_buffer);
+    m_context->object_registry.add(id, EObjectType::kOscillator, osc, this, oscillators.size());
     oscillators.push_back(osc);
     oscillator_ids.push_back(id);
     return id;
 }
 
 ObjectID Voice::addBasicEnvelopeInternal(BasicEnvelope* env, ObjectID id) {
-    SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, 4); // Basic envelope uses 4 mod channels (attack, decay, sustain, release)
-    SignalBuffer* mod_out_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, 1); // Output buffer for envelope
-    //mod_buffer->setId(m_context->getNextObjectID());
-    //mod_out_buffer->setId(id);
-    //mod_buffer->setChannelDivision(0, 1);
-    mod_out_buffer->setChannelDivision(0, 1); // Envelope output at audio rate
-    env->setOutputBuffer(mod_out_buffer);
-    env->setModBuffer(mod_buffer);
-    modulation_producers.push_back(env);
+    return addModulationProducerInternal(env, id, 4); // Basic envelope uses 4 mod channels (attack, decay, sustain, release)
+}
+
+ObjectID Voice::addModulationProducerInternal(ModulationProducer* producer, ObjectID id, size_t n_mod_inputs) {
+    SignalBuffer* mod_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, n_mod_inputs);
+    SignalBuffer* mod_out_buffer = new SignalBuffer(SignalBuffer::EType::kMod, m_context->max_n_frames, 1); // Output buffer for the producer
+    // Producers run at control rate
+    for (size_t ch = 0; ch < mod_buffer->getNumChannels(); ++ch) {
+        mod_buffer->setChannelDivision(ch, m_context->control_rate_division);
+    }
+    mod_out_buffer->setChannelDivision(0, m_context->control_rate_division);
+    producer->setOutputBuffer(mod_out_buffer);
+    producer->setModBuffer(mod_buffer);
+    m_context->object_registry.add(id, EObjectType::kModulatorProducer, producer, this, modulation_producers.size());
+    modulation_producers.push_back(producer);
     modulation_producer_ids.push_back(id);
     return id;
 }
@@ -100,34 +226,49 @@ ObjectID Voice::addBasicEnvelope(float attack_time, float decay_time, float sust
     return addBasicEnvelopeInternal(env, id);
 }
 
+ObjectID Voice::addSampleAndHold(float rate) {
+    ObjectID id = m_context->getNextObjectID();
+    SampleAndHold* producer = new SampleAndHold(m_context, id, voice_index, rate);
+    return addModulationProducerInternal(producer, id, 0);
+}
+
+ObjectID Voice::addSmoothRandom(float rate) {
+    ObjectID id = m_context->getNextObjectID();
+    SmoothRandom* producer = new SmoothRandom(m_context, id, voice_index, rate);
+    return addModulationProducerInternal(producer, id, 0);
+}
+
 EObjectType Voice::getObjectType(ObjectID id) {
-    // Check oscillators
-    for (const auto& osc_id : oscillator_ids) {
-        if (osc_id == id) {
-            return EObjectType::kOscillator;
-        }
+    const ObjectRegistry::Entry& entry = m_context->object_registry.get(id);
+    if (entry.owner == this) {
+        return entry.type;
+    }
+
+    // Effects are owned by their chain
+    if (entry.type == EObjectType::kEffect && getEffectChainOwning(id)) {
+        return EObjectType::kEffect;
     }
 
-    // Check effect chains
+    // Effect chains are identified by their index
     for (auto& effect_chain : effect_chains) {
-        if (effect_chain->getIndex() == id) {
+        if (effect_chain->getIndex() == static_cast<EffectChainIndex>(id)) {
             return EObjectType::kEffectChain;
         }
+    }
+    return EObjectType::kUndefined; // Not found
+}
 
-        // Check effects within effect chains
-        if (effect_chain->objectIDIsEffect(id)) {
-            return EObjectType::kEffect;
-        }
+EffectChain* Voice::getEffectChainOwning(ObjectID effect_id) {
+    const ObjectRegistry::Entry& entry = m_context->object_registry.get(effect_id);
+    if (entry.type != EObjectType::kEffect) {
+        return nullptr;
     }
-    
-    // Check audio buffers
-    for (const auto& buffer : audio_buffers) {
-        if (buffer->getId() == id) {
-            return EObjectType::kAudioBuffer; // Assuming audio buffers are considered effects here
+    for (auto* effect_chain : effect_chains) {
+        if (effect_chain == entry.owner) {
+            return effect_chain;
         }
     }
-
-    return EObjectType::kUndefined; // Not found
+    return nullptr;
 }
 
 void Voice::resizeBuffers(size_t n_frames) {
@@ -154,88 +295,162 @@ void Voice::resizeBuffers(size_t n_frames) {
     for (auto* effect_chain : effect_chains) {
         effect_chain->resizeBuffers(n_frames);
     }
+
+    // Resizing reallocates channels outside of the arena, so pack them again
+    layoutBuffers();
+}
+
+void Voice::layoutBuffers() {
+    // Order follows processVoice so a block walks through the arena front to back
+    buffer_arena.clear();
+    for (auto* mod_prod : modulation_producers) {
+        buffer_arena.addBuffer(mod_prod->getModBuffer());
+        buffer_arena.addBuffer(mod_prod->getOutputBuffer());
+    }
+    for (auto* osc : oscillators) {
+        buffer_arena.addBuffer(osc->getModBuffer());
+        buffer_arena.addBuffer(osc->getOutputBuffer());
+    }
+
+    std::vector<SignalBuffer*> chain_buffers;
+    for (auto* effect_chain : effect_chains) {
+        effect_chain->collectBuffers(chain_buffers);
+    }
+    for (auto* buffer : chain_buffers) {
+        buffer_arena.addBuffer(buffer);
+    }
+
+    // Anything not reached above (e.g. buffers only routed to the master)
+    for (auto* buffer : audio_buffers) {
+        buffer_arena.addBuffer(buffer);
+    }
+
+    buffer_arena.layout();
+
+    // Channels moved into the arena
+    modulation_router.resolveChannels();
+
+    planBufferWrites();
+}
+
+void Voice::planBufferWrites() {
+    // Within a sub-block, oscillators run first, then the effect chains in order. The first oscillator that writes
+    // a buffer overwrites it and later ones add to it; effect chains always overwrite their output. Buffers read
+    // (as an oscillator's audio input or a chain's input) before anything writes them are cleared every block, so
+    // the reader sees silence instead of what was left from the last block.
+    std::vector<SignalBuffer*> written;
+    std::vector<SignalBuffer*> read_before_write;
+    auto is_written = [&written](SignalBuffer* buffer) {
+        return std::find(written.begin(), written.end(), buffer) != written.end();
+    };
+
+    for (auto* osc : oscillators) {
+        SignalBuffer* input = osc->getInputBuffer();
+        if (input && !is_written(input)) {
+            read_before_write.push_back(input);
+        }
+        SignalBuffer* output = osc->getOutputBuffer();
+        const bool first_writer = output && !is_written(output);
+        osc->setOverwriteOutput(first_writer);
+        if (first_writer) {
+            written.push_back(output);
+        }
+    }
+    for (auto* effect_chain : effect_chains) {
+        SignalBuffer* input = effect_chain->getInputBuffer();
+        if (input && !is_written(input)) {
+            read_before_write.push_back(input);
+        }
+        SignalBuffer* output = effect_chain->getOutputBuffer();
+        if (output && !is_written(output)) {
+            written.push_back(output);
+        }
+    }
+
+    cleared_audio_buffers.clear();
+    for (auto* buffer : audio_buffers) {
+        if (buffer->getType() != SignalBuffer::EType::kAudio) {
+            continue;
+        }
+        if (!is_written(buffer) || std::find(read_before_write.begin(), read_before_write.end(), buffer) != read_before_write.end()) {
+            cleared_audio_buffers.push_back(buffer);
+        }
+    }
 }
 
 ObjectID Voice::addAudioBuffer(size_t n_frames, size_t n_channels) {
     ObjectID id = m_context->getNextObjectID();
     SignalBuffer* buffer = new SignalBuffer(SignalBuffer::EType::kAudio, n_frames, n_channels);
     buffer->setId(id);
+    m_context->object_registry.add(id, EObjectType::kAudioBuffer, buffer, this, audio_buffers.size());
     audio_buffers.push_back(buffer);
     return id;
 }
 
 SignalBuffer* Voice::getAudioBufferByID(ObjectID id) {
-    for (auto* buffer : audio_buffers) {
-        if (buffer->getId() == id) {
-            return buffer;
-        }
-    }
-    return nullptr; // Not found
+    return m_context->object_registry.find<SignalBuffer>(id, EObjectType::kAudioBuffer, this);
+}
+
+Oscillator* Voice::getOscillatorByID(ObjectID id) {
+    return m_context->object_registry.find<Oscillator>(id, EObjectType::kOscillator, this);
 }
 
 void Voice::assignOscillatorAudioBuffer(ObjectID osc_id, ObjectID buffer_id) {
-    // Find the oscillator
-    for (size_t i = 0; i < oscillators.size(); ++i) {
-        if (oscillator_ids[i] == osc_id) {
-            // Find the buffer
-            for (auto* buffer : audio_buffers) {
-                if (buffer->getId() == buffer_id) {
-                    oscillators[i]->setOutputBuffer(buffer);
-                    return;
-                }
-            }
-        }
+    Oscillator* osc = getOscillatorByID(osc_id);
+    SignalBuffer* buffer = getAudioBufferByID(buffer_id);
+    if (osc && buffer) {
+        osc->setOutputBuffer(buffer);
+        planBufferWrites();
     }
 }
 
+ErrorCode Voice::assignOscillatorInputBuffer(ObjectID osc_id, ObjectID buffer_id) {
+    Oscillator* osc = getOscillatorByID(osc_id);
+    if (!osc) {
+        return ErrorCode::kObjectNotFound;
+    }
+    SignalBuffer* buffer = getAudioBufferByID(buffer_id);
+    if (!buffer) {
+        return ErrorCode::kAudioBufferNotFound;
+    }
+    osc->setInputBuffer(buffer);
+    planBufferWrites();
+    return ErrorCode::kNoError;
+}
+
 ObjectID Voice::getConnectedAudioBufferForOscillator(ObjectID osc_id) {
-    // Find the oscillator
-    for (size_t i = 0; i < oscillators.size(); ++i) {
-        if (oscillator_ids[i] == osc_id) {
-            SignalBuffer* output_buffer = oscillators[i]->getOutputBuffer();
-            if (output_buffer) {
-                return output_buffer->getId();
-            } else {
-                return -1; // No buffer assigned
-            }
-        }
+    Oscillator* osc = getOscillatorByID(osc_id);
+    if (!osc) {
+        return -1; // Oscillator not found
+    }
+    SignalBuffer* output_buffer = osc->getOutputBuffer();
+    if (output_buffer) {
+        return output_buffer->getId();
     }
-    return -1; // Oscillator not found
+    return -1; // No buffer assigned
 }
 
 ErrorCode Voice::addAudioBufferToMaster(ObjectID buffer_id, ObjectID master_buffer_id) {
-    // Find the buffer
-    for (auto* buffer : audio_buffers) {
-        if (buffer->getId() == buffer_id) {
-            voice_master_audio_buffer_src_ptrs.push_back(buffer);
-
-            // Now find the master buffer in the parent synthesizer
-            Synthesizer* synth = getSynthesizerFromVoice(this);
-            SignalBuffer* synth_audio_buffer = synth->getAudioBufferByID(master_buffer_id);
-            if (synth_audio_buffer) {
-                parent_audio_buffer_ptrs.push_back(synth_audio_buffer);
-                //ConsoleUtility::logYellow(m_context->log_stream, "Connected voice buffer ID " + std::to_string(buffer_id) + " to master buffer ID " + std::to_string(master_buffer_id));
-                
-            } else {
-                return ErrorCode::kAudioBufferNotFound;
-            }
-            return ErrorCode::kNoError;
-        }
+    SignalBuffer* buffer = getAudioBufferByID(buffer_id);
+    if (!buffer) {
+        return ErrorCode::kAudioBufferNotFound;
     }
 
-    return ErrorCode::kAudioBufferNotFound;
+    // Now find the master buffer in the parent synthesizer. Both lists are only extended together, they correspond.
+    Synthesizer* synth = getSynthesizerFromVoice(this);
+    SignalBuffer* synth_audio_buffer = synth->getAudioBufferByID(master_buffer_id);
+    if (!synth_audio_buffer) {
+        return ErrorCode::kAudioBufferNotFound;
+    }
+    voice_master_audio_buffer_src_ptrs.push_back(buffer);
+    parent_audio_buffer_ptrs.push_back(synth_audio_buffer);
+    return ErrorCode::kNoError;
 }
 
 
 ErrorCode Voice::addModulation(ObjectID source_id, std::string source_param, ObjectID target_id, std::string target_param, float amount, bool is_centered) {
     // Find the modulation source
-    ModulationProducer* source_ptr = nullptr;
-    for (auto* mod_prod : modulation_producers) {
-        if (mod_prod->getId() == source_id) {
-            source_ptr = mod_prod;
-            break;
-        }
-    }
+    ModulationProducer* source_ptr = m_context->object_registry.find<ModulationProducer>(source_id, EObjectType::kModulatorProducer, this);
     if (!source_ptr) {
         return ErrorCode::kModulationSourceNotFound;
     }
@@ -263,13 +478,7 @@ ErrorCode Voice::addModulation(ObjectID source_id, std::string source_param, Obj
     
     if (dest_type == EObjectType::kOscillator){
         // Find the oscillator with the target_id
-        Oscillator* target_osc = nullptr;
-        for (size_t i = 0; i < oscillators.size(); ++i) {
-            if (oscillator_ids[i] == target_id) {
-                target_osc = oscillators[i];
-                break;
-            }
-        }
+        Oscillator* target_osc = getOscillatorByID(target_id);
 
         if (!target_osc) {
             return ErrorCode::kModulationDestinationNotFound;
@@ -292,36 +501,24 @@ ErrorCode Voice::addModulation(ObjectID source_id, std::string source_param, Obj
         }
 
         // We now have the source and destination pointers, and we have the destination index
-        Modulation* mod = new Modulation();
-        mod->modulation_source = source_ptr;
-        mod->modulation_destination = target_osc;
-        mod->amount = amount;
-        mod->source_index = source_index;
-        mod->dest_index = dest_index;
-        mod->dest_type = dest_type;
-        modulations.push_back(mod);
+        Modulation mod;
+        mod.source_id = source_id;
+        mod.source_index = source_index;
+        mod.dest_id = target_id;
+        mod.dest_index = dest_index;
+        mod.amount = amount;
+        mod.dest_type = dest_type;
+        mod.source_buffer = source_ptr->getOutputBuffer();
+        mod.dest_buffer = target_osc->getModBuffer();
+        modulation_router.addModulation(mod);
     } else if (dest_type == EObjectType::kEffect) {
         // Find the effect with the target_id
-        Effect* target_eff = nullptr;
-        EffectChain* parent_effect_chain = nullptr;
-        EffectChainIndex parent_effect_chain_index = -1;
-
-        for (auto* effect_chain : effect_chains){
-            if (effect_chain->hasEffect(target_id)){
-                parent_effect_chain = effect_chain;
-                parent_effect_chain_index = effect_chain->getIndex();
-                break;
-            }
-        }
-
-        if(parent_effect_chain){
-            target_eff = parent_effect_chain->getEffectByObjectID(target_id);
-        }
-
+        EffectChain* parent_effect_chain = getEffectChainOwning(target_id);
+        Effect* target_eff = (parent_effect_chain) ? parent_effect_chain->getEffectByObjectID(target_id) : nullptr;
         if (!target_eff) {
             return ErrorCode::kModulationDestinationNotFound;
         }
-
+        const EffectChainIndex parent_effect_chain_index = parent_effect_chain->getIndex();
         int effect_index = parent_effect_chain->getEffectIndexByObjectID(target_id);
         
 
@@ -342,15 +539,18 @@ ErrorCode Voice::addModulation(ObjectID source_id, std::string source_param, Obj
         }
 
         // We now have the source and destination pointers, and we have the destination index
-        Modulation* mod = new Modulation();
-        mod->amount = amount;
-        mod->modulation_source = source_ptr;
-        mod->source_index = source_index;
-        mod->dest_index = dest_index;
-        mod->dest_type = dest_type;
-        mod->effect_chain_index = parent_effect_chain_index;
-        mod->effect_index = effect_index;
-        modulations.push_back(mod);
+        Modulation mod;
+        mod.source_id = source_id;
+        mod.source_index = source_index;
+        mod.dest_id = target_id;
+        mod.dest_index = dest_index;
+        mod.amount = amount;
+        mod.dest_type = dest_type;
+        mod.effect_chain_index = parent_effect_chain_index;
+        mod.effect_index = effect_index;
+        mod.source_buffer = source_ptr->getOutputBuffer();
+        mod.dest_buffer = target_eff->getModulationBuffer();
+        modulation_router.addModulation(mod);
     }
     return ErrorCode::kNoError;
 }
@@ -379,6 +579,9 @@ void Voice::processVoice(size_t n_audio_frames) {
         for(auto* mod_prod : modulation_producers){
             mod_prod->onRetrigger();
         }
+        for(auto* osc : oscillators){
+            osc->onRetrigger();
+        }
     }
 
     // Process modulation producers
@@ -390,76 +593,50 @@ void Voice::processVoice(size_t n_audio_frames) {
     // We need to set modulation inputs for each oscillator
     // For now, just set pitch and amplitude based on current_midi_note
     const float pitch = static_cast<float>(current_midi_note);
+    calculatePortamentoCoefficient(); // Depends only on the portamento time and sample rate
+    if(std::abs(pitch - current_note) < 1e-4f){
+        current_note = pitch; // Glide finished
+    }
+    const bool gliding = current_note != pitch;
+    const float glide_start = current_note;
     for(auto* osc : oscillators){
         SignalBuffer* mod_buffer = osc->getModBuffer();
         if(mod_buffer){
-            if(true){ // Temporary until I implement no glide with frame offset
-                float* pitch_channel = mod_buffer->getChannel(static_cast<size_t>(Oscillator::EModChannel::kPitch));
+            const size_t pitch_index = static_cast<size_t>(Oscillator::EModChannel::kPitch);
+            if(gliding){
+                // The whole range is written below, so skip writing out the previous hint first
+                mod_buffer->setChannelHint(pitch_index, SignalBuffer::ChannelHint());
+                float* pitch_channel = mod_buffer->getChannel(pitch_index);
                 if(pitch_channel){
+                    // Every oscillator glides from the same note
+                    current_note = glide_start;
                     for(size_t f = 0; f < n_audio_frames; ++f){
-                        calculatePortamentoCoefficient();
                         current_note += (pitch - current_note) * portamento_g;
                         pitch_channel[f + frame_offset] = current_note + voice_detune_semitones;
                     }
                 }
             }else {
-                mod_buffer->setConstantValue(static_cast<size_t>(Oscillator::EModChannel::kPitch), pitch + voice_detune_semitones, frame_offset);
+                mod_buffer->setChannelConstant(pitch_index, pitch + voice_detune_semitones);
+            }
+            mod_buffer->setChannelSilent(static_cast<size_t>(Oscillator::EModChannel::kAmplitude));
+            // Channels past pitch and amplitude only hold routed modulation, which adds into them below
+            for(size_t ch = static_cast<size_t>(Oscillator::EModChannel::kAmplitude) + 1; ch < mod_buffer->getNumChannels(); ++ch){
+                mod_buffer->setChannelSilent(ch);
             }
-            mod_buffer->setConstantValue(static_cast<size_t>(Oscillator::EModChannel::kAmplitude), 0.f, frame_offset);
         }
     }
 
-    // Apply modulations
-    for(auto* mod : modulations){
-        ModulationProducer* source = static_cast<ModulationProducer*>(mod->modulation_source);
-        if(!source) continue;
-        if(mod->dest_type == EObjectType::kOscillator){
-            Oscillator* dest = static_cast<Oscillator*>(mod->modulation_destination);
-            if(!dest) continue;
-            SignalBuffer* source_buffer = source->getOutputBuffer();
-            SignalBuffer* dest_buffer = dest->getModBuffer();
-            if(!source_buffer || !dest_buffer) continue;
-            float* source_channel = source_buffer->getChannel(mod->source_index);
-            float* dest_channel = dest_buffer->getChannel(mod->dest_index);
-            if(!source_channel || !dest_channel) continue;
-            const size_t source_division = source_buffer->getChannelDivision(mod->source_index);
-            const size_t dest_division = dest_buffer->getChannelDivision(mod->dest_index);
-            // Apply modulation
-            for(size_t i = 0; i < n_audio_frames; ++i){
-                size_t source_idx = i / source_division;
-                size_t dest_idx = i / dest_division;
-                if(source_idx < n_audio_frames && dest_idx < n_audio_frames){
-                    dest_channel[dest_idx + frame_offset / dest_division] += mod->amount * source_channel[source_idx + frame_offset / source_division];
-                }
-            }
-        }else if (mod->dest_type == EObjectType::kEffect){
-            Effect* dest = effect_chains[mod->effect_chain_index]->getEffectByIndex(mod->effect_index);
-            if(!dest) {
-                continue;
-            }
-            
-            SignalBuffer* source_buffer = source->getOutputBuffer();
-            SignalBuffer* dest_buffer = dest->getModulationBuffer();
-            if(!source_buffer || !dest_buffer) continue;
-            float* source_channel = source_buffer->getChannel(mod->source_index);
-            float* dest_channel = dest_buffer->getChannel(mod->dest_index);
-            
-            if(!source_channel || !dest_channel) continue;
-            const size_t source_division = source_buffer->getChannelDivision(mod->source_index);
-            const size_t dest_division = dest_buffer->getChannelDivision(mod->dest_index);
-            // Apply modulation
-            for(size_t i = 0; i < n_audio_frames / dest_division; ++i){
-                size_t source_idx = i / source_division;
-                if(source_idx < n_audio_frames){
-                    dest_channel[i + frame_offset / dest_division] += mod->amount * source_channel[source_idx + frame_offset / source_division];
-                }
-            }
-        }
+    // Effect modulation buffers start every sub-block at zero; the routings below add into them
+    for(auto* effect_chain : effect_chains){
+        effect_chain->zeroOutModulationBuffers();
     }
 
+    // Apply modulations
+    modulation_router.process(n_audio_frames, frame_offset);
+
     // Process oscillators
     for(auto* osc : oscillators){
-        osc->processBlock(nullptr, osc->getModBuffer(), osc->getOutputBuffer(), n_audio_frames); // For now, no inputs
+        osc->processBlock(osc->getInputBuffer(), osc->getModBuffer(), osc->getOutputBuffer(), n_audio_frames);
     }
 
     // Process effect chains
@@ -495,14 +672,25 @@ void Voice::processVoice(size_t n_audio_frames) {
 
         size_t n_channels = std::min(src_buffer->getNumChannels(), dest_buffer->getNumChannels()); // Because I gave up on doing more than two channels, this probably isn't necessary
         for (size_t c = 0; c < n_channels; ++c) {
+            if (src_buffer->isChannelSilent(c)) {
+                continue;
+            }
             float* src_channel = src_buffer->getChannel(c);
-            float* dest_channel = dest_buffer->getChannel(c);
-            if (!src_channel || !dest_channel) {
+            if (!src_channel) {
                 continue;
             }
 
-            for (size_t f = 0; f < n_audio_frames; ++f) {
-                dest_channel[f + frame_offset] += src_channel[f + frame_offset];
+            // The first voice to reach a silent channel copies instead of adding to zeros
+            if (dest_buffer->isChannelSilent(c)) {
+                float* dest_channel = dest_buffer->getChannelForOverwrite(c, frame_offset, frame_offset + n_audio_frames);
+                if (dest_channel) {
+                    vectorCopy(dest_channel + frame_offset, src_channel + frame_offset, n_audio_frames);
+                }
+                continue;
+            }
+            float* dest_channel = dest_buffer->getChannel(c);
+            if (dest_channel) {
+                vectorAdd(dest_channel + frame_offset, src_channel + frame_offset, n_audio_frames);
             }
         }
     }
@@ -512,6 +700,9 @@ void Voice::processVoice(size_t n_audio_frames) {
         bool silent = true;
         for(auto* buffer : voice_master_audio_buffer_src_ptrs){
             for(size_t c = 0; c < buffer->getNumChannels(); ++c){
+                if(buffer->isChannelSilent(c)){
+                    continue;
+                }
                 float* channel = buffer->getChannel(c);
                 for(size_t f = 0; f < n_audio_frames; ++f){
                     if(std::abs(channel[f + frame_offset]) > 0.0001f){
@@ -537,15 +728,27 @@ void Voice::processVoice(size_t n_audio_frames) {
 }
 
 ErrorCode Voice::setOscillatorFrequencyOffset(ObjectID osc_id, float midi_note_offset) {
-    // Find the oscillator
-    for (size_t i = 0; i < oscillators.size(); ++i) {
-        if (oscillator_ids[i] == osc_id) {
-            // Set the frequency offset
-            oscillators[i]->setFrequencyOffset(midi_note_offset);
-            return ErrorCode::kNoError;
-        }
+    Oscillator* osc = getOscillatorByID(osc_id);
+    if (!osc) {
+        return ErrorCode::kModulationDestinationNotFound;
     }
-    return ErrorCode::kModulationDestinationNotFound;
+    osc->setFrequencyOffset(midi_note_offset);
+    return ErrorCode::kNoError;
+}
+
+ErrorCode Voice::setOscillatorUnison(ObjectID osc_id, size_t n_voices, float detune_semitones, float stereo_spread) {
+    Oscillator* osc = getOscillatorByID(osc_id);
+    if (!osc) {
+        return ErrorCode::kObjectNotFound;
+    }
+    if (WaveformOscillator* waveform_osc = dynamic_cast<WaveformOscillator*>(osc)) {
+        waveform_osc->setUnison(n_voices, detune_semitones, stereo_spread);
+    } else if (VAOscillator* va_osc = dynamic_cast<VAOscillator*>(osc)) {
+        va_osc->setUnison(n_voices, detune_semitones, stereo_spread);
+    } else {
+        return ErrorCode::kUnsupportedByObject;
+    }
+    return ErrorCode::kNoError;
 }
 
 void Voice::deactivate() {
@@ -558,6 +761,43 @@ void Voice::deactivate() {
     }
 }
 
+void Voice::copyStateFrom(const Voice& other) {
+    current_midi_note = other.current_midi_note;
+    last_midi_note = other.last_midi_note;
+    current_note = other.current_note;
+    is_playing = other.is_playing;
+    is_releasing = other.is_releasing;
+    should_retrigger = other.should_retrigger;
+    should_reset_portamento = other.should_reset_portamento;
+    voice_age = other.voice_age;
+    voice_detune_semitones = other.voice_detune_semitones; // Keep the random detune so held notes do not jump
+}
+
+void Voice::matchObjectsWith(const Voice& running, HotReloadPlan& plan) {
+    const ObjectRegistry& running_registry = running.m_context->object_registry;
+    const ObjectRegistry& registry = m_context->object_registry;
+    plan.voices.push_back({&running, this});
+
+    plan.matchObjects(running_registry, running.oscillators, running.oscillator_ids, registry, oscillators, oscillator_ids, plan.oscillators);
+
+    const std::vector<bool> matched_producers = plan.matchObjects(running_registry, running.modulation_producers, running.modulation_producer_ids,
+                                                                  registry, modulation_producers, modulation_producer_ids, plan.producers);
+    for (size_t i = 0; i < modulation_producers.size(); ++i) {
+        if (!matched_producers[i]) {
+            plan.new_producers.push_back({this, modulation_producers[i]});
+        }
+    }
+
+    // Effect chains are paired by position
+    for (size_t i = 0; i < effect_chains.size(); ++i) {
+        if (i < running.effect_chains.size()) {
+            effect_chains[i]->matchEffectsWith(*running.effect_chains[i], plan);
+        } else {
+            plan.n_new_objects += effect_chains[i]->getNumEffects();
+        }
+    }
+}
+
 void Voice::setSampleRate(float sample_rate) {
     for (auto* osc : oscillators) {
         osc->setSampleRate(sample_rate);
@@ -590,9 +830,15 @@ void Voice::connectVoiceEffects(){
     for(auto* effect_chain : effect_chains){
         effect_chain->connectEffects();
     }
+
+    layoutBuffers();
 }
 
 EffectChain* Voice::getEffectChainByIndex(EffectChainIndex index) {
+    // Chain indices restart at 0 for every voice build, so chain i normally sits at position i
+    if (index >= 0 && static_cast<size_t>(index) < effect_chains.size() && effect_chains[index]->getIndex() == index) {
+        return effect_chains[index];
+    }
     for (auto* effect_chain : effect_chains) {
         if (effect_chain->getIndex() == index) {
             return effect_chain;
@@ -602,6 +848,9 @@ EffectChain* Voice::getEffectChainByIndex(EffectChainIndex index) {
 }
 
 void Voice::beginBlock() {
+    // frame_offset still holds the length of the previous block. Its last control point is where this
+    // block's control-rate ramps start.
+    modulation_router.beginBlock(frame_offset);
     frame_offset = 0;
 
     for (auto* mod_prod : modulation_producers) {
@@ -616,17 +865,10 @@ void Voice::beginBlock() {
         effect_chain->beginBlock();
     }
 
-    for(auto* buffer : audio_buffers){
-        if(buffer->getType() == SignalBuffer::EType::kAudio){
-            buffer->zeroOut();
-        }
-    }
-
-    // Zero out modulation buffers for effects in effect chains
-    for(auto* effect_chain : effect_chains){
-        effect_chain->zeroOutModulationBuffers();
+    // Written buffers are overwritten by their first writer (see planBufferWrites)
+    for(auto* buffer : cleared_audio_buffers){
+        buffer->zeroOut();
     }
-
 }
 
 }
\ No newline at end of file
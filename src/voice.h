@@ -9,22 +9,44 @@
 #include <cmath>
 #include "modulator_producer.h"
 #include  "modulation.h"
+#include "modulation_router.h"
 #include "modulation_producers/basic_envelope.h"
+#include "modulation_producers/random_modulators.h"
 #include "effect.h"
 #include "effect_chain.h"
+#include "buffer_arena.h"
+#include "hot_reload.h"
+#include "oscillators/waveform_osc.h"
+#include "oscillators/va_osc.h"
+#include "oscillators/fm_osc.h"
+#include "oscillators/sampler_osc.h"
+#include "oscillators/granular_osc.h"
+#include "oscillators/noise_osc.h"
+#include "oscillators/wavetable_osc.h"
+#include "dsp/random.h"
 
 namespace OrangeSodium{
 
 class Voice {
 public:
-    Voice(Context* context, void* parent_synthesizer);
+    Voice(Context* context, void* parent_synthesizer, size_t voice_index = 0);
     ~Voice();
 
     ObjectID addSineOscillator(size_t n_channels, float amplitude); // Add a sine wave oscillator to the voice; returns its ObjectID
     ErrorCode setOscillatorFrequencyOffset(ObjectID osc_id, float midi_note_offset); // Set frequency offset (in MIDI note numbers) for the specified oscillator
+    ErrorCode setOscillatorUnison(ObjectID osc_id, size_t n_voices, float detune_semitones, float stereo_spread); // Set the unison voices of a waveform or virtual analog oscillator
     ObjectID addWaveformOscillator(size_t n_channels, ResourceID waveform_id, float amplitude); // Add a waveform oscillator to the voice; returns its ObjectID
+    ObjectID addAdditiveOscillator(size_t n_channels, ResourceID table_id, float amplitude); // Add an additive oscillator playing a partial table; returns its ObjectID
+    ObjectID addVAOscillator(size_t n_channels, VAOscillator::EShape shape, float amplitude, float pulse_width); // Add a virtual analog oscillator; returns its ObjectID
+    ObjectID addFMOscillator(size_t n_channels, size_t n_operators, float amplitude); // Add an FM/PM operator stack; returns its ObjectID
+    ObjectID addSamplerOscillator(size_t n_channels, ResourceID sample_id, float amplitude); // Add a sample playback oscillator; returns its ObjectID
+    ObjectID addGranularOscillator(size_t n_channels, ResourceID sample_id, float amplitude); // Add a granular oscillator reading a sample; returns its ObjectID
+    ObjectID addWavetableOscillator(size_t n_channels, ResourceID wavetable_id, float amplitude); // Add a wavetable oscillator; returns its ObjectID
+    ObjectID addNoiseOscillator(size_t n_channels, NoiseOscillator::EColor color, float amplitude); // Add a noise oscillator; returns its ObjectID
     ObjectID addAudioBuffer(size_t n_frames, size_t n_channels); // Add an audio buffer to the voice; returns its ObjectID
     SignalBuffer* getAudioBufferByID(ObjectID id); // Get pointer to audio buffer by its ObjectID; returns nullptr if not found
+    Oscillator* getOscillatorByID(ObjectID id); // Get pointer to one of this voice's oscillators; returns nullptr if not found
+    EffectChain* getEffectChainOwning(ObjectID effect_id); // Get this voice's effect chain holding the effect; returns nullptr if not found
     EObjectType getObjectType(ObjectID id); // Get the type of object with the given ID; returns kOscillator, kFilter, etc. Returns kUndefined if not found (default)
     // void setMasterAudioBufferInfo(size_t n_channels) {
     //     if (voice_master_audio_buffer) {
@@ -37,12 +59,17 @@ public:
 
     ObjectID addBasicEnvelope(); // Add a basic ADSR envelope as a modulation producer; returns its ObjectID
     ObjectID addBasicEnvelope(float attack_time, float decay_time, float sustain_level, float release_time); // Add a basic ADSR envelope as a modulation producer; returns its ObjectID
+    ObjectID addSampleAndHold(float rate); // Add a sample-and-hold random modulation producer drawing rate values per second; returns its ObjectID
+    ObjectID addSmoothRandom(float rate); // Add a smooth random modulation producer drawing rate values per second; returns its ObjectID
 
     /// @brief Resize all buffers in the voice to the specified number of frames
     void resizeBuffers(size_t n_frames);
     
     void assignOscillatorAudioBuffer(ObjectID osc_id, ObjectID buffer_id);
 
+    /// @brief Feed an audio buffer to an oscillator as its audio input; the buffer's writers must be added before it
+    ErrorCode assignOscillatorInputBuffer(ObjectID osc_id, ObjectID buffer_id);
+
     ObjectID getConnectedAudioBufferForOscillator(ObjectID osc_id);
 
     // Connect a voice audio buffer to a master buffer
@@ -91,6 +118,17 @@ public:
 
     void deactivate();
 
+    inline bool isReleasing() const {
+        return is_releasing;
+    }
+
+    /// @brief Take over the note state (note, glide, playing and releasing flags, age, detune) of the same voice in
+    /// the previous build of the program
+    void copyStateFrom(const Voice& other);
+
+    /// @brief Pair this voice's objects with those of the same voice in the running synthesizer, for a hot reload
+    void matchObjectsWith(const Voice& running, HotReloadPlan& plan);
+
     unsigned int getCurrentMIDINote() const {
         return current_midi_note;
     }
@@ -103,9 +141,15 @@ public:
         return voice_age;
     }
 
+    /// @brief Index of the voice in its synthesizer; seeds the random streams of the voice and its objects
+    size_t getVoiceIndex() const {
+        return voice_index;
+    }
+
     void setRandomDetune(float semitone_scale){
-        float r = rand() / static_cast<float>(RAND_MAX); // [0, 1]
-        voice_detune_semitones = (r * 2.0f - 1.0f) * semitone_scale; // [-semitone_scale, semitone_scale]
+        // The voice's own stream, so a voice gets the same detune on every build
+        CounterRandom random(CounterRandom::makeKey(voice_index, kVoiceRandomStream));
+        voice_detune_semitones = random.nextBipolar() * semitone_scale; // [-semitone_scale, semitone_scale]
     }
 
     void setSampleRate(float sample_rate);
@@ -141,8 +185,8 @@ private:
     std::vector<ModulationProducer*> modulation_producers;
     std::vector<ObjectID> modulation_producer_ids;
 
-    /// @brief Collection of modulations
-    std::vector<Modulation*> modulations;
+    /// @brief Owns and executes every modulation routing of the voice
+    ModulationRouter modulation_router;
 
     //SignalBuffer* voice_master_audio_buffer = nullptr; // Master audio output buffer for the voice. DATA MUST BE COPIED TO THIS BUFFER
     std::vector<SignalBuffer*> voice_master_audio_buffer_src_ptrs; // Pointers to source buffers that are used as outputs for the voice
@@ -156,6 +200,8 @@ private:
     bool is_releasing = false; // Denotes if this voice is in the release phase
     bool should_retrigger = false; // Denotes if the voice should retrigger envelopes, etc
     unsigned int voice_age = 0; // Age of the voice in number of MIDI activations
+    size_t voice_index = 0; // See getVoiceIndex
+    static constexpr uint32_t kVoiceRandomStream = 0xFFFFFFFFu; // Stream of the voice itself; no object has this ID
 
     float portamento_time = 0.f; // Time to glide between notes, in seconds
     float portamento_g; // Portamento filter coefficient
@@ -171,7 +217,21 @@ private:
 
     size_t frame_offset; // To allow for per-sample MIDI events, we keep track of the current frame offset within the block being processed
 
+    BufferArena buffer_arena; // Contiguous storage for all voice buffers, laid out in processing order
+
+    /// @brief Pack all voice buffers into buffer_arena. Called after the voice is built and after any resize.
+    void layoutBuffers();
+
+    // Audio buffers that are read before anything writes them in a sub-block (or never written); only these
+    // are cleared at the start of a block. Everything else is overwritten by its first writer.
+    std::vector<SignalBuffer*> cleared_audio_buffers;
+
+    /// @brief Decide, in execution order, which oscillator writes each audio buffer first and which buffers need clearing
+    void planBufferWrites();
+
     ObjectID addBasicEnvelopeInternal(BasicEnvelope* env, ObjectID id);
+    ObjectID addModulationProducerInternal(ModulationProducer* producer, ObjectID id, size_t n_mod_inputs);
+
     void calculatePortamentoCoefficient(){
         if(portamento_time <= 0.f) {
             portamento_g = 1.f;